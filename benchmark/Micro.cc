@@ -0,0 +1,313 @@
+// Micro-benchmarks of runtime primitives, exercised directly rather than through scripts. Each
+// benchmark body is run in batches until a batch takes long enough to time reliably, and the
+// fastest of several batches is reported, so results are repeatable across runs. Inputs are
+// generated deterministically.
+//
+// Usage: norlit-micro [filter]
+// Only benchmarks whose name contains the filter are run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "norlit/gc/Handle.h"
+#include "norlit/gc/Array.h"
+
+#include "norlit/js/JSNumber.h"
+#include "norlit/js/JSString.h"
+#include "norlit/js/Objects.h"
+#include "norlit/js/Conversion.h"
+
+#include "norlit/util/HashMap.h"
+#include "norlit/util/TaggedInteger.h"
+#include "norlit/util/Double2String.h"
+
+#include "norlit/js/grammar/Token.h"
+#include "norlit/js/grammar/Scanner.h"
+
+#include "norlit/js/object/JSOrdinaryObject.h"
+
+#include "norlit/js/bytecode/Emitter.h"
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::object;
+using namespace norlit::js::grammar;
+using namespace norlit::js::bytecode;
+using namespace norlit::util;
+
+namespace {
+
+const char* filter = "";
+
+// Keeps results alive so the compiler cannot drop the work producing them
+volatile uintptr_t sink;
+
+template<typename T>
+void Consume(const Handle<T>& value) {
+    sink = reinterpret_cast<uintptr_t>(static_cast<T*>(value));
+}
+
+void Consume(uintptr_t value) {
+    sink = value;
+}
+
+// Run body, which performs opsPerCall operations, and report the time per operation. If bytes is
+// given, the number of bytes processed by each call, throughput is reported as well
+template<typename F>
+void Bench(const std::string& name, size_t opsPerCall, F body, size_t bytes = 0) {
+    if (!strstr(name.c_str(), filter)) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    const double kMinBatchSeconds = 0.05;
+    const int kBatches = 5;
+
+    // Find a number of calls per batch that takes at least kMinBatchSeconds
+    size_t calls = 1;
+    while (true) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < calls; i++) {
+            body();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= kMinBatchSeconds || calls >= (1u << 30)) {
+            break;
+        }
+        calls *= seconds > 0 ? std::max<size_t>(2, std::min<size_t>(10, static_cast<size_t>(kMinBatchSeconds / seconds) + 1)) : 10;
+    }
+
+    double best = 0;
+    for (int batch = 0; batch < kBatches; batch++) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < calls; i++) {
+            body();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (batch == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+
+    double nsPerOp = best * 1e9 / (static_cast<double>(calls) * opsPerCall);
+    if (bytes) {
+        double mbPerSecond = static_cast<double>(bytes) * calls / best / (1024 * 1024);
+        printf("%-40s %12.2f ns/op %10.2f MB/s\n", name.c_str(), nsPerOp, mbPerSecond);
+    } else {
+        printf("%-40s %12.2f ns/op\n", name.c_str(), nsPerOp);
+    }
+}
+
+// Strings "key0", "key1", ... created ahead of time
+Handle<Array<JSString>> MakeKeys(size_t count, const char* prefix = "key") {
+    Handle<Array<JSString>> keys = Array<JSString>::New(count);
+    for (size_t i = 0; i < count; i++) {
+        keys->Put(i, JSString::New((prefix + std::to_string(i)).c_str()));
+    }
+    return keys;
+}
+
+void BenchStrings() {
+    // Up to 7 ASCII characters fit in a tagged pointer, so nothing is allocated
+    Bench("JSString::New/short", 1, [] {
+        Consume(JSString::New("hello"));
+    });
+
+    Handle<JSString> left = JSString::New("hello, ");
+    Handle<JSString> right = JSString::New("world");
+    Bench("JSString::Concat/short", 1, [&] {
+        Consume(JSString::Concat(left, right));
+    });
+    Bench("JSString::Concat/append-1000", 1000, [&] {
+        Handle<JSString> result = JSString::New("");
+        for (int i = 0; i < 1000; i++) {
+            result = JSString::Concat(result, right);
+        }
+        Consume(result);
+    });
+
+    // Longer strings are interned by New, which is the only way to reach Intern. The first finds
+    // an equal string already in the intern table, the second adds a new one each time
+    Handle<JSString> interned = JSString::New("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+    Bench("JSString::Intern/hit", 1, [] {
+        Consume(JSString::New("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"));
+    });
+    uint64_t counter = 0;
+    Bench("JSString::Intern/miss", 1, [&] {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "unique%llu", static_cast<unsigned long long>(counter++));
+        Consume(JSString::New(buffer));
+    });
+    Consume(interned);
+}
+
+void BenchHashMap() {
+    for (size_t size : { 16, 1024, 65536 }) {
+        Handle<Array<JSString>> keys = MakeKeys(size);
+        Handle<HashMap<JSString, TaggedInteger>> map = new HashMap<JSString, TaggedInteger>();
+        for (size_t i = 0; i < size; i++) {
+            map->Put(keys->Get(i), TaggedInteger::New(i));
+        }
+        Bench("HashMap::Get/" + std::to_string(size), size, [&] {
+            for (size_t i = 0; i < size; i++) {
+                Consume(map->Get(keys->Get(i)));
+            }
+        });
+        Bench("HashMap::Put/existing-" + std::to_string(size), size, [&] {
+            for (size_t i = 0; i < size; i++) {
+                Consume(map->Put(keys->Get(i), TaggedInteger::New(i)));
+            }
+        });
+        // Starts at the default capacity, so this includes every resize on the way to size
+        Bench("HashMap::Put/resize-" + std::to_string(size), size, [&] {
+            Handle<HashMap<JSString, TaggedInteger>> fresh = new HashMap<JSString, TaggedInteger>();
+            for (size_t i = 0; i < size; i++) {
+                fresh->Put(keys->Get(i), TaggedInteger::New(i));
+            }
+            Consume(fresh);
+        });
+    }
+}
+
+void BenchObjects() {
+    Handle<JSValue> value = JSNumber::New(static_cast<int32_t>(1));
+    for (size_t size : { 1, 10, 100, 1000, 10000 }) {
+        Handle<Array<JSString>> keys = MakeKeys(size);
+        Bench("JSOrdinaryObject::Define/" + std::to_string(size), size, [&] {
+            Handle<JSOrdinaryObject> object = new JSOrdinaryObject(nullptr);
+            for (size_t i = 0; i < size; i++) {
+                Objects::CreateDataProperty(object, keys->Get(i), value);
+            }
+            Consume(object);
+        });
+
+        Handle<JSOrdinaryObject> object = new JSOrdinaryObject(nullptr);
+        for (size_t i = 0; i < size; i++) {
+            Objects::CreateDataProperty(object, keys->Get(i), value);
+        }
+        Bench("JSOrdinaryObject::Get/" + std::to_string(size), size, [&] {
+            for (size_t i = 0; i < size; i++) {
+                Consume(Objects::Get(object, keys->Get(i)));
+            }
+        });
+    }
+}
+
+void BenchNumbers() {
+    const size_t kCount = 1000;
+    Handle<Array<JSValue>> integers = Array<JSValue>::New(kCount);
+    Handle<Array<JSValue>> doubles = Array<JSValue>::New(kCount);
+    // Fixed linear congruential sequence, so the inputs are the same on every run
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    double raw[kCount];
+    for (size_t i = 0; i < kCount; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        double fraction = static_cast<double>(state >> 11) / static_cast<double>(1ULL << 53);
+        raw[i] = (fraction - 0.5) * 1e6;
+        integers->Put(i, JSNumber::New(static_cast<int32_t>(state >> 40)));
+        doubles->Put(i, JSNumber::New(raw[i]));
+    }
+
+    Bench("Conversion::ToString/integer", kCount, [&] {
+        for (size_t i = 0; i < kCount; i++) {
+            Consume(Conversion::ToString(integers->Get(i)));
+        }
+    });
+    Bench("Conversion::ToString/double", kCount, [&] {
+        for (size_t i = 0; i < kCount; i++) {
+            Consume(Conversion::ToString(doubles->Get(i)));
+        }
+    });
+    Bench("DesembleDouble", kCount, [&] {
+        for (size_t i = 0; i < kCount; i++) {
+            uint64_t s;
+            int16_t n;
+            uint8_t k;
+            DesembleDouble(raw[i], s, n, k);
+            Consume(static_cast<uintptr_t>(s + n + k));
+        }
+    });
+}
+
+void BenchScanner() {
+    // Representative mix of tokens: keywords, identifiers, punctuators, numbers, strings and
+    // comments. Regular expressions and templates are left out, as they need the parser to scan
+    const char* snippet =
+        "// Compute the checksum of a table\n"
+        "function checksum(table, seed) {\n"
+        "    var sum = seed | 0, count = 0;\n"
+        "    for (var i = 0; i < table.length; i++) {\n"
+        "        /* skip holes */\n"
+        "        if (table[i] === undefined) continue;\n"
+        "        sum = (sum * 31 + table[i].value) % 1000000007;\n"
+        "        count += 1.5e-3;\n"
+        "    }\n"
+        "    return { sum: sum, count: count, name: \"checksum\\n\" };\n"
+        "}\n";
+    std::string text;
+    while (text.size() < 1024 * 1024) {
+        text += snippet;
+    }
+    Handle<JSString> source = JSString::New(text.c_str());
+
+    Bench("Scanner::NextToken/1MB", 1, [&] {
+        Scanner scanner(source);
+        size_t tokens = 0;
+        while (scanner.NextToken().type != Token::kEOF) {
+            tokens++;
+        }
+        Consume(static_cast<uintptr_t>(tokens));
+    }, text.size());
+}
+
+void BenchEmitter() {
+    const size_t kCount = 1000;
+    Handle<Array<JSString>> strings = MakeKeys(kCount, "constant");
+    Handle<Array<JSValue>> numbers = Array<JSValue>::New(kCount);
+    for (size_t i = 0; i < kCount; i++) {
+        numbers->Put(i, JSNumber::New(i + 0.5));
+    }
+
+    Bench("Emitter::EmitConstant/distinct-strings", kCount, [&] {
+        Emitter emitter;
+        for (size_t i = 0; i < kCount; i++) {
+            Consume(static_cast<uintptr_t>(emitter.EmitConstant(strings->Get(i))));
+        }
+    });
+    Bench("Emitter::EmitConstant/distinct-numbers", kCount, [&] {
+        Emitter emitter;
+        for (size_t i = 0; i < kCount; i++) {
+            Consume(static_cast<uintptr_t>(emitter.EmitConstant(numbers->Get(i))));
+        }
+    });
+    // Constant pools of real functions are dominated by repeated names
+    Bench("Emitter::EmitConstant/repeated", kCount, [&] {
+        Emitter emitter;
+        for (size_t i = 0; i < kCount; i++) {
+            Consume(static_cast<uintptr_t>(emitter.EmitConstant(strings->Get(i % 16))));
+        }
+    });
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        filter = argv[1];
+    }
+    try {
+        BenchStrings();
+        BenchHashMap();
+        BenchObjects();
+        BenchNumbers();
+        BenchScanner();
+        BenchEmitter();
+    } catch (const char* error) {
+        printf("%s\n", error);
+        return 1;
+    }
+    return 0;
+}
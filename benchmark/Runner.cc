@@ -0,0 +1,253 @@
+// Benchmark harness. Each benchmark is a script defining a global function run, which performs
+// one iteration and throws if its result is wrong. The script is evaluated once in a fresh realm,
+// then run is called for the warmup iterations followed by the timed ones.
+//
+// Usage: norlit-bench [--iterations=N] [--warmup=N] [--json=<file>] benchmark.js...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "norlit/gc/Handle.h"
+#include "norlit/gc/Array.h"
+
+#include "norlit/js/JSString.h"
+#include "norlit/js/JSSymbol.h"
+#include "norlit/js/Objects.h"
+#include "norlit/js/Testing.h"
+#include "norlit/js/Conversion.h"
+#include "norlit/js/Exception.h"
+
+#include "norlit/util/ScopeExit.h"
+
+#include "norlit/js/object/JSOrdinaryObject.h"
+#include "norlit/js/object/JSFunction.h"
+
+#include "norlit/js/bytecode/Code.h"
+#include "norlit/js/bytecode/BackgroundCompiler.h"
+
+#include "norlit/js/vm/Realm.h"
+#include "norlit/js/vm/Context.h"
+#include "norlit/js/vm/Environment.h"
+#include "norlit/js/vm/OpcodeStats.h"
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::object;
+using namespace norlit::js::bytecode;
+using namespace norlit::js::vm;
+
+namespace {
+
+struct Result {
+    std::string name;
+    bool passed = false;
+    size_t iterations = 0;
+    double totalMs = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    // Instructions executed by the timed iterations. Only counted with NORLIT_OPCODE_STATS
+    bool hasInstructions = false;
+    uint64_t instructions = 0;
+};
+
+std::string BenchmarkName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos && dot != 0) {
+        name.resize(dot);
+    }
+    return name;
+}
+
+std::string DescribeException(const Handle<JSValue>& value) {
+    Handle<JSValue> exception = value;
+    try {
+        if (Handle<JSValue> stack = Objects::GetV(exception, "stack")) {
+            exception = stack;
+        }
+    } catch (ESException&) {
+    }
+    return &Conversion::ToString(exception)->ToCString()->At(0);
+}
+
+void InstallConsole(const Handle<Realm>& realm) {
+    Handle<ESNativeFunction> func = new ESNativeFunction(realm->FunctionPrototype(), realm,
+    [] (const Handle<JSValue>&, const Handle<Array<JSValue>>& args)->Handle<JSValue> {
+        for (size_t i = 0, size = args->Length(); i < size; i++) {
+            Handle<JSValue> value = args->Get(i);
+            if (Testing::Is<JSSymbol>(value)) {
+                printf("Symbol()\n");
+            } else {
+                printf("%s\n", &Conversion::ToString(value)->ToCString()->At(0));
+            }
+        }
+        return nullptr;
+    }, nullptr);
+
+    Handle<JSOrdinaryObject> console = new JSOrdinaryObject(realm->ObjectPrototype());
+    Objects::Set(console, JSString::New("log"), func, true);
+    Objects::Set(realm->GetGlobalObject(), JSString::New("console"), console, true);
+}
+
+void Measure(const Handle<Code>& code, size_t warmup, size_t iterations, Result& result) {
+    Handle<Realm> realm = new Realm();
+    Handle<Context> guard = new Context(realm, nullptr, nullptr);
+    Context::PushContext(guard);
+    NORLIT_SCOPE_EXIT{ Context::PopContext(); };
+    InstallConsole(realm);
+
+    Handle<GlobalEnvironment> genv = realm->GetGlobalEnvironment();
+    {
+        Handle<BytecodeContext> ctx = new BytecodeContext(genv, genv, realm, nullptr, code);
+        Context::PushContext(ctx);
+        NORLIT_SCOPE_EXIT{ Context::PopContext(); };
+        ctx->Run();
+    }
+
+    Handle<JSValue> value = Objects::Get(realm->GetGlobalObject(), "run");
+    if (!Testing::IsCallable(value)) {
+        throw "Benchmark does not define a run function";
+    }
+    Handle<JSObject> run = value.CastTo<JSObject>();
+
+    for (size_t i = 0; i < warmup; i++) {
+        Objects::Call(run, nullptr);
+    }
+
+#ifdef NORLIT_OPCODE_STATS
+    OpcodeStats::Reset();
+#endif
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        Objects::Call(run, nullptr);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.totalMs += ms;
+        result.minMs = i == 0 ? ms : std::min(result.minMs, ms);
+        result.maxMs = std::max(result.maxMs, ms);
+    }
+#ifdef NORLIT_OPCODE_STATS
+    result.hasInstructions = true;
+    result.instructions = OpcodeStats::TotalCount();
+#endif
+    result.iterations = iterations;
+    result.passed = true;
+}
+
+void WriteJsonString(FILE* file, const std::string& str) {
+    fputc('"', file);
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Allocation and GC pause counts are written as null, the collector does not report them
+bool WriteJson(const std::string& path, const std::vector<Result>& results) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\n  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        fprintf(file, "%s\n    {\n      \"name\": ", i ? "," : "");
+        WriteJsonString(file, result.name);
+        fprintf(file, ",\n      \"passed\": %s", result.passed ? "true" : "false");
+        fprintf(file, ",\n      \"iterations\": %zu", result.iterations);
+        fprintf(file, ",\n      \"totalMs\": %.3f", result.totalMs);
+        fprintf(file, ",\n      \"meanMs\": %.3f", result.iterations ? result.totalMs / result.iterations : 0.0);
+        fprintf(file, ",\n      \"minMs\": %.3f", result.minMs);
+        fprintf(file, ",\n      \"maxMs\": %.3f", result.maxMs);
+        if (result.hasInstructions) {
+            fprintf(file, ",\n      \"instructions\": %llu", static_cast<unsigned long long>(result.instructions));
+        } else {
+            fprintf(file, ",\n      \"instructions\": null");
+        }
+        fprintf(file, ",\n      \"allocations\": null");
+        fprintf(file, ",\n      \"gcPauses\": null");
+        fprintf(file, "\n    }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    size_t iterations = 10;
+    size_t warmup = 2;
+    std::string jsonPath;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            iterations = std::max<size_t>(strtoul(argv[i] + 13, nullptr, 10), 1);
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            warmup = strtoul(argv[i] + 9, nullptr, 10);
+        } else if (strncmp(argv[i], "--json=", 7) == 0) {
+            jsonPath = argv[i] + 7;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        printf("Usage: %s [--iterations=N] [--warmup=N] [--json=<file>] benchmark.js...\n", argv[0]);
+        return 1;
+    }
+
+    BackgroundCompiler compiler(paths, "");
+    std::vector<Result> results;
+    bool failed = false;
+
+    printf("%-20s %10s %12s %12s %12s %16s\n", "benchmark", "iterations", "mean (ms)", "min (ms)", "max (ms)", "instructions");
+    for (size_t i = 0; i < compiler.Size(); i++) {
+        Result result;
+        result.name = BenchmarkName(paths[i]);
+        std::string error;
+        try {
+            Handle<Code> code = compiler.Finish(i);
+            if (!code) {
+                error = "Cannot open file " + paths[i];
+            } else {
+                Measure(code, warmup, iterations, result);
+            }
+        } catch (const char* message) {
+            error = message;
+        } catch (std::string& message) {
+            error = message;
+        } catch (ESException& e) {
+            error = DescribeException(e.value());
+        }
+
+        if (!result.passed) {
+            failed = true;
+            printf("%-20s FAILED\n%s\n", result.name.c_str(), error.c_str());
+        } else if (result.hasInstructions) {
+            printf("%-20s %10zu %12.3f %12.3f %12.3f %16llu\n", result.name.c_str(), result.iterations,
+                   result.totalMs / result.iterations, result.minMs, result.maxMs,
+                   static_cast<unsigned long long>(result.instructions));
+        } else {
+            printf("%-20s %10zu %12.3f %12.3f %12.3f %16s\n", result.name.c_str(), result.iterations,
+                   result.totalMs / result.iterations, result.minMs, result.maxMs, "-");
+        }
+        results.push_back(std::move(result));
+    }
+
+    if (!jsonPath.empty() && !WriteJson(jsonPath, results)) {
+        printf("Cannot write %s.\n", jsonPath.c_str());
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+// Closures: creation of closures capturing variables of enclosing functions, calls through them,
+// and updates of captured variables. Exercises function object creation and scope lookup.
+
+var EXPECTED_SUM = 657850;
+
+function makeCounter(start) {
+    var count = start;
+    return function (step) {
+        count = count + step;
+        return count;
+    };
+}
+
+function makeAdder(x) {
+    return function (y) {
+        return function (z) {
+            return x + y + z;
+        };
+    };
+}
+
+function compose(f, g) {
+    return function (x) {
+        return f(g(x));
+    };
+}
+
+function run() {
+    var sum = 0;
+
+    // Create many short-lived closures
+    for (var i = 0; i < 1000; i++) {
+        var counter = makeCounter(i);
+        counter(1);
+        sum = sum + counter(2);
+    }
+
+    // Call a long-lived closure repeatedly
+    var shared = makeCounter(0);
+    for (i = 0; i < 5000; i++) {
+        shared(1);
+    }
+    sum = sum + shared(0);
+
+    // Curried functions, three levels deep
+    for (i = 0; i < 500; i++) {
+        sum = sum + makeAdder(i)(1)(2);
+    }
+
+    // Chains of composed functions
+    var inc = function (x) {
+        return x + 1;
+    };
+    var chain = inc;
+    for (i = 0; i < 20; i++) {
+        chain = compose(chain, inc);
+    }
+    for (i = 0; i < 200; i++) {
+        sum = sum + chain(i);
+    }
+
+    if (sum != EXPECTED_SUM) {
+        throw new Error("Closures: sum " + sum);
+    }
+}
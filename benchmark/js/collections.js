@@ -0,0 +1,133 @@
+// Collections: Map and Set with string, integer and object keys used as indexes and caches, with
+// entries deleted and added while being iterated. Exercises hashing, SameValueZero lookups, growth and
+// compaction of the tables, and iterators over tables that change under them.
+
+var EXPECTED_CHECKSUM = 10201486;
+
+var WORDS = ["alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "iota", "kappa",
+    "lambda", "mu", "nu", "xi", "omicron", "pi", "rho", "sigma", "tau", "upsilon"];
+
+function countWords(count) {
+    var counts = new Map();
+    for (var i = 0; i < count; i++) {
+        var word = WORDS[i * 7 % WORDS.length] + (i % 13);
+        counts.set(word, (counts.get(word) || 0) + 1);
+    }
+    var checksum = counts.size;
+    for (var entry of counts) {
+        checksum += entry[0].length * entry[1];
+    }
+    return checksum;
+}
+
+function integerIndex(count) {
+    var index = new Map();
+    for (var i = 0; i < count; i++) {
+        index.set(i * 31 % 4099, i);
+    }
+    var checksum = 0;
+    for (i = 0; i < count; i += 3) {
+        if (index.has(i)) {
+            checksum += index.get(i) % 97;
+        }
+        index.delete(i + 1);
+    }
+    index.set(-0, 1);
+    index.set(NaN, 2);
+    index.set(0.5, 3);
+    checksum += index.get(0) + index.get(NaN) * 10 + index.get(0.5) * 100 + index.size;
+    return checksum;
+}
+
+function dedupe(count) {
+    var seen = new Set();
+    var unique = 0;
+    for (var i = 0; i < count; i++) {
+        var value = i * i % 1021;
+        if (!seen.has(value)) {
+            seen.add(value);
+            unique++;
+        }
+    }
+    return unique + seen.size;
+}
+
+function mutateWhileIterating(count) {
+    var set = new Set();
+    for (var i = 0; i < count; i++) {
+        set.add(i);
+    }
+    var visited = 0;
+    var checksum = 0;
+    // Deleted values ahead of the iterator are skipped, added ones are visited
+    set.forEach(function (value) {
+        visited++;
+        checksum += value;
+        set.delete(value + 1);
+        if (value < count && value % 10 === 0) {
+            set.add(value + count);
+        }
+    });
+    var map = new Map();
+    for (i = 0; i < 200; i++) {
+        map.set("k" + i, i);
+    }
+    for (var key of map.keys()) {
+        checksum += map.get(key);
+        map.delete(key);
+        if (map.size === 50) {
+            map.clear();
+            map.set("last", 1000);
+        }
+    }
+    return checksum + visited + map.size;
+}
+
+function objectKeys(count) {
+    var nodes = [];
+    for (var i = 0; i < count; i++) {
+        nodes[i] = { id: i };
+    }
+    var parents = new Map();
+    var cache = new WeakMap();
+    var marked = new WeakSet();
+    for (i = 1; i < count; i++) {
+        parents.set(nodes[i], nodes[(i - 1) >> 1]);
+    }
+    var checksum = 0;
+    for (i = 0; i < count; i += 5) {
+        var depth = 0;
+        var node = nodes[i];
+        while (parents.has(node)) {
+            if (cache.has(node)) {
+                depth += cache.get(node);
+                break;
+            }
+            node = parents.get(node);
+            depth++;
+        }
+        cache.set(nodes[i], depth);
+        if (depth % 2 === 0) {
+            marked.add(nodes[i]);
+        }
+        checksum += depth;
+    }
+    for (i = 0; i < count; i += 5) {
+        if (marked.has(nodes[i])) {
+            checksum++;
+        }
+    }
+    return checksum;
+}
+
+function run() {
+    var checksum = 0;
+    checksum += countWords(20000);
+    checksum += integerIndex(20000);
+    checksum += dedupe(20000);
+    checksum += mutateWhileIterating(5000);
+    checksum += objectKeys(5000);
+    if (checksum != EXPECTED_CHECKSUM) {
+        throw new Error("Collections: checksum " + checksum);
+    }
+}
@@ -0,0 +1,81 @@
+// Exceptions: throwing and catching values across frames, with and without Error objects, and
+// running finally blocks on both normal and abrupt completion. Exercises the unwinder and Error
+// construction.
+
+var EXPECTED_SUM = 2291584;
+
+function thrower(depth, value) {
+    if (depth == 0) {
+        throw value;
+    }
+    return thrower(depth - 1, value) + 1;
+}
+
+function withFinally(n, counter) {
+    try {
+        if (n % 3 == 0) {
+            throw n;
+        }
+        return n;
+    } finally {
+        counter.finallyCount++;
+    }
+}
+
+function run() {
+    var sum = 0;
+
+    // Throw a primitive and catch it in the same frame
+    for (var i = 0; i < 2000; i++) {
+        try {
+            throw i;
+        } catch (e) {
+            sum = sum + e;
+        }
+    }
+
+    // Unwind through several frames
+    for (i = 0; i < 500; i++) {
+        try {
+            thrower(10, i);
+        } catch (e) {
+            sum = sum + e;
+        }
+    }
+
+    // Construct and throw Error objects
+    for (i = 0; i < 500; i++) {
+        try {
+            throw new TypeError("failure " + i);
+        } catch (e) {
+            if (e instanceof TypeError) {
+                sum = sum + 1;
+            }
+        }
+    }
+
+    // Finally blocks on normal and abrupt completion
+    var counter = { finallyCount: 0 };
+    for (i = 0; i < 1000; i++) {
+        try {
+            sum = sum + withFinally(i, counter);
+        } catch (e) {
+            sum = sum - e;
+        }
+    }
+    sum = sum + counter.finallyCount;
+
+    // Errors raised by the engine
+    for (i = 0; i < 500; i++) {
+        try {
+            var missing = null;
+            missing.property = i;
+        } catch (e) {
+            sum = sum + 1;
+        }
+    }
+
+    if (sum != EXPECTED_SUM) {
+        throw new Error("Exceptions: sum " + sum);
+    }
+}
@@ -0,0 +1,77 @@
+// Generators: suspension and resumption of generator functions, consumed both by calling next
+// directly and by for-of, including delegation through nested generators. Exercises generator
+// object creation, context switches and the iterator protocol.
+
+var EXPECTED_SUM = 15218774;
+
+function* range(start, end) {
+    for (var i = start; i < end; i++) {
+        yield i;
+    }
+}
+
+function* fibonacci() {
+    var a = 0, b = 1;
+    while (true) {
+        yield a;
+        var next = a + b;
+        a = b;
+        b = next;
+    }
+}
+
+function* filterEven(source) {
+    for (var value of source) {
+        if (value % 2 == 0) {
+            yield value;
+        }
+    }
+}
+
+function* tree(depth) {
+    if (depth == 0) {
+        yield 1;
+        return;
+    }
+    for (var value of tree(depth - 1)) {
+        yield value;
+    }
+    for (value of tree(depth - 1)) {
+        yield value;
+    }
+}
+
+function run() {
+    var sum = 0;
+
+    // Consume with for-of
+    for (var value of range(0, 5000)) {
+        sum = sum + value;
+    }
+
+    // Consume an infinite generator with next
+    var fib = fibonacci();
+    for (var i = 0; i < 30; i++) {
+        sum = sum + fib.next().value;
+    }
+
+    // Chained generators
+    for (value of filterEven(range(0, 2000))) {
+        sum = sum + value;
+    }
+
+    // Generators created recursively
+    for (value of tree(8)) {
+        sum = sum + value;
+    }
+
+    // Many short-lived generators
+    for (i = 0; i < 500; i++) {
+        var g = range(i, i + 3);
+        sum = sum + g.next().value + g.next().value + g.next().value;
+    }
+
+    if (sum != EXPECTED_SUM) {
+        throw new Error("Generators: sum " + sum);
+    }
+}
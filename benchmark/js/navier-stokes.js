@@ -0,0 +1,216 @@
+// NavierStokes-lite: a reduced version of Oliver Hunt's 2D fluid solver from the V8 benchmark
+// suite, on a 64x64 grid. Exercises floating point arithmetic and indexed element access in tight
+// loops.
+
+var SIZE = 64;
+var ITERATIONS = 20;
+var EXPECTED_CHECKSUM = 14276;
+
+function FluidField(width, height) {
+    this.width = width;
+    this.height = height;
+    this.rowSize = width + 2;
+    this.size = (width + 2) * (height + 2);
+    this.dt = 0.1;
+    this.iterations = ITERATIONS;
+    this.dens = this.newField();
+    this.densPrev = this.newField();
+    this.u = this.newField();
+    this.uPrev = this.newField();
+    this.v = this.newField();
+    this.vPrev = this.newField();
+}
+
+FluidField.prototype.newField = function () {
+    var field = new Array(this.size);
+    for (var i = 0; i < this.size; i++) {
+        field[i] = 0;
+    }
+    return field;
+};
+
+FluidField.prototype.addFields = function (x, s, dt) {
+    for (var i = 0; i < this.size; i++) {
+        x[i] = x[i] + dt * s[i];
+    }
+};
+
+FluidField.prototype.setBoundary = function (b, x) {
+    var width = this.width, height = this.height, rowSize = this.rowSize;
+    var i, j;
+    if (b == 1) {
+        for (i = 1; i <= width; i++) {
+            x[i] = x[i + rowSize];
+            x[i + (height + 1) * rowSize] = x[i + height * rowSize];
+        }
+        for (j = 1; j <= height; j++) {
+            x[j * rowSize] = -x[1 + j * rowSize];
+            x[(width + 1) + j * rowSize] = -x[width + j * rowSize];
+        }
+    } else if (b == 2) {
+        for (i = 1; i <= width; i++) {
+            x[i] = -x[i + rowSize];
+            x[i + (height + 1) * rowSize] = -x[i + height * rowSize];
+        }
+        for (j = 1; j <= height; j++) {
+            x[j * rowSize] = x[1 + j * rowSize];
+            x[(width + 1) + j * rowSize] = x[width + j * rowSize];
+        }
+    } else {
+        for (i = 1; i <= width; i++) {
+            x[i] = x[i + rowSize];
+            x[i + (height + 1) * rowSize] = x[i + height * rowSize];
+        }
+        for (j = 1; j <= height; j++) {
+            x[j * rowSize] = x[1 + j * rowSize];
+            x[(width + 1) + j * rowSize] = x[width + j * rowSize];
+        }
+    }
+    var maxEdge = (height + 1) * rowSize;
+    x[0] = 0.5 * (x[1] + x[rowSize]);
+    x[maxEdge] = 0.5 * (x[1 + maxEdge] + x[height * rowSize]);
+    x[width + 1] = 0.5 * (x[width] + x[width + 1 + rowSize]);
+    x[width + 1 + maxEdge] = 0.5 * (x[width + maxEdge] + x[width + 1 + height * rowSize]);
+};
+
+FluidField.prototype.linearSolve = function (b, x, x0, a, c) {
+    var width = this.width, height = this.height, rowSize = this.rowSize;
+    var invC = 1 / c;
+    for (var k = 0; k < this.iterations; k++) {
+        for (var j = 1; j <= height; j++) {
+            var lastRow = (j - 1) * rowSize;
+            var currentRow = j * rowSize;
+            var nextRow = (j + 1) * rowSize;
+            var lastX = x[currentRow];
+            ++currentRow;
+            for (var i = 1; i <= width; i++) {
+                lastX = x[currentRow] = (x0[currentRow] + a * (lastX + x[++currentRow] + x[++lastRow] + x[++nextRow])) * invC;
+            }
+        }
+        this.setBoundary(b, x);
+    }
+};
+
+FluidField.prototype.diffuse = function (b, x, x0, dt) {
+    this.linearSolve(b, x, x0, 0, 1);
+};
+
+FluidField.prototype.advect = function (b, d, d0, u, v, dt) {
+    var width = this.width, height = this.height, rowSize = this.rowSize;
+    var wdt0 = dt * width;
+    var hdt0 = dt * height;
+    var wp5 = width + 0.5;
+    var hp5 = height + 0.5;
+    for (var j = 1; j <= height; j++) {
+        var pos = j * rowSize;
+        for (var i = 1; i <= width; i++) {
+            var x = i - wdt0 * u[++pos];
+            var y = j - hdt0 * v[pos];
+            if (x < 0.5) x = 0.5;
+            else if (x > wp5) x = wp5;
+            var i0 = Math.floor(x);
+            var i1 = i0 + 1;
+            if (y < 0.5) y = 0.5;
+            else if (y > hp5) y = hp5;
+            var j0 = Math.floor(y);
+            var j1 = j0 + 1;
+            var s1 = x - i0;
+            var s0 = 1 - s1;
+            var t1 = y - j0;
+            var t0 = 1 - t1;
+            var row1 = j0 * rowSize;
+            var row2 = j1 * rowSize;
+            d[pos] = s0 * (t0 * d0[i0 + row1] + t1 * d0[i0 + row2]) + s1 * (t0 * d0[i1 + row1] + t1 * d0[i1 + row2]);
+        }
+    }
+    this.setBoundary(b, d);
+};
+
+FluidField.prototype.project = function (u, v, p, div) {
+    var width = this.width, height = this.height, rowSize = this.rowSize;
+    var h = -0.5 / Math.sqrt(width * height);
+    for (var j = 1; j <= height; j++) {
+        var row = j * rowSize;
+        var previousRow = (j - 1) * rowSize;
+        var prevValue = row - 1;
+        var currentRow = row;
+        var nextValue = row + 1;
+        var nextRow = (j + 1) * rowSize;
+        for (var i = 1; i <= width; i++) {
+            div[++currentRow] = h * (u[++nextValue] - u[++prevValue] + v[++nextRow] - v[++previousRow]);
+            p[currentRow] = 0;
+        }
+    }
+    this.setBoundary(0, div);
+    this.setBoundary(0, p);
+
+    this.linearSolve(0, p, div, 1, 4);
+    var wScale = 0.5 * width;
+    var hScale = 0.5 * height;
+    for (j = 1; j <= height; j++) {
+        var prevPos = j * rowSize - 1;
+        var currentPos = j * rowSize;
+        var nextPos = j * rowSize + 1;
+        var prevRow = (j - 1) * rowSize;
+        var currentRow2 = j * rowSize;
+        var nextRow2 = (j + 1) * rowSize;
+        for (i = 1; i <= width; i++) {
+            u[++currentPos] = u[currentPos] - wScale * (p[++nextPos] - p[++prevPos]);
+            v[currentPos] = v[currentPos] - hScale * (p[++nextRow2] - p[++prevRow]);
+        }
+    }
+    this.setBoundary(1, u);
+    this.setBoundary(2, v);
+};
+
+FluidField.prototype.densityStep = function () {
+    this.addFields(this.dens, this.densPrev, this.dt);
+    this.diffuse(0, this.densPrev, this.dens, this.dt);
+    this.advect(0, this.dens, this.densPrev, this.u, this.v, this.dt);
+};
+
+FluidField.prototype.velocityStep = function () {
+    this.addFields(this.u, this.uPrev, this.dt);
+    this.addFields(this.v, this.vPrev, this.dt);
+    var temp = this.uPrev; this.uPrev = this.u; this.u = temp;
+    this.diffuse(1, this.u, this.uPrev, this.dt);
+    temp = this.vPrev; this.vPrev = this.v; this.v = temp;
+    this.diffuse(2, this.v, this.vPrev, this.dt);
+    this.project(this.u, this.v, this.uPrev, this.vPrev);
+    temp = this.uPrev; this.uPrev = this.u; this.u = temp;
+    temp = this.vPrev; this.vPrev = this.v; this.v = temp;
+    this.advect(1, this.u, this.uPrev, this.uPrev, this.vPrev, this.dt);
+    this.advect(2, this.v, this.vPrev, this.uPrev, this.vPrev, this.dt);
+    this.project(this.u, this.v, this.uPrev, this.vPrev);
+};
+
+FluidField.prototype.update = function () {
+    // Inject density and velocity at the centre of the grid
+    for (var i = 0; i < this.size; i++) {
+        this.densPrev[i] = 0;
+        this.uPrev[i] = 0;
+        this.vPrev[i] = 0;
+    }
+    var centre = (this.height / 2 + 1) * this.rowSize + this.width / 2 + 1;
+    this.densPrev[centre] = 50;
+    this.uPrev[centre] = 2;
+    this.vPrev[centre] = 3;
+    this.velocityStep();
+    this.densityStep();
+};
+
+function run() {
+    var field = new FluidField(SIZE, SIZE);
+    for (var frame = 0; frame < 5; frame++) {
+        field.update();
+    }
+    var sum = 0;
+    for (var i = 0; i < field.size; i++) {
+        sum = sum + field.dens[i];
+    }
+    // Checksum of the density field, rounded so it does not depend on summation order
+    var checksum = Math.round(sum * 1000);
+    if (checksum != EXPECTED_CHECKSUM) {
+        throw new Error("NavierStokes: checksum " + checksum);
+    }
+}
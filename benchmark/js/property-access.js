@@ -0,0 +1,67 @@
+// Property access: loads and stores of named properties on objects sharing a constructor, on
+// object literals, through the prototype chain and with computed keys. Exercises property lookup
+// and the shape of ordinary objects.
+
+var EXPECTED_SUM = 2303900;
+
+function Point(x, y) {
+    this.x = x;
+    this.y = y;
+}
+
+Point.prototype.scale = 2;
+
+Point.prototype.lengthSquared = function () {
+    return this.x * this.x + this.y * this.y;
+};
+
+function run() {
+    var points = new Array(100);
+    for (var i = 0; i < points.length; i++) {
+        points[i] = new Point(i, i + 1);
+    }
+
+    // Own properties of objects created by the same constructor
+    var sum = 0;
+    for (var round = 0; round < 50; round++) {
+        for (i = 0; i < points.length; i++) {
+            var p = points[i];
+            p.x = p.x + 1;
+            sum = sum + p.x + p.y;
+        }
+    }
+
+    // Properties inherited from the prototype, and a method call
+    for (i = 0; i < points.length; i++) {
+        sum = sum + points[i].scale + points[i].lengthSquared();
+    }
+
+    // Object literals with different property orders
+    var literals = new Array();
+    for (i = 0; i < 100; i++) {
+        if (i % 2 == 0) {
+            literals[literals.length] = { a: i, b: 1, c: 2 };
+        } else {
+            literals[literals.length] = { c: 2, b: 1, a: i };
+        }
+    }
+    for (round = 0; round < 50; round++) {
+        for (i = 0; i < literals.length; i++) {
+            sum = sum + literals[i].a + literals[i].b + literals[i].c;
+        }
+    }
+
+    // Computed keys
+    var keys = ["alpha", "beta", "gamma", "delta", "epsilon"];
+    var dict = {};
+    for (i = 0; i < keys.length; i++) {
+        dict[keys[i]] = i;
+    }
+    for (round = 0; round < 1000; round++) {
+        sum = sum + dict[keys[round % keys.length]];
+    }
+
+    if (sum != EXPECTED_SUM) {
+        throw new Error("Property access: sum " + sum);
+    }
+}
@@ -0,0 +1,62 @@
+// Regular expressions: parsing generated log lines with captures, global replacement with strings
+// and functions, splitting and counting matches. Exercises compilation caching, prefix scans,
+// backtracking with captures and the RegExp methods of String.prototype.
+
+var EXPECTED_CHECKSUM = 534411;
+
+function makeLog(count) {
+    var levels = ["INFO", "WARN", "ERROR", "DEBUG"];
+    var lines = new Array();
+    for (var i = 0; i < count; i++) {
+        lines[lines.length] = "2016-0" + (i % 9 + 1) + "-1" + (i % 10) + " " + levels[i % 4] +
+            " [worker-" + (i % 7) + "] request id=" + (i * 7919 % 100000) + " took " + (i % 250) + "ms";
+    }
+    return lines.join("\n");
+}
+
+function run() {
+    var log = makeLog(1500);
+    var checksum = 0;
+
+    var lines = log.split(/\n/);
+    var line = /^(\d{4})-(\d\d)-(\d\d) (INFO|WARN|ERROR|DEBUG) \[worker-(\d+)\] .*?id=(\d+) took (\d+)ms$/;
+    for (var i = 0; i < lines.length; i++) {
+        var m = line.exec(lines[i]);
+        if (m[4] === "ERROR") {
+            checksum += +m[6] % 1000;
+        }
+        checksum += +m[7] + +m[5];
+    }
+
+    var slow = log.match(/took [12]\d\dms/g);
+    checksum += slow.length;
+
+    var masked = log.replace(/id=\d+/g, "id=***");
+    checksum += masked.length;
+
+    var renamed = log.replace(/\[worker-(\d)\]/g, function (all, n) {
+        return "<" + (n * 2) + ">";
+    });
+    checksum += renamed.length;
+
+    var swapped = log.replace(/(\d{4})-(\d\d)-(\d\d)/g, "$3/$2/$1");
+    checksum += swapped.indexOf("10/01/2016");
+
+    var words = 0;
+    var word = /\b[a-z]+\b/gi;
+    while (word.exec(lines[3]) !== null) {
+        words++;
+    }
+    checksum += words * 100;
+
+    for (i = 0; i < lines.length; i++) {
+        if (/WARN|ERROR/.test(lines[i])) {
+            checksum++;
+        }
+    }
+    checksum += log.search(/worker-6/);
+
+    if (checksum != EXPECTED_CHECKSUM) {
+        throw new Error("Regular expressions: checksum " + checksum);
+    }
+}
@@ -0,0 +1,78 @@
+// Array sorting: records by a numeric field with a comparison function, which must be stable,
+// small integers and strings with the default comparison, and input that is already mostly in order.
+// Inputs come from a fixed pseudo-random sequence.
+
+var EXPECTED_CHECKSUM = 140759;
+
+var seed = 1;
+
+function random() {
+    // Park-Miller minimal standard generator
+    seed = (seed * 16807) % 2147483647;
+    return seed;
+}
+
+function checkSorted(array, less) {
+    for (var i = 1; i < array.length; i++) {
+        if (less(array[i], array[i - 1])) {
+            throw new Error("Not sorted at " + i);
+        }
+    }
+}
+
+function run() {
+    seed = 1;
+    var checksum = 0;
+
+    // Records with many equal keys, sorted with a comparison function. Equal keys keep their order
+    var records = [];
+    for (var i = 0; i < 5000; i++) {
+        records.push({ key: random() % 100, index: i });
+    }
+    records.sort(function (a, b) {
+        return a.key - b.key;
+    });
+    checkSorted(records, function (a, b) {
+        return a.key < b.key || (a.key === b.key && a.index < b.index);
+    });
+    checksum = (checksum + records[0].index + records[2500].index + records[4999].index) % 1000003;
+
+    // Small integers, compared as strings by default
+    var numbers = [];
+    for (i = 0; i < 5000; i++) {
+        numbers.push(random() % 100000 - 50000);
+    }
+    numbers.sort();
+    checkSorted(numbers, function (a, b) {
+        return String(a) < String(b);
+    });
+    checksum = (checksum + numbers[0] + numbers[1234] + numbers[4999] + 150000) % 1000003;
+
+    // Strings
+    var strings = [];
+    for (i = 0; i < 3000; i++) {
+        strings.push("item" + (random() % 10000));
+    }
+    strings.sort();
+    checkSorted(strings, function (a, b) {
+        return a < b;
+    });
+    checksum = (checksum + strings[1500].length * 7 + strings[0].length) % 1000003;
+
+    // Mostly ascending runs with a few elements out of place, with a numeric comparison
+    var runs = [];
+    for (i = 0; i < 5000; i++) {
+        runs.push(i % 7 === 0 ? random() % 5000 : i);
+    }
+    runs.sort(function (a, b) {
+        return a - b;
+    });
+    checkSorted(runs, function (a, b) {
+        return a < b;
+    });
+    checksum = (checksum + runs[100] + runs[2500] + runs[4900]) % 1000003;
+
+    if (checksum != EXPECTED_CHECKSUM) {
+        throw new Error("Sort: checksum " + checksum);
+    }
+}
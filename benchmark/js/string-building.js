@@ -0,0 +1,45 @@
+// String building: repeated concatenation of short strings and numbers, both by appending to a
+// single string and by joining pieces pairwise. Exercises string concatenation, number to string
+// conversion and string comparison.
+
+function appendAll(count) {
+    var result = "";
+    for (var i = 0; i < count; i++) {
+        result = result + "item" + i + ";";
+    }
+    return result;
+}
+
+function joinPairwise(pieces) {
+    while (pieces.length > 1) {
+        var next = new Array();
+        for (var i = 0; i + 1 < pieces.length; i = i + 2) {
+            next[next.length] = pieces[i] + pieces[i + 1];
+        }
+        if (pieces.length % 2 == 1) {
+            next[next.length] = pieces[pieces.length - 1];
+        }
+        pieces = next;
+    }
+    return pieces[0];
+}
+
+function run() {
+    var appended = appendAll(2000);
+
+    var pieces = new Array();
+    for (var i = 0; i < 2000; i++) {
+        pieces[pieces.length] = "item" + i + ";";
+    }
+    var joined = joinPairwise(pieces);
+
+    var mixed = "";
+    for (i = 0; i < 1000; i++) {
+        mixed += i * 0.5;
+        mixed += "|";
+    }
+
+    if (appended.length != 16890 || joined != appended || mixed.length != 4780) {
+        throw new Error("String building: lengths " + appended.length + ", " + joined.length + ", " + mixed.length);
+    }
+}
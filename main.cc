@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "norlit/gc/Heap.h"
 #include "norlit/gc/Handle.h"
@@ -21,6 +22,7 @@
 
 #include "norlit/util/HashMap.h"
 #include "norlit/util/ArrayList.h"
+#include "norlit/util/ScopeExit.h"
 
 #include "norlit/js/grammar/Scanner.h"
 #include "norlit/js/grammar/Parser.h"
@@ -30,10 +32,13 @@
 
 #include "norlit/js/bytecode/Emitter.h"
 #include "norlit/js/bytecode/Code.h"
+#include "norlit/js/bytecode/BackgroundCompiler.h"
 
 #include "norlit/js/vm/Realm.h"
 #include "norlit/js/vm/Context.h"
 #include "norlit/js/vm/Environment.h"
+#include "norlit/js/vm/Profiler.h"
+#include "norlit/js/vm/OpcodeStats.h"
 
 #include "norlit/js/Exception.h"
 
@@ -107,29 +112,44 @@ struct ReferenceDumper : public HeapIterator, public FieldIterator {
 #include "norlit/js/grammar/Node.h"
 
 int main(int argc, char* argv[]) {
-    std::string text;
-    Optional<std::ifstream> file;
-    std::istream* target;
-    if (argc >= 2) {
-        file = std::ifstream{ argv[1] };
-        target = &*file;
-    } else {
-        file = std::ifstream{ "test.js" };
-        target = &*file;
-        //target = &std::cin;
-    }
-    if (!*target) {
-        printf("Cannot open file.\n");
-        return 1;
+    std::vector<std::string> paths;
+    // --prof=<file> writes a sampled CPU profile of the scripts in collapsed stack format
+    std::string profilePath;
+#ifdef NORLIT_OPCODE_STATS
+    // --opcode-stats=<file> writes per-opcode counts and cycles, --trace=<file> a binary trace of
+    // every instruction and --print-trace=<file> prints such a trace
+    std::string statsPath;
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--prof=", 7) == 0) {
+            profilePath = argv[i] + 7;
+            continue;
+        }
+#ifdef NORLIT_OPCODE_STATS
+        if (strncmp(argv[i], "--opcode-stats=", 15) == 0) {
+            statsPath = argv[i] + 15;
+            continue;
+        }
+        if (strncmp(argv[i], "--trace=", 8) == 0) {
+            if (!OpcodeStats::StartTrace(argv[i] + 8)) {
+                printf("Cannot write trace %s.\n", argv[i] + 8);
+                return 1;
+            }
+            continue;
+        }
+        if (strncmp(argv[i], "--print-trace=", 14) == 0) {
+            return OpcodeStats::PrintTrace(argv[i] + 14) ? 0 : 1;
+        }
+#endif
+        paths.push_back(argv[i]);
     }
-
-
-    while (!target->eof()) {
-        std::string buffer;
-        std::getline(*target, buffer);
-        text += buffer;
-        text += "\n";
+    if (paths.empty()) {
+        paths.push_back("test.js");
     }
+    // Code compiled by a previous run is reused when a cache directory is given
+    const char* cacheDirectory = getenv("NORLIT_CODE_CACHE");
+    // Scripts are read and decoded on worker threads while earlier ones are compiled and run
+    BackgroundCompiler compiler(paths, cacheDirectory ? cacheDirectory : "");
 
     Handle<Realm> realm = new Realm();
 
@@ -137,20 +157,6 @@ int main(int argc, char* argv[]) {
         Handle<Context> guard = new Context(realm, nullptr, nullptr);
         Context::PushContext(guard);
 
-        Scanner lex(JSString::NewFromCString(text.c_str()));
-        Parser gram{ lex };
-        Handle<Script> expr = gram.ParseScript();
-
-        //printf("---AST---\n");
-        //expr->Dump(0);
-
-        //printf("\n---Bytecode---\n");
-        Emitter e;
-        expr->Codegen(e);
-        Handle<Code> c = e.ToCode();
-        //c->Dump();
-        //printf("\n");
-
         Handle<JSObject> global = realm->GetGlobalObject();
         {
             Handle<ESNativeFunction> func = new ESNativeFunction(realm->FunctionPrototype(), realm,
@@ -177,10 +183,34 @@ int main(int argc, char* argv[]) {
         }
         Objects::Set(global, JSString::New("version"), JSString::New("NorlitJS Engine V0.0.1"), true);
         Handle<GlobalEnvironment> genv = realm->GetGlobalEnvironment();
-        Handle<BytecodeContext> ctx = new BytecodeContext(genv, genv, realm, nullptr, c);
-        Context::PopContext(); // Pop the guard
-        Context::PushContext(ctx);
-        ctx->Run();
+        if (!profilePath.empty()) {
+            Profiler::Start();
+        }
+        for (size_t i = 0; i < compiler.Size(); i++) {
+            Handle<Code> c = compiler.Finish(i);
+            if (!c) {
+                printf("Cannot open file %s.\n", paths[i].c_str());
+                return 1;
+            }
+            //c->Dump();
+            Handle<BytecodeContext> ctx = new BytecodeContext(genv, genv, realm, nullptr, c);
+            Context::PushContext(ctx);
+            NORLIT_SCOPE_EXIT{ Context::PopContext(); };
+            ctx->Run();
+        }
+        if (!profilePath.empty()) {
+            Profiler::Stop();
+            if (!Profiler::WriteCollapsed(profilePath)) {
+                printf("Cannot write profile %s.\n", profilePath.c_str());
+            }
+            Profiler::Reset();
+        }
+#ifdef NORLIT_OPCODE_STATS
+        OpcodeStats::StopTrace();
+        if (!statsPath.empty() && !OpcodeStats::WriteReport(statsPath)) {
+            printf("Cannot write opcode statistics %s.\n", statsPath.c_str());
+        }
+#endif
         return 0;
     } catch (const char* error) {
         printf("%s\n", error);
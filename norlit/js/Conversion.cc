@@ -353,15 +353,22 @@ int64_t Conversion::ToIntegerValue(const Handle<JSNumber>& num) {
 }
 
 int32_t Conversion::ToInt32(const Handle<JSNumber>& num) {
-    double val = num->Value();
+    return ToInt32(num->Value());
+}
+
+uint32_t Conversion::ToUInt32(const Handle<JSNumber>& num) {
+    return static_cast<uint32_t>(ToInt32(num));
+}
+
+int32_t Conversion::ToInt32(double val) {
     if (std::isnan(val) || std::isinf(val)) {
         return 0;
     }
     return static_cast<int32_t>(static_cast<int64_t>(val));
 }
 
-uint32_t Conversion::ToUInt32(const Handle<JSNumber>& num) {
-    return static_cast<uint32_t>(ToInt32(num));
+uint32_t Conversion::ToUInt32(double val) {
+    return static_cast<uint32_t>(ToInt32(val));
 }
 
 int64_t Conversion::ToIntegerIndex(const Handle<JSString>& str) {
@@ -384,7 +391,11 @@ int64_t Conversion::ToIntegerIndex(const Handle<JSPropertyKey>& key) {
 }
 
 int64_t Conversion::ToLength(const Handle<JSNumber>& argument) {
-    if (std::isnan(argument->Value())) {
+    double val = argument->Value();
+    if (std::isnan(val) || val <= 0) {
+        return 0;
+    }
+    if (val >= 0x1FFFFFFFFFFFFFLL) {
         return 0x1FFFFFFFFFFFFFLL;
     }
     int64_t ret = ToIntegerValue(argument);
@@ -32,6 +32,8 @@ class Conversion {
     static int64_t ToIntegerValue(const gc::Handle<JSNumber>&);
     static int32_t ToInt32(const gc::Handle<JSNumber>&);
     static uint32_t ToUInt32(const gc::Handle<JSNumber>&);
+    static int32_t ToInt32(double);
+    static uint32_t ToUInt32(double);
 
     static int64_t ToIntegerIndex(const gc::Handle<JSString>&);
     static int64_t ToIntegerIndex(const gc::Handle<JSPropertyKey>&);
@@ -25,7 +25,19 @@ class ESException {
     }
 };
 
+// Thrown in place of errors raised on a thread that may not touch the heap, where no error object
+// can be created. The work is done again on the thread running the engine to raise the actual error
+class OffHeapError {};
+
 struct Exceptions {
+    // While alive, errors raised on the current thread are thrown as OffHeapError
+    class OffHeapScope {
+        bool saved;
+      public:
+        OffHeapScope();
+        ~OffHeapScope();
+    };
+
     NORLIT_NORETURN static void ThrowIncompatibleReceiverTypeError(const char* name);
     NORLIT_NORETURN static void ThrowTypeError(const char* name);
     NORLIT_NORETURN static void ThrowSyntaxError(const char* name);
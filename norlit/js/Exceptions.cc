@@ -12,7 +12,26 @@ using namespace norlit::js::vm;
 using namespace norlit::js::object;
 using namespace norlit::util;
 
+namespace {
+thread_local bool offHeap = false;
+
+void CheckOnHeap() {
+    if (offHeap) {
+        throw OffHeapError();
+    }
+}
+}
+
+Exceptions::OffHeapScope::OffHeapScope() :saved(offHeap) {
+    offHeap = true;
+}
+
+Exceptions::OffHeapScope::~OffHeapScope() {
+    offHeap = saved;
+}
+
 void Exceptions::ThrowIncompatibleReceiverTypeError(const char* name) {
+    CheckOnHeap();
     Handle<JSString> msg = JSString::Concat(JSString::New(name), JSString::New(" called on incompatible receiver"));
     Handle<JSObject> error = Objects::Construct(Context::CurrentRealm()->TypeError(), Arrays::ToArray<JSValue>(msg));
 
@@ -20,6 +39,7 @@ void Exceptions::ThrowIncompatibleReceiverTypeError(const char* name) {
 }
 
 void Exceptions::ThrowTypeError(const char* name) {
+    CheckOnHeap();
     Handle<JSString> msg = JSString::New(name);
     Handle<JSObject> error = Objects::Construct(Context::CurrentRealm()->TypeError(), Arrays::ToArray<JSValue>(msg));
 
@@ -27,6 +47,7 @@ void Exceptions::ThrowTypeError(const char* name) {
 }
 
 void Exceptions::ThrowSyntaxError(const char* name) {
+    CheckOnHeap();
     Handle<JSString> msg = JSString::New(name);
     Handle<JSObject> error = Objects::Construct(Context::CurrentRealm()->SyntaxError(), Arrays::ToArray<JSValue>(msg));
 
@@ -34,6 +55,7 @@ void Exceptions::ThrowSyntaxError(const char* name) {
 }
 
 void Exceptions::ThrowRangeError(const char* name) {
+    CheckOnHeap();
     Handle<JSString> msg = JSString::New(name);
     Handle<JSObject> error = Objects::Construct(Context::CurrentRealm()->RangeError(), Arrays::ToArray<JSValue>(msg));
 
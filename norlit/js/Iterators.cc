@@ -1,8 +1,11 @@
 #include "all.h"
 
 #include "vm/Context.h"
+#include "object/Exotics.h"
 
 #include "../util/Arrays.h"
+#include "../util/ScopeExit.h"
+#include "../util/HashMap.h"
 
 using namespace norlit::gc;
 using namespace norlit::js;
@@ -10,6 +13,31 @@ using namespace norlit::js::object;
 using namespace norlit::js::vm;
 using namespace norlit::util;
 
+namespace {
+// Check that next resolves to the built-in method of intrinsic, i.e. no object on the prototype chain before
+// intrinsic shadows it, and intrinsic itself is not modified since creation of the realm.
+// Only ordinary objects are inspected, so the check never runs user code such as proxy traps.
+bool HasIntactNext(const Handle<JSObject>& obj, const Handle<JSObject>& intrinsic) {
+    static Handle<JSString> next = JSString::New("next");
+    JSObject* p = obj;
+    // Generator objects have the prototype of the generator function in between
+    for (int depth = 0; depth < 3 && p; depth++) {
+        JSOrdinaryObject* ordinary = dynamic_cast<JSOrdinaryObject*>(p);
+        if (!ordinary) {
+            return false;
+        }
+        if (p == intrinsic) {
+            return ordinary->IsWatchIntact();
+        }
+        if (ordinary->HasStoredProperty(next)) {
+            return false;
+        }
+        p = ordinary->GetPrototypeOf();
+    }
+    return false;
+}
+}
+
 Handle<JSObject> Iterators::GetIterator(const Handle<JSValue>& obj, const Handle<JSObject>& method) {
     Handle<JSValue> iterator = Objects::Call(method, obj);
     if (!Testing::Is<JSObject>(iterator)) {
@@ -54,9 +82,203 @@ Handle<JSObject> Iterators::IteratorStep(const Handle<JSObject>& iterator) {
     return result;
 }
 
+void Iterators::IteratorClose(const Handle<JSObject>& iterator) {
+    Handle<JSObject> returnMethod = Objects::GetMethod(iterator, "return");
+    if (!returnMethod) {
+        return;
+    }
+    Handle<JSValue> innerResult = Objects::Call(returnMethod, iterator);
+    if (!Testing::Is<JSObject>(innerResult)) {
+        Exceptions::ThrowTypeError("Iteration result must be object");
+    }
+}
+
 Handle<JSObject> Iterators::CreateIterResultObject(const Handle<JSValue>& value, bool done) {
     Handle<JSObject> obj = Objects::ObjectCreate(Context::CurrentRealm()->ObjectPrototype());
     Objects::CreateDataProperty(obj, "value", value);
     Objects::CreateDataProperty(obj, "done", JSBoolean::New(done));
     return obj;
-}
\ No newline at end of file
+}
+Handle<JSObject> Iterators::EnumerateObjectProperties(const Handle<JSValue>& value) {
+    Handle<ForInIteratorObject> iterator = Objects::ObjectCreate<ForInIteratorObject>(nullptr);
+    iterator->enumerateNextIndex(0);
+    if (!value || value->GetType() == JSValue::Type::kNull) {
+        return iterator;
+    }
+    ArrayList<JSPropertyKey> keys;
+    Handle<JSObject> O = Conversion::ToObject(value);
+    Handle<JSObject> proto = O;
+    Handle<HashMap<JSPropertyKey, JSPropertyKey>> visited = new HashMap<JSPropertyKey, JSPropertyKey>();
+    while (proto) {
+        Handle<Array<JSPropertyKey>> ownKeys = proto->OwnPropertyKeys();
+        for (Handle<JSPropertyKey> key : ownKeys->GetIterable()) {
+            if (!Testing::Is<JSString>(key) || visited->Get(key)) {
+                continue;
+            }
+            // Non-enumerable properties still shadow those on the prototype chain
+            visited->Put(key, key);
+            Optional<PropertyDescriptor> desc = proto->GetOwnProperty(key);
+            if (desc && *desc->enumerable) {
+                keys.Add(key);
+            }
+        }
+        proto = proto->GetPrototypeOf();
+    }
+    iterator->enumeratedObject(O);
+    iterator->enumeratedKeys(keys.ToArray());
+    return iterator;
+}
+
+bool Iterators::IteratorStepValue(const Handle<JSObject>& iterator, Handle<JSValue>& value) {
+    if (Handle<ForInIteratorObject> enumerator = iterator.ExactCheckedCastTo<ForInIteratorObject>()) {
+        return !ForInIteratorNext(enumerator, value);
+    } else if (Handle<ArrayIteratorObject> arrayIterator = iterator.ExactCheckedCastTo<ArrayIteratorObject>()) {
+        if (HasIntactNext(arrayIterator, Context::CurrentRealm()->ArrayIteratorPrototype())) {
+            return !ArrayIteratorNext(arrayIterator, value);
+        }
+    } else if (Handle<MapIteratorObject> mapIterator = iterator.ExactCheckedCastTo<MapIteratorObject>()) {
+        if (HasIntactNext(mapIterator, Context::CurrentRealm()->MapIteratorPrototype())) {
+            return !MapIteratorNext(mapIterator, value);
+        }
+    } else if (Handle<SetIteratorObject> setIterator = iterator.ExactCheckedCastTo<SetIteratorObject>()) {
+        if (HasIntactNext(setIterator, Context::CurrentRealm()->SetIteratorPrototype())) {
+            return !SetIteratorNext(setIterator, value);
+        }
+    } else if (Handle<GeneratorObject> generator = iterator.ExactCheckedCastTo<GeneratorObject>()) {
+        if (generator->generatorState() != GeneratorObject::GeneratorState::kExecuting &&
+                HasIntactNext(generator, Context::CurrentRealm()->GeneratorPrototype())) {
+            return !GeneratorResume(generator, nullptr, value);
+        }
+    }
+    Handle<JSObject> result = IteratorStep(iterator);
+    if (!result) {
+        return false;
+    }
+    value = IteratorValue(result);
+    return true;
+}
+
+// Keys are collected when the enumeration starts, and those whose property is deleted before they
+// are reached are skipped
+bool Iterators::ForInIteratorNext(const Handle<ForInIteratorObject>& O, Handle<JSValue>& value) {
+    value = nullptr;
+    Handle<JSObject> object = O->enumeratedObject();
+    if (!object) {
+        return true;
+    }
+    Handle<Array<JSPropertyKey>> keys = O->enumeratedKeys();
+    Handle<JSPropertyKey> key;
+    for (uint32_t index = O->enumerateNextIndex(), length = static_cast<uint32_t>(keys->Length()); index < length; ) {
+        key = keys->Get(index++);
+        O->enumerateNextIndex(index);
+        if (Objects::HasProperty(object, key)) {
+            value = key;
+            return false;
+        }
+    }
+    O->enumeratedObject(nullptr);
+    O->enumeratedKeys(nullptr);
+    return true;
+}
+
+bool Iterators::ArrayIteratorNext(const Handle<ArrayIteratorObject>& O, Handle<JSValue>& value) {
+    value = nullptr;
+    Handle<JSObject> a = O->iteratedObject();
+    if (!a) {
+        return true;
+    }
+    uint32_t index = O->arrayIteratorNextIndex();
+    ArrayIteratorObject::IterationKind itemKind = O->arrayIterationKind();
+    // 8. If a has a[[TypedArrayName]] internal slot, then
+    //     a.Let len be the value of O's [[ArrayLength]] internal slot.
+    // 9. Else,
+    int64_t len = Conversion::ToLength(Objects::Get(a, "length"));
+    if (index >= len) {
+        O->iteratedObject(nullptr);
+        return true;
+    }
+    O->arrayIteratorNextIndex(index + 1);
+    Handle<JSNumber> keyAsNum = JSNumber::New(static_cast<int64_t>(index));
+    if (itemKind == ArrayIteratorObject::IterationKind::kKey) {
+        value = keyAsNum;
+        return false;
+    }
+    Handle<JSValue> elementValue = Objects::Get(a, Conversion::ToString(keyAsNum));
+    if (itemKind == ArrayIteratorObject::IterationKind::kValue) {
+        value = elementValue;
+    } else {
+        value = Objects::CreateArrayFromList(Arrays::ToArray<JSValue>(keyAsNum, elementValue));
+    }
+    return false;
+}
+
+bool Iterators::MapIteratorNext(const Handle<MapIteratorObject>& O, Handle<JSValue>& value) {
+    value = nullptr;
+    Handle<OrderedHashTable> table = O->iteratedTable();
+    if (!table) {
+        return true;
+    }
+    uint32_t index = O->mapNextIndex();
+    if (!OrderedHashTable::Seek(table, index)) {
+        O->iteratedTable(nullptr);
+        return true;
+    }
+    // Catch up with the current table so replaced ones can be collected
+    O->iteratedTable(table);
+    O->mapNextIndex(index + 1);
+    switch (O->mapIterationKind()) {
+        case MapIteratorObject::IterationKind::kKey:
+            value = table->KeyAt(index);
+            break;
+        case MapIteratorObject::IterationKind::kValue:
+            value = table->ValueAt(index);
+            break;
+        case MapIteratorObject::IterationKind::kBoth:
+            value = Objects::CreateArrayFromList(Arrays::ToArray<JSValue>(table->KeyAt(index), table->ValueAt(index)));
+            break;
+    }
+    return false;
+}
+
+bool Iterators::SetIteratorNext(const Handle<SetIteratorObject>& O, Handle<JSValue>& value) {
+    value = nullptr;
+    Handle<OrderedHashTable> table = O->iteratedTable();
+    if (!table) {
+        return true;
+    }
+    uint32_t index = O->setNextIndex();
+    if (!OrderedHashTable::Seek(table, index)) {
+        O->iteratedTable(nullptr);
+        return true;
+    }
+    O->iteratedTable(table);
+    O->setNextIndex(index + 1);
+    Handle<JSValue> entry = table->KeyAt(index);
+    if (O->setIterationKind() == SetIteratorObject::IterationKind::kBoth) {
+        value = Objects::CreateArrayFromList(Arrays::ToArray<JSValue>(entry, entry));
+    } else {
+        value = entry;
+    }
+    return false;
+}
+
+bool Iterators::GeneratorResume(const Handle<GeneratorObject>& gen, const Handle<JSValue>& value, Handle<JSValue>& result) {
+    if (gen->generatorState() == GeneratorObject::GeneratorState::kCompleted) {
+        result = nullptr;
+        return true;
+    }
+    Handle<BytecodeContext> ctx = gen->generatorContext();
+    gen->generatorState(GeneratorObject::GeneratorState::kExecuting);
+    Context::PushContext(ctx);
+    NORLIT_SCOPE_EXIT{ Context::PopContext(); };
+    ctx->Push(value);
+    BytecodeContext::ReturnStatus status = ctx->Run();
+    result = ctx->Pop();
+    if (status == BytecodeContext::ReturnStatus::kReturn) {
+        gen->generatorState(GeneratorObject::GeneratorState::kCompleted);
+        return true;
+    } else {
+        gen->generatorState(GeneratorObject::GeneratorState::kSuspendedYield);
+        return false;
+    }
+}
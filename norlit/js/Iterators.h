@@ -10,6 +10,14 @@
 namespace norlit {
 namespace js {
 
+namespace object {
+class ArrayIteratorObject;
+class MapIteratorObject;
+class SetIteratorObject;
+class ForInIteratorObject;
+class GeneratorObject;
+}
+
 struct Iterators {
     static gc::Handle<object::JSObject> GetIterator(const gc::Handle<JSValue>&, const gc::Handle<object::JSObject>&);
     static gc::Handle<object::JSObject> GetIterator(const gc::Handle<JSValue>&);
@@ -21,7 +29,27 @@ struct Iterators {
     static gc::Handle<JSValue> IteratorValue(const gc::Handle<object::JSObject>&);
     static gc::Handle<object::JSObject> IteratorStep(const gc::Handle<object::JSObject>&);
 
+    // 7.4.6
+    static void IteratorClose(const gc::Handle<object::JSObject>&);
+
     static gc::Handle<object::JSObject> CreateIterResultObject(const gc::Handle<JSValue>&, bool);
+
+    // 13.7.5.15
+    // Returns an internal enumerator that only IteratorStepValue can step
+    static gc::Handle<object::JSObject> EnumerateObjectProperties(const gc::Handle<JSValue>&);
+
+    // Combination of IteratorStep and IteratorValue. For-in enumerators, and built-in array, map and set iterators and
+    // generators whose next method is unmodified are stepped directly without allocating iterator result objects.
+    // Returns false when the iteration is complete.
+    static bool IteratorStepValue(const gc::Handle<object::JSObject>&, gc::Handle<JSValue>&);
+
+    // Steps of for-in enumeration, %ArrayIteratorPrototype%.next, %MapIteratorPrototype%.next, %SetIteratorPrototype%.next and
+    // GeneratorResume, returning done and storing the value.
+    static bool ForInIteratorNext(const gc::Handle<object::ForInIteratorObject>&, gc::Handle<JSValue>&);
+    static bool ArrayIteratorNext(const gc::Handle<object::ArrayIteratorObject>&, gc::Handle<JSValue>&);
+    static bool MapIteratorNext(const gc::Handle<object::MapIteratorObject>&, gc::Handle<JSValue>&);
+    static bool SetIteratorNext(const gc::Handle<object::SetIteratorObject>&, gc::Handle<JSValue>&);
+    static bool GeneratorResume(const gc::Handle<object::GeneratorObject>&, const gc::Handle<JSValue>&, gc::Handle<JSValue>&);
 };
 
 }
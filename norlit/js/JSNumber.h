@@ -30,9 +30,16 @@ class JSNumber final : public JSPrimitive {
     static gc::Handle<JSNumber> New(int64_t);
     static gc::Handle<JSNumber> New(int32_t);
     static gc::Handle<JSNumber> New(double);
+    // The tagged value New returns for value if it is a small integer, or nullptr. Does not touch the heap
+    static JSNumber* NewSmallInteger(double);
 
     static bool IsNegativeZero(double);
 
+    // Whether the number is stored as a tagged small integer, so reading it does not touch the heap
+    bool IsSmallInteger() const {
+        return JSValue::IsSmallInteger();
+    }
+
     static gc::Handle<JSNumber> NaN();
     static gc::Handle<JSNumber> Infinity();
     static gc::Handle<JSNumber> Zero();
@@ -71,6 +78,14 @@ inline gc::Handle<JSNumber> JSNumber::New(int32_t value) {
     return New(static_cast<int64_t>(value));
 }
 
+inline JSNumber* JSNumber::NewSmallInteger(double value) {
+    int64_t intValue = (int64_t)value;
+    if (intValue != value || IsNegativeZero(value) || intValue > MAX_SMI_VALUE || intValue < MIN_SMI_VALUE) {
+        return nullptr;
+    }
+    return CreateSmallInteger(intValue);
+}
+
 inline gc::Handle<JSNumber> JSNumber::New(double value) {
     int64_t intValue = (int64_t)value;
     if (intValue == value && !IsNegativeZero(value)) {
@@ -1,6 +1,7 @@
 #include "JSString.h"
 #include "../gc/Heap.h"
 #include "../util/HashMap.h"
+#include "../util/StringSearch.h"
 
 #include "grammar/Scanner.h"
 
@@ -45,6 +46,120 @@ void JSString::ConvertUtf8ToUtf16(const char* from, char16_t* to) {
     }
 }
 
+namespace {
+
+class ExternalStringFinalizer;
+
+// Keeps the finalizers of live external strings alive. Each one unlinks itself once it has run
+class ExternalStringFinalizerList : public Object {
+  public:
+    ExternalStringFinalizer* first = nullptr;
+
+    virtual void IterateField(const FieldIterator& iter) override final {
+        iter(&first);
+    }
+};
+
+// Releases the resource of an external string once the string is collected
+class ExternalStringFinalizer : public Object {
+    JSString* target = nullptr;
+    ExternalStringResource* resource;
+    ExternalStringFinalizerList* list = nullptr;
+    ExternalStringFinalizer* prev = nullptr;
+    ExternalStringFinalizer* next = nullptr;
+
+    void Unlink() {
+        if (prev) {
+            prev->WriteBarrier(&prev->next, next);
+        } else {
+            list->WriteBarrier(&list->first, next);
+        }
+        if (next) {
+            next->WriteBarrier(&next->prev, prev);
+        }
+        prev = nullptr;
+        next = nullptr;
+    }
+
+  public:
+    ExternalStringFinalizer(const Handle<JSString>& target, ExternalStringResource* resource, const Handle<ExternalStringFinalizerList>& list): resource(resource) {
+        this->WriteBarrier(&this->target, target);
+        this->WriteBarrier(&this->list, list);
+        this->WriteBarrier(&this->next, list->first);
+        if (next) {
+            next->WriteBarrier(&next->prev, this);
+        }
+        list->WriteBarrier(&list->first, this);
+    }
+
+    virtual void IterateField(const FieldIterator& iter) override final {
+        iter(&target, FieldIterator::weak);
+        iter(&list);
+        iter(&prev);
+        iter(&next);
+    }
+
+    virtual void NotifyWeakReferenceCollected(Object** field) override final {
+        if (field == reinterpret_cast<Object**>(&target) && resource) {
+            if (resource->release) {
+                resource->release(resource->data, resource->userData);
+            }
+            delete resource;
+            resource = nullptr;
+            Unlink();
+        }
+    }
+};
+
+// Decode the UTF-8 sequence at str[i] and advance i past it. Lead bytes that cannot start a sequence,
+// overlong forms, surrogates and truncated sequences decode to U+FFFD, consuming the longest prefix that
+// could have started a valid sequence, or at least one byte
+uint32_t DecodeUtf8Sequence(const unsigned char* str, size_t size, size_t& i) {
+    unsigned char c = str[i++];
+    if (c < 0x80) {
+        return c;
+    }
+    size_t trailing;
+    uint32_t codePoint;
+    // Range of the first continuation byte, narrowed for leads which could otherwise encode overlong
+    // forms, surrogates or code points beyond U+10FFFF
+    unsigned char lower = 0x80;
+    unsigned char upper = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        trailing = 1;
+        codePoint = c & 31;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        trailing = 2;
+        codePoint = c & 15;
+        if (c == 0xE0) {
+            lower = 0xA0;
+        } else if (c == 0xED) {
+            upper = 0x9F;
+        }
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        trailing = 3;
+        codePoint = c & 7;
+        if (c == 0xF0) {
+            lower = 0x90;
+        } else if (c == 0xF4) {
+            upper = 0x8F;
+        }
+    } else {
+        return 0xFFFD;
+    }
+    for (size_t n = 0; n < trailing; n++) {
+        if (i == size || str[i] < lower || str[i] > upper) {
+            return 0xFFFD;
+        }
+        codePoint = (codePoint << 6) | (str[i++] & 63);
+        lower = 0x80;
+        upper = 0xBF;
+    }
+    return codePoint;
+}
+
+}
+
 JSString* JSString::CreateASCIIShortString(size_t length, const char* str) {
     uintptr_t result = 0;
     /* Compact string to uintptr_t */
@@ -144,6 +259,15 @@ JSString::JSString(size_t length, const wchar_t* str) {
     this->hash = hash;
 }
 
+JSString::JSString(ExternalStringResource* resource) {
+    external = resource;
+    uintptr_t hash = 0;
+    for (size_t i = 0, length = resource->length; i < length; i++) {
+        hash = 31 * hash + At(i);
+    }
+    this->hash = hash;
+}
+
 void JSString::IterateField(const FieldIterator& iter) {
     iter(&string);
 }
@@ -185,6 +309,17 @@ Handle<JSString> JSString::New(const char* str) {
 }
 
 Handle<JSString> JSString::New(const wchar_t* str) {
+    if (JSString* shortString = NewShortString(str)) {
+        return shortString;
+    }
+    size_t length = 0;
+    while (str[length]) {
+        length++;
+    }
+    return Intern(new JSString(length, str));
+}
+
+JSString* JSString::NewShortString(const wchar_t* str) {
     size_t length = 0;
     bool ascii = true;
     for (; str[length]; length++) {
@@ -201,7 +336,7 @@ Handle<JSString> JSString::New(const wchar_t* str) {
             return CreateUnicodeShortString(length, str);
         }
     }
-    return Intern(new JSString(length, str));
+    return nullptr;
 }
 
 Handle<JSString> JSString::NewFromCString(const char* str) {
@@ -217,6 +352,70 @@ Handle<JSString> JSString::NewFromCString(const char* str) {
 #endif
 }
 
+size_t JSString::DecodeUTF8(const char* str, size_t size, char16_t* to) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(str);
+    size_t len = 0;
+    for (size_t i = 0; i < size;) {
+        uint32_t codePoint = DecodeUtf8Sequence(bytes, size, i);
+        if (codePoint >= 0x10000) {
+            if (to) {
+                codePoint -= 0x10000;
+                to[len] = 0xD800 | (codePoint >> 10);
+                to[len + 1] = 0xDC00 | (codePoint & 0x3FF);
+            }
+            len += 2;
+        } else {
+            if (to) {
+                to[len] = static_cast<char16_t>(codePoint);
+            }
+            len++;
+        }
+    }
+    return len;
+}
+
+Handle<JSString> JSString::NewExternal(const ExternalStringResource& res) {
+    bool ascii = true;
+    if (res.length <= MAX_ASCII_SHORT_STRING_LENGTH) {
+        for (size_t i = 0; i < res.length; i++) {
+            uint16_t ch = res.oneByte ? static_cast<const uint8_t*>(res.data)[i] : static_cast<const char16_t*>(res.data)[i];
+            if (ch >= 0x80) {
+                ascii = false;
+            }
+        }
+    }
+    // Short strings must be tagged values
+    if (res.length <= MAX_UNICODE_SHORT_STRING_LENGTH || (ascii && res.length <= MAX_ASCII_SHORT_STRING_LENGTH)) {
+        wchar_t buffer[MAX_ASCII_SHORT_STRING_LENGTH];
+        for (size_t i = 0; i < res.length; i++) {
+            buffer[i] = res.oneByte ? static_cast<const uint8_t*>(res.data)[i] : static_cast<const char16_t*>(res.data)[i];
+        }
+        Handle<JSString> str = ascii ? CreateASCIIShortString(res.length, buffer) : CreateUnicodeShortString(res.length, buffer);
+        if (res.release) {
+            res.release(res.data, res.userData);
+        }
+        return str;
+    }
+
+    ExternalStringResource* resource = new ExternalStringResource(res);
+    Handle<JSString> str = new JSString(resource);
+    // Strings compare by identity, so an external string must be the interned one. If an equal
+    // string exists already, the resource is not needed
+    Handle<JSString> interned = Intern(str);
+    if (interned != str) {
+        str->external = nullptr;
+        if (resource->release) {
+            resource->release(resource->data, resource->userData);
+        }
+        delete resource;
+        return interned;
+    }
+
+    static ExternalStringFinalizerList finalizers;
+    new ExternalStringFinalizer(str, resource, &finalizers);
+    return str;
+}
+
 bool JSString::Equals(const Handle<Object>& object) {
     /* Pointer comparision (shortcut) */
     if (this == object) {
@@ -230,6 +429,15 @@ bool JSString::Equals(const Handle<Object>& object) {
     if (another->Length() != length) {
         return false;
     }
+    // External strings have no contiguous UTF-16 array
+    if (!this->string || !another->string) {
+        for (size_t i = 0; i < length; i++) {
+            if (this->At(i) != another->At(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
     char16_t* thisContent = &this->string->At(0);
     char16_t* otherContent = &another->string->At(0);
 
@@ -314,6 +522,73 @@ Handle<ValueArray<wchar_t>> JSString::ToWChar() {
     return result;
 }
 
+JSString::Characters JSString::GetCharacters(char16_t (&buffer)[MAX_ASCII_SHORT_STRING_LENGTH]) const {
+    if (IsShortString()) {
+        size_t length = GetShortStringLength();
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = GetShortStringChar(i);
+        }
+        return { buffer, length, false };
+    } else if (string) {
+        return { &string->At(0), string->Length(), false };
+    } else {
+        return { external->data, external->length, external->oneByte };
+    }
+}
+
+namespace {
+
+// Call f with the characters of text and pattern as typed pointers
+template<typename F>
+auto WithCharacters(const void* text, bool textOneByte, const void* pattern, bool patternOneByte, F f) -> decltype(f(static_cast<const char16_t*>(nullptr), static_cast<const char16_t*>(nullptr))) {
+    if (textOneByte) {
+        const uint8_t* t = static_cast<const uint8_t*>(text);
+        if (patternOneByte) {
+            return f(t, static_cast<const uint8_t*>(pattern));
+        }
+        return f(t, static_cast<const char16_t*>(pattern));
+    }
+    const char16_t* t = static_cast<const char16_t*>(text);
+    if (patternOneByte) {
+        return f(t, static_cast<const uint8_t*>(pattern));
+    }
+    return f(t, static_cast<const char16_t*>(pattern));
+}
+
+}
+
+int64_t JSString::IndexOf(const Handle<JSString>& search, size_t from) {
+    NoGC _;
+    char16_t textBuffer[MAX_ASCII_SHORT_STRING_LENGTH], patternBuffer[MAX_ASCII_SHORT_STRING_LENGTH];
+    Characters text = GetCharacters(textBuffer);
+    Characters pattern = search->GetCharacters(patternBuffer);
+    size_t pos = WithCharacters(text.data, text.oneByte, pattern.data, pattern.oneByte, [&](const auto* t, const auto* p) {
+        return StringSearch::Find(t, text.length, p, pattern.length, from);
+    });
+    return pos == StringSearch::kNotFound ? -1 : static_cast<int64_t>(pos);
+}
+
+int64_t JSString::LastIndexOf(const Handle<JSString>& search, size_t from) {
+    NoGC _;
+    char16_t textBuffer[MAX_ASCII_SHORT_STRING_LENGTH], patternBuffer[MAX_ASCII_SHORT_STRING_LENGTH];
+    Characters text = GetCharacters(textBuffer);
+    Characters pattern = search->GetCharacters(patternBuffer);
+    size_t pos = WithCharacters(text.data, text.oneByte, pattern.data, pattern.oneByte, [&](const auto* t, const auto* p) {
+        return StringSearch::FindLast(t, text.length, p, pattern.length, from);
+    });
+    return pos == StringSearch::kNotFound ? -1 : static_cast<int64_t>(pos);
+}
+
+bool JSString::RegionMatches(size_t pos, const Handle<JSString>& search) {
+    NoGC _;
+    char16_t textBuffer[MAX_ASCII_SHORT_STRING_LENGTH], patternBuffer[MAX_ASCII_SHORT_STRING_LENGTH];
+    Characters text = GetCharacters(textBuffer);
+    Characters pattern = search->GetCharacters(patternBuffer);
+    return WithCharacters(text.data, text.oneByte, pattern.data, pattern.oneByte, [&](const auto* t, const auto* p) {
+        return StringSearch::MatchesAt(t, text.length, p, pattern.length, pos);
+    });
+}
+
 Handle<JSString> JSString::Substring(size_t start, size_t end) {
     std::wstring builder;
     for (size_t i = start; i < end; i++) {
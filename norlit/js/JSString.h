@@ -11,6 +11,22 @@
 namespace norlit {
 namespace js {
 
+namespace regexp {
+class Program;
+}
+
+// Characters owned by the embedder that an external JSString refers to instead of copying them
+// into the heap. The buffer must stay valid and unchanged until release is called
+struct ExternalStringResource {
+    // Latin-1 characters if oneByte, UTF-16 code units otherwise
+    const void* data;
+    size_t length;
+    bool oneByte;
+    // Called once the string is collected. May be null
+    void (*release)(const void* data, void* userData);
+    void* userData;
+};
+
 class JSString final : public JSPropertyKey {
     /*
     * Tagged String Representation
@@ -24,6 +40,9 @@ class JSString final : public JSPropertyKey {
     *
     */
   private:
+    // Matches regular expressions on the characters in place
+    friend class regexp::Program;
+
     static const size_t MAX_ASCII_SHORT_STRING_LENGTH = sizeof(void*) - 1;
     static const size_t MAX_UNICODE_SHORT_STRING_LENGTH = sizeof(void*) / 2 - 1;
 
@@ -35,11 +54,23 @@ class JSString final : public JSPropertyKey {
     static gc::Handle<JSString> Intern(const gc::Handle<JSString>);
 
     gc::ValueArray<char16_t>* string = nullptr;
+    // Characters of external strings, which have no string array
+    ExternalStringResource* external = nullptr;
     // Cache hashcode
     uintptr_t hash;
 
+    // Raw characters of a string, Latin-1 if oneByte and UTF-16 otherwise. Short strings have no
+    // buffer and are unpacked into the one passed in. Only valid until the next allocation
+    struct Characters {
+        const void* data;
+        size_t length;
+        bool oneByte;
+    };
+    Characters GetCharacters(char16_t (&buffer)[MAX_ASCII_SHORT_STRING_LENGTH]) const;
+
     JSString(size_t, const char*);
     JSString(size_t, const wchar_t*);
+    JSString(ExternalStringResource*);
 
     bool IsShortStringUnicode() const;
     size_t GetShortStringLength() const;
@@ -53,6 +84,16 @@ class JSString final : public JSPropertyKey {
     static gc::Handle<JSString> New(const char*);
     static gc::Handle<JSString> New(const wchar_t*);
     static gc::Handle<JSString> NewFromCString(const char*);
+    // The tagged value New returns for str if it is short enough, or nullptr. Does not touch the heap
+    static JSString* NewShortString(const wchar_t*);
+    // Decode size bytes of UTF-8 into to, or only count if to is null. Returns the number of UTF-16
+    // code units. Each invalid sequence decodes to U+FFFD. Does not touch the heap, so it may be called
+    // from any thread
+    static size_t DecodeUTF8(const char*, size_t size, char16_t* to = nullptr);
+    // Create a string referring to the characters of the resource without copying them.
+    // Short strings are copied into tagged values, and equal strings already interned are returned
+    // instead. In both cases the resource is released at once
+    static gc::Handle<JSString> NewExternal(const ExternalStringResource&);
 
     static gc::Handle<JSString> Concat(const gc::Handle<JSString>&, const gc::Handle<JSString>&);
     static gc::Handle<JSString> Concat(std::initializer_list<gc::Handle<JSString>>);
@@ -64,6 +105,14 @@ class JSString final : public JSPropertyKey {
     gc::Handle<gc::ValueArray<char>> ToCString();
     gc::Handle<gc::ValueArray<wchar_t>> ToWChar();
     gc::Handle<JSString> Substring(size_t start, size_t end);
+
+    // Index of the first occurrence of search at or after from, or -1
+    int64_t IndexOf(const gc::Handle<JSString>& search, size_t from);
+    // Index of the last occurrence of search at or before from, or -1
+    int64_t LastIndexOf(const gc::Handle<JSString>& search, size_t from);
+    // Whether search occurs at pos
+    bool RegionMatches(size_t pos, const gc::Handle<JSString>& search);
+
     gc::Handle<JSString> Trim();
     gc::Handle<JSString> TrimLeft();
 };
@@ -89,8 +138,10 @@ inline char16_t JSString::GetShortStringChar(size_t pos) const {
 inline size_t JSString::Length() const {
     if (IsShortString()) {
         return GetShortStringLength();
-    } else {
+    } else if (string) {
         return string->Length();
+    } else {
+        return external->length;
     }
 }
 
@@ -100,8 +151,12 @@ inline char16_t JSString::At(size_t pos) const {
     }
     if (IsShortString()) {
         return GetShortStringChar(pos);
-    } else {
+    } else if (string) {
         return string->At(pos);
+    } else if (external->oneByte) {
+        return static_cast<const uint8_t*>(external->data)[pos];
+    } else {
+        return static_cast<const char16_t*>(external->data)[pos];
     }
 }
 
@@ -241,6 +241,24 @@ bool Objects::OrdinaryHasInstance(const Handle<JSValue>& C, const Handle<JSValue
 }
 
 
+Handle<JSObject> Objects::SpeciesConstructor(const Handle<JSObject>& O, const Handle<JSObject>& defaultConstructor) {
+    Handle<JSValue> C = Get(O, "constructor");
+    if (!C) {
+        return defaultConstructor;
+    }
+    if (!Testing::Is<JSObject>(C)) {
+        Exceptions::ThrowTypeError("Constructor must be object");
+    }
+    Handle<JSValue> S = Get(C.CastTo<JSObject>(), JSSymbol::Species());
+    if (!S || Testing::Is<JSNull>(S)) {
+        return defaultConstructor;
+    }
+    if (!Testing::IsConstructor(S)) {
+        Exceptions::ThrowTypeError("Species is not a constructor");
+    }
+    return S.CastTo<JSObject>();
+}
+
 Handle<Realm> Objects::GetFunctionRealm(const Handle<JSObject>& obj) {
     assert(Testing::IsCallable(obj));
     if (Handle<ESFunctionBase> func = obj.DynamicCastTo<ESFunctionBase>()) {
@@ -396,14 +414,7 @@ Handle<JSObject> Objects::ArrayCreate(int64_t len, const Handle<JSObject>& proto
         proto = Context::CurrentRealm()->ArrayPrototype();
     }
     Handle<ArrayObject> ret = new ArrayObject(proto);
-    JSOrdinaryObject::OrdinaryDefineOwnProperty(ret, JSString::New("length"), {
-        { JSNumber::New(static_cast<int64_t>(len)) },
-        nullopt,
-        nullopt,
-        true,
-        false,
-        false
-    });
+    ret->InitializeLength(static_cast<uint32_t>(len));
     return ret;
 }
 
@@ -421,6 +432,40 @@ Handle<JSObject> Objects::StringCreate(const Handle<JSString>& value, const Hand
     return S;
 }
 
+Handle<JSObject> Objects::RegExpAlloc(const Handle<JSObject>& newTarget) {
+    Handle<RegExpObject> obj = OrdinaryCreateFromConstructor<RegExpObject>(newTarget, &Realm::RegExpPrototype);
+    DefinePropertyOrThrow(obj, "lastIndex", {
+        nullopt,
+        nullopt,
+        nullopt,
+        true,
+        false,
+        false
+    });
+    return obj;
+}
+
+Handle<JSObject> Objects::RegExpInitialize(const Handle<JSObject>& obj, const Handle<JSValue>& pattern, const Handle<JSValue>& flags) {
+    Handle<JSString> P = pattern ? Conversion::ToString(pattern) : JSString::New("");
+    Handle<JSString> F = flags ? Conversion::ToString(flags) : JSString::New("");
+    uint8_t parsedFlags;
+    if (!regexp::Program::ParseFlags(F, parsedFlags)) {
+        Exceptions::ThrowSyntaxError("Invalid regular expression flags");
+    }
+    Handle<regexp::Program> matcher = regexp::Program::Compile(P, parsedFlags);
+    Handle<RegExpObject> regexp = obj.CastTo<RegExpObject>();
+    regexp->originalSource(P);
+    regexp->originalFlags(F);
+    regexp->regExpMatcher(matcher);
+    Set(obj, "lastIndex", JSNumber::New(0), true);
+    return obj;
+}
+
+Handle<JSObject> Objects::RegExpCreate(const Handle<JSValue>& P, const Handle<JSValue>& F) {
+    Handle<JSObject> obj = RegExpAlloc(Context::CurrentRealm()->RegExp());
+    return RegExpInitialize(obj, P, F);
+}
+
 bool Objects::InstanceOfOperator(const Handle<JSValue>& O, const Handle<JSValue>& C) {
     if (!Testing::Is<JSObject>(C)) {
         Exceptions::ThrowTypeError("Constructor argument of instanceof operator must be object");
@@ -134,6 +134,9 @@ class Objects {
     // 7.3.19
     static bool OrdinaryHasInstance(const gc::Handle<JSValue>&, const gc::Handle<JSValue>&);
 
+    // 7.3.20
+    static gc::Handle<object::JSObject> SpeciesConstructor(const gc::Handle<object::JSObject>&, const gc::Handle<object::JSObject>&);
+
     // 7.3.22
     static gc::Handle<vm::Realm> GetFunctionRealm(const gc::Handle<object::JSObject>&);
 
@@ -181,6 +184,14 @@ class Objects {
     // 9.4.3.4
     static gc::Handle<object::JSObject> StringCreate(const gc::Handle<JSString>&, const gc::Handle<object::JSObject>&);
 
+    // 21.2.3.2.1
+    static gc::Handle<object::JSObject> RegExpAlloc(const gc::Handle<object::JSObject>&);
+
+    // 21.2.3.2.2
+    static gc::Handle<object::JSObject> RegExpInitialize(const gc::Handle<object::JSObject>&, const gc::Handle<JSValue>&, const gc::Handle<JSValue>&);
+
+    // 21.2.3.2.3
+    static gc::Handle<object::JSObject> RegExpCreate(const gc::Handle<JSValue>&, const gc::Handle<JSValue>&);
 
     // 12.9.4
     static bool InstanceOfOperator(const gc::Handle<JSValue>&, const gc::Handle<JSValue>&);
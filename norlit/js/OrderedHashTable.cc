@@ -0,0 +1,239 @@
+#include "all.h"
+
+#include "OrderedHashTable.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+
+namespace {
+uintptr_t Mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return static_cast<uintptr_t>(hash);
+}
+
+// SameValueZero of a stored key and a normalized key whose hashes are equal. Tagged values and -0
+// never have a heap counterpart, so only heap strings and heap numbers need more than identity
+bool SameValueZero(const Handle<JSValue>& x, const Handle<JSValue>& y) {
+    if (x == y) return true;
+    if (!x || !y || x->IsTagged() || y->IsTagged()) return false;
+    JSValue::Type type = x->GetType();
+    if (type != y->GetType()) return false;
+    if (type == JSValue::Type::kString) {
+        return x.CastTo<Object>()->Equals(y.CastTo<Object>());
+    }
+    if (type == JSValue::Type::kNumber) {
+        double xVal = x.CastTo<JSNumber>()->Value();
+        double yVal = y.CastTo<JSNumber>()->Value();
+        return xVal == yVal || (std::isnan(xVal) && std::isnan(yVal));
+    }
+    return false;
+}
+}
+
+Handle<OrderedHashTable> OrderedHashTable::Allocate(uint32_t capacity, bool hasValues) {
+    Handle<OrderedHashTable> table = new OrderedHashTable();
+    Handle<ValueArray<uint32_t>> buckets = ValueArray<uint32_t>::New(capacity / 2);
+    for (uint32_t i = 0; i < capacity / 2; i++) {
+        buckets->At(i) = kEnd;
+    }
+    table->WriteBarrier(&table->buckets_, buckets);
+    Handle<ValueArray<Link>> links = ValueArray<Link>::New(capacity);
+    table->WriteBarrier(&table->links_, links);
+    Handle<Array<JSValue>> keys = Array<JSValue>::New(capacity);
+    table->WriteBarrier(&table->keys_, keys);
+    if (hasValues) {
+        Handle<Array<JSValue>> values = Array<JSValue>::New(capacity);
+        table->WriteBarrier(&table->values_, values);
+    }
+    return table;
+}
+
+Handle<OrderedHashTable> OrderedHashTable::New(bool hasValues) {
+    return Allocate(kInitialCapacity, hasValues);
+}
+
+void OrderedHashTable::Rehash(Handle<OrderedHashTable>& table, uint32_t capacity) {
+    Handle<OrderedHashTable> result = Allocate(capacity, table->values_ != nullptr);
+    Handle<ValueArray<uint32_t>> holes = ValueArray<uint32_t>::New(table->used_ - table->size_);
+    // No allocation below, so the raw entries can be walked directly
+    uint32_t holeCount = 0;
+    for (uint32_t i = 0, used = table->used_; i < used; i++) {
+        const Link& link = table->links_->At(i);
+        if (link.chain == kDeleted) {
+            holes->At(holeCount++) = i;
+        } else {
+            result->Append(link.hash, table->KeyAt(i), table->ValueAt(i));
+        }
+    }
+    table->Retire(result, holes);
+    table = result;
+}
+
+Handle<JSValue> OrderedHashTable::NormalizeKey(const Handle<JSValue>& key) {
+    // Integral numbers are small integers whenever they fit, so -0 is the only heap number equal to zero
+    if (key && !key->IsTagged() && key->GetType() == JSValue::Type::kNumber && key.CastTo<JSNumber>()->Value() == 0) {
+        return JSNumber::Zero();
+    }
+    return key;
+}
+
+uintptr_t OrderedHashTable::Hash(const Handle<JSValue>& key) {
+    // Undefined, small integers, short strings, booleans and null are identified by their bits
+    if (!key || key->IsTagged()) {
+        return Mix(reinterpret_cast<uintptr_t>(static_cast<JSValue*>(key)));
+    }
+    switch (key->GetType()) {
+        case JSValue::Type::kNumber: {
+            double value = key.CastTo<JSNumber>()->Value();
+            if (std::isnan(value)) {
+                value = std::numeric_limits<double>::quiet_NaN();
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return Mix(bits);
+        }
+        default:
+            // Heap strings hash their contents, cached at creation. Everything else hashes by identity
+            return Mix(key.CastTo<Object>()->HashCode());
+    }
+}
+
+uint32_t OrderedHashTable::FindEntry(const Handle<JSValue>& key, uintptr_t hash) {
+    uint32_t entry = buckets_->At(hash & (buckets_->Length() - 1));
+    while (entry != kEnd) {
+        const Link& link = links_->At(entry);
+        if (link.hash == hash && SameValueZero(keys_->Get(entry), key)) {
+            return entry;
+        }
+        entry = link.chain;
+    }
+    return kEnd;
+}
+
+void OrderedHashTable::Append(uintptr_t hash, const Handle<JSValue>& key, const Handle<JSValue>& value) {
+    uint32_t index = used_++;
+    uint32_t& bucket = buckets_->At(hash & (buckets_->Length() - 1));
+    Link& link = links_->At(index);
+    link.hash = hash;
+    link.chain = bucket;
+    bucket = index;
+    keys_->Put(index, key);
+    if (values_) {
+        values_->Put(index, value);
+    }
+    size_++;
+}
+
+void OrderedHashTable::Retire(const Handle<OrderedHashTable>& next, const Handle<ValueArray<uint32_t>>& holes) {
+    this->WriteBarrier(&this->next_, next);
+    this->WriteBarrier(&this->holes_, holes);
+    // Iterators keeping a replaced table alive only need the forwarding information
+    buckets_ = nullptr;
+    links_ = nullptr;
+    keys_ = nullptr;
+    values_ = nullptr;
+}
+
+bool OrderedHashTable::Has(const Handle<JSValue>& key) {
+    Handle<JSValue> normalized = NormalizeKey(key);
+    return FindEntry(normalized, Hash(normalized)) != kEnd;
+}
+
+Handle<JSValue> OrderedHashTable::Get(const Handle<JSValue>& key) {
+    Handle<JSValue> normalized = NormalizeKey(key);
+    uint32_t entry = FindEntry(normalized, Hash(normalized));
+    return entry == kEnd ? nullptr : ValueAt(entry);
+}
+
+void OrderedHashTable::Set(Handle<OrderedHashTable>& table, const Handle<JSValue>& key, const Handle<JSValue>& value) {
+    Handle<JSValue> normalized = NormalizeKey(key);
+    uintptr_t hash = Hash(normalized);
+    uint32_t entry = table->FindEntry(normalized, hash);
+    if (entry != kEnd) {
+        if (table->values_) {
+            table->values_->Put(entry, value);
+        }
+        return;
+    }
+    if (table->used_ == table->Capacity()) {
+        // Squeeze out the holes if they make up half of the table, otherwise grow
+        uint32_t capacity = table->Capacity();
+        if (table->size_ >= capacity / 2) {
+            if (capacity == kMaxCapacity) {
+                Exceptions::ThrowRangeError("Collection has too many entries");
+            }
+            capacity *= 2;
+        }
+        Rehash(table, capacity);
+    }
+    table->Append(hash, normalized, value);
+}
+
+bool OrderedHashTable::Delete(Handle<OrderedHashTable>& table, const Handle<JSValue>& key) {
+    Handle<JSValue> normalized = NormalizeKey(key);
+    uintptr_t hash = Hash(normalized);
+    uint32_t* slot = &table->buckets_->At(hash & (table->buckets_->Length() - 1));
+    while (*slot != kEnd) {
+        uint32_t entry = *slot;
+        Link& link = table->links_->At(entry);
+        if (link.hash == hash && SameValueZero(table->keys_->Get(entry), normalized)) {
+            *slot = link.chain;
+            link.chain = kDeleted;
+            table->keys_->Put(entry, nullptr);
+            if (table->values_) {
+                table->values_->Put(entry, nullptr);
+            }
+            table->size_--;
+            uint32_t capacity = table->Capacity();
+            if (capacity > kInitialCapacity && table->size_ < capacity / 4) {
+                Rehash(table, capacity / 2);
+            }
+            return true;
+        }
+        slot = &link.chain;
+    }
+    return false;
+}
+
+void OrderedHashTable::Clear(Handle<OrderedHashTable>& table) {
+    Handle<OrderedHashTable> result = Allocate(kInitialCapacity, table->values_ != nullptr);
+    table->Retire(result, nullptr);
+    table = result;
+}
+
+bool OrderedHashTable::Seek(Handle<OrderedHashTable>& table, uint32_t& index) {
+    while (table->next_) {
+        if (!table->holes_) {
+            index = 0;
+        } else {
+            // Each hole before index is gone from the next table
+            uint32_t skipped = 0;
+            for (uint32_t i = 0, count = static_cast<uint32_t>(table->holes_->Length()); i < count && table->holes_->At(i) < index; i++) {
+                skipped++;
+            }
+            index -= skipped;
+        }
+        table = table->next_;
+    }
+    for (uint32_t used = table->used_; index < used; index++) {
+        if (table->links_->At(index).chain != kDeleted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OrderedHashTable::IterateField(const FieldIterator& iter) {
+    iter(&buckets_);
+    iter(&links_);
+    iter(&keys_);
+    iter(&values_);
+    iter(&next_);
+    iter(&holes_);
+}
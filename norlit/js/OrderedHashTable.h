@@ -0,0 +1,103 @@
+#ifndef NORLIT_JS_ORDEREDHASHTABLE_H
+#define NORLIT_JS_ORDEREDHASHTABLE_H
+
+#include "JSValue.h"
+#include "../gc/Array.h"
+
+namespace norlit {
+namespace js {
+
+/*
+ * Deterministic hash table backing Map and Set, keeping entries in insertion order.
+ *
+ * Entries are appended to flat arrays and chained into buckets by index. The hash of each entry is
+ * stored next to its chain link, so a lookup only compares keys whose hashes match. Keys are
+ * compared with SameValueZero. Deleting an entry unlinks it and leaves a hole that is squeezed out
+ * the next time the table is rebuilt.
+ *
+ * A table is never rebuilt in place. When it grows, shrinks or is cleared, the live entries are
+ * copied into a new table and the old one forwards to it, remembering where its holes were. An
+ * iterator holding a table and an index can therefore always catch up with the current table, no
+ * matter how the collection was modified in between.
+ */
+class OrderedHashTable final : public gc::Object {
+    struct Link {
+        uintptr_t hash;
+        // Next entry of the bucket, kEnd, or kDeleted once the entry is removed
+        uint32_t chain;
+    };
+
+    static const uint32_t kEnd = 0xFFFFFFFF;
+    static const uint32_t kDeleted = 0xFFFFFFFE;
+    static const uint32_t kInitialCapacity = 4;
+    static const uint32_t kMaxCapacity = 1u << 30;
+
+    // First entry of each bucket. There is one bucket for every two entries
+    gc::ValueArray<uint32_t>* buckets_ = nullptr;
+    gc::ValueArray<Link>* links_ = nullptr;
+    gc::Array<JSValue>* keys_ = nullptr;
+    // Null for tables of sets
+    gc::Array<JSValue>* values_ = nullptr;
+    // Number of entries appended, including deleted ones
+    uint32_t used_ = 0;
+    // Number of live entries
+    uint32_t size_ = 0;
+
+    // The table that replaced this one, and the indices of the holes dropped on the way in ascending
+    // order. holes_ is null if the table was cleared
+    OrderedHashTable* next_ = nullptr;
+    gc::ValueArray<uint32_t>* holes_ = nullptr;
+
+    OrderedHashTable() {}
+
+    static gc::Handle<OrderedHashTable> Allocate(uint32_t capacity, bool hasValues);
+    static void Rehash(gc::Handle<OrderedHashTable>&, uint32_t capacity);
+    static gc::Handle<JSValue> NormalizeKey(const gc::Handle<JSValue>&);
+    static uintptr_t Hash(const gc::Handle<JSValue>&);
+
+    uint32_t Capacity() const {
+        return static_cast<uint32_t>(keys_->Length());
+    }
+
+    // Index of the entry of key, or kEnd
+    uint32_t FindEntry(const gc::Handle<JSValue>& key, uintptr_t hash);
+    void Append(uintptr_t hash, const gc::Handle<JSValue>& key, const gc::Handle<JSValue>& value);
+    void Retire(const gc::Handle<OrderedHashTable>& next, const gc::Handle<gc::ValueArray<uint32_t>>& holes);
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+  public:
+    static gc::Handle<OrderedHashTable> New(bool hasValues);
+
+    uint32_t Size() const {
+        return size_;
+    }
+
+    bool Has(const gc::Handle<JSValue>& key);
+    // Value of key, or undefined if it is absent
+    gc::Handle<JSValue> Get(const gc::Handle<JSValue>& key);
+
+    // Mutations may replace the table, so they take it by reference and update it
+    // Add key or update its value. A key of -0 is stored as +0
+    static void Set(gc::Handle<OrderedHashTable>& table, const gc::Handle<JSValue>& key, const gc::Handle<JSValue>& value);
+    // Returns whether key was present
+    static bool Delete(gc::Handle<OrderedHashTable>& table, const gc::Handle<JSValue>& key);
+    static void Clear(gc::Handle<OrderedHashTable>& table);
+
+    // Move table and index to the first live entry at or after index, following replaced tables to
+    // the current one. Returns false if there is no such entry
+    static bool Seek(gc::Handle<OrderedHashTable>& table, uint32_t& index);
+
+    // Key and value of a live entry. Entries of sets have their key as value
+    gc::Handle<JSValue> KeyAt(uint32_t index) const {
+        return keys_->Get(index);
+    }
+
+    gc::Handle<JSValue> ValueAt(uint32_t index) const {
+        return values_ ? values_->Get(index) : keys_->Get(index);
+    }
+};
+
+}
+}
+
+#endif
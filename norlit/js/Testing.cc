@@ -2,7 +2,8 @@
 
 #include "JSBoolean.h"
 #include "JSString.h"
-#include "object/JSObject.h"
+#include "JSSymbol.h"
+#include "object/Exotics.h"
 
 #include <limits>
 #include <algorithm>
@@ -31,6 +32,18 @@ bool Testing::IsConstructor(const Handle<JSValue>& val) {
     return val.CastTo<JSObject>()->IsConstructor();
 }
 
+bool Testing::IsRegExp(const Handle<JSValue>& argument) {
+    if (!Is<JSObject>(argument)) {
+        return false;
+    }
+    Handle<JSObject> O = argument.CastTo<JSObject>();
+    Handle<JSValue> isRegExp = Objects::Get(O, JSSymbol::Match());
+    if (isRegExp) {
+        return Conversion::ToBooleanValue(isRegExp);
+    }
+    return O.ExactInstanceOf<RegExpObject>();
+}
+
 bool Testing::SameValue(const Handle<JSValue>& x, const Handle<JSValue>& y) {
     if (x == y) return true;
     if (x->GetType() == JSValue::Type::kNumber&&y->GetType() == JSValue::Type::kNumber) {
@@ -57,9 +70,7 @@ int Testing::IsSmaller(const Handle<JSPrimitive>& l, const Handle<JSPrimitive>&
         for (size_t i = 0; i < minLength; i++) {
             int diff = lStr->At(i) - rStr->At(i);
             if (diff != 0) {
-                if (diff < 0) {
-                    return true;
-                }
+                return diff < 0;
             }
         }
         return lStr->Length() < rStr->Length();
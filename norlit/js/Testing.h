@@ -106,6 +106,7 @@ class Testing {
 
     static bool IsCallable(const gc::Handle<JSValue>&);
     static bool IsConstructor(const gc::Handle<JSValue>&);
+    static bool IsRegExp(const gc::Handle<JSValue>&);
 
     static bool SameValue(const gc::Handle<JSValue>&, const gc::Handle<JSValue>&);
     //  1 true
@@ -4,6 +4,8 @@
 #include "../../gc/Array.h"
 #include "../object/JSObject.h"
 
+#include <string>
+
 #define DEFINE_CTOR() \
 	static gc::Handle<JSValue> Call(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);\
 	static gc::Handle<object::JSObject> Construct(const gc::Handle<gc::Array<JSValue>>&, const gc::Handle<object::JSObject>&)
@@ -94,6 +96,8 @@ static gc::Handle<JSValue> Call(const gc::Handle<JSValue>&, const gc::Handle<gc:
 static gc::Handle<object::JSObject> Construct(const gc::Handle<gc::Array<JSValue>>&, const gc::Handle<object::JSObject>&);\
 struct prototype {\
 	static gc::Handle<JSValue> toString(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);\
+	static gc::Handle<JSValue> get_stack(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);\
+	static gc::Handle<JSValue> set_stack(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);\
 };\
 };
 
@@ -230,6 +234,11 @@ struct String {
     static gc::Handle<JSValue> fromCodePoint(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);
     static gc::Handle<JSValue> raw(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);
 
+    // 21.1.3.14.1 GetSubstitution(matched, str, position, captures, replacement), appending the result to builder
+    static void GetSubstitution(
+        std::wstring& builder, const gc::Handle<JSString>&, const gc::Handle<JSString>&, size_t,
+        const gc::Handle<gc::Array<JSValue>>&, const gc::Handle<JSString>&);
+
     struct prototype {
         static gc::Handle<JSValue> charAt(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);
         static gc::Handle<JSValue> charCodeAt(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&);
@@ -341,6 +350,67 @@ struct BuiltinArray {
     DEFINE_METHOD(Iterator_next);
 };
 
+struct Map {
+    DEFINE_CTOR();
+
+    DEFINE_GETTER(Symbol_species);
+
+    struct prototype {
+        DEFINE_METHOD(clear);
+        DEFINE_METHOD(delete_);
+        DEFINE_METHOD(entries);
+        DEFINE_METHOD(forEach);
+        DEFINE_METHOD(get);
+        DEFINE_METHOD(has);
+        DEFINE_METHOD(keys);
+        DEFINE_METHOD(set);
+        DEFINE_GETTER(size);
+        DEFINE_METHOD(values);
+    };
+
+    DEFINE_METHOD(Iterator_next);
+};
+
+struct Set {
+    DEFINE_CTOR();
+
+    DEFINE_GETTER(Symbol_species);
+
+    struct prototype {
+        DEFINE_METHOD(add);
+        DEFINE_METHOD(clear);
+        DEFINE_METHOD(delete_);
+        DEFINE_METHOD(entries);
+        DEFINE_METHOD(forEach);
+        DEFINE_METHOD(has);
+        DEFINE_GETTER(size);
+        DEFINE_METHOD(values);
+    };
+
+    DEFINE_METHOD(Iterator_next);
+};
+
+struct WeakMap {
+    DEFINE_CTOR();
+
+    struct prototype {
+        DEFINE_METHOD(delete_);
+        DEFINE_METHOD(get);
+        DEFINE_METHOD(has);
+        DEFINE_METHOD(set);
+    };
+};
+
+struct WeakSet {
+    DEFINE_CTOR();
+
+    struct prototype {
+        DEFINE_METHOD(add);
+        DEFINE_METHOD(delete_);
+        DEFINE_METHOD(has);
+    };
+};
+
 struct Generator {
     struct prototype {
         DEFINE_METHOD(next);
@@ -5,13 +5,254 @@
 #include "../vm/Context.h"
 #include "../object/Exotics.h"
 
+#include "../../util/Arrays.h"
+#include "../../util/TimSort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
 using namespace norlit::gc;
+using namespace norlit::util;
 using namespace norlit::js;
 using namespace norlit::js::vm;
 using namespace norlit::js::object;
 using namespace norlit::js::builtin;
 
 namespace {
+Handle<JSString> IndexToKey(int64_t index) {
+    return Conversion::ToString(JSNumber::New(index));
+}
+
+// Relative index argument clamped to [0, len], as used by slice and splice
+int64_t RelativeIndex(const Handle<JSValue>& arg, int64_t len) {
+    double relative = Conversion::ToNumberValue(arg);
+    if (std::isnan(relative)) {
+        return 0;
+    }
+    relative = std::trunc(relative);
+    if (relative < 0) {
+        return static_cast<int64_t>(std::max(len + relative, 0.0));
+    }
+    return static_cast<int64_t>(std::min(relative, static_cast<double>(len)));
+}
+
+// Arguments of the callback of forEach, map and the like
+Handle<Array<JSValue>> CallbackArgs(const Handle<JSValue>& kValue, int64_t k, const Handle<JSObject>& O) {
+    return Arrays::ToArray<JSValue>(kValue, JSNumber::New(k).CastTo<JSValue>(), O.CastTo<JSValue>());
+}
+
+Handle<JSObject> RequireCallable(const Handle<JSValue>& callbackfn) {
+    if (!Testing::IsCallable(callbackfn)) {
+        Exceptions::ThrowTypeError("Callback is not a function");
+    }
+    return callbackfn.CastTo<JSObject>();
+}
+
+// Whether no object on the prototype chain of array can have elements, so that missing elements read
+// as undefined and setting one defines it on the array. Only the intrinsic prototypes are recognized:
+// Array.prototype while it is dense and empty, and Object.prototype while it is unmodified
+bool HasNoInheritedElements(const Handle<ArrayObject>& array) {
+    Handle<Realm> realm = Context::CurrentRealm();
+    Handle<JSObject> proto = array->GetPrototypeOf();
+    if (proto != realm->ArrayPrototype()) {
+        return false;
+    }
+    Handle<ArrayObject> arrayProto = proto.CastTo<ArrayObject>();
+    if (!arrayProto->IsDense() || arrayProto->DenseSize() != 0) {
+        return false;
+    }
+    Handle<JSObject> objProto = arrayProto->GetPrototypeOf();
+    return objProto == realm->ObjectPrototype() && objProto.CastTo<JSOrdinaryObject>()->IsWatchIntact();
+}
+
+// Check HasProperty(O, k), and Get(O, k) if it is present. Elements in the backing store of a dense
+// array are read directly. This is repeated for every element, as callbacks may change the array
+bool GetElementIfPresent(const Handle<JSObject>& O, int64_t k, Handle<JSValue>& value) {
+    Handle<ArrayObject> array = O.ExactCheckedCastTo<ArrayObject>();
+    if (array && array->IsDense() && k < array->DenseSize()) {
+        value = array->GetElement(static_cast<uint32_t>(k));
+        return true;
+    }
+    Handle<JSString> Pk = IndexToKey(k);
+    if (!Objects::HasProperty(O, Pk)) {
+        return false;
+    }
+    value = Objects::Get(O, Pk);
+    return true;
+}
+
+// CreateDataPropertyOrThrow(A, k, value), adding to the backing store directly when k is the next
+// element of a dense array
+void CreateElement(const Handle<JSObject>& A, int64_t k, const Handle<JSValue>& value) {
+    Handle<ArrayObject> array = A.ExactCheckedCastTo<ArrayObject>();
+    if (array && k < 0xFFFFFFFF && array->AddElement(static_cast<uint32_t>(k), value)) {
+        return;
+    }
+    Objects::CreateDataPropertyOrThrow(A, IndexToKey(k), value);
+}
+
+void DeletePropertyOrThrow(const Handle<JSObject>& O, const Handle<JSPropertyKey>& P) {
+    if (!O->Delete(P)) {
+        Exceptions::ThrowTypeError("Cannot delete property");
+    }
+}
+
+// 9.4.2.3 ArraySpeciesCreate
+Handle<JSObject> ArraySpeciesCreate(const Handle<JSObject>& originalArray, int64_t length) {
+    if (!originalArray.ExactInstanceOf<ArrayObject>()) {
+        return Objects::ArrayCreate(length);
+    }
+    Handle<JSValue> C = Objects::Get(originalArray, "constructor");
+    if (Testing::IsConstructor(C)) {
+        Handle<Realm> thisRealm = Context::CurrentRealm();
+        Handle<Realm> realmC = Objects::GetFunctionRealm(C.CastTo<JSObject>());
+        if (thisRealm != realmC && C == realmC->GetArray()) {
+            C = nullptr;
+        }
+    }
+    if (Testing::Is<JSObject>(C)) {
+        C = Objects::Get(C.CastTo<JSObject>(), JSSymbol::Species());
+        if (Testing::Is<JSNull>(C)) {
+            C = nullptr;
+        }
+    }
+    if (!C) {
+        return Objects::ArrayCreate(length);
+    }
+    if (!Testing::IsConstructor(C)) {
+        Exceptions::ThrowTypeError("Species is not a constructor");
+    }
+    return Objects::Construct(C.CastTo<JSObject>(), Arrays::ToArray<JSValue>(JSNumber::New(length).CastTo<JSValue>()));
+}
+
+// 22.1.3.24.1 SortCompare, returning whether x sorts before y. Undefined is never compared
+bool SortCompare(const Handle<JSObject>& comparefn, const Handle<JSValue>& x, const Handle<JSValue>& y) {
+    if (comparefn) {
+        double v = Conversion::ToNumberValue(Objects::Call(comparefn, nullptr, Arrays::ToArray<JSValue>(x, y)));
+        return v < 0;
+    }
+    Handle<JSString> xString = Conversion::ToString(x);
+    Handle<JSString> yString = Conversion::ToString(y);
+    return Testing::IsSmaller(xString, yString) == 1;
+}
+
+// SortCompare without a comparison function for strings, comparing UTF-16 code units directly
+bool StringLess(const Handle<JSValue>& x, const Handle<JSValue>& y) {
+    Handle<JSString> xString = x.CastTo<JSString>();
+    Handle<JSString> yString = y.CastTo<JSString>();
+    size_t xLength = xString->Length(), yLength = yString->Length();
+    for (size_t i = 0, size = std::min(xLength, yLength); i < size; i++) {
+        char16_t xChar = xString->At(i), yChar = yString->At(i);
+        if (xChar != yChar) {
+            return xChar < yChar;
+        }
+    }
+    return xLength < yLength;
+}
+
+// SortCompare without a comparison function for integers, comparing their decimal representations
+// without converting them to strings
+bool IntegerStringLess(int64_t x, int64_t y) {
+    if (x == y) {
+        return false;
+    }
+    // "-" sorts before every digit, and is followed by the magnitude
+    if ((x < 0) != (y < 0)) {
+        return x < 0;
+    }
+    uint64_t xMagnitude = x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x);
+    uint64_t yMagnitude = y < 0 ? 0 - static_cast<uint64_t>(y) : static_cast<uint64_t>(y);
+    int xDigits = 1, yDigits = 1;
+    uint64_t xScale = 1, yScale = 1;
+    while (xMagnitude / xScale >= 10) {
+        xScale *= 10;
+        xDigits++;
+    }
+    while (yMagnitude / yScale >= 10) {
+        yScale *= 10;
+        yDigits++;
+    }
+    // Compare the leading digits of the longer with the shorter, which sorts first if it is a prefix
+    if (xDigits < yDigits) {
+        return xMagnitude <= yMagnitude / (yScale / xScale);
+    }
+    if (xDigits > yDigits) {
+        return xMagnitude / (xScale / yScale) < yMagnitude;
+    }
+    return xMagnitude < yMagnitude;
+}
+
+// Storage for TimSort
+struct ValueSlots {
+    Handle<Array<JSValue>> array;
+
+    Handle<JSValue> Get(size_t index) {
+        return array->Get(index);
+    }
+    void Put(size_t index, const Handle<JSValue>& value) {
+        array->Put(index, value);
+    }
+    ValueSlots Allocate(size_t size) {
+        return { Array<JSValue>::New(size) };
+    }
+};
+
+struct IntegerSlots {
+    Handle<ValueArray<int64_t>> array;
+
+    int64_t Get(size_t index) {
+        return array->At(index);
+    }
+    void Put(size_t index, int64_t value) {
+        array->At(index) = value;
+    }
+    IntegerSlots Allocate(size_t size) {
+        return { ValueArray<int64_t>::New(size) };
+    }
+};
+
+// Sort items, none of which is undefined. Without a comparison function, arrays of only small
+// integers or only strings are compared without calling into script or converting to strings
+void SortItems(const Handle<Array<JSValue>>& items, const Handle<JSObject>& comparefn) {
+    size_t size = items->Length();
+    if (size < 2) {
+        return;
+    }
+    if (comparefn) {
+        auto less = [&comparefn](const Handle<JSValue>& x, const Handle<JSValue>& y) {
+            return SortCompare(comparefn, x, y);
+        };
+        TimSort<ValueSlots, decltype(less)>::Sort({ items }, size, less);
+        return;
+    }
+
+    bool allIntegers = true, allStrings = true;
+    for (size_t i = 0; i < size && (allIntegers || allStrings); i++) {
+        Handle<JSValue> item = items->Get(i);
+        allIntegers = allIntegers && Testing::Is<JSNumber>(item) && item.CastTo<JSNumber>()->IsSmallInteger();
+        allStrings = allStrings && Testing::Is<JSString>(item);
+    }
+
+    if (allIntegers) {
+        Handle<ValueArray<int64_t>> integers = ValueArray<int64_t>::New(size);
+        for (size_t i = 0; i < size; i++) {
+            integers->At(i) = static_cast<int64_t>(items->Get(i).CastTo<JSNumber>()->Value());
+        }
+        TimSort<IntegerSlots, bool(*)(int64_t, int64_t)>::Sort({ integers }, size, IntegerStringLess);
+        for (size_t i = 0; i < size; i++) {
+            items->Put(i, JSNumber::New(integers->At(i)));
+        }
+    } else if (allStrings) {
+        TimSort<ValueSlots, bool(*)(const Handle<JSValue>&, const Handle<JSValue>&)>::Sort({ items }, size, StringLess);
+    } else {
+        auto less = [](const Handle<JSValue>& x, const Handle<JSValue>& y) {
+            return SortCompare(nullptr, x, y);
+        };
+        TimSort<ValueSlots, decltype(less)>::Sort({ items }, size, less);
+    }
+}
+
 Handle<JSObject> CreateArrayIterator(const Handle<JSObject>& array, ArrayIteratorObject::IterationKind kind) {
     Handle<ArrayIteratorObject> iterator = Objects::ObjectCreate<ArrayIteratorObject>(Context::CurrentRealm()->ArrayIteratorPrototype());
     iterator->iteratedObject(array);
@@ -48,6 +289,309 @@ Handle<JSObject> BuiltinArray::Construct(const Handle<Array<JSValue>>& args, con
     }
 }
 
+Handle<JSValue> BuiltinArray::get_Symbol_species(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return that;
+}
+
+Handle<JSValue> BuiltinArray::prototype::filter(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    Handle<JSObject> callbackfn = RequireCallable(GetArg(args, 0));
+    Handle<JSValue> T = GetArg(args, 1);
+    Handle<JSObject> A = ArraySpeciesCreate(O, 0);
+    int64_t to = 0;
+    for (int64_t k = 0; k < len; k++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(O, k, kValue)) {
+            Handle<JSValue> selected = Objects::Call(callbackfn, T, CallbackArgs(kValue, k, O));
+            if (Conversion::ToBooleanValue(selected)) {
+                CreateElement(A, to++, kValue);
+            }
+        }
+    }
+    return A;
+}
+
+Handle<JSValue> BuiltinArray::prototype::forEach(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    Handle<JSObject> callbackfn = RequireCallable(GetArg(args, 0));
+    Handle<JSValue> T = GetArg(args, 1);
+    for (int64_t k = 0; k < len; k++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(O, k, kValue)) {
+            Objects::Call(callbackfn, T, CallbackArgs(kValue, k, O));
+        }
+    }
+    return nullptr;
+}
+
+Handle<JSValue> BuiltinArray::prototype::indexOf(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    if (len == 0) {
+        return JSNumber::New(static_cast<int32_t>(-1));
+    }
+    Handle<JSValue> searchElement = GetArg(args, 0);
+    int64_t k = args->Length() > 1 ? RelativeIndex(GetArg(args, 1), len) : 0;
+    for (; k < len; k++) {
+        Handle<JSValue> elementK;
+        if (GetElementIfPresent(O, k, elementK) && Testing::IsStrictlyEqual(searchElement, elementK)) {
+            return JSNumber::New(k);
+        }
+    }
+    return JSNumber::New(static_cast<int32_t>(-1));
+}
+
+Handle<JSValue> BuiltinArray::prototype::join(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    Handle<JSValue> separator = GetArg(args, 0);
+    Handle<JSString> sep = separator ? Conversion::ToString(separator) : JSString::New(",");
+    size_t sepLength = sep->Length();
+    std::wstring builder;
+    for (int64_t k = 0; k < len; k++) {
+        if (k > 0) {
+            for (size_t i = 0; i < sepLength; i++) {
+                builder += sep->At(i);
+            }
+        }
+        // Unlike other methods, holes are read through the prototype chain
+        Handle<JSValue> element;
+        Handle<ArrayObject> array = O.ExactCheckedCastTo<ArrayObject>();
+        if (array && array->IsDense() && k < array->DenseSize()) {
+            element = array->GetElement(static_cast<uint32_t>(k));
+        } else {
+            element = Objects::Get(O, IndexToKey(k));
+        }
+        if (element && !Testing::Is<JSNull>(element)) {
+            Handle<JSString> next = Conversion::ToString(element);
+            for (size_t i = 0, size = next->Length(); i < size; i++) {
+                builder += next->At(i);
+            }
+        }
+    }
+    return JSString::New(builder.c_str());
+}
+
+Handle<JSValue> BuiltinArray::prototype::map(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    Handle<JSObject> callbackfn = RequireCallable(GetArg(args, 0));
+    Handle<JSValue> T = GetArg(args, 1);
+    Handle<JSObject> A = ArraySpeciesCreate(O, len);
+    for (int64_t k = 0; k < len; k++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(O, k, kValue)) {
+            Handle<JSValue> mappedValue = Objects::Call(callbackfn, T, CallbackArgs(kValue, k, O));
+            CreateElement(A, k, mappedValue);
+        }
+    }
+    return A;
+}
+
+Handle<JSValue> BuiltinArray::prototype::pop(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    Handle<ArrayObject> array = O.ExactCheckedCastTo<ArrayObject>();
+    if (array && array->IsPacked() && array->IsLengthWritable() && array->length() != 0) {
+        uint32_t index = array->length() - 1;
+        Handle<JSValue> element = array->GetElement(index);
+        array->SpliceElements(index, 1, Array<JSValue>::New(0));
+        return element;
+    }
+
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    if (len == 0) {
+        Objects::Set(O, "length", JSNumber::New(static_cast<int32_t>(0)), true);
+        return nullptr;
+    }
+    int64_t newLen = len - 1;
+    Handle<JSString> index = IndexToKey(newLen);
+    Handle<JSValue> element = Objects::Get(O, index);
+    DeletePropertyOrThrow(O, index);
+    Objects::Set(O, "length", JSNumber::New(newLen), true);
+    return element;
+}
+
+Handle<JSValue> BuiltinArray::prototype::push(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    size_t argCount = args->Length();
+    Handle<ArrayObject> array = O.ExactCheckedCastTo<ArrayObject>();
+    if (array && array->CanAppend() && array->length() + argCount < 0xFFFFFFFF && HasNoInheritedElements(array)) {
+        for (size_t i = 0; i < argCount; i++) {
+            array->AddElement(array->length(), args->Get(i));
+        }
+        return JSNumber::New(static_cast<int64_t>(array->length()));
+    }
+
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    if (len + static_cast<int64_t>(argCount) > 0x1FFFFFFFFFFFFFLL) {
+        Exceptions::ThrowTypeError("Array length exceeds the maximum");
+    }
+    for (size_t i = 0; i < argCount; i++) {
+        Objects::Set(O, IndexToKey(len), args->Get(i), true);
+        len++;
+    }
+    Handle<JSNumber> newLen = JSNumber::New(len);
+    Objects::Set(O, "length", newLen, true);
+    return newLen;
+}
+
+Handle<JSValue> BuiltinArray::prototype::reduce(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    Handle<JSObject> callbackfn = RequireCallable(GetArg(args, 0));
+    int64_t k = 0;
+    Handle<JSValue> accumulator;
+    if (args->Length() >= 2) {
+        accumulator = args->Get(1);
+    } else {
+        bool kPresent = false;
+        for (; !kPresent && k < len; k++) {
+            kPresent = GetElementIfPresent(O, k, accumulator);
+        }
+        if (!kPresent) {
+            Exceptions::ThrowTypeError("Reduce of empty array with no initial value");
+        }
+    }
+    for (; k < len; k++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(O, k, kValue)) {
+            accumulator = Objects::Call(callbackfn, nullptr, Arrays::Concat(Arrays::ToArray<JSValue>(accumulator), CallbackArgs(kValue, k, O)));
+        }
+    }
+    return accumulator;
+}
+
+Handle<JSValue> BuiltinArray::prototype::slice(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    int64_t k = RelativeIndex(GetArg(args, 0), len);
+    Handle<JSValue> end = GetArg(args, 1);
+    int64_t finalIndex = end ? RelativeIndex(end, len) : len;
+    int64_t count = std::max<int64_t>(finalIndex - k, 0);
+    Handle<JSObject> A = ArraySpeciesCreate(O, count);
+    int64_t n = 0;
+    for (; k < finalIndex; k++, n++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(O, k, kValue)) {
+            CreateElement(A, n, kValue);
+        }
+    }
+    Objects::Set(A, "length", JSNumber::New(n), true);
+    return A;
+}
+
+Handle<JSValue> BuiltinArray::prototype::sort(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSValue> comparefnArg = GetArg(args, 0);
+    Handle<JSObject> comparefn;
+    if (comparefnArg) {
+        comparefn = RequireCallable(comparefnArg);
+    }
+    Handle<JSObject> obj = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(obj, "length"));
+
+    // Holes are left out and written back as deletions at the end, undefined sorts after everything else
+    ArrayList<JSValue> list;
+    int64_t undefinedCount = 0;
+    for (int64_t k = 0; k < len; k++) {
+        Handle<JSValue> kValue;
+        if (GetElementIfPresent(obj, k, kValue)) {
+            if (kValue) {
+                list.Add(kValue);
+            } else {
+                undefinedCount++;
+            }
+        }
+    }
+    Handle<Array<JSValue>> items = list.ToArray();
+    SortItems(items, comparefn);
+
+    int64_t itemCount = static_cast<int64_t>(items->Length());
+    for (int64_t k = 0; k < itemCount + undefinedCount; k++) {
+        Handle<JSValue> value = k < itemCount ? items->Get(k) : nullptr;
+        Handle<ArrayObject> array = obj.ExactCheckedCastTo<ArrayObject>();
+        if (array && array->IsDense() && k < array->DenseSize()) {
+            array->SetElement(static_cast<uint32_t>(k), value);
+        } else {
+            Objects::Set(obj, IndexToKey(k), value, true);
+        }
+    }
+    for (int64_t k = itemCount + undefinedCount; k < len; k++) {
+        DeletePropertyOrThrow(obj, IndexToKey(k));
+    }
+    return obj;
+}
+
+Handle<JSValue> BuiltinArray::prototype::splice(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> O = Conversion::ToObject(that);
+    int64_t len = Conversion::ToLength(Objects::Get(O, "length"));
+    int64_t actualStart = RelativeIndex(GetArg(args, 0), len);
+    size_t argCount = args->Length();
+    int64_t actualDeleteCount;
+    if (argCount == 0) {
+        actualDeleteCount = 0;
+    } else if (argCount == 1) {
+        actualDeleteCount = len - actualStart;
+    } else {
+        double dc = Conversion::ToNumberValue(args->Get(1));
+        dc = std::isnan(dc) ? 0 : std::trunc(dc);
+        actualDeleteCount = static_cast<int64_t>(std::min(std::max(dc, 0.0), static_cast<double>(len - actualStart)));
+    }
+    Handle<Array<JSValue>> items = GetRestArg(args, 2);
+    int64_t itemCount = static_cast<int64_t>(items->Length());
+    if (len + itemCount - actualDeleteCount > 0x1FFFFFFFFFFFFFLL) {
+        Exceptions::ThrowTypeError("Array length exceeds the maximum");
+    }
+
+    Handle<JSObject> A = ArraySpeciesCreate(O, actualDeleteCount);
+    for (int64_t k = 0; k < actualDeleteCount; k++) {
+        Handle<JSValue> fromValue;
+        if (GetElementIfPresent(O, actualStart + k, fromValue)) {
+            CreateElement(A, k, fromValue);
+        }
+    }
+    Objects::Set(A, "length", JSNumber::New(actualDeleteCount), true);
+
+    // The species constructor may have changed the array, so this is checked only now
+    Handle<ArrayObject> array = O.ExactCheckedCastTo<ArrayObject>();
+    if (array && array->IsPacked() && array->length() == len && array->IsLengthWritable() &&
+            (itemCount <= actualDeleteCount || (array->CanAppend() && len + itemCount - actualDeleteCount < 0xFFFFFFFF && HasNoInheritedElements(array)))) {
+        array->SpliceElements(static_cast<uint32_t>(actualStart), static_cast<uint32_t>(actualDeleteCount), items);
+        return A;
+    }
+
+    if (itemCount < actualDeleteCount) {
+        for (int64_t k = actualStart; k < len - actualDeleteCount; k++) {
+            Handle<JSString> from = IndexToKey(k + actualDeleteCount);
+            Handle<JSString> to = IndexToKey(k + itemCount);
+            if (Objects::HasProperty(O, from)) {
+                Objects::Set(O, to, Objects::Get(O, from), true);
+            } else {
+                DeletePropertyOrThrow(O, to);
+            }
+        }
+        for (int64_t k = len; k > len - actualDeleteCount + itemCount; k--) {
+            DeletePropertyOrThrow(O, IndexToKey(k - 1));
+        }
+    } else if (itemCount > actualDeleteCount) {
+        for (int64_t k = len - actualDeleteCount; k > actualStart; k--) {
+            Handle<JSString> from = IndexToKey(k + actualDeleteCount - 1);
+            Handle<JSString> to = IndexToKey(k + itemCount - 1);
+            if (Objects::HasProperty(O, from)) {
+                Objects::Set(O, to, Objects::Get(O, from), true);
+            } else {
+                DeletePropertyOrThrow(O, to);
+            }
+        }
+    }
+    for (int64_t k = 0; k < itemCount; k++) {
+        Objects::Set(O, IndexToKey(actualStart + k), items->Get(k), true);
+    }
+    Objects::Set(O, "length", JSNumber::New(len - actualDeleteCount + itemCount), true);
+    return A;
+}
+
 Handle<JSValue> BuiltinArray::prototype::keys(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
     return CreateArrayIterator(Conversion::ToObject(that), ArrayIteratorObject::IterationKind::kKey);
 }
@@ -64,29 +608,7 @@ Handle<JSValue> BuiltinArray::Iterator_next(const Handle<JSValue>& that, const H
     if (!O) {
         Exceptions::ThrowIncompatibleReceiverTypeError("Array Iterator.prototype.next");
     }
-    Handle<JSObject> a = O->iteratedObject();
-    if (!a) {
-        return Iterators::CreateIterResultObject(nullptr, true);
-    }
-    uint32_t index = O->arrayIteratorNextIndex();
-    ArrayIteratorObject::IterationKind itemKind = O->arrayIterationKind();
-    // 8. If a has a[[TypedArrayName]] internal slot, then
-    //     a.Let len be the value of Os[[ArrayLength]] internal slot.
-    // 9. Else,
-    int64_t len = Conversion::ToLength(Objects::Get(a, "length"));
-    if (index >= len) {
-        O->iteratedObject(nullptr);
-        return Iterators::CreateIterResultObject(nullptr, true);
-    }
-    O->arrayIteratorNextIndex(index + 1);
-    Handle<JSNumber> keyAsNum = JSNumber::New(static_cast<int64_t>(index));
-    if (itemKind == ArrayIteratorObject::IterationKind::kKey) {
-        return Iterators::CreateIterResultObject(keyAsNum, false);
-    }
-    Handle<JSValue> elementValue = Objects::Get(a, Conversion::ToString(keyAsNum));
-    if (itemKind == ArrayIteratorObject::IterationKind::kValue) {
-        return Iterators::CreateIterResultObject(elementValue, false);
-    } else {
-        throw "return Iterators::CreateIterResultObject([index, elementValue], false);";
-    }
+    Handle<JSValue> value;
+    bool done = Iterators::ArrayIteratorNext(O, value);
+    return Iterators::CreateIterResultObject(value, done);
 }
\ No newline at end of file
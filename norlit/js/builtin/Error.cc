@@ -8,6 +8,7 @@
 #include "../Conversion.h"
 
 #include "../object/Exotics.h"
+#include "../bytecode/Code.h"
 
 #include "../Exception.h"
 
@@ -16,10 +17,20 @@ using namespace norlit::js;
 using namespace norlit::js::vm;
 using namespace norlit::js::object;
 using namespace norlit::js::builtin;
+using namespace norlit::js::bytecode;
 using namespace norlit::util;
 
 namespace {
 
+// Append the line and column being executed by the frame, if it runs code with a known source
+void AppendLocation(std::wstring& builder, const Handle<ErrorFrame>& frame) {
+    Handle<Code> code = frame->code();
+    size_t line, column;
+    if (code && code->FindLineAndColumn(frame->pc(), line, column)) {
+        builder += L" (" + std::to_wstring(line) + L":" + std::to_wstring(column) + L")";
+    }
+}
+
 Handle<JSString> ErrorToString(const Handle<JSObject>& O, const char* ctorName) {
     Handle<JSString> name;
     if (Handle<JSValue> nameAsValue = Objects::Get(O, "name")) {
@@ -43,8 +54,6 @@ Handle<JSString> ErrorToString(const Handle<JSObject>& O, const char* ctorName)
 }
 
 Handle<JSObject> ConstructErrorObject(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target, Realm::Intrinsic proto, const char* ctorName) {
-    static int reentry = 0;
-    reentry ++;
     Handle<JSValue> message = GetArg(args, 0);
     Handle<JSObject> O = Objects::OrdinaryCreateFromConstructor<ErrorObject>(target, proto);
     if (message) {
@@ -59,61 +68,101 @@ Handle<JSObject> ConstructErrorObject(const Handle<Array<JSValue>>& args, const
         });
     }
 
+    Handle<ErrorObject> E = O.CastTo<ErrorObject>();
+    E->stack(ErrorToString(O, ctorName));
 
-    Handle<JSString> stackString = ErrorToString(O, ctorName);
+    // The frame of the constructor itself is left out
     ArrayList<Context>& ctx = Context::GetContextStack();
+    size_t count = ctx.Size() ? ctx.Size() - 1 : 0;
+    Handle<Array<ErrorFrame>> frames = Array<ErrorFrame>::New(count);
+    for (size_t i = 0; i < count; i++) {
+        Handle<Context> c = ctx.Get(count - 1 - i);
+        Handle<ErrorFrame> frame = new ErrorFrame();
+        frame->function(c->function());
+        frame->thisValue(c->thisPointer());
+        if (Handle<BytecodeContext> bytecodeContext = c.DynamicCastTo<BytecodeContext>()) {
+            frame->code(bytecodeContext->GetCode());
+            frame->pc(bytecodeContext->GetPc());
+        }
+        frames->Put(i, frame);
+    }
+    E->stackFrames(frames);
+    return O;
+}
 
-    if (reentry == 1) {
-        std::wstring stackBuilder = &stackString->ToWChar()->At(0);
-
-        for (size_t size = ctx.Size(), i = size - 2; i < size; i--) {
-            Handle<Context> c = ctx.Get(i);
-
-            Handle<JSValue> that = c->thisPointer();
-            Handle<ESFunctionBase> func = c->function();
-            if (that&&!Testing::Is<JSNull>(that)) {
-                try {
-                    Handle<JSValue> ctor = Objects::GetV(that, "constructor");
-                    if (!ctor) {
-                        goto fallback;
-                    }
-                    Handle<JSString> ctorName = Conversion::ToString(Objects::GetV(ctor, "name"));
-                    Handle<JSString> funcName = Conversion::ToString(Objects::GetV(func, "name"));
-                    stackBuilder += L"\n    at ";
-                    stackBuilder += &ctorName->ToWChar()->At(0);
-                    stackBuilder += '.';
-                    stackBuilder += &funcName->ToWChar()->At(0);
-                } catch (ESException&) {
+// Format the captured frames into the stack trace
+void FormatStack(const Handle<ErrorObject>& E) {
+    Handle<Array<ErrorFrame>> frames = E->stackFrames();
+    // Reading the stack while it is formatted gives the first line only
+    E->stackFrames(nullptr);
+    std::wstring stackBuilder = &E->stack()->ToWChar()->At(0);
+
+    for (size_t i = 0, size = frames->Length(); i < size; i++) {
+        Handle<ErrorFrame> frame = frames->Get(i);
+
+        Handle<JSValue> that = frame->thisValue();
+        Handle<ESFunctionBase> func = frame->function();
+        if (that&&!Testing::Is<JSNull>(that)) {
+            try {
+                Handle<JSValue> ctor = Objects::GetV(that, "constructor");
+                if (!ctor) {
                     goto fallback;
                 }
-                continue;
-            }
-
-fallback:
-            if (func) {
+                Handle<JSString> ctorName = Conversion::ToString(Objects::GetV(ctor, "name"));
                 Handle<JSString> funcName = Conversion::ToString(Objects::GetV(func, "name"));
                 stackBuilder += L"\n    at ";
+                stackBuilder += &ctorName->ToWChar()->At(0);
+                stackBuilder += '.';
                 stackBuilder += &funcName->ToWChar()->At(0);
-            } else {
-                stackBuilder += L"\n    at script";
+            } catch (ESException&) {
+                goto fallback;
             }
+            AppendLocation(stackBuilder, frame);
+            continue;
         }
 
-        stackString = JSString::New(stackBuilder.c_str());
-    } else {
-        stackString = JSString::Concat(stackString, JSString::New("\n    Due to Error re-entrance, stack information is not displayed"));
+fallback:
+        if (func) {
+            Handle<JSString> funcName = Conversion::ToString(Objects::GetV(func, "name"));
+            stackBuilder += L"\n    at ";
+            stackBuilder += &funcName->ToWChar()->At(0);
+        } else {
+            stackBuilder += L"\n    at script";
+        }
+        AppendLocation(stackBuilder, frame);
     }
 
-    Objects::DefinePropertyOrThrow(O, JSString::New("stack"), PropertyDescriptor{
-        { stackString },
+    E->stack(JSString::New(stackBuilder.c_str()));
+}
+
+Handle<JSValue> GetStack(const Handle<JSValue>& O) {
+    if (!Testing::Is<JSObject>(O)) {
+        return nullptr;
+    }
+    Handle<ErrorObject> E = O.ExactCheckedCastTo<ErrorObject>();
+    if (!E) {
+        return nullptr;
+    }
+    if (E->stackFrames()) {
+        FormatStack(E);
+    }
+    return E->stack();
+}
+
+// Assigning to stack gives the object an own stack property, as it did when stack was a data property
+Handle<JSValue> SetStack(const Handle<JSValue>& O, const Handle<Array<JSValue>>& args) {
+    if (!Testing::Is<JSObject>(O)) {
+        Exceptions::ThrowIncompatibleReceiverTypeError("set stack");
+    }
+    Objects::DefinePropertyOrThrow(O.CastTo<JSObject>(), JSString::New("stack"), PropertyDescriptor{
+        GetArg(args, 0),
         nullopt,
         nullopt,
         true,
         false,
         true
     });
-
-    return O;
+    return nullptr;
 }
 
 }
@@ -130,6 +179,12 @@ Handle<JSValue> className::prototype::toString(const Handle<JSValue>& O, const H
 		Exceptions::ThrowIncompatibleReceiverTypeError(#className ".prototype.call");\
     }\
     return ErrorToString(O.CastTo<JSObject>(), #className);\
+}\
+Handle<JSValue> className::prototype::get_stack(const Handle<JSValue>& O, const Handle<Array<JSValue>>&) {\
+    return GetStack(O);\
+}\
+Handle<JSValue> className::prototype::set_stack(const Handle<JSValue>& O, const Handle<Array<JSValue>>& args) {\
+    return SetStack(O, args);\
 }
 
 ERROR_DEFINITION_GENERATE(Error)
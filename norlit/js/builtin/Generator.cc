@@ -33,23 +33,9 @@ Handle<GeneratorObject> GeneratorValidate(const Handle<JSValue>& val) {
 
 Handle<JSValue> Generator::prototype::next(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
     Handle<GeneratorObject> gen = GeneratorValidate(that);
-    if (gen->generatorState() == GeneratorObject::GeneratorState::kCompleted) {
-        return Iterators::CreateIterResultObject(nullptr, true);
-    }
-    Handle<JSValue> value = GetArg(args, 0);
-    Handle<BytecodeContext> ctx = gen->generatorContext();
-    gen->generatorState(GeneratorObject::GeneratorState::kExecuting);
-    Context::PushContext(ctx);
-    NORLIT_SCOPE_EXIT{ Context::PopContext(); };
-    ctx->Push(value);
-    BytecodeContext::ReturnStatus status = ctx->Run();
-    if (status == BytecodeContext::ReturnStatus::kReturn) {
-        gen->generatorState(GeneratorObject::GeneratorState::kCompleted);
-        return Iterators::CreateIterResultObject(ctx->Pop(), true);
-    } else {
-        gen->generatorState(GeneratorObject::GeneratorState::kSuspendedYield);
-        return Iterators::CreateIterResultObject(ctx->Pop(), false);
-    }
+    Handle<JSValue> result;
+    bool done = Iterators::GeneratorResume(gen, GetArg(args, 0), result);
+    return Iterators::CreateIterResultObject(result, done);
 }
 
 Handle<JSValue> Generator::prototype::return_(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
@@ -0,0 +1,258 @@
+#include "../all.h"
+
+#include "Builtin.h"
+
+#include "../vm/Context.h"
+#include "../object/Exotics.h"
+
+#include "../../util/Arrays.h"
+
+using namespace norlit::gc;
+using namespace norlit::util;
+using namespace norlit::js;
+using namespace norlit::js::vm;
+using namespace norlit::js::object;
+using namespace norlit::js::builtin;
+
+namespace {
+Handle<MapObject> ThisMap(const Handle<JSValue>& that, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<MapObject> M = that.ExactCheckedCastTo<MapObject>()) {
+            return M;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+Handle<WeakMapObject> ThisWeakMap(const Handle<JSValue>& that, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<WeakMapObject> M = that.ExactCheckedCastTo<WeakMapObject>()) {
+            return M;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+// Whether the adder a newly created collection looks up is the built-in one of the unmodified
+// intrinsic prototype, so entries can be added without calling it
+bool HasBuiltinAdder(const Handle<JSObject>& collection, const Handle<JSObject>& intrinsic) {
+    return collection->GetPrototypeOf() == intrinsic && intrinsic.CastTo<JSOrdinaryObject>()->IsWatchIntact();
+}
+
+using EntryAdder = void (*)(const Handle<JSObject>&, const Handle<JSValue>&, const Handle<JSValue>&);
+
+void AddMapEntry(const Handle<JSObject>& map, const Handle<JSValue>& key, const Handle<JSValue>& value) {
+    Handle<MapObject> M = map.CastTo<MapObject>();
+    Handle<OrderedHashTable> table = M->mapData();
+    OrderedHashTable::Set(table, key, value);
+    M->mapData(table);
+}
+
+void AddWeakMapEntry(const Handle<JSObject>& map, const Handle<JSValue>& key, const Handle<JSValue>& value) {
+    if (!Testing::Is<JSObject>(key)) {
+        Exceptions::ThrowTypeError("Invalid value used as weak map key");
+    }
+    key.CastTo<JSOrdinaryObject>()->WeakMapValues(true)->Put(map, value);
+}
+
+// Values key is mapped to by WeakMaps, or null if it is not a key of any
+Handle<HashMap<JSObject, JSValue, true>> WeakMapValuesOf(const Handle<JSValue>& key) {
+    if (!Testing::Is<JSObject>(key)) {
+        return nullptr;
+    }
+    return key.CastTo<JSOrdinaryObject>()->WeakMapValues(false);
+}
+
+// Steps shared by the Map and WeakMap constructors: add the [key, value] entries of iterable to
+// target through adder, or through builtinAdder if adder is known to be the built-in method
+void AddEntriesFromIterable(const Handle<JSObject>& target, const Handle<JSValue>& iterable, const char* adderName, EntryAdder builtinAdder) {
+    Handle<JSValue> adder = Objects::Get(target, adderName);
+    if (!Testing::IsCallable(adder)) {
+        Exceptions::ThrowTypeError("Adder of the collection is not a function");
+    }
+    Handle<JSObject> iter = Iterators::GetIterator(iterable);
+    Handle<JSValue> nextItem;
+    Handle<JSValue> k;
+    Handle<JSValue> v;
+    while (Iterators::IteratorStepValue(iter, nextItem)) {
+        try {
+            if (!Testing::Is<JSObject>(nextItem)) {
+                Exceptions::ThrowTypeError("Iterator value is not an entry object");
+            }
+            // Elements of packed arrays are own data properties, so they can be read directly
+            Handle<ArrayObject> entry = nextItem.ExactCheckedCastTo<ArrayObject>();
+            if (entry && entry->IsPacked() && entry->length() >= 2) {
+                k = entry->GetElement(0);
+                v = entry->GetElement(1);
+            } else {
+                k = Objects::Get(nextItem.CastTo<JSObject>(), "0");
+                v = Objects::Get(nextItem.CastTo<JSObject>(), "1");
+            }
+            if (builtinAdder) {
+                builtinAdder(target, k, v);
+            } else {
+                Objects::Call(adder.CastTo<JSObject>(), target, Arrays::ToArray<JSValue>(k, v));
+            }
+        } catch (ESException&) {
+            // The original exception wins over anything thrown while closing
+            try {
+                Iterators::IteratorClose(iter);
+            } catch (ESException&) {
+            }
+            throw;
+        }
+    }
+}
+
+Handle<JSObject> CreateMapIterator(const Handle<MapObject>& map, MapIteratorObject::IterationKind kind) {
+    Handle<MapIteratorObject> iterator = Objects::ObjectCreate<MapIteratorObject>(Context::CurrentRealm()->MapIteratorPrototype());
+    iterator->iteratedTable(map->mapData());
+    iterator->mapNextIndex(0);
+    iterator->mapIterationKind(kind);
+    return iterator;
+}
+}
+
+Handle<JSValue> Map::Call(const Handle<JSValue>&, const Handle<Array<JSValue>>&) {
+    Exceptions::ThrowTypeError("Constructor Map requires 'new'");
+}
+
+// 23.1.1.1 Map([iterable])
+Handle<JSObject> Map::Construct(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target) {
+    Handle<MapObject> map = Objects::OrdinaryCreateFromConstructor<MapObject>(target, &Realm::MapPrototype);
+    map->mapData(OrderedHashTable::New(true));
+    Handle<JSValue> iterable = GetArg(args, 0);
+    if (!iterable || iterable->GetType() == JSValue::Type::kNull) {
+        return map;
+    }
+    bool builtin = HasBuiltinAdder(map, Context::CurrentRealm()->MapPrototype());
+    AddEntriesFromIterable(map, iterable, "set", builtin ? AddMapEntry : nullptr);
+    return map;
+}
+
+Handle<JSValue> Map::get_Symbol_species(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return that;
+}
+
+Handle<JSValue> Map::prototype::clear(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    Handle<MapObject> M = ThisMap(that, "Map.prototype.clear");
+    Handle<OrderedHashTable> table = M->mapData();
+    OrderedHashTable::Clear(table);
+    M->mapData(table);
+    return nullptr;
+}
+
+Handle<JSValue> Map::prototype::delete_(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<MapObject> M = ThisMap(that, "Map.prototype.delete");
+    Handle<OrderedHashTable> table = M->mapData();
+    bool deleted = OrderedHashTable::Delete(table, GetArg(args, 0));
+    M->mapData(table);
+    return JSBoolean::New(deleted);
+}
+
+Handle<JSValue> Map::prototype::entries(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return CreateMapIterator(ThisMap(that, "Map.prototype.entries"), MapIteratorObject::IterationKind::kBoth);
+}
+
+// 23.1.3.5 Map.prototype.forEach(callbackfn[, thisArg])
+// Entries added during the iteration are visited, and entries deleted before being reached are not
+Handle<JSValue> Map::prototype::forEach(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<MapObject> M = ThisMap(that, "Map.prototype.forEach");
+    Handle<JSValue> callbackfn = GetArg(args, 0);
+    if (!Testing::IsCallable(callbackfn)) {
+        Exceptions::ThrowTypeError("Callback is not a function");
+    }
+    Handle<JSValue> T = GetArg(args, 1);
+    Handle<OrderedHashTable> table = M->mapData();
+    Handle<JSValue> key;
+    Handle<JSValue> value;
+    for (uint32_t index = 0; OrderedHashTable::Seek(table, index); index++) {
+        key = table->KeyAt(index);
+        value = table->ValueAt(index);
+        Objects::Call(callbackfn.CastTo<JSObject>(), T, Arrays::ToArray<JSValue>(value, key, M.CastTo<JSValue>()));
+    }
+    return nullptr;
+}
+
+Handle<JSValue> Map::prototype::get(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    return ThisMap(that, "Map.prototype.get")->mapData()->Get(GetArg(args, 0));
+}
+
+Handle<JSValue> Map::prototype::has(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    return JSBoolean::New(ThisMap(that, "Map.prototype.has")->mapData()->Has(GetArg(args, 0)));
+}
+
+Handle<JSValue> Map::prototype::keys(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return CreateMapIterator(ThisMap(that, "Map.prototype.keys"), MapIteratorObject::IterationKind::kKey);
+}
+
+Handle<JSValue> Map::prototype::set(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<MapObject> M = ThisMap(that, "Map.prototype.set");
+    AddMapEntry(M, GetArg(args, 0), GetArg(args, 1));
+    return M;
+}
+
+Handle<JSValue> Map::prototype::get_size(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return JSNumber::New(static_cast<int64_t>(ThisMap(that, "Map.prototype.size")->mapData()->Size()));
+}
+
+Handle<JSValue> Map::prototype::values(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return CreateMapIterator(ThisMap(that, "Map.prototype.values"), MapIteratorObject::IterationKind::kValue);
+}
+
+Handle<JSValue> Map::Iterator_next(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    if (!Testing::Is<JSObject>(that)) {
+        Exceptions::ThrowIncompatibleReceiverTypeError("Map Iterator.prototype.next");
+    }
+    Handle<MapIteratorObject> O = that.ExactCheckedCastTo<MapIteratorObject>();
+    if (!O) {
+        Exceptions::ThrowIncompatibleReceiverTypeError("Map Iterator.prototype.next");
+    }
+    Handle<JSValue> value;
+    bool done = Iterators::MapIteratorNext(O, value);
+    return Iterators::CreateIterResultObject(value, done);
+}
+
+Handle<JSValue> WeakMap::Call(const Handle<JSValue>&, const Handle<Array<JSValue>>&) {
+    Exceptions::ThrowTypeError("Constructor WeakMap requires 'new'");
+}
+
+// 23.3.1.1 WeakMap([iterable])
+Handle<JSObject> WeakMap::Construct(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target) {
+    Handle<WeakMapObject> map = Objects::OrdinaryCreateFromConstructor<WeakMapObject>(target, &Realm::WeakMapPrototype);
+    Handle<JSValue> iterable = GetArg(args, 0);
+    if (!iterable || iterable->GetType() == JSValue::Type::kNull) {
+        return map;
+    }
+    bool builtin = HasBuiltinAdder(map, Context::CurrentRealm()->WeakMapPrototype());
+    AddEntriesFromIterable(map, iterable, "set", builtin ? AddWeakMapEntry : nullptr);
+    return map;
+}
+
+Handle<JSValue> WeakMap::prototype::delete_(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakMapObject> M = ThisWeakMap(that, "WeakMap.prototype.delete");
+    Handle<HashMap<JSObject, JSValue, true>> values = WeakMapValuesOf(GetArg(args, 0));
+    if (!values || !values->ContainsKey(M)) {
+        return JSBoolean::New(false);
+    }
+    values->Remove(M);
+    return JSBoolean::New(true);
+}
+
+Handle<JSValue> WeakMap::prototype::get(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakMapObject> M = ThisWeakMap(that, "WeakMap.prototype.get");
+    Handle<HashMap<JSObject, JSValue, true>> values = WeakMapValuesOf(GetArg(args, 0));
+    return values ? values->Get(M) : nullptr;
+}
+
+Handle<JSValue> WeakMap::prototype::has(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakMapObject> M = ThisWeakMap(that, "WeakMap.prototype.has");
+    Handle<HashMap<JSObject, JSValue, true>> values = WeakMapValuesOf(GetArg(args, 0));
+    return JSBoolean::New(values && values->ContainsKey(M));
+}
+
+Handle<JSValue> WeakMap::prototype::set(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakMapObject> M = ThisWeakMap(that, "WeakMap.prototype.set");
+    AddWeakMapEntry(M, GetArg(args, 0), GetArg(args, 1));
+    return M;
+}
@@ -0,0 +1,662 @@
+#include "../all.h"
+
+#include "Builtin.h"
+
+#include "../vm/Context.h"
+#include "../object/Exotics.h"
+#include "../regexp/Program.h"
+
+#include "../../util/Arrays.h"
+#include "../../util/ArrayList.h"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace norlit::gc;
+using namespace norlit::util;
+using namespace norlit::js;
+using namespace norlit::js::vm;
+using namespace norlit::js::object;
+using namespace norlit::js::regexp;
+using namespace norlit::js::builtin;
+
+namespace {
+
+Handle<JSObject> ThisObject(const Handle<JSValue>& that, const char* caller) {
+    if (!Testing::Is<JSObject>(that)) {
+        Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+    }
+    return that.CastTo<JSObject>();
+}
+
+Handle<RegExpObject> ThisRegExp(const Handle<JSValue>& that, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<RegExpObject> R = that.ExactCheckedCastTo<RegExpObject>()) {
+            return R;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+// The RegExp object if its exec method and flag accessors are the built-in ones of an unmodified
+// prototype, so it can be matched without looking them up or creating result objects
+Handle<RegExpObject> BuiltinRegExp(const Handle<JSObject>& R) {
+    Handle<RegExpObject> regexp = R.ExactCheckedCastTo<RegExpObject>();
+    if (!regexp || !regexp->HasOnlyLastIndex()) {
+        return nullptr;
+    }
+    Handle<JSObject> proto = Context::CurrentRealm()->RegExpPrototype();
+    if (regexp->GetPrototypeOf() != proto || !proto.CastTo<JSOrdinaryObject>()->IsWatchIntact()) {
+        return nullptr;
+    }
+    return regexp;
+}
+
+// 21.2.5.2.3 AdvanceStringIndex
+int64_t AdvanceStringIndex(const Handle<JSString>& S, int64_t index, bool unicode) {
+    if (!unicode || index + 1 >= static_cast<int64_t>(S->Length())) {
+        return index + 1;
+    }
+    char16_t first = S->At(static_cast<size_t>(index));
+    if (first < 0xD800 || first > 0xDBFF) {
+        return index + 1;
+    }
+    char16_t second = S->At(static_cast<size_t>(index + 1));
+    if (second < 0xDC00 || second > 0xDFFF) {
+        return index + 1;
+    }
+    return index + 2;
+}
+
+// Steps of 21.2.5.2.2 RegExpBuiltinExec up to the match, including the update of lastIndex. On
+// success captures holds the start and end of each group, or -1 for groups that did not participate
+bool RegExpBuiltinMatch(const Handle<RegExpObject>& R, const Handle<JSString>& S, std::vector<int64_t>& captures) {
+    int64_t lastIndex = Conversion::ToLength(Objects::Get(R, "lastIndex"));
+    Handle<Program> matcher = R->regExpMatcher();
+    bool globalOrSticky = (matcher->Flags() & (Program::kGlobal | Program::kSticky)) != 0;
+    if (!globalOrSticky) {
+        lastIndex = 0;
+    }
+    if (lastIndex > static_cast<int64_t>(S->Length()) || !matcher->Exec(S, static_cast<size_t>(lastIndex), captures)) {
+        if (globalOrSticky) {
+            Objects::Set(R, "lastIndex", JSNumber::New(0), true);
+        }
+        return false;
+    }
+    if (globalOrSticky) {
+        Objects::Set(R, "lastIndex", JSNumber::New(captures[1]), true);
+    }
+    return true;
+}
+
+Handle<JSValue> Capture(const Handle<JSString>& S, const std::vector<int64_t>& captures, size_t group) {
+    int64_t start = captures[group * 2];
+    if (start == -1) {
+        return nullptr;
+    }
+    return S->Substring(static_cast<size_t>(start), static_cast<size_t>(captures[group * 2 + 1]));
+}
+
+// 21.2.5.2.2 RegExpBuiltinExec
+Handle<JSValue> RegExpBuiltinExec(const Handle<RegExpObject>& R, const Handle<JSString>& S) {
+    std::vector<int64_t> captures;
+    if (!RegExpBuiltinMatch(R, S, captures)) {
+        return JSNull::New();
+    }
+    // Elements are added to the backing store of the new array directly, which cannot fail
+    Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+    Objects::CreateDataProperty(A, "index", JSNumber::New(captures[0]));
+    Objects::CreateDataProperty(A, "input", S);
+    for (size_t i = 0, count = captures.size() / 2; i < count; i++) {
+        A->AddElement(static_cast<uint32_t>(i), Capture(S, captures, i));
+    }
+    return A;
+}
+
+// 21.2.5.2.1 RegExpExec
+Handle<JSValue> RegExpExec(const Handle<JSObject>& R, const Handle<JSString>& S) {
+    Handle<JSValue> exec = Objects::Get(R, "exec");
+    if (Testing::IsCallable(exec)) {
+        Handle<JSValue> result = Objects::Call(exec.CastTo<JSObject>(), R, Arrays::ToArray<JSValue>(S));
+        if (!Testing::Is<JSObject>(result) && !Testing::Is<JSNull>(result)) {
+            Exceptions::ThrowTypeError("Result of exec must be object or null");
+        }
+        return result;
+    }
+    Handle<RegExpObject> regexp = R.ExactCheckedCastTo<RegExpObject>();
+    if (!regexp) {
+        Exceptions::ThrowTypeError("exec is not callable");
+    }
+    return RegExpBuiltinExec(regexp, S);
+}
+
+// Steps of 21.2.3.1 RegExp(pattern, flags) after newTarget is determined
+Handle<JSObject> RegExpConstruct(const Handle<JSValue>& pattern, const Handle<JSValue>& flags, bool patternIsRegExp, const Handle<JSObject>& newTarget) {
+    Handle<JSValue> P;
+    Handle<JSValue> F;
+    Handle<RegExpObject> regexp = Testing::Is<JSObject>(pattern) ? pattern.ExactCheckedCastTo<RegExpObject>() : nullptr;
+    if (regexp) {
+        P = regexp->originalSource();
+        F = flags ? flags : regexp->originalFlags().CastTo<JSValue>();
+    } else if (patternIsRegExp) {
+        P = Objects::Get(pattern.CastTo<JSObject>(), "source");
+        F = flags ? flags : Objects::Get(pattern.CastTo<JSObject>(), "flags");
+    } else {
+        P = pattern;
+        F = flags;
+    }
+    Handle<JSObject> O = Objects::RegExpAlloc(newTarget);
+    return Objects::RegExpInitialize(O, P, F);
+}
+
+// Shared by the flag accessors. The prototype has the accessors but no flags
+Handle<JSValue> GetFlag(const Handle<JSValue>& that, uint8_t flag, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<RegExpObject> R = that.ExactCheckedCastTo<RegExpObject>()) {
+            return JSBoolean::New((R->regExpMatcher()->Flags() & flag) != 0);
+        }
+        if (that == Context::CurrentRealm()->RegExpPrototype()) {
+            return nullptr;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+const wchar_t* EscapeLineTerminator(char16_t ch) {
+    switch (ch) {
+        case '\n':
+            return L"n";
+        case '\r':
+            return L"r";
+        case 0x2028:
+            return L"u2028";
+        case 0x2029:
+            return L"u2029";
+        default:
+            return nullptr;
+    }
+}
+
+// 21.2.3.2.4 EscapeRegExpPattern. Slashes outside classes and line terminators are escaped, so that
+// the source between slashes reads as a literal of the same pattern
+Handle<JSString> EscapeRegExpPattern(const Handle<JSString>& P) {
+    size_t length = P->Length();
+    if (length == 0) {
+        return JSString::New("(?:)");
+    }
+    std::wstring builder;
+    bool inClass = false;
+    for (size_t i = 0; i < length; i++) {
+        char16_t ch = P->At(i);
+        if (ch == '\\' && i + 1 < length) {
+            builder += ch;
+            ch = P->At(++i);
+            if (const wchar_t* escape = EscapeLineTerminator(ch)) {
+                builder += escape;
+            } else {
+                builder += ch;
+            }
+            continue;
+        }
+        if (const wchar_t* escape = EscapeLineTerminator(ch)) {
+            builder += '\\';
+            builder += escape;
+            continue;
+        }
+        if (ch == '/' && !inClass) {
+            builder += L"\\/";
+            continue;
+        }
+        if (ch == '[') {
+            inClass = true;
+        } else if (ch == ']') {
+            inClass = false;
+        }
+        builder += ch;
+    }
+    return JSString::New(builder.c_str());
+}
+
+void AppendSubstring(std::wstring& builder, const Handle<JSString>& S, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        builder += S->At(i);
+    }
+}
+
+// RegExp.prototype[Symbol.replace] on a RegExp with the built-in behaviour. All matches are found
+// before any replacement is computed, as a replacer function must not affect them
+Handle<JSValue> ReplaceBuiltin(
+    const Handle<RegExpObject>& rx, const Handle<JSString>& S, const Handle<JSValue>& replaceValue, const Handle<JSString>& replaceString
+) {
+    Handle<Program> matcher = rx->regExpMatcher();
+    size_t lengthS = S->Length();
+    size_t groups = matcher->CaptureCount();
+    std::vector<int64_t> matches;
+    std::vector<int64_t> captures;
+    if (matcher->Flags() & Program::kGlobal) {
+        bool unicode = (matcher->Flags() & Program::kUnicode) != 0;
+        Objects::Set(rx, "lastIndex", JSNumber::New(0), true);
+        size_t lastIndex = 0;
+        while (lastIndex <= lengthS && matcher->Exec(S, lastIndex, captures)) {
+            matches.insert(matches.end(), captures.begin(), captures.end());
+            lastIndex = static_cast<size_t>(captures[1]);
+            if (captures[0] == captures[1]) {
+                lastIndex = static_cast<size_t>(AdvanceStringIndex(S, lastIndex, unicode));
+            }
+        }
+    } else if (RegExpBuiltinMatch(rx, S, captures)) {
+        matches = captures;
+    }
+    if (matches.empty()) {
+        return S;
+    }
+
+    bool functionalReplace = !replaceString;
+    bool hasSubstitutions = !functionalReplace && replaceString->IndexOf(JSString::New("$"), 0) != -1;
+    std::wstring builder;
+    size_t nextSourcePosition = 0;
+    for (size_t offset = 0; offset < matches.size(); offset += groups * 2) {
+        std::vector<int64_t> match(matches.begin() + offset, matches.begin() + offset + groups * 2);
+        size_t position = static_cast<size_t>(match[0]);
+        AppendSubstring(builder, S, nextSourcePosition, position);
+        nextSourcePosition = static_cast<size_t>(match[1]);
+        if (!functionalReplace && !hasSubstitutions) {
+            AppendSubstring(builder, replaceString, 0, replaceString->Length());
+            continue;
+        }
+        Handle<JSString> matched = S->Substring(position, nextSourcePosition);
+        Handle<Array<JSValue>> groupValues = Array<JSValue>::New(groups - 1);
+        for (size_t i = 1; i < groups; i++) {
+            groupValues->Put(i - 1, Capture(S, match, i));
+        }
+        if (!functionalReplace) {
+            String::GetSubstitution(builder, matched, S, position, groupValues, replaceString);
+            continue;
+        }
+        Handle<Array<JSValue>> replacerArgs = Array<JSValue>::New(groups + 2);
+        replacerArgs->Put(0, matched);
+        for (size_t i = 1; i < groups; i++) {
+            replacerArgs->Put(i, groupValues->Get(i - 1));
+        }
+        replacerArgs->Put(groups, JSNumber::New(static_cast<int64_t>(position)));
+        replacerArgs->Put(groups + 1, S);
+        Handle<JSString> replacement = Conversion::ToString(Objects::Call(replaceValue.CastTo<JSObject>(), nullptr, replacerArgs));
+        AppendSubstring(builder, replacement, 0, replacement->Length());
+    }
+    AppendSubstring(builder, S, nextSourcePosition, lengthS);
+    return JSString::New(builder.c_str());
+}
+
+// RegExp.prototype[Symbol.split] on a RegExp with the built-in behaviour whose species constructor
+// is %RegExp%. Instead of trying a sticky copy at every position, the matcher searches for the next
+// match, which is where the sticky attempts would first succeed
+Handle<JSValue> SplitBuiltin(const Handle<RegExpObject>& rx, const Handle<JSString>& S, uint32_t lim) {
+    Handle<Program> matcher = rx->regExpMatcher();
+    if (matcher->Flags() & Program::kSticky) {
+        matcher = Program::Compile(rx->originalSource(), matcher->Flags() & ~Program::kSticky);
+    }
+    bool unicodeMatching = (matcher->Flags() & Program::kUnicode) != 0;
+    // Elements are added to the backing store of the new array directly, which cannot fail
+    Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+    if (lim == 0) {
+        return A;
+    }
+    size_t size = S->Length();
+    std::vector<int64_t> captures;
+    if (size == 0) {
+        if (!matcher->Exec(S, 0, captures)) {
+            A->AddElement(0, S);
+        }
+        return A;
+    }
+    size_t p = 0;
+    size_t q = 0;
+    while (q < size) {
+        if (!matcher->Exec(S, q, captures) || static_cast<size_t>(captures[0]) >= size) {
+            break;
+        }
+        q = static_cast<size_t>(captures[0]);
+        size_t e = std::min(static_cast<size_t>(captures[1]), size);
+        if (e == p) {
+            q = static_cast<size_t>(AdvanceStringIndex(S, q, unicodeMatching));
+            continue;
+        }
+        A->AddElement(A->length(), S->Substring(p, q));
+        if (A->length() == lim) {
+            return A;
+        }
+        p = e;
+        for (size_t i = 1, groups = captures.size() / 2; i < groups; i++) {
+            A->AddElement(A->length(), Capture(S, captures, i));
+            if (A->length() == lim) {
+                return A;
+            }
+        }
+        q = p;
+    }
+    A->AddElement(A->length(), S->Substring(p, size));
+    return A;
+}
+
+}
+
+Handle<JSValue> RegExp::Call(const Handle<JSValue>&, const Handle<Array<JSValue>>& args) {
+    Handle<JSValue> pattern = GetArg(args, 0);
+    Handle<JSValue> flags = GetArg(args, 1);
+    bool patternIsRegExp = Testing::IsRegExp(pattern);
+    Handle<JSObject> newTarget = Context::CurrentRealm()->RegExp();
+    // Called as a function, a RegExp is returned as is unless flags are given
+    if (patternIsRegExp && !flags) {
+        Handle<JSValue> patternConstructor = Objects::Get(pattern.CastTo<JSObject>(), "constructor");
+        if (Testing::SameValue(newTarget, patternConstructor)) {
+            return pattern;
+        }
+    }
+    return RegExpConstruct(pattern, flags, patternIsRegExp, newTarget);
+}
+
+Handle<JSObject> RegExp::Construct(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target) {
+    Handle<JSValue> pattern = GetArg(args, 0);
+    return RegExpConstruct(pattern, GetArg(args, 1), Testing::IsRegExp(pattern), target);
+}
+
+Handle<JSValue> RegExp::get_Symbol_species(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return that;
+}
+
+Handle<JSValue> RegExp::prototype::exec(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<RegExpObject> R = ThisRegExp(that, "RegExp.prototype.exec");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    return RegExpBuiltinExec(R, S);
+}
+
+Handle<JSValue> RegExp::prototype::get_flags(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    Handle<JSObject> R = ThisObject(that, "RegExp.prototype.flags");
+    std::wstring result;
+    if (Conversion::ToBooleanValue(Objects::Get(R, "global"))) {
+        result += 'g';
+    }
+    if (Conversion::ToBooleanValue(Objects::Get(R, "ignoreCase"))) {
+        result += 'i';
+    }
+    if (Conversion::ToBooleanValue(Objects::Get(R, "multiline"))) {
+        result += 'm';
+    }
+    if (Conversion::ToBooleanValue(Objects::Get(R, "unicode"))) {
+        result += 'u';
+    }
+    if (Conversion::ToBooleanValue(Objects::Get(R, "sticky"))) {
+        result += 'y';
+    }
+    return JSString::New(result.c_str());
+}
+
+Handle<JSValue> RegExp::prototype::get_global(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return GetFlag(that, Program::kGlobal, "RegExp.prototype.global");
+}
+
+Handle<JSValue> RegExp::prototype::get_ignoreCase(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return GetFlag(that, Program::kIgnoreCase, "RegExp.prototype.ignoreCase");
+}
+
+Handle<JSValue> RegExp::prototype::Symbol_match(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> rx = ThisObject(that, "RegExp.prototype[Symbol.match]");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    if (Handle<RegExpObject> regexp = BuiltinRegExp(rx)) {
+        Handle<Program> matcher = regexp->regExpMatcher();
+        if (!(matcher->Flags() & Program::kGlobal)) {
+            return RegExpBuiltinExec(regexp, S);
+        }
+        // lastIndex ends up 0 after the failed match that stops the loop, so it is only kept locally
+        Objects::Set(rx, "lastIndex", JSNumber::New(0), true);
+        bool unicode = (matcher->Flags() & Program::kUnicode) != 0;
+        Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+        std::vector<int64_t> captures;
+        size_t lastIndex = 0;
+        while (lastIndex <= S->Length() && matcher->Exec(S, lastIndex, captures)) {
+            A->AddElement(A->length(), Capture(S, captures, 0));
+            lastIndex = static_cast<size_t>(captures[1]);
+            if (captures[0] == captures[1]) {
+                lastIndex = static_cast<size_t>(AdvanceStringIndex(S, lastIndex, unicode));
+            }
+        }
+        if (A->length() == 0) {
+            return JSNull::New();
+        }
+        return A;
+    }
+
+    if (!Conversion::ToBooleanValue(Objects::Get(rx, "global"))) {
+        return RegExpExec(rx, S);
+    }
+    bool fullUnicode = Conversion::ToBooleanValue(Objects::Get(rx, "unicode"));
+    Objects::Set(rx, "lastIndex", JSNumber::New(0), true);
+    Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+    while (true) {
+        Handle<JSValue> result = RegExpExec(rx, S);
+        if (Testing::Is<JSNull>(result)) {
+            if (A->length() == 0) {
+                return JSNull::New();
+            }
+            return A;
+        }
+        Handle<JSString> matchStr = Conversion::ToString(Objects::Get(result.CastTo<JSObject>(), "0"));
+        A->AddElement(A->length(), matchStr);
+        if (matchStr->Length() == 0) {
+            int64_t thisIndex = Conversion::ToLength(Objects::Get(rx, "lastIndex"));
+            Objects::Set(rx, "lastIndex", JSNumber::New(AdvanceStringIndex(S, thisIndex, fullUnicode)), true);
+        }
+    }
+}
+
+Handle<JSValue> RegExp::prototype::get_multiline(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return GetFlag(that, Program::kMultiline, "RegExp.prototype.multiline");
+}
+
+Handle<JSValue> RegExp::prototype::Symbol_replace(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> rx = ThisObject(that, "RegExp.prototype[Symbol.replace]");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    size_t lengthS = S->Length();
+    Handle<JSValue> replaceValue = GetArg(args, 1);
+    bool functionalReplace = Testing::IsCallable(replaceValue);
+    Handle<JSString> replaceString = functionalReplace ? nullptr : Conversion::ToString(replaceValue);
+    // Converting replaceValue may have changed rx, so it is checked afterwards
+    if (Handle<RegExpObject> regexp = BuiltinRegExp(rx)) {
+        return ReplaceBuiltin(regexp, S, replaceValue, replaceString);
+    }
+
+    bool global = Conversion::ToBooleanValue(Objects::Get(rx, "global"));
+    bool fullUnicode = false;
+    if (global) {
+        fullUnicode = Conversion::ToBooleanValue(Objects::Get(rx, "unicode"));
+        Objects::Set(rx, "lastIndex", JSNumber::New(0), true);
+    }
+    ArrayList<JSObject> results;
+    while (true) {
+        Handle<JSValue> result = RegExpExec(rx, S);
+        if (Testing::Is<JSNull>(result)) {
+            break;
+        }
+        results.Add(result.CastTo<JSObject>());
+        if (!global) {
+            break;
+        }
+        Handle<JSString> matchStr = Conversion::ToString(Objects::Get(result.CastTo<JSObject>(), "0"));
+        if (matchStr->Length() == 0) {
+            int64_t thisIndex = Conversion::ToLength(Objects::Get(rx, "lastIndex"));
+            Objects::Set(rx, "lastIndex", JSNumber::New(AdvanceStringIndex(S, thisIndex, fullUnicode)), true);
+        }
+    }
+
+    std::wstring builder;
+    size_t nextSourcePosition = 0;
+    for (size_t i = 0, count = results.Size(); i < count; i++) {
+        Handle<JSObject> result = results.Get(i);
+        int64_t nCaptures = std::max<int64_t>(Conversion::ToLength(Objects::Get(result, "length")) - 1, 0);
+        Handle<JSString> matched = Conversion::ToString(Objects::Get(result, "0"));
+        double index = Conversion::ToNumberValue(Objects::Get(result, "index"));
+        size_t position = std::isnan(index) || index <= 0 ? 0 : index >= lengthS ? lengthS : static_cast<size_t>(index);
+        Handle<Array<JSValue>> captures = Array<JSValue>::New(static_cast<size_t>(nCaptures));
+        for (int64_t n = 1; n <= nCaptures; n++) {
+            Handle<JSValue> capN = Objects::Get(result, Conversion::ToString(JSNumber::New(n)));
+            if (capN) {
+                capN = Conversion::ToString(capN);
+            }
+            captures->Put(static_cast<size_t>(n - 1), capN);
+        }
+        Handle<JSString> replacement;
+        if (functionalReplace) {
+            Handle<Array<JSValue>> replacerArgs = Array<JSValue>::New(static_cast<size_t>(nCaptures) + 3);
+            replacerArgs->Put(0, matched);
+            for (size_t n = 0; n < captures->Length(); n++) {
+                replacerArgs->Put(n + 1, captures->Get(n));
+            }
+            replacerArgs->Put(captures->Length() + 1, JSNumber::New(static_cast<int64_t>(position)));
+            replacerArgs->Put(captures->Length() + 2, S);
+            replacement = Conversion::ToString(Objects::Call(replaceValue.CastTo<JSObject>(), nullptr, replacerArgs));
+        }
+        // Matches that overlap text already replaced are dropped
+        if (position < nextSourcePosition) {
+            continue;
+        }
+        AppendSubstring(builder, S, nextSourcePosition, position);
+        if (functionalReplace) {
+            AppendSubstring(builder, replacement, 0, replacement->Length());
+        } else {
+            String::GetSubstitution(builder, matched, S, position, captures, replaceString);
+        }
+        nextSourcePosition = position + matched->Length();
+    }
+    if (nextSourcePosition < lengthS) {
+        AppendSubstring(builder, S, nextSourcePosition, lengthS);
+    }
+    return JSString::New(builder.c_str());
+}
+
+Handle<JSValue> RegExp::prototype::Symbol_search(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> rx = ThisObject(that, "RegExp.prototype[Symbol.search]");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    Handle<JSValue> previousLastIndex = Objects::Get(rx, "lastIndex");
+    Objects::Set(rx, "lastIndex", JSNumber::New(0), true);
+    if (Handle<RegExpObject> regexp = BuiltinRegExp(rx)) {
+        std::vector<int64_t> captures;
+        bool found = regexp->regExpMatcher()->Exec(S, 0, captures);
+        Objects::Set(rx, "lastIndex", previousLastIndex, true);
+        return JSNumber::New(found ? captures[0] : -1);
+    }
+    Handle<JSValue> result = RegExpExec(rx, S);
+    Objects::Set(rx, "lastIndex", previousLastIndex, true);
+    if (Testing::Is<JSNull>(result)) {
+        return JSNumber::New(-1);
+    }
+    return Objects::Get(result.CastTo<JSObject>(), "index");
+}
+
+Handle<JSValue> RegExp::prototype::get_source(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<RegExpObject> R = that.ExactCheckedCastTo<RegExpObject>()) {
+            return EscapeRegExpPattern(R->originalSource());
+        }
+        if (that == Context::CurrentRealm()->RegExpPrototype()) {
+            return JSString::New("(?:)");
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError("RegExp.prototype.source");
+}
+
+Handle<JSValue> RegExp::prototype::Symbol_split(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> rx = ThisObject(that, "RegExp.prototype[Symbol.split]");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    Handle<JSValue> limit = GetArg(args, 1);
+    Handle<JSObject> defaultConstructor = Context::CurrentRealm()->RegExp();
+    Handle<JSObject> C = Objects::SpeciesConstructor(rx, defaultConstructor);
+    uint32_t lim = 0xFFFFFFFF;
+    bool limitConverted = false;
+    if (C == defaultConstructor && BuiltinRegExp(rx)) {
+        if (limit) {
+            lim = Conversion::ToUInt32(Conversion::ToNumber(limit));
+        }
+        limitConverted = true;
+        // Converting limit may have changed rx, so it is checked afterwards
+        if (Handle<RegExpObject> regexp = BuiltinRegExp(rx)) {
+            return SplitBuiltin(regexp, S, lim);
+        }
+    }
+
+    Handle<JSString> flags = Conversion::ToString(Objects::Get(rx, "flags"));
+    bool unicodeMatching = flags->IndexOf(JSString::New("u"), 0) != -1;
+    Handle<JSString> newFlags = flags->IndexOf(JSString::New("y"), 0) != -1 ? flags : JSString::Concat(flags, JSString::New("y"));
+    Handle<JSObject> splitter = Objects::Construct(C, Arrays::ToArray<JSValue>(rx.CastTo<JSValue>(), newFlags.CastTo<JSValue>()));
+    // Elements are added to the backing store of the new array directly, which cannot fail
+    Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+    if (limit && !limitConverted) {
+        lim = Conversion::ToUInt32(Conversion::ToNumber(limit));
+    }
+    if (lim == 0) {
+        return A;
+    }
+    size_t size = S->Length();
+    if (size == 0) {
+        if (Testing::Is<JSNull>(RegExpExec(splitter, S))) {
+            A->AddElement(0, S);
+        }
+        return A;
+    }
+    size_t p = 0;
+    size_t q = 0;
+    while (q < size) {
+        Objects::Set(splitter, "lastIndex", JSNumber::New(static_cast<int64_t>(q)), true);
+        Handle<JSValue> z = RegExpExec(splitter, S);
+        if (Testing::Is<JSNull>(z)) {
+            q = static_cast<size_t>(AdvanceStringIndex(S, q, unicodeMatching));
+            continue;
+        }
+        size_t e = static_cast<size_t>(std::min<int64_t>(Conversion::ToLength(Objects::Get(splitter, "lastIndex")), size));
+        if (e == p) {
+            q = static_cast<size_t>(AdvanceStringIndex(S, q, unicodeMatching));
+            continue;
+        }
+        A->AddElement(A->length(), S->Substring(p, q));
+        if (A->length() == lim) {
+            return A;
+        }
+        p = e;
+        int64_t numberOfCaptures = std::max<int64_t>(Conversion::ToLength(Objects::Get(z.CastTo<JSObject>(), "length")) - 1, 0);
+        for (int64_t i = 1; i <= numberOfCaptures; i++) {
+            A->AddElement(A->length(), Objects::Get(z.CastTo<JSObject>(), Conversion::ToString(JSNumber::New(i))));
+            if (A->length() == lim) {
+                return A;
+            }
+        }
+        q = p;
+    }
+    A->AddElement(A->length(), S->Substring(p, size));
+    return A;
+}
+
+Handle<JSValue> RegExp::prototype::get_sticky(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return GetFlag(that, Program::kSticky, "RegExp.prototype.sticky");
+}
+
+Handle<JSValue> RegExp::prototype::test(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSObject> R = ThisObject(that, "RegExp.prototype.test");
+    Handle<JSString> S = Conversion::ToString(GetArg(args, 0));
+    if (Handle<RegExpObject> regexp = BuiltinRegExp(R)) {
+        std::vector<int64_t> captures;
+        return JSBoolean::New(RegExpBuiltinMatch(regexp, S, captures));
+    }
+    return JSBoolean::New(!Testing::Is<JSNull>(RegExpExec(R, S)));
+}
+
+Handle<JSValue> RegExp::prototype::toString(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    Handle<JSObject> R = ThisObject(that, "RegExp.prototype.toString");
+    Handle<JSString> pattern = Conversion::ToString(Objects::Get(R, "source"));
+    Handle<JSString> flags = Conversion::ToString(Objects::Get(R, "flags"));
+    return JSString::Concat({ JSString::New("/"), pattern, JSString::New("/"), flags });
+}
+
+Handle<JSValue> RegExp::prototype::get_unicode(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return GetFlag(that, Program::kUnicode, "RegExp.prototype.unicode");
+}
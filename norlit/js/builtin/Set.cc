@@ -0,0 +1,221 @@
+#include "../all.h"
+
+#include "Builtin.h"
+
+#include "../vm/Context.h"
+#include "../object/Exotics.h"
+
+#include "../../util/Arrays.h"
+
+using namespace norlit::gc;
+using namespace norlit::util;
+using namespace norlit::js;
+using namespace norlit::js::vm;
+using namespace norlit::js::object;
+using namespace norlit::js::builtin;
+
+namespace {
+Handle<SetObject> ThisSet(const Handle<JSValue>& that, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<SetObject> S = that.ExactCheckedCastTo<SetObject>()) {
+            return S;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+Handle<WeakSetObject> ThisWeakSet(const Handle<JSValue>& that, const char* caller) {
+    if (Testing::Is<JSObject>(that)) {
+        if (Handle<WeakSetObject> S = that.ExactCheckedCastTo<WeakSetObject>()) {
+            return S;
+        }
+    }
+    Exceptions::ThrowIncompatibleReceiverTypeError(caller);
+}
+
+// Whether the adder a newly created collection looks up is the built-in one of the unmodified
+// intrinsic prototype, so values can be added without calling it
+bool HasBuiltinAdder(const Handle<JSObject>& collection, const Handle<JSObject>& intrinsic) {
+    return collection->GetPrototypeOf() == intrinsic && intrinsic.CastTo<JSOrdinaryObject>()->IsWatchIntact();
+}
+
+using ValueAdder = void (*)(const Handle<JSObject>&, const Handle<JSValue>&);
+
+void AddSetValue(const Handle<JSObject>& set, const Handle<JSValue>& value) {
+    Handle<SetObject> S = set.CastTo<SetObject>();
+    Handle<OrderedHashTable> table = S->setData();
+    OrderedHashTable::Set(table, value, nullptr);
+    S->setData(table);
+}
+
+void AddWeakSetValue(const Handle<JSObject>& set, const Handle<JSValue>& value) {
+    if (!Testing::Is<JSObject>(value)) {
+        Exceptions::ThrowTypeError("Invalid value used in weak set");
+    }
+    set.CastTo<WeakSetObject>()->weakSetData()->Put(value.CastTo<JSObject>(), JSBoolean::New(true));
+}
+
+// Steps shared by the Set and WeakSet constructors: add the values of iterable to target through
+// its add method, or through builtinAdder if that is known to be the built-in method
+void AddValuesFromIterable(const Handle<JSObject>& target, const Handle<JSValue>& iterable, ValueAdder builtinAdder) {
+    Handle<JSValue> adder = Objects::Get(target, "add");
+    if (!Testing::IsCallable(adder)) {
+        Exceptions::ThrowTypeError("Adder of the collection is not a function");
+    }
+    Handle<JSObject> iter = Iterators::GetIterator(iterable);
+    Handle<JSValue> nextValue;
+    while (Iterators::IteratorStepValue(iter, nextValue)) {
+        try {
+            if (builtinAdder) {
+                builtinAdder(target, nextValue);
+            } else {
+                Objects::Call(adder.CastTo<JSObject>(), target, Arrays::ToArray<JSValue>(nextValue));
+            }
+        } catch (ESException&) {
+            // The original exception wins over anything thrown while closing
+            try {
+                Iterators::IteratorClose(iter);
+            } catch (ESException&) {
+            }
+            throw;
+        }
+    }
+}
+
+Handle<JSObject> CreateSetIterator(const Handle<SetObject>& set, SetIteratorObject::IterationKind kind) {
+    Handle<SetIteratorObject> iterator = Objects::ObjectCreate<SetIteratorObject>(Context::CurrentRealm()->SetIteratorPrototype());
+    iterator->iteratedTable(set->setData());
+    iterator->setNextIndex(0);
+    iterator->setIterationKind(kind);
+    return iterator;
+}
+}
+
+Handle<JSValue> Set::Call(const Handle<JSValue>&, const Handle<Array<JSValue>>&) {
+    Exceptions::ThrowTypeError("Constructor Set requires 'new'");
+}
+
+// 23.2.1.1 Set([iterable])
+Handle<JSObject> Set::Construct(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target) {
+    Handle<SetObject> set = Objects::OrdinaryCreateFromConstructor<SetObject>(target, &Realm::SetPrototype);
+    set->setData(OrderedHashTable::New(false));
+    Handle<JSValue> iterable = GetArg(args, 0);
+    if (!iterable || iterable->GetType() == JSValue::Type::kNull) {
+        return set;
+    }
+    bool builtin = HasBuiltinAdder(set, Context::CurrentRealm()->SetPrototype());
+    AddValuesFromIterable(set, iterable, builtin ? AddSetValue : nullptr);
+    return set;
+}
+
+Handle<JSValue> Set::get_Symbol_species(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return that;
+}
+
+Handle<JSValue> Set::prototype::add(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<SetObject> S = ThisSet(that, "Set.prototype.add");
+    AddSetValue(S, GetArg(args, 0));
+    return S;
+}
+
+Handle<JSValue> Set::prototype::clear(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    Handle<SetObject> S = ThisSet(that, "Set.prototype.clear");
+    Handle<OrderedHashTable> table = S->setData();
+    OrderedHashTable::Clear(table);
+    S->setData(table);
+    return nullptr;
+}
+
+Handle<JSValue> Set::prototype::delete_(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<SetObject> S = ThisSet(that, "Set.prototype.delete");
+    Handle<OrderedHashTable> table = S->setData();
+    bool deleted = OrderedHashTable::Delete(table, GetArg(args, 0));
+    S->setData(table);
+    return JSBoolean::New(deleted);
+}
+
+Handle<JSValue> Set::prototype::entries(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return CreateSetIterator(ThisSet(that, "Set.prototype.entries"), SetIteratorObject::IterationKind::kBoth);
+}
+
+// 23.2.3.6 Set.prototype.forEach(callbackfn[, thisArg])
+// Values added during the iteration are visited, and values deleted before being reached are not
+Handle<JSValue> Set::prototype::forEach(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<SetObject> S = ThisSet(that, "Set.prototype.forEach");
+    Handle<JSValue> callbackfn = GetArg(args, 0);
+    if (!Testing::IsCallable(callbackfn)) {
+        Exceptions::ThrowTypeError("Callback is not a function");
+    }
+    Handle<JSValue> T = GetArg(args, 1);
+    Handle<OrderedHashTable> table = S->setData();
+    Handle<JSValue> value;
+    for (uint32_t index = 0; OrderedHashTable::Seek(table, index); index++) {
+        value = table->KeyAt(index);
+        Objects::Call(callbackfn.CastTo<JSObject>(), T, Arrays::ToArray<JSValue>(value, value, S.CastTo<JSValue>()));
+    }
+    return nullptr;
+}
+
+Handle<JSValue> Set::prototype::has(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    return JSBoolean::New(ThisSet(that, "Set.prototype.has")->setData()->Has(GetArg(args, 0)));
+}
+
+Handle<JSValue> Set::prototype::get_size(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return JSNumber::New(static_cast<int64_t>(ThisSet(that, "Set.prototype.size")->setData()->Size()));
+}
+
+Handle<JSValue> Set::prototype::values(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    return CreateSetIterator(ThisSet(that, "Set.prototype.values"), SetIteratorObject::IterationKind::kValue);
+}
+
+Handle<JSValue> Set::Iterator_next(const Handle<JSValue>& that, const Handle<Array<JSValue>>&) {
+    if (!Testing::Is<JSObject>(that)) {
+        Exceptions::ThrowIncompatibleReceiverTypeError("Set Iterator.prototype.next");
+    }
+    Handle<SetIteratorObject> O = that.ExactCheckedCastTo<SetIteratorObject>();
+    if (!O) {
+        Exceptions::ThrowIncompatibleReceiverTypeError("Set Iterator.prototype.next");
+    }
+    Handle<JSValue> value;
+    bool done = Iterators::SetIteratorNext(O, value);
+    return Iterators::CreateIterResultObject(value, done);
+}
+
+Handle<JSValue> WeakSet::Call(const Handle<JSValue>&, const Handle<Array<JSValue>>&) {
+    Exceptions::ThrowTypeError("Constructor WeakSet requires 'new'");
+}
+
+// 23.4.1.1 WeakSet([iterable])
+Handle<JSObject> WeakSet::Construct(const Handle<Array<JSValue>>& args, const Handle<JSObject>& target) {
+    Handle<WeakSetObject> set = Objects::OrdinaryCreateFromConstructor<WeakSetObject>(target, &Realm::WeakSetPrototype);
+    set->weakSetData(new WeakTable());
+    Handle<JSValue> iterable = GetArg(args, 0);
+    if (!iterable || iterable->GetType() == JSValue::Type::kNull) {
+        return set;
+    }
+    bool builtin = HasBuiltinAdder(set, Context::CurrentRealm()->WeakSetPrototype());
+    AddValuesFromIterable(set, iterable, builtin ? AddWeakSetValue : nullptr);
+    return set;
+}
+
+Handle<JSValue> WeakSet::prototype::add(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakSetObject> S = ThisWeakSet(that, "WeakSet.prototype.add");
+    AddWeakSetValue(S, GetArg(args, 0));
+    return S;
+}
+
+Handle<JSValue> WeakSet::prototype::delete_(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakTable> data = ThisWeakSet(that, "WeakSet.prototype.delete")->weakSetData();
+    Handle<JSValue> value = GetArg(args, 0);
+    if (!Testing::Is<JSObject>(value) || !data->ContainsKey(value.CastTo<JSObject>())) {
+        return JSBoolean::New(false);
+    }
+    data->Remove(value.CastTo<JSObject>());
+    return JSBoolean::New(true);
+}
+
+Handle<JSValue> WeakSet::prototype::has(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<WeakTable> data = ThisWeakSet(that, "WeakSet.prototype.has")->weakSetData();
+    Handle<JSValue> value = GetArg(args, 0);
+    return JSBoolean::New(Testing::Is<JSObject>(value) && data->ContainsKey(value.CastTo<JSObject>()));
+}
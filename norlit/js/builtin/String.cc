@@ -5,7 +5,13 @@
 #include "../vm/Context.h"
 #include "../object/Exotics.h"
 
+#include "../../util/Arrays.h"
+
+#include <cmath>
+#include <algorithm>
+
 using namespace norlit::gc;
+using namespace norlit::util;
 using namespace norlit::js;
 using namespace norlit::js::vm;
 using namespace norlit::js::object;
@@ -23,3 +29,249 @@ Handle<JSObject> String::Construct(const Handle<Array<JSValue>>& args, const Han
     Handle<JSString> s = args->Length() > 0 ? Conversion::ToString(args->Get(0)) : JSString::New("");
     return Objects::StringCreate(s, Objects::GetPrototypeFromConstructor(target, &Realm::StringPrototype));
 }
+
+namespace {
+// ToString(RequireObjectCoercible(this value))
+Handle<JSString> ThisString(const Handle<JSValue>& that) {
+    Testing::RequireObjectCoercible(that);
+    return Conversion::ToString(that);
+}
+
+// ToInteger(value) clamped to [0, length]
+size_t ClampPosition(const Handle<JSValue>& value, size_t length) {
+    double pos = Conversion::ToNumberValue(value);
+    if (std::isnan(pos) || pos <= 0) {
+        return 0;
+    }
+    return pos >= length ? length : static_cast<size_t>(pos);
+}
+
+Handle<JSString> SearchString(const Handle<JSValue>& argument) {
+    if (Testing::IsRegExp(argument)) {
+        Exceptions::ThrowTypeError("First argument must not be a regular expression");
+    }
+    return Conversion::ToString(argument);
+}
+}
+
+void String::GetSubstitution(
+    std::wstring& builder, const Handle<JSString>& matched, const Handle<JSString>& str, size_t position,
+    const Handle<Array<JSValue>>& captures, const Handle<JSString>& replacement
+) {
+    size_t stringLength = str->Length();
+    size_t tailPos = std::min(position + matched->Length(), stringLength);
+    size_t m = captures->Length();
+    for (size_t i = 0, length = replacement->Length(); i < length; i++) {
+        char16_t ch = replacement->At(i);
+        if (ch != '$' || i + 1 == length) {
+            builder += ch;
+            continue;
+        }
+        char16_t next = replacement->At(i + 1);
+        if (next == '$') {
+            builder += '$';
+        } else if (next == '&') {
+            for (size_t j = 0, matchLength = matched->Length(); j < matchLength; j++) {
+                builder += matched->At(j);
+            }
+        } else if (next == '`') {
+            for (size_t j = 0; j < position; j++) {
+                builder += str->At(j);
+            }
+        } else if (next == '\'') {
+            for (size_t j = tailPos; j < stringLength; j++) {
+                builder += str->At(j);
+            }
+        } else if (next >= '0' && next <= '9') {
+            // $nn takes precedence over $n when both name a capture. Anything else is kept as is
+            size_t n = next - '0';
+            size_t digits = 1;
+            if (i + 2 < length) {
+                char16_t last = replacement->At(i + 2);
+                size_t nn = n * 10 + (last - '0');
+                if (last >= '0' && last <= '9' && nn >= 1 && nn <= m) {
+                    n = nn;
+                    digits = 2;
+                }
+            }
+            if (n < 1 || n > m) {
+                builder += ch;
+                continue;
+            }
+            // Captures that did not participate are undefined and replaced with nothing
+            if (Handle<JSValue> capture = captures->Get(n - 1)) {
+                Handle<JSString> captureString = capture.CastTo<JSString>();
+                for (size_t j = 0, captureLength = captureString->Length(); j < captureLength; j++) {
+                    builder += captureString->At(j);
+                }
+            }
+            i += digits;
+            continue;
+        } else {
+            builder += ch;
+            continue;
+        }
+        i++;
+    }
+}
+
+Handle<JSValue> String::prototype::endsWith(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSString> S = ThisString(that);
+    Handle<JSString> searchStr = SearchString(GetArg(args, 0));
+    size_t len = S->Length();
+    Handle<JSValue> endPosition = GetArg(args, 1);
+    size_t end = endPosition ? ClampPosition(endPosition, len) : len;
+    size_t searchLength = searchStr->Length();
+    if (searchLength > end) {
+        return JSBoolean::New(false);
+    }
+    return JSBoolean::New(S->RegionMatches(end - searchLength, searchStr));
+}
+
+Handle<JSValue> String::prototype::includes(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSString> S = ThisString(that);
+    Handle<JSString> searchStr = SearchString(GetArg(args, 0));
+    size_t start = ClampPosition(GetArg(args, 1), S->Length());
+    return JSBoolean::New(S->IndexOf(searchStr, start) != -1);
+}
+
+Handle<JSValue> String::prototype::indexOf(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSString> S = ThisString(that);
+    Handle<JSString> searchStr = Conversion::ToString(GetArg(args, 0));
+    size_t start = ClampPosition(GetArg(args, 1), S->Length());
+    return JSNumber::New(S->IndexOf(searchStr, start));
+}
+
+Handle<JSValue> String::prototype::lastIndexOf(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSString> S = ThisString(that);
+    Handle<JSString> searchStr = Conversion::ToString(GetArg(args, 0));
+    size_t len = S->Length();
+    // NaN, including an absent position, searches from the end
+    double numPos = Conversion::ToNumberValue(GetArg(args, 1));
+    size_t start = std::isnan(numPos) ? len : ClampPosition(JSNumber::New(numPos), len);
+    return JSNumber::New(S->LastIndexOf(searchStr, start));
+}
+
+Handle<JSValue> String::prototype::match(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Testing::RequireObjectCoercible(that);
+    Handle<JSValue> regexp = GetArg(args, 0);
+    if (regexp && !Testing::Is<JSNull>(regexp)) {
+        Handle<JSObject> matcher = Objects::GetMethod(regexp, JSSymbol::Match());
+        if (matcher) {
+            return Objects::Call(matcher, regexp, Arrays::ToArray<JSValue>(that));
+        }
+    }
+    Handle<JSString> S = Conversion::ToString(that);
+    Handle<JSObject> rx = Objects::RegExpCreate(regexp, nullptr);
+    return Objects::Invoke(rx, JSSymbol::Match(), Arrays::ToArray<JSValue>(S));
+}
+
+Handle<JSValue> String::prototype::replace(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Testing::RequireObjectCoercible(that);
+    Handle<JSValue> searchValue = GetArg(args, 0);
+    Handle<JSValue> replaceValue = GetArg(args, 1);
+    if (searchValue && !Testing::Is<JSNull>(searchValue)) {
+        Handle<JSObject> replacer = Objects::GetMethod(searchValue, JSSymbol::Replace());
+        if (replacer) {
+            return Objects::Call(replacer, searchValue, Arrays::ToArray<JSValue>(that, replaceValue));
+        }
+    }
+    Handle<JSString> string = Conversion::ToString(that);
+    Handle<JSString> searchString = Conversion::ToString(searchValue);
+    bool functionalReplace = Testing::IsCallable(replaceValue);
+    Handle<JSString> replaceString = functionalReplace ? nullptr : Conversion::ToString(replaceValue);
+    int64_t pos = string->IndexOf(searchString, 0);
+    if (pos == -1) {
+        return string;
+    }
+    size_t position = static_cast<size_t>(pos);
+
+    std::wstring builder;
+    for (size_t i = 0; i < position; i++) {
+        builder += string->At(i);
+    }
+    if (functionalReplace) {
+        Handle<JSValue> replValue = Objects::Call(replaceValue.CastTo<JSObject>(), nullptr, Arrays::ToArray<JSValue>(searchString.CastTo<JSValue>(), JSNumber::New(pos).CastTo<JSValue>(), string.CastTo<JSValue>()));
+        Handle<JSString> replStr = Conversion::ToString(replValue);
+        for (size_t i = 0, length = replStr->Length(); i < length; i++) {
+            builder += replStr->At(i);
+        }
+    } else {
+        GetSubstitution(builder, searchString, string, position, Array<JSValue>::New(0), replaceString);
+    }
+    for (size_t i = position + searchString->Length(), length = string->Length(); i < length; i++) {
+        builder += string->At(i);
+    }
+    return JSString::New(builder.c_str());
+}
+
+Handle<JSValue> String::prototype::search(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Testing::RequireObjectCoercible(that);
+    Handle<JSValue> regexp = GetArg(args, 0);
+    if (regexp && !Testing::Is<JSNull>(regexp)) {
+        Handle<JSObject> searcher = Objects::GetMethod(regexp, JSSymbol::Search());
+        if (searcher) {
+            return Objects::Call(searcher, regexp, Arrays::ToArray<JSValue>(that));
+        }
+    }
+    Handle<JSString> string = Conversion::ToString(that);
+    Handle<JSObject> rx = Objects::RegExpCreate(regexp, nullptr);
+    return Objects::Invoke(rx, JSSymbol::Search(), Arrays::ToArray<JSValue>(string));
+}
+
+Handle<JSValue> String::prototype::split(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Testing::RequireObjectCoercible(that);
+    Handle<JSValue> separator = GetArg(args, 0);
+    Handle<JSValue> limit = GetArg(args, 1);
+    if (separator && !Testing::Is<JSNull>(separator)) {
+        Handle<JSObject> splitter = Objects::GetMethod(separator, JSSymbol::Split());
+        if (splitter) {
+            return Objects::Call(splitter, separator, Arrays::ToArray<JSValue>(that, limit));
+        }
+    }
+    Handle<JSString> S = Conversion::ToString(that);
+    // Elements are added to the backing store of the new array directly, which cannot fail
+    Handle<ArrayObject> A = Objects::ArrayCreate(0).CastTo<ArrayObject>();
+    uint32_t lim = limit ? Conversion::ToUInt32(Conversion::ToNumber(limit)) : 0xFFFFFFFF;
+    Handle<JSString> R = Conversion::ToString(separator);
+    if (lim == 0) {
+        return A;
+    }
+    if (!separator) {
+        A->AddElement(0, S);
+        return A;
+    }
+
+    size_t s = S->Length();
+    size_t r = R->Length();
+    if (s == 0) {
+        if (r != 0) {
+            A->AddElement(0, S);
+        }
+        return A;
+    }
+    // An empty separator splits between every code unit
+    if (r == 0) {
+        for (size_t q = 0; q < s && A->length() < lim; q++) {
+            A->AddElement(A->length(), S->Substring(q, q + 1));
+        }
+        return A;
+    }
+    size_t p = 0;
+    for (int64_t q; (q = S->IndexOf(R, p)) != -1;) {
+        A->AddElement(A->length(), S->Substring(p, static_cast<size_t>(q)));
+        if (A->length() == lim) {
+            return A;
+        }
+        p = static_cast<size_t>(q) + r;
+    }
+    A->AddElement(A->length(), S->Substring(p, s));
+    return A;
+}
+
+Handle<JSValue> String::prototype::startsWith(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
+    Handle<JSString> S = ThisString(that);
+    Handle<JSString> searchStr = SearchString(GetArg(args, 0));
+    size_t start = ClampPosition(GetArg(args, 1), S->Length());
+    return JSBoolean::New(S->RegionMatches(start, searchStr));
+}
@@ -0,0 +1,205 @@
+#include "BackgroundCompiler.h"
+#include "CodeCache.h"
+#include "Emitter.h"
+
+#include "../grammar/Node.h"
+#include "../grammar/Scanner.h"
+#include "../grammar/Parser.h"
+
+#include "../Exception.h"
+
+#include "../../util/MappedFile.h"
+
+#include <algorithm>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::grammar;
+using namespace norlit::js::bytecode;
+using namespace norlit::util;
+
+struct BackgroundCompiler::Job {
+    std::string path;
+    bool ready = false;
+    bool opened = false;
+    // ASCII files are used in place, others are decoded into text. Ownership of either passes to
+    // the external string created by Finish
+    MappedFile* file = nullptr;
+    std::u16string* text = nullptr;
+    uint64_t hash = 0;
+    std::vector<uint8_t> cache;
+    // Code generated by the worker, with the scanner and the parser whose arena holds its constants.
+    // Left empty if generation failed, then Finish generates the code again to report the error
+    std::unique_ptr<Scanner> scanner;
+    std::unique_ptr<Parser> parser;
+    std::unique_ptr<Emitter> emitter;
+
+    Job(const std::string& path): path(path) {}
+    ~Job() {
+        delete file;
+        delete text;
+    }
+};
+
+BackgroundCompiler::BackgroundCompiler(const std::vector<std::string>& paths, const std::string& cacheDirectory, size_t threads) :
+    cacheDirectory(cacheDirectory) {
+    for (const std::string& path : paths) {
+        jobs.emplace_back(new Job(path));
+    }
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    threads = std::min(threads, jobs.size());
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this] {
+            Work();
+        });
+    }
+}
+
+BackgroundCompiler::~BackgroundCompiler() {
+    {
+        // Jobs not started yet are abandoned
+        std::lock_guard<std::mutex> lock(mutex);
+        next = jobs.size();
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void BackgroundCompiler::Work() {
+    while (true) {
+        Job* job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (next >= jobs.size()) {
+                return;
+            }
+            job = jobs[next++].get();
+        }
+        Prepare(*job);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job->ready = true;
+        }
+        done.notify_all();
+    }
+}
+
+// Runs on worker threads, so nothing here may allocate on the heap
+void BackgroundCompiler::Prepare(Job& job) {
+    MappedFile* file = new MappedFile();
+    if (!file->Open(job.path.c_str())) {
+        delete file;
+        return;
+    }
+    job.opened = true;
+
+    const char* data = file->data();
+    size_t size = file->size();
+    bool ascii = true;
+    for (size_t i = 0; i < size; i++) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            ascii = false;
+            break;
+        }
+    }
+    if (ascii) {
+        job.file = file;
+        job.hash = CodeCache::Hash(reinterpret_cast<const uint8_t*>(data), size);
+    } else {
+        std::u16string* text = new std::u16string(JSString::DecodeUTF8(data, size), 0);
+        JSString::DecodeUTF8(data, size, &(*text)[0]);
+        delete file;
+        job.text = text;
+        job.hash = CodeCache::Hash(text->data(), text->size());
+    }
+
+    if (!cacheDirectory.empty()) {
+        CodeCache::ReadEntry(cacheDirectory, job.hash, job.cache);
+    }
+    if (job.cache.empty()) {
+        Generate(job);
+    }
+}
+
+// Runs on worker threads. Errors are thrown as OffHeapError instead of allocating them
+void BackgroundCompiler::Generate(Job& job) {
+    Exceptions::OffHeapScope scope;
+    try {
+        if (job.file) {
+            job.scanner.reset(new Scanner(job.file->data(), job.file->size()));
+        } else {
+            job.scanner.reset(new Scanner(job.text->data(), job.text->size()));
+        }
+        job.parser.reset(new Parser(*job.scanner));
+        Script* script = job.parser->ParseScript();
+        job.emitter.reset(new Emitter);
+        script->Codegen(*job.emitter);
+        job.emitter->Optimize();
+    } catch (...) {
+        job.emitter.reset();
+        job.parser.reset();
+        job.scanner.reset();
+    }
+}
+
+Handle<Code> BackgroundCompiler::Finish(size_t index, Handle<JSString>* source) {
+    Job& job = *jobs[index];
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&job] {
+            return job.ready;
+        });
+    }
+    if (!job.opened) {
+        return nullptr;
+    }
+
+    ExternalStringResource resource;
+    if (job.file) {
+        resource = { job.file->data(), job.file->size(), true, [](const void*, void* file) {
+            delete static_cast<MappedFile*>(file);
+        }, job.file };
+        job.file = nullptr;
+    } else {
+        resource = { job.text->data(), job.text->size(), false, [](const void*, void* text) {
+            delete static_cast<std::u16string*>(text);
+        }, job.text };
+        job.text = nullptr;
+    }
+    Handle<JSString> str = JSString::NewExternal(resource);
+    if (source) {
+        *source = str;
+    }
+
+    if (!job.cache.empty()) {
+        Handle<Code> code = CodeCache::Deserialize(job.cache, str, job.hash);
+        job.cache.clear();
+        if (code) {
+            return code;
+        }
+    }
+
+    // Only the constants, nested code and regular expressions are left to put on the heap
+    Handle<Code> code;
+    if (job.emitter) {
+        code = job.emitter->ToCode(str);
+        job.emitter.reset();
+        job.parser.reset();
+        job.scanner.reset();
+    } else {
+        Scanner lex(str, 0, str->Length());
+        Parser gram{ lex };
+        Script* script = gram.ParseScript();
+        Emitter e;
+        script->Codegen(e);
+        code = e.ToCode(str);
+    }
+    code->SetScriptSource(str);
+    if (!cacheDirectory.empty()) {
+        CodeCache::Store(cacheDirectory, job.hash, code);
+    }
+    return code;
+}
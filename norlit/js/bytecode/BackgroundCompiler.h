@@ -0,0 +1,62 @@
+#ifndef NORLIT_JS_BYTECODE_BACKGROUNDCOMPILER_H
+#define NORLIT_JS_BYTECODE_BACKGROUNDCOMPILER_H
+
+#include "Code.h"
+
+#include "../JSString.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace bytecode {
+
+// Loads a batch of scripts using worker threads.
+//
+// The heap and the intern table may only be touched by the thread running the engine, so workers
+// do everything that can be done off the heap: reading the file, decoding UTF-8, hashing the text,
+// reading the code cache entry and, if there is none, scanning, parsing and generating code with
+// constants kept in the arena of the parser. Finish then completes a script on the calling thread by
+// wrapping the text as an external string and either deserializing the cached code or interning the
+// constants and creating the code objects. A script the worker fails to compile is compiled again by
+// Finish, so that the error is thrown on the engine thread.
+class BackgroundCompiler {
+    struct Job;
+
+    std::vector<std::unique_ptr<Job>> jobs;
+    std::vector<std::thread> workers;
+    std::string cacheDirectory;
+    size_t next = 0;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    void Work();
+    void Prepare(Job&);
+    void Generate(Job&);
+
+  public:
+    // Empty cacheDirectory disables the code cache. Zero threads uses one per hardware thread
+    BackgroundCompiler(const std::vector<std::string>& paths, const std::string& cacheDirectory = "", size_t threads = 0);
+    BackgroundCompiler(const BackgroundCompiler&) = delete;
+    BackgroundCompiler& operator=(const BackgroundCompiler&) = delete;
+    ~BackgroundCompiler();
+
+    size_t Size() const {
+        return jobs.size();
+    }
+
+    // Wait for the index-th script and finish it on the calling thread, which must be the one
+    // running the engine. Each script may be finished once. Returns nullptr if the file cannot be read
+    gc::Handle<Code> Finish(size_t index, gc::Handle<JSString>* source = nullptr);
+};
+
+}
+}
+}
+
+#endif
@@ -4,14 +4,46 @@
 #include "../JSString.h"
 #include "../JSNumber.h"
 #include "../JSBoolean.h"
+#include "../grammar/Scanner.h"
+#include "../../util/HashMap.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <vector>
 
 #define IDENT(s) printf("\n%*s", static_cast<int>(ident + s), "")
 
 using namespace norlit::gc;
 using namespace norlit::js;
 using namespace norlit::js::bytecode;
+using namespace norlit::util;
+
+namespace {
+// Offset of the first character of each line of source
+Handle<ValueArray<uint32_t>> GetLineStarts(const Handle<JSString>& source) {
+    // Built once per source and shared by all code generated from it
+    static Handle<HashMap<JSString, ValueArray<uint32_t>, true>> tables = new HashMap<JSString, ValueArray<uint32_t>, true>();
+    Handle<ValueArray<uint32_t>> table = tables->Get(source);
+    if (table) {
+        return table;
+    }
+    std::vector<uint32_t> starts { 0 };
+    for (size_t i = 0, length = source->Length(); i < length; i++) {
+        char16_t ch = source->At(i);
+        if (grammar::Scanner::IsLineTerminator(ch)) {
+            // CRLF is a single line terminator
+            if (ch == '\r' && i + 1 < length && source->At(i + 1) == '\n') {
+                i++;
+            }
+            starts.push_back(static_cast<uint32_t>(i + 1));
+        }
+    }
+    table = ValueArray<uint32_t>::New(starts.size());
+    std::copy(starts.begin(), starts.end(), &table->At(0));
+    tables->Put(source, table);
+    return table;
+}
+}
 
 namespace {
 bool HasImmediate(Instruction ins) {
@@ -28,8 +60,16 @@ bool HasImmediate(Instruction ins) {
         case Instruction::kImplicitThis:
         case Instruction::kJump:
         case Instruction::kJumpIfTrue:
+        case Instruction::kUnwindScope:
         case Instruction::kFunction:
         case Instruction::kGenerator:
+        case Instruction::kIteratorNext:
+        case Instruction::kGetNamedProperty:
+        case Instruction::kGetNamedPropertyNoPop:
+        case Instruction::kGetNameNum:
+        case Instruction::kInitDefNoPop:
+        case Instruction::kIncName:
+        case Instruction::kDecName:
             return true;
         default:
             return false;
@@ -37,29 +77,121 @@ bool HasImmediate(Instruction ins) {
 }
 }
 
+uint32_t Code::ReadImmediate(const Handle<ValueArray<uint8_t>>& bc, size_t pc, size_t width) {
+    // Nothing below allocates, so the bytes stay in place
+    return ReadImmediate(&bc->At(0), pc, width);
+}
+
+uint32_t Code::ReadImmediate(const uint8_t* bc, size_t pc, size_t width) {
+    uint32_t ret = 0;
+    for (size_t i = 0; i < width; i++) {
+        ret = (ret << 8) | bc[pc + i];
+    }
+    return ret;
+}
+
+size_t Code::InstructionLength(const Handle<ValueArray<uint8_t>>& bc, size_t pc, size_t width) {
+    return InstructionLength(&bc->At(0), pc, width);
+}
+
+size_t Code::InstructionLength(const uint8_t* bc, size_t pc, size_t width) {
+    Instruction ins = static_cast<Instruction>(bc[pc]);
+    switch (ins) {
+        case Instruction::kTableSwitch:
+            return 1 + width * (3 + ReadImmediate(bc, pc + 1 + width, width));
+        case Instruction::kLookupSwitch:
+            return 1 + width * (2 + 2 * ReadImmediate(bc, pc + 1, width));
+        default:
+            return HasImmediate(ins) ? 1 + width : 1;
+    }
+}
+
+size_t Code::InstructionLength(const Handle<ValueArray<uint8_t>>& bc, size_t pc) {
+    if (static_cast<Instruction>(bc->At(pc)) == Instruction::kWide) {
+        return 1 + InstructionLength(bc, pc + 1, 4);
+    }
+    return InstructionLength(bc, pc, 2);
+}
+
 void Code::IterateField(const FieldIterator& iter) {
     iter(&this->constantPool);
     iter(&this->codePool);
     iter(&this->exceptionTable);
     iter(&this->bytecode);
+    iter(&this->source);
+    iter(&this->positionTable);
 }
 
-uint16_t Code::FindExceptionHandler(uint16_t pc) {
+size_t Code::FindExceptionHandler(size_t pc) {
     for (size_t len = this->exceptionTable->Length(), i = 0; i < len; i++) {
         const ExceptionTableEntry& ent = this->exceptionTable->At(i);
         if (ent.startPc <= pc&&pc < ent.endPc) {
             return ent.handlerPc;
         }
     }
-    return 0xFFFF;
+    return kNoHandler;
 }
 
-int Code::FindScopeDifference(uint16_t from, uint16_t to) {
+size_t Code::FindSourcePosition(size_t pc) {
+    Handle<Code> self = this;
+    if (!self->source) {
+        return kNoPosition;
+    }
+    if (!self->positionTable) {
+        self->BuildPositionTable();
+    }
+    Handle<ValueArray<uint8_t>> table = self->positionTable;
+    size_t ptr = 0;
+    size_t length = table->Length();
+    auto readVarint = [&]() {
+        uint32_t value = 0;
+        for (int shift = 0; ptr < length; shift += 7) {
+            uint8_t byte = table->At(ptr++);
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    };
+
+    size_t entryPc = 0;
+    int64_t position = 0;
+    size_t result = kNoPosition;
+    while (ptr < length) {
+        entryPc += readVarint();
+        // Source offsets may go backwards, so their deltas are zigzag encoded
+        uint32_t delta = readVarint();
+        position += (delta & 1) ? -static_cast<int64_t>(delta >> 1) - 1 : static_cast<int64_t>(delta >> 1);
+        if (entryPc > pc) {
+            break;
+        }
+        result = static_cast<size_t>(position);
+    }
+    return result;
+}
+
+bool Code::FindLineAndColumn(size_t pc, size_t& line, size_t& column) {
+    Handle<Code> self = this;
+    size_t position = self->FindSourcePosition(pc);
+    if (position == kNoPosition) {
+        return false;
+    }
+    Handle<ValueArray<uint32_t>> starts = GetLineStarts(self->source);
+    const uint32_t* begin = &starts->At(0);
+    const uint32_t* lineStart = std::upper_bound(begin, begin + starts->Length(), position) - 1;
+    line = lineStart - begin + 1;
+    column = position - *lineStart + 1;
+    return true;
+}
+
+int Code::FindScopeDifference(size_t from, size_t to) {
     if (from > to)
         return -this->FindScopeDifference(to, from);
+    Handle<ValueArray<uint8_t>> bc = this->bytecode;
     int ret = 0;
-    for (size_t i = from; i < to; i++) {
-        Instruction ins = static_cast<Instruction>(this->bytecode->At(i));
+    for (size_t i = from; i < to; i += InstructionLength(bc, i)) {
+        Instruction ins = static_cast<Instruction>(bc->At(i));
         switch (ins) {
             case Instruction::kPushScope:
                 ret--;
@@ -68,9 +200,6 @@ int Code::FindScopeDifference(uint16_t from, uint16_t to) {
                 ret++;
                 break;
             default:
-                if (HasImmediate(ins)) {
-                    i += 2;
-                }
                 break;
         }
     }
@@ -78,6 +207,10 @@ int Code::FindScopeDifference(uint16_t from, uint16_t to) {
 }
 
 void Code::Dump(size_t ident) {
+    if (!IsCompiled()) {
+        printf("Code (not compiled) [%u, %u)", sourceStart, sourceEnd);
+        return;
+    }
     Handle<Array<JSValue>> constant = this->constantPool;
     Handle<Array<Code>> code = this->codePool;
     Handle<ValueArray<ExceptionTableEntry>> exceptionTable = this->exceptionTable;
@@ -123,16 +256,22 @@ void Code::Dump(size_t ident) {
     IDENT(2);
     printf("Bytecode");
     for (size_t i = 0, size = bc->Length(); i < size; i++) {
+        size_t width = 2;
         auto get16 = [&] () {
-            uint8_t hi = bc->At(++i);
-            uint8_t lo = bc->At(++i);
-            return (hi << 8) | lo;
+            uint32_t ret = ReadImmediate(bc, i + 1, width);
+            i += width;
+            return static_cast<int>(ret);
         };
 
         IDENT(4);
         printf("%-3d ", static_cast<int>(i));
 
         Instruction ins = static_cast<Instruction>(bc->At(i));
+        if (ins == Instruction::kWide) {
+            printf("wide ");
+            width = 4;
+            ins = static_cast<Instruction>(bc->At(++i));
+        }
         switch (ins) {
             case Instruction::kDefVar:
                 printf("var %d", get16());
@@ -164,9 +303,50 @@ void Code::Dump(size_t ident) {
             case Instruction::kJumpIfTrue:
                 printf("jump_if_true %d",get16());
                 break;
+            case Instruction::kTableSwitch: {
+                int low = width == 2 ? static_cast<int16_t>(get16()) : get16();
+                int count = get16();
+                printf("table_switch default %d", get16());
+                for (int j = 0; j < count; j++) {
+                    IDENT(8);
+                    printf("%d: %d", low + j, get16());
+                }
+                break;
+            }
+            case Instruction::kLookupSwitch: {
+                int count = get16();
+                printf("lookup_switch default %d", get16());
+                for (int j = 0; j < count; j++) {
+                    IDENT(8);
+                    int key = get16();
+                    printf("%d: %d", key, get16());
+                }
+                break;
+            }
+            case Instruction::kUnwindScope:
+                printf("unwind_scope %d", get16());
+                break;
             case Instruction::kFunction:
                 printf("function %d", get16());
                 break;
+            case Instruction::kGetNamedProperty:
+                printf("get_named_property %d", get16());
+                break;
+            case Instruction::kGetNamedPropertyNoPop:
+                printf("get_named_property_no_pop %d", get16());
+                break;
+            case Instruction::kGetNameNum:
+                printf("get_name_num %d", get16());
+                break;
+            case Instruction::kInitDefNoPop:
+                printf("init_no_pop %d", get16());
+                break;
+            case Instruction::kIncName:
+                printf("inc_name %d", get16());
+                break;
+            case Instruction::kDecName:
+                printf("dec_name %d", get16());
+                break;
             case Instruction::kOne:
                 printf("one");
                 break;
@@ -182,9 +362,27 @@ void Code::Dump(size_t ident) {
             case Instruction::kArray:
                 printf("array");
                 break;
+            case Instruction::kRegExp:
+                printf("regexp");
+                break;
             case Instruction::kSpread:
                 printf("spread");
                 break;
+            case Instruction::kGetIterator:
+                printf("get_iterator");
+                break;
+            case Instruction::kEnumerate:
+                printf("enumerate");
+                break;
+            case Instruction::kIteratorNext:
+                printf("iterator_next %d", get16());
+                break;
+            case Instruction::kIteratorClose:
+                printf("iterator_close");
+                break;
+            case Instruction::kIteratorCloseThrow:
+                printf("iterator_close_throw");
+                break;
             case Instruction::kCall:
                 printf("call");
                 break;
@@ -311,6 +509,6 @@ void Code::Dump(size_t ident) {
     for (size_t len = exceptionTable->Length(), i = 0; i < len; i++) {
         IDENT(4);
         const ExceptionTableEntry& ent = exceptionTable->At(i);
-        printf("%05d %05d %05d", ent.startPc, ent.endPc, ent.handlerPc);
+        printf("%05u %05u %05u", ent.startPc, ent.endPc, ent.handlerPc);
     }
 }
\ No newline at end of file
@@ -2,25 +2,47 @@
 #define NORLIT_JS_BYTECODE_CODE_H
 
 #include "../JSValue.h"
+#include "../JSString.h"
 #include "../../gc/Array.h"
 
 namespace norlit {
 namespace js {
 namespace bytecode {
 
+struct CodeCacheImpl;
+
 class Code : public gc::Object {
+    friend struct CodeCacheImpl;
+
   public:
     struct ExceptionTableEntry {
-        uint16_t startPc;
-        uint16_t endPc;
-        uint16_t handlerPc;
+        uint32_t startPc;
+        uint32_t endPc;
+        uint32_t handlerPc;
     };
+
+    static const size_t kNoHandler = static_cast<size_t>(-1);
+    static const size_t kNoPosition = static_cast<size_t>(-1);
   private:
     gc::Array<JSValue>* constantPool = nullptr;
     gc::Array<Code>* codePool = nullptr;
     gc::ValueArray<ExceptionTableEntry>* exceptionTable = nullptr;
     gc::ValueArray<uint8_t>* bytecode = nullptr;
 
+    // Source range the code is generated from. It is kept after compilation so the position
+    // table can be built by generating the code again
+    JSString* source = nullptr;
+    uint32_t sourceStart = 0;
+    uint32_t sourceEnd = 0;
+    // Whether the source range is a whole script rather than a function
+    bool script = false;
+    // Pairs of bytecode offset and source offset, each delta-encoded from the previous pair as
+    // variable-length integers. Only built when first asked for, see BuildPositionTable
+    gc::ValueArray<uint8_t>* positionTable = nullptr;
+
+    // Generate the code again with source positions recorded. Defined in Codegen.cc
+    void BuildPositionTable();
+
   public:
 
     Code(
@@ -35,6 +57,29 @@ class Code : public gc::Object {
         WriteBarrier(&bytecode, bc);
     }
 
+    // Code of a pre-parsed function, compiled by Compile when first needed
+    Code(const gc::Handle<JSString>& source, uint32_t start, uint32_t end): sourceStart(start), sourceEnd(end) {
+        WriteBarrier(&this->source, source);
+    }
+
+    // Code generated from a whole script
+    void SetScriptSource(const gc::Handle<JSString>& source) {
+        WriteBarrier(&this->source, source);
+        sourceStart = 0;
+        sourceEnd = static_cast<uint32_t>(source->Length());
+        script = true;
+    }
+    // Set by Emitter::ToCode when positions are recorded
+    void SetPositionTable(const gc::Handle<gc::ValueArray<uint8_t>>& table) {
+        WriteBarrier(&positionTable, table);
+    }
+
+    bool IsCompiled() {
+        return bytecode != nullptr;
+    }
+    // Parse the function from its source and generate its code in place. Defined in Codegen.cc
+    void Compile();
+
     uint8_t At(size_t ptr) {
         return bytecode->At(ptr);
     }
@@ -48,8 +93,25 @@ class Code : public gc::Object {
         return codePool->Get(ptr);
     }
 
-    uint16_t FindExceptionHandler(uint16_t pc);
-    int FindScopeDifference(uint16_t from, uint16_t to);
+    // Length of the instruction at pc including its immediates and kWide prefix
+    static size_t InstructionLength(const gc::Handle<gc::ValueArray<uint8_t>>&, size_t pc);
+    // Length of the unprefixed instruction at pc whose immediates are width bytes each
+    static size_t InstructionLength(const gc::Handle<gc::ValueArray<uint8_t>>&, size_t pc, size_t width);
+    static uint32_t ReadImmediate(const gc::Handle<gc::ValueArray<uint8_t>>&, size_t pc, size_t width);
+    // Same as above over bytecode off the heap, which is being generated
+    static size_t InstructionLength(const uint8_t*, size_t pc, size_t width);
+    static uint32_t ReadImmediate(const uint8_t*, size_t pc, size_t width);
+
+    uint32_t ReadImmediate(size_t ptr, bool wide) {
+        return ReadImmediate(bytecode, ptr, wide ? 4 : 2);
+    }
+
+    size_t FindExceptionHandler(size_t pc);
+    // Offset in the source of the instruction at pc, or kNoPosition if the source is unknown
+    size_t FindSourcePosition(size_t pc);
+    // 1-based line and column of the instruction at pc. Returns false if the source is unknown
+    bool FindLineAndColumn(size_t pc, size_t& line, size_t& column);
+    int FindScopeDifference(size_t from, size_t to);
 
     void IterateField(const gc::FieldIterator&) override final;
     void Dump(size_t ident = 0);
@@ -0,0 +1,399 @@
+#include "../all.h"
+
+#include "CodeCache.h"
+
+#include "../JSPrimitive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::bytecode;
+
+namespace {
+
+const char kMagic[4] = { 'N', 'J', 'S', 'C' };
+const size_t kHeaderLength = 4 + 4 + 8 + 8 + 8;
+
+enum class Tag : uint8_t {
+    kUndefined,
+    kNull,
+    kFalse,
+    kTrue,
+    kNumber,
+    kString
+};
+
+// FNV-1a
+uint64_t Fnv1a(const uint8_t* data, size_t length, uint64_t hash = 0xCBF29CE484222325ULL) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+class Writer {
+    std::vector<uint8_t>& out;
+  public:
+    Writer(std::vector<uint8_t>& out): out(out) {}
+
+    void U8(uint8_t value) {
+        out.push_back(value);
+    }
+    void U16(uint16_t value) {
+        out.push_back(value & 0xFF);
+        out.push_back(value >> 8);
+    }
+    void U32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out.push_back((value >> (i * 8)) & 0xFF);
+        }
+    }
+    void U64(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            out.push_back((value >> (i * 8)) & 0xFF);
+        }
+    }
+    void Double(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        U64(bits);
+    }
+};
+
+class Reader {
+    const std::vector<uint8_t>& in;
+    size_t pos;
+    bool failed = false;
+  public:
+    Reader(const std::vector<uint8_t>& in, size_t pos): in(in), pos(pos) {}
+
+    bool Failed() const {
+        return failed;
+    }
+    bool Check(size_t length) {
+        if (failed || in.size() - pos < length) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+    uint8_t U8() {
+        if (!Check(1)) return 0;
+        return in[pos++];
+    }
+    uint16_t U16() {
+        if (!Check(2)) return 0;
+        uint16_t value = in[pos] | (in[pos + 1] << 8);
+        pos += 2;
+        return value;
+    }
+    uint32_t U32() {
+        if (!Check(4)) return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= static_cast<uint32_t>(in[pos++]) << (i * 8);
+        }
+        return value;
+    }
+    uint64_t U64() {
+        if (!Check(8)) return 0;
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) {
+            value |= static_cast<uint64_t>(in[pos++]) << (i * 8);
+        }
+        return value;
+    }
+    double Double() {
+        uint64_t bits = U64();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    void Bytes(uint8_t* to, size_t length) {
+        if (!Check(length)) return;
+        memcpy(to, &in[pos], length);
+        pos += length;
+    }
+};
+
+std::string CachePath(const std::string& directory, uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.njsc", static_cast<unsigned long long>(hash));
+    return directory + "/" + name;
+}
+
+}
+
+namespace norlit {
+namespace js {
+namespace bytecode {
+
+// Recursive helpers need the private fields of Code
+struct CodeCacheImpl {
+    static void Write(Writer& w, const Handle<Code>& code) {
+        if (!code->IsCompiled()) {
+            w.U8(1);
+            w.U32(code->sourceStart);
+            w.U32(code->sourceEnd);
+            return;
+        }
+        w.U8(0);
+
+        Handle<Array<JSValue>> constant = code->constantPool;
+        w.U32(constant->Length());
+        for (size_t i = 0, size = constant->Length(); i < size; i++) {
+            Handle<JSValue> value = constant->Get(i);
+            switch (value->GetType()) {
+                case JSValue::Type::kUndefined:
+                    w.U8(static_cast<uint8_t>(Tag::kUndefined));
+                    break;
+                case JSValue::Type::kNull:
+                    w.U8(static_cast<uint8_t>(Tag::kNull));
+                    break;
+                case JSValue::Type::kBoolean:
+                    w.U8(static_cast<uint8_t>(value.CastTo<JSBoolean>()->Value() ? Tag::kTrue : Tag::kFalse));
+                    break;
+                case JSValue::Type::kNumber:
+                    w.U8(static_cast<uint8_t>(Tag::kNumber));
+                    w.Double(value.CastTo<JSNumber>()->Value());
+                    break;
+                case JSValue::Type::kString: {
+                    Handle<JSString> str = value.CastTo<JSString>();
+                    w.U8(static_cast<uint8_t>(Tag::kString));
+                    w.U32(str->Length());
+                    for (size_t j = 0, len = str->Length(); j < len; j++) {
+                        w.U16(str->At(j));
+                    }
+                    break;
+                }
+                default:
+                    throw "internal error: constant cannot be serialized";
+            }
+        }
+
+        Handle<Array<Code>> pool = code->codePool;
+        w.U32(pool->Length());
+        for (size_t i = 0, size = pool->Length(); i < size; i++) {
+            Write(w, pool->Get(i));
+        }
+
+        Handle<ValueArray<Code::ExceptionTableEntry>> table = code->exceptionTable;
+        w.U32(table->Length());
+        for (size_t i = 0, size = table->Length(); i < size; i++) {
+            const Code::ExceptionTableEntry& entry = table->At(i);
+            w.U32(entry.startPc);
+            w.U32(entry.endPc);
+            w.U32(entry.handlerPc);
+        }
+
+        Handle<ValueArray<uint8_t>> bc = code->bytecode;
+        w.U32(bc->Length());
+        for (size_t i = 0, size = bc->Length(); i < size; i++) {
+            w.U8(bc->At(i));
+        }
+    }
+
+    static Handle<Code> Read(Reader& r, const Handle<JSString>& source) {
+        uint8_t kind = r.U8();
+        if (kind == 1) {
+            uint32_t start = r.U32();
+            uint32_t end = r.U32();
+            if (r.Failed() || start > end || end > source->Length()) {
+                return nullptr;
+            }
+            return new Code(source, start, end);
+        } else if (kind != 0) {
+            return nullptr;
+        }
+
+        uint32_t constantCount = r.U32();
+        if (!r.Check(constantCount)) return nullptr;
+        Handle<Array<JSValue>> constant = Array<JSValue>::New(constantCount);
+        for (uint32_t i = 0; i < constantCount; i++) {
+            Handle<JSValue> value;
+            switch (static_cast<Tag>(r.U8())) {
+                case Tag::kUndefined:
+                    break;
+                case Tag::kNull:
+                    value = JSNull::New();
+                    break;
+                case Tag::kFalse:
+                    value = JSBoolean::New(false);
+                    break;
+                case Tag::kTrue:
+                    value = JSBoolean::New(true);
+                    break;
+                case Tag::kNumber:
+                    value = JSNumber::New(r.Double());
+                    break;
+                case Tag::kString: {
+                    uint32_t length = r.U32();
+                    if (!r.Check(static_cast<size_t>(length) * 2)) return nullptr;
+                    std::wstring buf(length, 0);
+                    for (uint32_t j = 0; j < length; j++) {
+                        buf[j] = r.U16();
+                    }
+                    value = JSString::New(buf.c_str());
+                    break;
+                }
+                default:
+                    return nullptr;
+            }
+            constant->Put(i, value);
+        }
+
+        uint32_t codeCount = r.U32();
+        if (!r.Check(codeCount)) return nullptr;
+        Handle<Array<Code>> pool = Array<Code>::New(codeCount);
+        for (uint32_t i = 0; i < codeCount; i++) {
+            Handle<Code> inner = Read(r, source);
+            if (!inner) return nullptr;
+            pool->Put(i, inner);
+        }
+
+        uint32_t entryCount = r.U32();
+        if (!r.Check(static_cast<size_t>(entryCount) * 12)) return nullptr;
+        Handle<ValueArray<Code::ExceptionTableEntry>> table = ValueArray<Code::ExceptionTableEntry>::New(entryCount);
+        for (uint32_t i = 0; i < entryCount; i++) {
+            Code::ExceptionTableEntry& entry = table->At(i);
+            entry.startPc = r.U32();
+            entry.endPc = r.U32();
+            entry.handlerPc = r.U32();
+        }
+
+        uint32_t length = r.U32();
+        if (!r.Check(length)) return nullptr;
+        Handle<ValueArray<uint8_t>> bc = ValueArray<uint8_t>::New(length);
+        if (length) {
+            r.Bytes(&bc->At(0), length);
+        }
+
+        if (r.Failed()) return nullptr;
+        return new Code(constant, pool, table, bc);
+    }
+};
+
+}
+}
+}
+
+uint64_t CodeCache::Hash(const Handle<JSString>& source) {
+    uint64_t hash = Fnv1a(nullptr, 0);
+    for (size_t i = 0, len = source->Length(); i < len; i++) {
+        char16_t ch = source->At(i);
+        uint8_t bytes[2] = { static_cast<uint8_t>(ch & 0xFF), static_cast<uint8_t>(ch >> 8) };
+        hash = Fnv1a(bytes, 2, hash);
+    }
+    return hash;
+}
+
+uint64_t CodeCache::Hash(const char16_t* source, size_t length) {
+    uint64_t hash = Fnv1a(nullptr, 0);
+    for (size_t i = 0; i < length; i++) {
+        char16_t ch = source[i];
+        uint8_t bytes[2] = { static_cast<uint8_t>(ch & 0xFF), static_cast<uint8_t>(ch >> 8) };
+        hash = Fnv1a(bytes, 2, hash);
+    }
+    return hash;
+}
+
+std::vector<uint8_t> CodeCache::Serialize(const Handle<Code>& code, uint64_t sourceHash) {
+    std::vector<uint8_t> payload;
+    Writer payloadWriter(payload);
+    CodeCacheImpl::Write(payloadWriter, code);
+
+    std::vector<uint8_t> out(kMagic, kMagic + 4);
+    Writer w(out);
+    w.U32(kVersion);
+    w.U64(sourceHash);
+    w.U64(payload.size());
+    w.U64(Fnv1a(payload.data(), payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+uint64_t CodeCache::Hash(const uint8_t* source, size_t length) {
+    uint64_t hash = Fnv1a(nullptr, 0);
+    for (size_t i = 0; i < length; i++) {
+        uint8_t bytes[2] = { source[i], 0 };
+        hash = Fnv1a(bytes, 2, hash);
+    }
+    return hash;
+}
+
+Handle<Code> CodeCache::Deserialize(const std::vector<uint8_t>& data, const Handle<JSString>& source) {
+    return Deserialize(data, source, Hash(source));
+}
+
+Handle<Code> CodeCache::Deserialize(const std::vector<uint8_t>& data, const Handle<JSString>& source, uint64_t sourceHash) {
+    if (data.size() < kHeaderLength || memcmp(data.data(), kMagic, 4) != 0) {
+        return nullptr;
+    }
+    Reader header(data, 4);
+    if (header.U32() != kVersion) {
+        return nullptr;
+    }
+    if (header.U64() != sourceHash) {
+        return nullptr;
+    }
+    uint64_t length = header.U64();
+    uint64_t checksum = header.U64();
+    if (length != data.size() - kHeaderLength || checksum != Fnv1a(data.data() + kHeaderLength, length)) {
+        return nullptr;
+    }
+    Reader r(data, kHeaderLength);
+    Handle<Code> code = CodeCacheImpl::Read(r, source);
+    if (code) {
+        code->SetScriptSource(source);
+    }
+    return code;
+}
+
+Handle<Code> CodeCache::Load(const std::string& directory, const Handle<JSString>& source) {
+    uint64_t hash = Hash(source);
+    std::vector<uint8_t> data;
+    if (!ReadEntry(directory, hash, data)) {
+        return nullptr;
+    }
+    return Deserialize(data, source, hash);
+}
+
+bool CodeCache::ReadEntry(const std::string& directory, uint64_t sourceHash, std::vector<uint8_t>& data) {
+    FILE* file = fopen(CachePath(directory, sourceHash).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    data.clear();
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+    return true;
+}
+
+void CodeCache::Store(const std::string& directory, const Handle<JSString>& source, const Handle<Code>& code) {
+    Store(directory, Hash(source), code);
+}
+
+void CodeCache::Store(const std::string& directory, uint64_t hash, const Handle<Code>& code) {
+    std::vector<uint8_t> data = Serialize(code, hash);
+    // Write to a temporary file first so a concurrent reader never sees a partial cache entry
+    std::string path = CachePath(directory, hash);
+    std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef NORLIT_JS_BYTECODE_CODECACHE_H
+#define NORLIT_JS_BYTECODE_CODECACHE_H
+
+#include "Code.h"
+
+#include "../JSString.h"
+
+#include <string>
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace bytecode {
+
+// Binary serialization of Code trees, so a script that has been compiled before can skip the
+// scanner, parser and code generator altogether.
+//
+// Layout (all integers little endian):
+//   Header  magic "NJSC", version u32, source hash u64, payload length u64, payload checksum u64
+//   Code    u8 0 (compiled), constant pool, code pool, exception table, bytecode
+//           u8 1 (not compiled yet), source start u32, source end u32
+//   Constant pool u32 count, each a u8 tag followed by a double or a u32 length and UTF-16 units
+//   Code pool u32 count, each a Code
+//   Exception table u32 count, each start, end and handler u32
+//   Bytecode u32 length followed by the bytes
+class CodeCache {
+  public:
+    // Must be bumped whenever the instruction encoding or the layout above changes
+    static const uint32_t kVersion = 4;
+
+    static uint64_t Hash(const gc::Handle<JSString>& source);
+    // Hash of source text outside the heap, which may be computed on any thread
+    static uint64_t Hash(const char16_t* source, size_t length);
+    static uint64_t Hash(const uint8_t* source, size_t length);
+
+    static std::vector<uint8_t> Serialize(const gc::Handle<Code>&, uint64_t sourceHash);
+    // Returns nullptr if the data is truncated, corrupted, of another version or for another source.
+    // Functions that are not compiled yet refer to the given source
+    static gc::Handle<Code> Deserialize(const std::vector<uint8_t>&, const gc::Handle<JSString>& source);
+    // Same as above when the hash of source is already known
+    static gc::Handle<Code> Deserialize(const std::vector<uint8_t>&, const gc::Handle<JSString>& source, uint64_t sourceHash);
+
+    // On-disk cache in directory, with one file per source named after its hash
+    static gc::Handle<Code> Load(const std::string& directory, const gc::Handle<JSString>& source);
+    // Read the raw cache entry for the source hash without deserializing it. Does not touch the heap
+    static bool ReadEntry(const std::string& directory, uint64_t sourceHash, std::vector<uint8_t>&);
+    static void Store(const std::string& directory, const gc::Handle<JSString>& source, const gc::Handle<Code>&);
+    static void Store(const std::string& directory, uint64_t sourceHash, const gc::Handle<Code>&);
+};
+
+}
+}
+}
+
+#endif
@@ -2,17 +2,20 @@
 #include "Instruction.h"
 #include "../grammar/Node.h"
 #include "../grammar/Token.h"
+#include "../grammar/Scanner.h"
+#include "../grammar/Parser.h"
 
-#include "../JSNumber.h"
+#include "../Exception.h"
 
 #include <typeinfo>
 #include <cstdio>
+#include <vector>
+#include <algorithm>
 
 using namespace norlit::gc;
 using namespace norlit::js;
 using namespace norlit::js::grammar;
 using namespace norlit::js::bytecode;
-using namespace norlit::util;
 
 namespace {
 
@@ -23,18 +26,18 @@ void ConvertTop2ToNum(Emitter& emitter) {
     emitter.Emit(Instruction::kNum);
 }
 
-Handle<Expression> TryToLvalue(const Handle<Expression>& expr) {
+Expression* TryToLvalue(Expression* expr) {
     const std::type_info& targetType = typeid(*expr);
     if (targetType == typeid(PropertyExpression) ||
             targetType == typeid(Identifier) ||
             targetType == typeid(SuperPropertyExpression)) {
         return expr;
     } else if (targetType == typeid(CoveredFormals)) {
-        Handle<Array<Expression>> items = expr.CastTo<CoveredFormals>()->items();
+        NodeList<Expression>* items = static_cast<CoveredFormals*>(expr)->items();
         if (items->Length() != 1) {
             return nullptr;
         }
-        Handle<Expression> ret = items->Get(0);
+        Expression* ret = items->Get(0);
         if (typeid(*ret) == typeid(SpreadExpression)) {
             return nullptr;
         }
@@ -44,8 +47,8 @@ Handle<Expression> TryToLvalue(const Handle<Expression>& expr) {
     }
 }
 
-Handle<Expression> ToSimpleAssignmentTarget(const Handle<Expression>& expr) {
-    Handle<Expression> ret = TryToLvalue(expr);
+Expression* ToSimpleAssignmentTarget(Expression* expr) {
+    Expression* ret = TryToLvalue(expr);
     if (!ret) {
         throw "Invalid simple assignment target";
     }
@@ -56,14 +59,14 @@ Handle<Expression> ToSimpleAssignmentTarget(const Handle<Expression>& expr) {
 
 /* Variable Declaration Code Generation */
 
-static void GenerateDefinition(const Handle<Expression>& expr, Emitter& emitter, VariableDeclaration::Type type) {
-    if (Handle<BinaryExpression> pair = expr.ExactCheckedCastTo<BinaryExpression>()) {
+static void GenerateDefinition(Expression* expr, Emitter& emitter, VariableDeclaration::Type type) {
+    if (BinaryExpression* pair = ExactCheckedCast<BinaryExpression>(expr)) {
         assert(pair->op() == '=');
         GenerateDefinition(pair->left(), emitter, type);
         return;
     }
-    if (Handle<Identifier> id = expr.ExactCheckedCastTo<Identifier>()) {
-        size_t index = emitter.EmitConstant(id->name());
+    if (Identifier* id = ExactCheckedCast<Identifier>(expr)) {
+        size_t index = emitter.EmitConstant(*id->name());
         switch (type) {
             case VariableDeclaration::Type::kVar:
                 emitter.Emit(Instruction::kDefVar);
@@ -75,37 +78,45 @@ static void GenerateDefinition(const Handle<Expression>& expr, Emitter& emitter,
                 emitter.Emit(Instruction::kDefConst);
                 break;
         }
-        emitter.Emit16(index);
+        emitter.EmitImmediate(index);
     } else {
         throw "TODO: var [a], {a};";
     }
 }
 
 // Bind the top of stack into a binding pattern
-static void BindIntoPattern(const Handle<Expression>& lhs, Emitter& emitter) {
-    if (Handle<Identifier> id = lhs.ExactCheckedCastTo<Identifier>()) {
-        size_t index = emitter.EmitConstant(id->name());
+static void BindIntoPattern(Expression* lhs, Emitter& emitter) {
+    if (Identifier* id = ExactCheckedCast<Identifier>(lhs)) {
+        size_t index = emitter.EmitConstant(*id->name());
         emitter.Emit(Instruction::kInitDef);
-        emitter.Emit16(index);
+        emitter.EmitImmediate(index);
     } else {
         throw "TODO: let [a] = xx;";
     }
 }
 
 // Bind the top of stack into a binding pattern
-static void AssignIntoPattern(const Handle<Expression>& lhs, Emitter& emitter) {
-    if (Handle<Identifier> id = lhs.ExactCheckedCastTo<Identifier>()) {
-        size_t index = emitter.EmitConstant(id->name());
+static void AssignIntoPattern(Expression* lhs, Emitter& emitter) {
+    if (Identifier* id = ExactCheckedCast<Identifier>(lhs)) {
+        size_t index = emitter.EmitConstant(*id->name());
         emitter.Emit(Instruction::kPutName);
-        emitter.Emit16(index);
+        emitter.EmitImmediate(index);
+        emitter.Emit(Instruction::kPop);
+    } else if (PropertyExpression* prop = ExactCheckedCast<PropertyExpression>(lhs)) {
+        prop->base()->Codegen(emitter);
+        prop->member()->Codegen(emitter);
+        // [Value] [Base] [Member] -> [Base] [Member] [Value]
+        emitter.Emit(Instruction::kRotate3);
+        emitter.Emit(Instruction::kRotate3);
+        emitter.Emit(Instruction::kSetProperty);
         emitter.Emit(Instruction::kPop);
     } else {
         throw "TODO: var [a] = xx;";
     }
 }
 
-static void GenerateVarAssignment(const Handle<Expression>& expr, Emitter& emitter, VariableDeclaration::Type type) {
-    if (Handle<BinaryExpression> pair = expr.ExactCheckedCastTo<BinaryExpression>()) {
+static void GenerateVarAssignment(Expression* expr, Emitter& emitter, VariableDeclaration::Type type) {
+    if (BinaryExpression* pair = ExactCheckedCast<BinaryExpression>(expr)) {
         assert(pair->op() == '=');
         pair->right()->Codegen(emitter);
         if (type == VariableDeclaration::Type::kVar) {
@@ -123,8 +134,9 @@ static void GenerateVarAssignment(const Handle<Expression>& expr, Emitter& emitt
 }
 
 void VariableDeclaration::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
     VariableDeclaration::Type type = this->type_;
-    Handle<Array<Expression>> items = this->decl_;
+    NodeList<Expression>* items = this->decl_;
     for (size_t i = 0, length = items->Length(); i < length; i++) {
         GenerateVarAssignment(items->Get(i), emitter, type);
     }
@@ -134,7 +146,7 @@ void VariableDeclaration::VarDeclGen(Emitter& emitter) {
     if (this->type_ != Type::kVar) {
         return;
     }
-    Handle<Array<Expression>> items = decl_;
+    NodeList<Expression>* items = decl_;
     for (size_t i = 0, length = items->Length(); i < length; i++) {
         GenerateDefinition(items->Get(i), emitter, VariableDeclaration::Type::kVar);
     }
@@ -146,7 +158,7 @@ void VariableDeclaration::LexDeclGen(Emitter& emitter) {
         return;
     }
     VariableDeclaration::Type type = this->type_;
-    Handle<Array<Expression>> items = decl_;
+    NodeList<Expression>* items = decl_;
     for (size_t i = 0, length = items->Length(); i < length; i++) {
         GenerateDefinition(items->Get(i), emitter, type);
     }
@@ -160,22 +172,22 @@ namespace js {
 namespace grammar {
 
 void Literal::Codegen(Emitter& emitter) {
-    size_t id = emitter.EmitConstant(literal_);
+    size_t id = emitter.EmitConstant(*literal());
     emitter.Emit(Instruction::kLoad);
-    emitter.Emit16(id);
+    emitter.EmitImmediate(id);
 }
 
 void Identifier::Codegen(Emitter& emitter) {
-    size_t id = emitter.EmitConstant(this->name_);
+    size_t id = emitter.EmitConstant(*this->name());
     emitter.Emit(Instruction::kGetName);
-    emitter.Emit16(id);
+    emitter.EmitImmediate(id);
 }
 
 void TemplateLiteral::Codegen(Emitter& emitter) {
-    Handle<TemplateLiteral> self = this;
-    size_t id = emitter.EmitConstant(self->cooked_->Get(0));
+    TemplateLiteral* self = this;
+    size_t id = emitter.EmitConstant(*self->cooked_->Get(0));
     emitter.Emit(Instruction::kLoad);
-    emitter.Emit16(id);
+    emitter.EmitImmediate(id);
     if (!self->subst_) {
         return;
     }
@@ -184,9 +196,9 @@ void TemplateLiteral::Codegen(Emitter& emitter) {
         emitter.Emit(Instruction::kStr);
         emitter.Emit(Instruction::kConcat);
 
-        id = emitter.EmitConstant(self->cooked_->Get(i + 1));
+        id = emitter.EmitConstant(*self->cooked_->Get(i + 1));
         emitter.Emit(Instruction::kLoad);
-        emitter.Emit16(id);
+        emitter.EmitImmediate(id);
         emitter.Emit(Instruction::kConcat);
     }
 }
@@ -196,12 +208,12 @@ void ThisExpression::Codegen(Emitter& emitter) {
 }
 
 void CoveredFormals::Codegen(Emitter& emitter) {
-    Handle<Array<Expression>> items = items_;
+    NodeList<Expression>* items = items_;
     size_t length = items->Length();
     if (length == 0) {
         throw "Expression expected in parenthesis expression";
     }
-    Handle<Expression> last = items->Get(length - 1);
+    Expression* last = items->Get(length - 1);
     if (typeid(*last) == typeid(SpreadExpression)) {
         throw "Rest parameter should not appear in parenthesis expression";
     }
@@ -213,14 +225,24 @@ void CoveredFormals::Codegen(Emitter& emitter) {
 }
 
 void RegexpLiteral::Codegen(Emitter& emitter) {
-    throw "TODO";
+    RegexpLiteral* self = this;
+    // An invalid pattern is an early error, checked when the code is created
+    emitter.AddRegExp(*self->regexp(), *self->flags());
+
+    size_t id = emitter.EmitConstant(*self->regexp());
+    emitter.Emit(Instruction::kLoad);
+    emitter.EmitImmediate(id);
+    id = emitter.EmitConstant(*self->flags());
+    emitter.Emit(Instruction::kLoad);
+    emitter.EmitImmediate(id);
+    emitter.Emit(Instruction::kRegExp);
 }
 
 void ArrayLiteral::Codegen(Emitter& emitter) {
-    Handle<Array<Expression>> items = this->items_;
+    NodeList<Expression>* items = this->items_;
     emitter.Emit(Instruction::kArrayStart);
     for (size_t i = 0, len = items->Length(); i < len; i++) {
-        Handle<Expression> expr = items->Get(i);
+        Expression* expr = items->Get(i);
         if (expr) {
             expr->Codegen(emitter);
         } else {
@@ -232,13 +254,13 @@ void ArrayLiteral::Codegen(Emitter& emitter) {
 
 void ObjectLiteral::Codegen(Emitter& emitter) {
     emitter.Emit(Instruction::kCreateObject);
-    for (Handle<Property> prop: this->items_->GetIterable()) {
+    for (Property* prop: this->items_->GetIterable()) {
         prop->Codegen(emitter);
     }
 }
 
 void Property::Codegen(Emitter& emitter) {
-    Handle<Property> self = this;
+    Property* self = this;
     switch (self->type_) {
         case Type::kNormal:
             self->key_->Codegen(emitter);
@@ -251,49 +273,51 @@ void Property::Codegen(Emitter& emitter) {
 }
 
 void CallExpression::Codegen(Emitter& emitter) {
-    Handle<Expression> callee = this->callee_;
-    Handle<Array<Expression>> args = this->args_;
-    Handle<Expression> lvalCallee = TryToLvalue(callee);
+    Expression* callee = this->callee_;
+    NodeList<Expression>* args = this->args_;
+    Expression* lvalCallee = TryToLvalue(callee);
     if (!lvalCallee) {
         callee->Codegen(emitter);
         emitter.Emit(Instruction::kThis);
     } else {
         const std::type_info& targetType = typeid(*lvalCallee);
         if (targetType == typeid(PropertyExpression)) {
-            Handle<PropertyExpression> prop = lvalCallee.CastTo<PropertyExpression>();
+            PropertyExpression* prop = static_cast<PropertyExpression*>(lvalCallee);
             prop->base()->Codegen(emitter);
             emitter.Emit(Instruction::kDup);
             prop->member()->Codegen(emitter);
             emitter.Emit(Instruction::kGetProperty);
             emitter.Emit(Instruction::kXchg);
         } else if (targetType == typeid(Identifier)) {
-            size_t id = emitter.EmitConstant(lvalCallee.CastTo<Identifier>()->name());
+            size_t id = emitter.EmitConstant(*static_cast<Identifier*>(lvalCallee)->name());
             emitter.Emit(Instruction::kGetName);
-            emitter.Emit16(id);
+            emitter.EmitImmediate(id);
             emitter.Emit(Instruction::kImplicitThis);
-            emitter.Emit16(id);
+            emitter.EmitImmediate(id);
         } else {
             throw "TODO";
         }
     }
     emitter.Emit(Instruction::kArrayStart);
     for (size_t i = 0, size = args->Length(); i < size; i++) {
-        Handle<Expression> expr = args->Get(i);
+        Expression* expr = args->Get(i);
         expr->Codegen(emitter);
     }
+    emitter.EmitPosition(position);
     emitter.Emit(Instruction::kCall);
 }
 
 void NewExpression::Codegen(Emitter& emitter) {
-    Handle<Expression> ctor = this->ctor_;
-    Handle<Array<Expression>> args = this->args_;
+    Expression* ctor = this->ctor_;
+    NodeList<Expression>* args = this->args_;
 
     ctor->Codegen(emitter);
     emitter.Emit(Instruction::kArrayStart);
     for (size_t i = 0, size = args->Length(); i < size; i++) {
-        Handle<Expression> expr = args->Get(i);
+        Expression* expr = args->Get(i);
         expr->Codegen(emitter);
     }
+    emitter.EmitPosition(position);
     emitter.Emit(Instruction::kNew);
 }
 
@@ -306,9 +330,10 @@ void NewTargetExpression::Codegen(Emitter& emitter) {
 }
 
 void PropertyExpression::Codegen(Emitter& emitter) {
-    Handle<PropertyExpression> self = this;
+    PropertyExpression* self = this;
     self->base_->Codegen(emitter);
     self->member_->Codegen(emitter);
+    emitter.EmitPosition(self->position);
     emitter.Emit(Instruction::kGetProperty);
 }
 
@@ -327,11 +352,11 @@ void SpreadExpression::Codegen(Emitter& emitter) {
 
 void PostfixExpression::Codegen(Emitter& emitter) {
     Instruction inc = this->increment()?Instruction::kAdd:Instruction::kSub;
-    Handle<Expression> lvalue = ToSimpleAssignmentTarget(this->expr_);
+    Expression* lvalue = ToSimpleAssignmentTarget(this->expr_);
 
     const std::type_info& targetType = typeid(*lvalue);
     if (targetType == typeid(PropertyExpression)) {
-        Handle<PropertyExpression> prop = lvalue.CastTo<PropertyExpression>();
+        PropertyExpression* prop = static_cast<PropertyExpression*>(lvalue);
         prop->base()->Codegen(emitter);
         prop->member()->Codegen(emitter);
         emitter.Emit(Instruction::kGetPropertyNoPop);
@@ -346,15 +371,15 @@ void PostfixExpression::Codegen(Emitter& emitter) {
         // Now it is [Value] [Value + 1]
         emitter.Emit(Instruction::kPop);
     } else if (targetType == typeid(Identifier)) {
-        size_t id = emitter.EmitConstant(lvalue.CastTo<Identifier>()->name());
+        size_t id = emitter.EmitConstant(*static_cast<Identifier*>(lvalue)->name());
         emitter.Emit(Instruction::kGetName);
-        emitter.Emit16(id);
+        emitter.EmitImmediate(id);
         emitter.Emit(Instruction::kNum);
         emitter.Emit(Instruction::kDup);
         emitter.Emit(Instruction::kOne);
         emitter.Emit(inc);
         emitter.Emit(Instruction::kPutName);
-        emitter.Emit16(id);
+        emitter.EmitImmediate(id);
         emitter.Emit(Instruction::kPop);
     } else {
         throw "TODO";
@@ -362,11 +387,11 @@ void PostfixExpression::Codegen(Emitter& emitter) {
 }
 
 void UnaryExpression::Codegen(Emitter& emitter) {
-    Handle<Expression> operand = this->expr_;
+    Expression* operand = this->expr_;
     uint16_t op = this->op_;
     switch (op) {
         case Token::kDelete: {
-            Handle<Expression> lvalue = TryToLvalue(operand);
+            Expression* lvalue = TryToLvalue(operand);
             if (!lvalue) {
                 operand->Codegen(emitter);
                 emitter.Emit(Instruction::kPop);
@@ -375,14 +400,14 @@ void UnaryExpression::Codegen(Emitter& emitter) {
             }
             const std::type_info& targetType = typeid(*lvalue);
             if (targetType == typeid(PropertyExpression)) {
-                Handle<PropertyExpression> prop = lvalue.CastTo<PropertyExpression>();
+                PropertyExpression* prop = static_cast<PropertyExpression*>(lvalue);
                 prop->base()->Codegen(emitter);
                 prop->member()->Codegen(emitter);
                 emitter.Emit(Instruction::kDeleteProperty);
             } else if (targetType == typeid(Identifier)) {
-                size_t id = emitter.EmitConstant(lvalue.CastTo<Identifier>()->name());
+                size_t id = emitter.EmitConstant(*static_cast<Identifier*>(lvalue)->name());
                 emitter.Emit(Instruction::kDeleteName);
-                emitter.Emit16(id);
+                emitter.EmitImmediate(id);
             } else {
                 throw "TODO";
             }
@@ -394,10 +419,10 @@ void UnaryExpression::Codegen(Emitter& emitter) {
             emitter.Emit(Instruction::kUndef);
             break;
         case Token::kTypeof: {
-            Handle<Expression> lvalue = TryToLvalue(operand);
+            Expression* lvalue = TryToLvalue(operand);
             if (lvalue && typeid(*lvalue) == typeid(Identifier)) {
                 emitter.Emit(Instruction::kGetNameOrUndef);
-                emitter.Emit16(emitter.EmitConstant(lvalue.CastTo<Identifier>()->name()));
+                emitter.EmitImmediate(emitter.EmitConstant(*static_cast<Identifier*>(lvalue)->name()));
             } else {
                 operand->Codegen(emitter);
             }
@@ -405,10 +430,10 @@ void UnaryExpression::Codegen(Emitter& emitter) {
             break;
         }
         case Token::kInc: {
-            Handle<Expression> lvalue = ToSimpleAssignmentTarget(operand);
+            Expression* lvalue = ToSimpleAssignmentTarget(operand);
             const std::type_info& targetType = typeid(*lvalue);
             if (targetType == typeid(PropertyExpression)) {
-                Handle<PropertyExpression> prop = lvalue.CastTo<PropertyExpression>();
+                PropertyExpression* prop = static_cast<PropertyExpression*>(lvalue);
                 prop->base()->Codegen(emitter);
                 prop->member()->Codegen(emitter);
                 emitter.Emit(Instruction::kGetPropertyNoPop);
@@ -416,23 +441,23 @@ void UnaryExpression::Codegen(Emitter& emitter) {
                 emitter.Emit(Instruction::kAdd);
                 emitter.Emit(Instruction::kSetProperty);
             } else if (targetType == typeid(Identifier)) {
-                size_t id = emitter.EmitConstant(lvalue.CastTo<Identifier>()->name());
+                size_t id = emitter.EmitConstant(*static_cast<Identifier*>(lvalue)->name());
                 emitter.Emit(Instruction::kGetName);
-                emitter.Emit16(id);
+                emitter.EmitImmediate(id);
                 emitter.Emit(Instruction::kOne);
                 emitter.Emit(Instruction::kAdd);
                 emitter.Emit(Instruction::kPutName);
-                emitter.Emit16(id);
+                emitter.EmitImmediate(id);
             } else {
                 throw "TODO";
             }
             break;
         }
         case Token::kDec: {
-            Handle<Expression> lvalue = ToSimpleAssignmentTarget(operand);
+            Expression* lvalue = ToSimpleAssignmentTarget(operand);
             const std::type_info& targetType = typeid(*lvalue);
             if (targetType == typeid(PropertyExpression)) {
-                Handle<PropertyExpression> prop = lvalue.CastTo<PropertyExpression>();
+                PropertyExpression* prop = static_cast<PropertyExpression*>(lvalue);
                 prop->base()->Codegen(emitter);
                 prop->member()->Codegen(emitter);
                 emitter.Emit(Instruction::kGetPropertyNoPop);
@@ -441,14 +466,14 @@ void UnaryExpression::Codegen(Emitter& emitter) {
                 emitter.Emit(Instruction::kSub);
                 emitter.Emit(Instruction::kSetProperty);
             } else if (targetType == typeid(Identifier)) {
-                size_t id = emitter.EmitConstant(lvalue.CastTo<Identifier>()->name());
+                size_t id = emitter.EmitConstant(*static_cast<Identifier*>(lvalue)->name());
                 emitter.Emit(Instruction::kGetName);
-                emitter.Emit16(id);
+                emitter.EmitImmediate(id);
                 emitter.Emit(Instruction::kNum);
                 emitter.Emit(Instruction::kOne);
                 emitter.Emit(Instruction::kSub);
                 emitter.Emit(Instruction::kPutName);
-                emitter.Emit16(id);
+                emitter.EmitImmediate(id);
             } else {
                 throw "TODO";
             }
@@ -480,11 +505,11 @@ void UnaryExpression::Codegen(Emitter& emitter) {
 
 namespace {
 
-void OpAssign(Emitter& emitter, const Handle<Expression>& left, const Handle<Expression>& right, void(*op)(Emitter&)) {
-    Handle<Expression> lval = ToSimpleAssignmentTarget(left);
+void OpAssign(Emitter& emitter, Expression* left, Expression* right, void(*op)(Emitter&)) {
+    Expression* lval = ToSimpleAssignmentTarget(left);
     const std::type_info& targetType = typeid(*lval);
     if (targetType == typeid(PropertyExpression)) {
-        Handle<PropertyExpression> prop = lval.CastTo<PropertyExpression>();
+        PropertyExpression* prop = static_cast<PropertyExpression*>(lval);
         prop->base()->Codegen(emitter);
         prop->member()->Codegen(emitter);
         emitter.Emit(Instruction::kGetPropertyNoPop);
@@ -492,13 +517,13 @@ void OpAssign(Emitter& emitter, const Handle<Expression>& left, const Handle<Exp
         op(emitter);
         emitter.Emit(Instruction::kSetProperty);
     } else if (targetType == typeid(Identifier)) {
-        size_t index = emitter.EmitConstant(lval.CastTo<Identifier>()->name());
+        size_t index = emitter.EmitConstant(*static_cast<Identifier*>(lval)->name());
         emitter.Emit(Instruction::kGetName);
-        emitter.Emit16(index);
+        emitter.EmitImmediate(index);
         right->Codegen(emitter);
         op(emitter);
         emitter.Emit(Instruction::kPutName);
-        emitter.Emit16(index);
+        emitter.EmitImmediate(index);
     } else {
         throw "TODO";
     }
@@ -507,8 +532,8 @@ void OpAssign(Emitter& emitter, const Handle<Expression>& left, const Handle<Exp
 }
 
 void BinaryExpression::Codegen(Emitter& emitter) {
-    Handle<Expression> left = left_;
-    Handle<Expression> right = right_;
+    Expression* left = left_;
+    Expression* right = right_;
     uint16_t op = op_;
     switch (op) {
         case '+':
@@ -672,11 +697,11 @@ void BinaryExpression::Codegen(Emitter& emitter) {
             right->Codegen(emitter);
             break;
         case '=': {
-            Handle<Expression> lval = TryToLvalue(left);
+            Expression* lval = TryToLvalue(left);
             if (lval) {
                 const std::type_info& targetType = typeid(*lval);
                 if (targetType == typeid(PropertyExpression)) {
-                    Handle<PropertyExpression> prop = lval.CastTo<PropertyExpression>();
+                    PropertyExpression* prop = static_cast<PropertyExpression*>(lval);
                     prop->base()->Codegen(emitter);
                     prop->member()->Codegen(emitter);
                     right->Codegen(emitter);
@@ -684,7 +709,7 @@ void BinaryExpression::Codegen(Emitter& emitter) {
                 } else if (targetType == typeid(Identifier)) {
                     right->Codegen(emitter);
                     emitter.Emit(Instruction::kPutName);
-                    emitter.Emit16(emitter.EmitConstant(lval.CastTo<Identifier>()->name()));
+                    emitter.EmitImmediate(emitter.EmitConstant(*static_cast<Identifier*>(lval)->name()));
                 } else {
                     throw "TODO";
                 }
@@ -747,7 +772,7 @@ void BinaryExpression::Codegen(Emitter& emitter) {
 }
 
 void ConditionalExpression::Codegen(Emitter& emitter) {
-    Handle<ConditionalExpression> self = this;
+    ConditionalExpression* self = this;
     self->cond_->Codegen(emitter);
     emitter.Emit(Instruction::kBool);
     emitter.Emit(Instruction::kJumpIfTrue);
@@ -766,7 +791,7 @@ void ConditionalExpression::Codegen(Emitter& emitter) {
 
 void BlockStatement::Codegen(Emitter& emitter) {
     emitter.Emit(Instruction::kPushScope);
-    Handle<Array<Statement>> items = items_;
+    NodeList<Statement>* items = items_;
     for (size_t i = 0, size = items_->Length(); i < size; i++) {
         items_->Get(i)->LexDeclGen(emitter);
     }
@@ -777,21 +802,23 @@ void BlockStatement::Codegen(Emitter& emitter) {
 }
 
 void ExpressionStatement::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
     emitter.Emit(Instruction::kPop);
     expr_->Codegen(emitter);
 }
 
 void DirectiveStatement::Codegen(Emitter& emitter) {
     emitter.Emit(Instruction::kPop);
-    size_t id = emitter.EmitConstant(this->value_);
+    size_t id = emitter.EmitConstant(*this->value());
     emitter.Emit(Instruction::kLoad);
-    emitter.Emit16(id);
+    emitter.EmitImmediate(id);
 }
 
 void EmptyStatement::Codegen(Emitter& emitter) {}
 
 void IfStatement::Codegen(Emitter& emitter) {
-    Handle<IfStatement> self = this;
+    IfStatement* self = this;
+    emitter.EmitPosition(self->position);
     if (self->otherwise_) {
         self->cond_->Codegen(emitter);
         emitter.Emit(Instruction::kBool);
@@ -815,21 +842,27 @@ void IfStatement::Codegen(Emitter& emitter) {
 }
 
 void DoStatement::Codegen(Emitter& emitter) {
-    Handle<DoStatement> self = this;
+    DoStatement* self = this;
+    emitter.EnterTarget(Emitter::TargetKind::kIteration);
     Emitter::Label bodyLabel = emitter.EmitLabel();
     self->body_->Codegen(emitter);
     // Continue point
+    Emitter::Label continueLabel = emitter.EmitLabel();
+    emitter.EmitPosition(self->position);
     self->cond_->Codegen(emitter);
     emitter.Emit(Instruction::kBool);
     emitter.Emit(Instruction::kJumpIfTrue);
     emitter.PatchLabel(emitter.EmitPlaceholder(), bodyLabel);
     // Break point
+    emitter.LeaveTarget(emitter.EmitLabel(), continueLabel);
 }
 
 void WhileStatement::Codegen(Emitter& emitter) {
-    Handle<WhileStatement> self = this;
+    WhileStatement* self = this;
+    emitter.EnterTarget(Emitter::TargetKind::kIteration);
     // Continue point
     Emitter::Label condLabel = emitter.EmitLabel();
+    emitter.EmitPosition(self->position);
     self->cond_->Codegen(emitter);
     emitter.Emit(Instruction::kBool);
     emitter.Emit(Instruction::kNot);
@@ -839,16 +872,377 @@ void WhileStatement::Codegen(Emitter& emitter) {
     emitter.Emit(Instruction::kJump);
     emitter.PatchLabel(emitter.EmitPlaceholder(), condLabel);
     // Break point
-    emitter.PatchLabel(finishBranch, emitter.EmitLabel());
+    Emitter::Label finishLabel = emitter.EmitLabel();
+    emitter.PatchLabel(finishBranch, finishLabel);
+    emitter.LeaveTarget(finishLabel, condLabel);
+}
+
+namespace {
+
+Expression* DeclaredBinding(Expression* expr) {
+    if (BinaryExpression* pair = ExactCheckedCast<BinaryExpression>(expr)) {
+        return pair->left();
+    }
+    return expr;
+}
+
+// 13.7.4.9 CreatePerIterationEnvironment
+// Replace the loop scope by a new one holding copies of the current let bindings
+void CreatePerIterationEnvironment(VariableDeclaration* decl, Emitter& emitter) {
+    NodeList<Expression>* items = decl->decl();
+    size_t length = items->Length();
+    for (size_t i = 0; i < length; i++) {
+        DeclaredBinding(items->Get(i))->Codegen(emitter);
+    }
+    emitter.Emit(Instruction::kPopScope);
+    emitter.Emit(Instruction::kPushScope);
+    for (size_t i = 0; i < length; i++) {
+        GenerateDefinition(items->Get(i), emitter, VariableDeclaration::Type::kLet);
+    }
+    for (size_t i = length; i-- > 0;) {
+        BindIntoPattern(DeclaredBinding(items->Get(i)), emitter);
+    }
+}
+
+void GenerateForInOf(
+    Emitter& emitter,
+    VariableDeclaration* decl,
+    Expression* target,
+    Expression* expr,
+    Statement* body,
+    bool isOf
+) {
+    // The iterator lives in a hidden binding rather than on the stack, as exception handlers clear the stack.
+    // % cannot appear in identifiers so it will never clash with user bindings
+    static const Constant iteratorName = Constant::String(L"%iterator");
+    uint32_t iteratorIndex = static_cast<uint32_t>(emitter.EmitConstant(iteratorName));
+    bool lexical = decl && decl->type() != VariableDeclaration::Type::kVar;
+
+    emitter.Emit(Instruction::kPushScope);
+    emitter.Emit(Instruction::kDefLet);
+    emitter.EmitImmediate(iteratorIndex);
+    expr->Codegen(emitter);
+    emitter.Emit(isOf ? Instruction::kGetIterator : Instruction::kEnumerate);
+    emitter.Emit(Instruction::kInitDef);
+    emitter.EmitImmediate(iteratorIndex);
+
+    emitter.EnterTarget(isOf ? Emitter::TargetKind::kIteratorLoop : Emitter::TargetKind::kIteration, iteratorIndex);
+    // Continue point
+    Emitter::Label nextLabel = emitter.EmitLabel();
+    emitter.Emit(Instruction::kGetName);
+    emitter.EmitImmediate(iteratorIndex);
+    emitter.Emit(Instruction::kIteratorNext);
+    Emitter::Placeholder doneBranch = emitter.EmitPlaceholder();
+    Emitter::Label bodyStart = emitter.EmitLabel();
+
+    if (lexical) {
+        // Each iteration gets a fresh binding
+        Expression* binding = decl->decl()->Get(0);
+        emitter.Emit(Instruction::kPushScope);
+        GenerateDefinition(binding, emitter, decl->type());
+        BindIntoPattern(binding, emitter);
+        body->Codegen(emitter);
+        emitter.Emit(Instruction::kPopScope);
+    } else {
+        if (decl) {
+            AssignIntoPattern(decl->decl()->Get(0), emitter);
+        } else {
+            Expression* lval = TryToLvalue(target);
+            AssignIntoPattern(lval ? lval : target, emitter);
+        }
+        body->Codegen(emitter);
+    }
+    Emitter::Label bodyEnd = emitter.EmitLabel();
+    emitter.Emit(Instruction::kJump);
+    emitter.PatchLabel(emitter.EmitPlaceholder(), nextLabel);
+
+    if (isOf) {
+        // An exception leaving the body closes the iterator. When the exception landed here, the stack is [Exception]
+        Emitter::Label closeLabel = emitter.EmitLabel();
+        emitter.Emit(Instruction::kGetName);
+        emitter.EmitImmediate(iteratorIndex);
+        emitter.Emit(Instruction::kIteratorCloseThrow);
+        emitter.ProtectTarget(bodyStart, bodyEnd, closeLabel);
+    }
+
+    // Break point
+    Emitter::Label breakLabel = emitter.EmitLabel();
+    if (isOf) {
+        emitter.Emit(Instruction::kGetName);
+        emitter.EmitImmediate(iteratorIndex);
+        emitter.Emit(Instruction::kIteratorClose);
+    }
+    emitter.PatchLabel(doneBranch, emitter.EmitLabel());
+    emitter.LeaveTarget(breakLabel, nextLabel);
+    emitter.Emit(Instruction::kPopScope);
+}
+
+}
+
+void ForStatement::Codegen(Emitter& emitter) {
+    ForStatement* self = this;
+    emitter.EmitPosition(self->position);
+    VariableDeclaration* decl = self->decl_;
+    bool lexical = decl && decl->type() != VariableDeclaration::Type::kVar;
+    // Closures capturing let bindings must observe a fresh copy per iteration. When there are no
+    // closures, the copy is unobservable and the whole loop shares one scope
+    bool copyBindings = lexical && decl->type() == VariableDeclaration::Type::kLet && self->perIterationScope_;
+
+    if (lexical) {
+        emitter.Emit(Instruction::kPushScope);
+        decl->LexDeclGen(emitter);
+    }
+    if (decl) {
+        decl->Codegen(emitter);
+    } else if (self->init_) {
+        self->init_->Codegen(emitter);
+        emitter.Emit(Instruction::kPop);
+    }
+    if (copyBindings) {
+        CreatePerIterationEnvironment(decl, emitter);
+    }
+
+    emitter.EnterTarget(Emitter::TargetKind::kIteration);
+    Emitter::Label condLabel = emitter.EmitLabel();
+    Emitter::Placeholder finishBranch;
+    if (self->cond_) {
+        self->cond_->Codegen(emitter);
+        emitter.Emit(Instruction::kBool);
+        emitter.Emit(Instruction::kNot);
+        emitter.Emit(Instruction::kJumpIfTrue);
+        finishBranch = emitter.EmitPlaceholder();
+    }
+    self->body_->Codegen(emitter);
+
+    // Continue point
+    Emitter::Label continueLabel = emitter.EmitLabel();
+    if (copyBindings) {
+        CreatePerIterationEnvironment(decl, emitter);
+    }
+    if (self->update_) {
+        self->update_->Codegen(emitter);
+        emitter.Emit(Instruction::kPop);
+    }
+    emitter.Emit(Instruction::kJump);
+    emitter.PatchLabel(emitter.EmitPlaceholder(), condLabel);
+
+    // Break point
+    Emitter::Label finishLabel = emitter.EmitLabel();
+    if (self->cond_) {
+        emitter.PatchLabel(finishBranch, finishLabel);
+    }
+    emitter.LeaveTarget(finishLabel, continueLabel);
+    if (lexical) {
+        emitter.Emit(Instruction::kPopScope);
+    }
+}
+
+void ForInStatement::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
+    GenerateForInOf(emitter, decl_, target_, expr_, body_, false);
+}
+
+void ForOfStatement::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
+    GenerateForInOf(emitter, decl_, target_, expr_, body_, true);
+}
+
+namespace {
+
+// Case selectors that can be dispatched by identity: small integers, short strings, booleans and null
+bool IsDispatchableCase(Expression* cond) {
+    Literal* lit = ExactCheckedCast<Literal>(cond);
+    JSValue* value;
+    return lit && lit->literal()->ToTagged(value) && value;
 }
 
+struct SwitchCase {
+    uintptr_t key;
+    size_t clause;
+    const Constant* value;
+};
+
+}
+
+void SwitchStatement::Codegen(Emitter& emitter) {
+    SwitchStatement* self = this;
+    NodeList<SwitchClause>* clauses = self->clauses_;
+    size_t clauseCount = clauses->Length();
+
+    emitter.EmitPosition(self->position);
+    self->expr_->Codegen(emitter);
+    emitter.Emit(Instruction::kPushScope);
+    for (SwitchClause* clause : clauses->GetIterable()) {
+        for (Statement* stmt : clause->body()->GetIterable()) {
+            stmt->LexDeclGen(emitter);
+        }
+    }
+    emitter.EnterTarget(Emitter::TargetKind::kSwitch);
+
+    // Jumps into the clause bodies, patched once the bodies are emitted
+    std::vector<std::vector<Emitter::Placeholder>> clauseRefs(clauseCount);
+    std::vector<Emitter::Placeholder> defaultRefs;
+
+    std::vector<SwitchCase> cases;
+    bool dispatchable = true;
+    for (size_t i = 0; i < clauseCount; i++) {
+        Expression* cond = clauses->Get(i)->cond();
+        if (!cond) {
+            continue;
+        }
+        if (!IsDispatchableCase(cond)) {
+            dispatchable = false;
+            break;
+        }
+        const Constant* value = static_cast<Literal*>(cond)->literal();
+        JSValue* tagged;
+        value->ToTagged(tagged);
+        cases.push_back({ reinterpret_cast<uintptr_t>(tagged), i, value });
+    }
+
+    if (dispatchable && !cases.empty()) {
+        // Selectors are constants without side effects, so dispatch them at once instead of comparing one by one.
+        // The first clause wins among duplicated selectors
+        std::stable_sort(cases.begin(), cases.end(), [](const SwitchCase& a, const SwitchCase& b) {
+            return a.key < b.key;
+        });
+        cases.erase(std::unique(cases.begin(), cases.end(), [](const SwitchCase& a, const SwitchCase& b) {
+            return a.key == b.key;
+        }), cases.end());
+
+        bool allInteger = true;
+        int64_t low = 0, high = 0;
+        for (const SwitchCase& c : cases) {
+            if (c.value->type() != Constant::Type::kNumber) {
+                allInteger = false;
+                break;
+            }
+            int64_t value = static_cast<int64_t>(c.value->number());
+            if (&c == &cases.front() || value < low) low = value;
+            if (&c == &cases.front() || value > high) high = value;
+        }
+        uint64_t range = static_cast<uint64_t>(high - low) + 1;
+
+        if (allInteger && low >= INT32_MIN && high <= INT32_MAX && range <= cases.size() * 2) {
+            // Dense integers: jump table indexed by value
+            std::vector<size_t> slots(range, clauseCount);
+            for (const SwitchCase& c : cases) {
+                slots[static_cast<int64_t>(c.value->number()) - low] = c.clause;
+            }
+            emitter.Emit(Instruction::kTableSwitch);
+            emitter.EmitImmediate(static_cast<uint32_t>(static_cast<int32_t>(low)));
+            emitter.EmitImmediate(static_cast<uint32_t>(range));
+            defaultRefs.push_back(emitter.EmitPlaceholder());
+            for (size_t slot : slots) {
+                if (slot == clauseCount) {
+                    defaultRefs.push_back(emitter.EmitPlaceholder());
+                } else {
+                    clauseRefs[slot].push_back(emitter.EmitPlaceholder());
+                }
+            }
+        } else {
+            // Sparse integers or short strings: binary search by identity
+            emitter.Emit(Instruction::kLookupSwitch);
+            emitter.EmitImmediate(static_cast<uint32_t>(cases.size()));
+            defaultRefs.push_back(emitter.EmitPlaceholder());
+            for (const SwitchCase& c : cases) {
+                emitter.EmitImmediate(static_cast<uint32_t>(emitter.EmitConstant(*c.value)));
+                clauseRefs[c.clause].push_back(emitter.EmitPlaceholder());
+            }
+        }
+    } else {
+        // Compare the selectors in order with ===
+        std::vector<Emitter::Placeholder> matched(clauseCount);
+        for (size_t i = 0; i < clauseCount; i++) {
+            Expression* cond = clauses->Get(i)->cond();
+            if (!cond) {
+                continue;
+            }
+            emitter.Emit(Instruction::kDup);
+            cond->Codegen(emitter);
+            emitter.Emit(Instruction::kSeq);
+            emitter.Emit(Instruction::kJumpIfTrue);
+            matched[i] = emitter.EmitPlaceholder();
+        }
+        emitter.Emit(Instruction::kPop);
+        emitter.Emit(Instruction::kJump);
+        defaultRefs.push_back(emitter.EmitPlaceholder());
+        // The discriminant is still on the stack when matched
+        for (size_t i = 0; i < clauseCount; i++) {
+            if (!clauses->Get(i)->cond()) {
+                continue;
+            }
+            emitter.PatchLabel(matched[i], emitter.EmitLabel());
+            emitter.Emit(Instruction::kPop);
+            emitter.Emit(Instruction::kJump);
+            clauseRefs[i].push_back(emitter.EmitPlaceholder());
+        }
+    }
+
+    bool hasDefault = false;
+    for (size_t i = 0; i < clauseCount; i++) {
+        SwitchClause* clause = clauses->Get(i);
+        Emitter::Label clauseLabel = emitter.EmitLabel();
+        for (Emitter::Placeholder p : clauseRefs[i]) {
+            emitter.PatchLabel(p, clauseLabel);
+        }
+        if (!clause->cond()) {
+            hasDefault = true;
+            for (Emitter::Placeholder p : defaultRefs) {
+                emitter.PatchLabel(p, clauseLabel);
+            }
+        }
+        for (Statement* stmt : clause->body()->GetIterable()) {
+            stmt->Codegen(emitter);
+        }
+    }
+
+    // Break point
+    Emitter::Label finishLabel = emitter.EmitLabel();
+    if (!hasDefault) {
+        for (Emitter::Placeholder p : defaultRefs) {
+            emitter.PatchLabel(p, finishLabel);
+        }
+    }
+    emitter.LeaveTarget(finishLabel);
+    emitter.Emit(Instruction::kPopScope);
+}
+
+void LabelledStatement::Codegen(Emitter& emitter) {
+    LabelledStatement* self = this;
+    emitter.AddLabel(self->label());
+    Statement* body = self->body_;
+    const std::type_info& bodyType = typeid(*body);
+    if (bodyType == typeid(DoStatement) ||
+            bodyType == typeid(WhileStatement) ||
+            bodyType == typeid(ForStatement) ||
+            bodyType == typeid(ForInStatement) ||
+            bodyType == typeid(ForOfStatement) ||
+            bodyType == typeid(SwitchStatement) ||
+            bodyType == typeid(LabelledStatement)) {
+        // The label is attached to the target entered by the body
+        body->Codegen(emitter);
+    } else {
+        emitter.EnterTarget(Emitter::TargetKind::kLabelled);
+        body->Codegen(emitter);
+        emitter.LeaveTarget(emitter.EmitLabel());
+    }
+}
+
+void BreakStatement::Codegen(Emitter& emitter) {
+    emitter.EmitBreak(label());
+}
+
+void ContinueStatement::Codegen(Emitter& emitter) {
+    emitter.EmitContinue(label());
+}
 
 void DebuggerStatement::Codegen(Emitter& emitter) {
     emitter.Emit(Instruction::kDebugger);
 }
 
 void Script::Codegen(Emitter& emitter) {
-    Handle<Script> self = this;
+    Script* self = this;
     for (size_t i = 0, size = self->body_->Length(); i < size; i++) {
         self->body_->Get(i)->VarDeclGen(emitter);
         self->body_->Get(i)->LexDeclGen(emitter);
@@ -861,20 +1255,32 @@ void Script::Codegen(Emitter& emitter) {
 }
 
 void ThrowStatement::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
     this->expr_->Codegen(emitter);
     emitter.Emit(Instruction::kThrow);
 }
 
 void ReturnStatement::Codegen(Emitter& emitter) {
+    emitter.EmitPosition(position);
     if (this->expr_)
         this->expr_->Codegen(emitter);
     else
         emitter.Emit(Instruction::kUndef);
-    emitter.Emit(Instruction::kReturn);
+    emitter.EmitReturn();
 }
 
 void TryStatement::Codegen(Emitter& emitter) {
-    Handle<TryStatement> self = this;
+    TryStatement* self = this;
+
+    // Abrupt completions leaving the body or the catch block run a copy of the finally block on their way out
+    if (self->finally_) {
+        emitter.EnterTry([self, &emitter]() {
+            self->finally_->Codegen(emitter);
+        });
+    }
+    if (self->param_) {
+        emitter.EnterTry();
+    }
 
     // General Step 1
     Emitter::Label bodyBlockStart = emitter.EmitLabel();
@@ -899,6 +1305,8 @@ void TryStatement::Codegen(Emitter& emitter) {
         // 7  FinallyBlock
 
         Emitter::Label catchLabel = emitter.EmitLabel();
+        emitter.ProtectTarget(bodyBlockStart, bodyBlockEnd, catchLabel);
+        emitter.LeaveTarget(catchLabel);
 
         // Step 3
         // When exception landed here, the stack is [Exception]
@@ -917,6 +1325,8 @@ void TryStatement::Codegen(Emitter& emitter) {
         Emitter::Placeholder finishHolder2 = emitter.EmitPlaceholder();
 
         Emitter::Label finallyLabel = emitter.EmitLabel();
+        emitter.ProtectTarget(catchBlockStart, catchBlockEnd, finallyLabel);
+        emitter.LeaveTarget(finallyLabel);
 
         // Step 5
         // When exception landed here, the stack is [Exception]
@@ -936,8 +1346,6 @@ void TryStatement::Codegen(Emitter& emitter) {
 
         emitter.PatchLabel(finishHolder, finishLabel);
         emitter.PatchLabel(finishHolder2, finishLabel);
-        emitter.NewExceptionTableEntry(bodyBlockStart, bodyBlockEnd, catchLabel);
-        emitter.NewExceptionTableEntry(catchBlockStart, catchBlockEnd, finallyLabel);
     } else if (self->param_) {
         // Try-Catch
         // 1  BodyBlock | OnError Goto Catch
@@ -947,6 +1355,8 @@ void TryStatement::Codegen(Emitter& emitter) {
         // Finish:
 
         Emitter::Label catchLabel = emitter.EmitLabel();
+        emitter.ProtectTarget(bodyBlockStart, bodyBlockEnd, catchLabel);
+        emitter.LeaveTarget(catchLabel);
 
         // Step 3
         // When exception landed here, the stack is [Exception]
@@ -960,7 +1370,6 @@ void TryStatement::Codegen(Emitter& emitter) {
         Emitter::Label finishLabel = emitter.EmitLabel();
 
         emitter.PatchLabel(finishHolder, finishLabel);
-        emitter.NewExceptionTableEntry(bodyBlockStart, bodyBlockEnd, catchLabel);
     } else {
         // Try-Finally
         // 1  BodyBlock | OnError Goto Finally
@@ -972,6 +1381,8 @@ void TryStatement::Codegen(Emitter& emitter) {
         // 5  FinallyBlock
 
         Emitter::Label finallyLabel = emitter.EmitLabel();
+        emitter.ProtectTarget(bodyBlockStart, bodyBlockEnd, finallyLabel);
+        emitter.LeaveTarget(finallyLabel);
 
         // Step 3
         // When exception landed here, the stack is [Exception]
@@ -990,7 +1401,6 @@ void TryStatement::Codegen(Emitter& emitter) {
         self->finally_->Codegen(emitter);
 
         emitter.PatchLabel(finishHolder, finishLabel);
-        emitter.NewExceptionTableEntry(bodyBlockStart, bodyBlockEnd, finallyLabel);
     }
 }
 
@@ -1004,16 +1414,15 @@ void Statement::Codegen(Emitter& emitter) {
 }
 
 // Function Generation
-void FunctionExpression::Codegen(Emitter& emitter) {
-    Handle<FunctionExpression> self = this;
-    Emitter innerEmitter;
+void FunctionExpression::Compile(Emitter& innerEmitter) {
+    FunctionExpression* self = this;
 
     {
         size_t i = 0;
-        for (Handle<Expression> param : self->param_->GetIterable()) {
-            size_t index = innerEmitter.EmitConstant(JSNumber::New(static_cast<int64_t>(i)));
+        for (Expression* param : self->param_->GetIterable()) {
+            size_t index = innerEmitter.EmitConstant(Constant::Number(static_cast<double>(i)));
             innerEmitter.Emit(Instruction::kLoad);
-            innerEmitter.Emit16(index);
+            innerEmitter.EmitImmediate(index);
             innerEmitter.Emit(Instruction::kGetPropertyNoPop);
             GenerateDefinition(param, innerEmitter, VariableDeclaration::Type::kLet);
             BindIntoPattern(param, innerEmitter);
@@ -1022,37 +1431,82 @@ void FunctionExpression::Codegen(Emitter& emitter) {
         }
     }
 
-    for (Handle<Statement> stmt : self->body_->GetIterable()) {
+    for (Statement* stmt : self->body_->GetIterable()) {
         stmt->VarDeclGen(innerEmitter);
         stmt->LexDeclGen(innerEmitter);
     }
 
     innerEmitter.Emit(Instruction::kUndef);
-    for (Handle<Statement> stmt : self->body_->GetIterable()) {
+    for (Statement* stmt : self->body_->GetIterable()) {
         stmt->Codegen(innerEmitter);
     }
     innerEmitter.Emit(Instruction::kUndef);
     innerEmitter.Emit(Instruction::kReturn);
-    size_t codeIndex = emitter.EmitCode(innerEmitter.ToCode());
+}
+
+void Code::Compile() {
+    Handle<Code> self = this;
+    Handle<JSString> source = self->source;
+    Scanner scanner(source, self->sourceStart, self->sourceEnd);
+    Parser parser(scanner, 1);
+    FunctionExpression* func = parser.ParseFunctionOrGeneratorExpression();
+    Emitter emitter;
+    func->Compile(emitter);
+    Handle<Code> code = emitter.ToCode(source);
+    self->WriteBarrier(&self->constantPool, code->constantPool);
+    self->WriteBarrier(&self->codePool, code->codePool);
+    self->WriteBarrier(&self->exceptionTable, code->exceptionTable);
+    self->WriteBarrier(&self->bytecode, code->bytecode);
+}
+
+// Code generation is deterministic, so generating the code again from the same source with
+// positions recorded gives the same bytecode, now with its position table
+void Code::BuildPositionTable() {
+    Handle<Code> self = this;
+    Handle<JSString> source = self->source;
+    Scanner scanner(source, self->sourceStart, self->sourceEnd);
+    Emitter emitter;
+    emitter.RecordPositions();
+    if (self->script) {
+        Parser parser(scanner);
+        parser.ParseScript()->Codegen(emitter);
+    } else {
+        Parser parser(scanner, 1);
+        parser.ParseFunctionOrGeneratorExpression()->Compile(emitter);
+    }
+    Handle<Code> code = emitter.ToCode(source);
+    self->WriteBarrier(&self->positionTable, code->positionTable);
+}
+
+void FunctionExpression::Codegen(Emitter& emitter) {
+    FunctionExpression* self = this;
+    size_t codeIndex;
+    if (self->isLazy()) {
+        codeIndex = emitter.EmitCode(self->start, self->end);
+    } else {
+        std::unique_ptr<Emitter> innerEmitter(new Emitter);
+        self->Compile(*innerEmitter);
+        codeIndex = emitter.EmitCode(std::move(innerEmitter));
+    }
 
     size_t nameIndex;
     if (self->name_) {
-        nameIndex = emitter.EmitConstant(self->name_);
+        nameIndex = emitter.EmitConstant(*self->name());
         emitter.Emit(Instruction::kPushScope);
         emitter.Emit(Instruction::kDefConst);
-        emitter.Emit16(nameIndex);
+        emitter.EmitImmediate(nameIndex);
     }
 
     if (self->isGenerator())
         emitter.Emit(Instruction::kGenerator);
     else
         emitter.Emit(Instruction::kFunction);
-    emitter.Emit16(codeIndex);
+    emitter.EmitImmediate(codeIndex);
 
     if (self->name_) {
         emitter.Emit(Instruction::kDup);
         emitter.Emit(Instruction::kInitDef);
-        emitter.Emit16(nameIndex);
+        emitter.EmitImmediate(nameIndex);
         emitter.Emit(Instruction::kPopScope);
     }
 }
@@ -1060,19 +1514,19 @@ void FunctionExpression::Codegen(Emitter& emitter) {
 void FunctionStatement::Codegen(Emitter& emitter) {}
 
 void FunctionStatement::VarDeclGen(Emitter& emitter) {
-    Handle<FunctionExpression> self = this->func_;
-    Handle<JSString> name = self->name_;
+    FunctionExpression* self = this->func_;
+    Constant* name = self->name_;
 
-    size_t nameIndex = emitter.EmitConstant(self->name_);
+    size_t nameIndex = emitter.EmitConstant(*self->name());
     emitter.Emit(Instruction::kDefLet);
-    emitter.Emit16(nameIndex);
+    emitter.EmitImmediate(nameIndex);
 
-    self->WriteBarrier(&self->name_, nullptr);
+    self->name_ = nullptr;
     self->Codegen(emitter);
-    self->WriteBarrier(&self->name_, name);
+    self->name_ = name;
 
     emitter.Emit(Instruction::kInitDef);
-    emitter.Emit16(nameIndex);
+    emitter.EmitImmediate(nameIndex);
 }
 
 void YieldExpression::Codegen(Emitter& emitter) {
@@ -1097,7 +1551,7 @@ void Statement::LexDeclGen(Emitter& emitter) {}
 // VarDeclGen
 
 void BlockStatement::VarDeclGen(Emitter& emitter) {
-    Handle<Array<Statement>> items = items_;
+    NodeList<Statement>* items = items_;
     for (size_t i = 0, length = items->Length(); i < length; i++) {
         items->Get(i)->VarDeclGen(emitter);
     }
@@ -1109,6 +1563,17 @@ void ThrowStatement::VarDeclGen(Emitter& emitter) {}
 void DebuggerStatement::VarDeclGen(Emitter& emitter) {}
 void DirectiveStatement::VarDeclGen(Emitter& emitter) {}
 void ReturnStatement::VarDeclGen(Emitter& emitter) {}
+void BreakStatement::VarDeclGen(Emitter& emitter) {}
+void ContinueStatement::VarDeclGen(Emitter& emitter) {}
+
+void SwitchStatement::VarDeclGen(Emitter& emitter) {
+    NodeList<SwitchClause>* clauses = clauses_;
+    for (SwitchClause* clause : clauses->GetIterable()) {
+        for (Statement* stmt : clause->body()->GetIterable()) {
+            stmt->VarDeclGen(emitter);
+        }
+    }
+}
 
 #define CREATE_VARDECLGEN_ITEM(x,discard) \
 	if(self->NORLIT_PP_CONCAT_2(x,_)) self->NORLIT_PP_CONCAT_2(x,_)->VarDeclGen(emitter);
@@ -1122,4 +1587,8 @@ void ReturnStatement::VarDeclGen(Emitter& emitter) {}
 CREATE_VARDECLGEN(IfStatement, then, otherwise);
 CREATE_VARDECLGEN(DoStatement, body);
 CREATE_VARDECLGEN(WhileStatement, body);
+CREATE_VARDECLGEN(ForStatement, decl, body);
+CREATE_VARDECLGEN(ForInStatement, decl, body);
+CREATE_VARDECLGEN(ForOfStatement, decl, body);
+CREATE_VARDECLGEN(LabelledStatement, body);
 CREATE_VARDECLGEN(TryStatement, body, error, finally);
@@ -1,86 +1,317 @@
 #include "Instruction.h"
 #include "Emitter.h"
 #include "Code.h"
+#include "Optimizer.h"
 
+#include "../Exception.h"
+#include "../regexp/Program.h"
 
 #include <cstdio>
 #include <cstring>
+#include <iterator>
 
 using namespace norlit::gc;
 using namespace norlit::js;
 using namespace norlit::js::bytecode;
+using namespace norlit::js::grammar;
 
-Emitter::Emitter() {
-    bytecode = ValueArray<uint8_t>::New(16);
-}
-
-size_t Emitter::EmitConstant(const Handle<JSValue>& val) {
-    size_t size = constantPool.Size();
-    for (size_t i = 0; i < size; i++) {
-        if (constantPool.Get(i) == val) {
-            return i;
-        }
+size_t Emitter::EmitConstant(const Constant& val) {
+    size_t size = constantPool.size();
+    auto iter = constantIndex.find(val);
+    if (iter != constantIndex.end()) {
+        return iter->second;
     }
-    constantPool.Add(val);
-    assert(size <= 0xFFFF);
+    constantIndex.emplace(val, size);
+    constantPool.push_back(val);
+    assert(size <= 0xFFFFFFFF);
     return size;
 }
 
+size_t Emitter::EmitCode(std::unique_ptr<Emitter> emitter) {
+    size_t ret = codePool.size();
+    codePool.push_back({ std::move(emitter), 0, 0 });
+    assert(ret <= 0xFFFFFFFF);
+    return ret;
+}
 
-size_t Emitter::EmitCode(const Handle<Code>& val) {
-    size_t ret = codePool.Size();
-    codePool.Add(val);
-    assert(ret <= 0xFFFF);
+size_t Emitter::EmitCode(uint32_t start, uint32_t end) {
+    size_t ret = codePool.size();
+    codePool.push_back({ nullptr, start, end });
+    assert(ret <= 0xFFFFFFFF);
     return ret;
 }
 
 void Emitter::Emit8(uint8_t bc) {
-    size_t capacity = bytecode->Length();
-    if (bytecodeLength >= capacity) {
-        Handle<ValueArray<uint8_t>> expanded = ValueArray<uint8_t>::New(capacity * 2);
-        memcpy(&expanded->At(0), &bytecode->At(0), bytecodeLength);
-        bytecode = expanded;
-    }
-    bytecode->At(bytecodeLength++) = bc;
+    bytecode.push_back(bc);
 }
 
-void Emitter::Emit16(uint16_t data) {
+void Emitter::EmitImmediate(uint32_t data) {
+    Emit8((data >> 24) & 0xFF);
+    Emit8((data >> 16) & 0xFF);
     Emit8((data >> 8) & 0xFF);
     Emit8(data & 0xFF);
 }
 
 void Emitter::Emit(Instruction ins) {
+    // Track lexical scopes so break and continue know how many to unwind
+    if (ins == Instruction::kPushScope) {
+        scopeDepth++;
+    } else if (ins == Instruction::kPopScope) {
+        scopeDepth--;
+    }
     Emit8(static_cast<uint8_t>(ins));
 }
 
 Emitter::Placeholder Emitter::EmitPlaceholder() {
-    size_t size = bytecodeLength;
-    Emit16(0);
-    return { static_cast<uint16_t>(size) };
+    size_t size = bytecode.size();
+    EmitImmediate(0);
+    return { static_cast<uint32_t>(size) };
 }
 
 Emitter::Label Emitter::EmitLabel() {
-    return{ static_cast<uint16_t>(bytecodeLength) };
+    return{ static_cast<uint32_t>(bytecode.size()) };
 }
 
 void Emitter::PatchLabel(Placeholder p, Label l) {
-    bytecode->At(p.location) = (l.location >> 8)&0xFF;
-    bytecode->At(p.location+1) = l.location & 0xFF;
+    bytecode[p.location] = (l.location >> 24) & 0xFF;
+    bytecode[p.location + 1] = (l.location >> 16) & 0xFF;
+    bytecode[p.location + 2] = (l.location >> 8) & 0xFF;
+    bytecode[p.location + 3] = l.location & 0xFF;
 }
 
 void Emitter::NewExceptionTableEntry(Label start, Label end, Label handler) {
-    exceptionTable.Add({
+    exceptionTable.push_back({
         start.location,
         end.location,
         handler.location
     });
 }
 
-Handle<Code> Emitter::ToCode() {
-    Handle<Array<JSValue>> constant = constantPool.ToArray();
-    Handle<Array<Code>> code = codePool.ToArray();
-    Handle<ValueArray<Code::ExceptionTableEntry>> ex = exceptionTable.ToArray();
-    Handle<ValueArray<uint8_t>> stripped = ValueArray<uint8_t>::New(bytecodeLength);
-    memcpy(&stripped->At(0), &bytecode->At(0), bytecodeLength);
-    return new Code(constant, code, ex, stripped);
+void Emitter::AddLabel(const Constant* label) {
+    for (const Constant* declared : labels) {
+        if (declared->Equals(*label)) {
+            Exceptions::ThrowSyntaxError("Label has already been declared");
+        }
+    }
+    labels.push_back(label);
+    pendingLabels++;
+}
+
+void Emitter::EnterTarget(TargetKind kind, uint32_t iterator) {
+    size_t labelEnd = labels.size();
+    size_t labelBegin = labelEnd - pendingLabels;
+    pendingLabels = 0;
+    targets.push_back({ kind, labelBegin, labelEnd, scopeDepth, iterator, nullptr, {}, {}, {} });
+}
+
+void Emitter::EnterTry(std::function<void()> finalizer) {
+    size_t labelEnd = labels.size();
+    targets.push_back({ TargetKind::kTry, labelEnd, labelEnd, scopeDepth, 0, std::move(finalizer), {}, {}, {} });
+}
+
+void Emitter::ProtectTarget(Label start, Label end, Label handler) {
+    // Exit code is emitted in order, so the ranges are sorted
+    for (const CodeRange& exit : targets.back().exits) {
+        if (exit.end.location <= start.location || exit.start.location >= end.location) {
+            continue;
+        }
+        if (start.location < exit.start.location) {
+            NewExceptionTableEntry(start, exit.start, handler);
+        }
+        start = exit.end;
+    }
+    if (start.location < end.location) {
+        NewExceptionTableEntry(start, end, handler);
+    }
+}
+
+void Emitter::LeaveTarget(Label breakTarget, Label continueTarget) {
+    JumpTarget& target = targets.back();
+    for (Placeholder p : target.breaks) {
+        PatchLabel(p, breakTarget);
+    }
+    for (Placeholder p : target.continues) {
+        PatchLabel(p, continueTarget);
+    }
+    labels.resize(target.labelBegin);
+    targets.pop_back();
+}
+
+void Emitter::EmitExitCode(size_t index, size_t& popped) {
+    TargetKind kind = targets[index].kind;
+    if (kind != TargetKind::kIteratorLoop && !targets[index].finalizer) {
+        return;
+    }
+    // Exception handlers recover the scope depth by scanning the bytecode linearly, so code that may throw must
+    // not run after kUnwindScope. Scopes are left one by one instead and entered again after the jump
+    while (scopeDepth > targets[index].scopeDepth) {
+        Emit(Instruction::kPopScope);
+        popped++;
+    }
+    Label start = EmitLabel();
+    if (kind == TargetKind::kIteratorLoop) {
+        Emit(Instruction::kGetName);
+        EmitImmediate(targets[index].iterator);
+        Emit(Instruction::kIteratorClose);
+    } else {
+        // The finally block is emitted as if it is outside of the targets being left, as it is in the source
+        std::function<void()> finalizer = targets[index].finalizer;
+        std::vector<JumpTarget> left(std::make_move_iterator(targets.begin() + index), std::make_move_iterator(targets.end()));
+        targets.erase(targets.begin() + index, targets.end());
+        std::vector<const Constant*> leftLabels(labels.begin() + left.front().labelBegin, labels.end());
+        labels.resize(left.front().labelBegin);
+
+        // Keep the completion value on the stack top, as statements replace it
+        Emit(Instruction::kUndef);
+        finalizer();
+        Emit(Instruction::kPop);
+
+        labels.insert(labels.end(), leftLabels.begin(), leftLabels.end());
+        targets.insert(targets.end(), std::make_move_iterator(left.begin()), std::make_move_iterator(left.end()));
+    }
+    Label end = EmitLabel();
+    for (size_t i = index; i < targets.size(); i++) {
+        targets[i].exits.push_back({ start, end });
+    }
+}
+
+void Emitter::ReenterScopes(size_t popped) {
+    // Unreachable, only keeps the scope depth consistent for the code that follows
+    for (size_t i = 0; i < popped; i++) {
+        Emit(Instruction::kPushScope);
+    }
+}
+
+void Emitter::EmitJumpToTarget(const Constant* label, bool isContinue) {
+    size_t popped = 0;
+    for (size_t i = targets.size(); i-- > 0;) {
+        TargetKind kind = targets[i].kind;
+        bool iteration = kind == TargetKind::kIteration || kind == TargetKind::kIteratorLoop;
+        bool match = false;
+        if (kind == TargetKind::kTry) {
+            // Never a target
+        } else if (label) {
+            for (size_t j = targets[i].labelBegin; j < targets[i].labelEnd; j++) {
+                if (labels[j]->Equals(*label)) {
+                    match = true;
+                    break;
+                }
+            }
+            if (match && isContinue && !iteration) {
+                Exceptions::ThrowSyntaxError("Label of continue statement does not denote an iteration statement");
+            }
+        } else {
+            match = isContinue ? iteration : kind != TargetKind::kLabelled;
+        }
+
+        if (match) {
+            if (scopeDepth != targets[i].scopeDepth) {
+                Emit(Instruction::kUnwindScope);
+                EmitImmediate(static_cast<uint32_t>(scopeDepth - targets[i].scopeDepth));
+            }
+            Emit(Instruction::kJump);
+            if (isContinue) {
+                targets[i].continues.push_back(EmitPlaceholder());
+            } else {
+                targets[i].breaks.push_back(EmitPlaceholder());
+            }
+            ReenterScopes(popped);
+            return;
+        }
+
+        EmitExitCode(i, popped);
+    }
+    if (label) {
+        Exceptions::ThrowSyntaxError("Undefined label");
+    } else if (isContinue) {
+        Exceptions::ThrowSyntaxError("Illegal continue statement");
+    } else {
+        Exceptions::ThrowSyntaxError("Illegal break statement");
+    }
+}
+
+void Emitter::EmitReturn() {
+    size_t popped = 0;
+    for (size_t i = targets.size(); i-- > 0;) {
+        EmitExitCode(i, popped);
+    }
+    Emit(Instruction::kReturn);
+    ReenterScopes(popped);
+}
+
+void Emitter::Optimize() {
+    if (optimized) {
+        return;
+    }
+    Optimizer(*this).Run();
+    for (NestedCode& nested : codePool) {
+        if (nested.emitter) {
+            nested.emitter->Optimize();
+        }
+    }
+    optimized = true;
+}
+
+Handle<Code> Emitter::ToCode(const Handle<JSString>& source) {
+    Optimize();
+    for (const std::pair<Constant, Constant>& regexp : regexps) {
+        // Compiling also caches the program for the RegExp objects created when the literal is evaluated
+        uint8_t flags;
+        if (!regexp::Program::ParseFlags(regexp.second.ToValue().CastTo<JSString>(), flags)) {
+            Exceptions::ThrowSyntaxError("Invalid regular expression flags");
+        }
+        regexp::Program::Compile(regexp.first.ToValue().CastTo<JSString>(), flags);
+    }
+
+    Handle<Array<JSValue>> constant = Array<JSValue>::New(constantPool.size());
+    for (size_t i = 0; i < constantPool.size(); i++) {
+        constant->Put(i, constantPool[i].ToValue());
+    }
+    Handle<Array<Code>> code = Array<Code>::New(codePool.size());
+    for (size_t i = 0; i < codePool.size(); i++) {
+        if (codePool[i].emitter) {
+            code->Put(i, codePool[i].emitter->ToCode(source));
+        } else {
+            code->Put(i, new Code(source, codePool[i].start, codePool[i].end));
+        }
+    }
+    Handle<ValueArray<Code::ExceptionTableEntry>> ex = ValueArray<Code::ExceptionTableEntry>::New(exceptionTable.size());
+    if (!exceptionTable.empty()) {
+        memcpy(&ex->At(0), exceptionTable.data(), exceptionTable.size() * sizeof(Code::ExceptionTableEntry));
+    }
+    Handle<ValueArray<uint8_t>> stripped = ValueArray<uint8_t>::New(bytecode.size());
+    if (!bytecode.empty()) {
+        memcpy(&stripped->At(0), bytecode.data(), bytecode.size());
+    }
+    Handle<Code> result = new Code(constant, code, ex, stripped);
+
+    if (recordPositions) {
+        std::vector<uint8_t> table;
+        auto writeVarint = [&](uint32_t value) {
+            while (value >= 0x80) {
+                table.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            table.push_back(static_cast<uint8_t>(value));
+        };
+        uint32_t lastPc = 0;
+        int64_t lastPosition = 0;
+        for (size_t i = 0; i < positions.size(); i++) {
+            // Removed instructions leave entries sharing a pc, of which only the last one applies
+            if (i + 1 < positions.size() && positions[i + 1].pc == positions[i].pc) {
+                continue;
+            }
+            int64_t delta = static_cast<int64_t>(positions[i].position) - lastPosition;
+            writeVarint(positions[i].pc - lastPc);
+            writeVarint(static_cast<uint32_t>(delta >= 0 ? delta * 2 : -delta * 2 - 1));
+            lastPc = positions[i].pc;
+            lastPosition = positions[i].position;
+        }
+        Handle<ValueArray<uint8_t>> encoded = ValueArray<uint8_t>::New(table.size());
+        if (!table.empty()) {
+            memcpy(&encoded->At(0), table.data(), table.size());
+        }
+        result->SetPositionTable(encoded);
+    }
+    return result;
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 
 #include "Code.h"
 
-#include "../JSValue.h"
-#include "../../gc/Array.h"
-#include "../../util/ArrayList.h"
-#include "../../util/ValueArrayList.h"
+#include "../grammar/Constant.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace norlit {
 namespace js {
@@ -14,26 +17,110 @@ namespace bytecode {
 
 enum class Instruction: uint8_t;
 
+// Generates the code of a script or a function. Nothing is put on the heap until ToCode, so
+// everything before it, including the optimizer, may run on any thread
     class Emitter {
-    util::ArrayList<JSValue> constantPool;
-    util::ArrayList<Code> codePool;
-    util::ValueArrayList<Code::ExceptionTableEntry> exceptionTable;
-    gc::Handle<gc::ValueArray<uint8_t>> bytecode;
-    size_t bytecodeLength = 0;
+    friend class Optimizer;
+
+    std::vector<grammar::Constant> constantPool;
+    // Index of each constant in the pool
+    std::unordered_map<grammar::Constant, size_t, grammar::Constant::Hasher, grammar::Constant::Comparer> constantIndex;
+
+    // Nested function. Its code is generated into an emitter of its own, or if it is only pre-parsed,
+    // compiled from the source range [start, end) when first called
+    struct NestedCode {
+        std::unique_ptr<Emitter> emitter;
+        uint32_t start;
+        uint32_t end;
+    };
+    std::vector<NestedCode> codePool;
+    std::vector<Code::ExceptionTableEntry> exceptionTable;
+    std::vector<uint8_t> bytecode;
+    // Pattern and flags of each regexp literal
+    std::vector<std::pair<grammar::Constant, grammar::Constant>> regexps;
+    bool optimized = false;
+
+    struct PositionEntry {
+        uint32_t pc;
+        uint32_t position;
+    };
+    // Source positions are only recorded when the position table of a Code is built on demand,
+    // so ordinary compilation pays nothing for them
+    bool recordPositions = false;
+    std::vector<PositionEntry> positions;
 
   public:
     struct Label {
-        uint16_t location;
+        uint32_t location;
     };
     struct Placeholder {
-        uint16_t location;
+        uint32_t location;
+    };
+
+    // Statements that break and continue may target
+    enum class TargetKind {
+        // Target of unlabelled break and continue
+        kIteration,
+        // Same as kIteration, but the iterator of for-of must be closed when the loop is left by break
+        kIteratorLoop,
+        // Target of unlabelled break
+        kSwitch,
+        // Target of labelled break only
+        kLabelled,
+        // Not a target. The protected block of a try statement, whose finally block is run when an abrupt
+        // completion leaves it
+        kTry
     };
 
-    Emitter();
-    size_t EmitConstant(const gc::Handle<JSValue>& val);
-    size_t EmitCode(const gc::Handle<Code>& val);
+  private:
+    struct CodeRange {
+        Label start;
+        Label end;
+    };
+
+    struct JumpTarget {
+        TargetKind kind;
+        // Labels of this target are labels[labelBegin, labelEnd)
+        size_t labelBegin;
+        size_t labelEnd;
+        size_t scopeDepth;
+        // Constant index of the binding holding the iterator of kIteratorLoop
+        uint32_t iterator;
+        // Emits the finally block of kTry, if there is one
+        std::function<void()> finalizer;
+        std::vector<Placeholder> breaks;
+        std::vector<Placeholder> continues;
+        // Code run by abrupt completions on their way out of this target. It is not protected by the
+        // exception handlers of the target
+        std::vector<CodeRange> exits;
+    };
+
+    std::vector<const grammar::Constant*> labels;
+    size_t pendingLabels = 0;
+    std::vector<JumpTarget> targets;
+    // Number of lexical scopes entered at the current emitting position
+    size_t scopeDepth = 0;
+
+    void EmitJumpToTarget(const grammar::Constant* label, bool isContinue);
+    // Emit the code run when an abrupt completion leaves targets[index], i.e. close the iterator of for-of or
+    // run the finally block of try. Scopes left for that are counted into popped
+    void EmitExitCode(size_t index, size_t& popped);
+    void ReenterScopes(size_t popped);
+
+  public:
+    size_t EmitConstant(const grammar::Constant& val);
+    // Code of a nested function generated into emitter
+    size_t EmitCode(std::unique_ptr<Emitter> emitter);
+    // Code of a nested function pre-parsed from the source range [start, end)
+    size_t EmitCode(uint32_t start, uint32_t end);
+    // Compile the regexp literal when the code is created. An invalid pattern is an early error
+    void AddRegExp(const grammar::Constant& pattern, const grammar::Constant& flags) {
+        regexps.emplace_back(pattern, flags);
+    }
     void Emit8(uint8_t byte);
-    void Emit16(uint16_t data);
+    // Immediates are always emitted 32 bits wide. The optimizer encodes them into 16 bits, or
+    // prefixes the instruction with kWide when they do not fit
+    void EmitImmediate(uint32_t data);
     void Emit(Instruction ins);
     Placeholder EmitPlaceholder();
     Label EmitLabel();
@@ -41,7 +128,53 @@ enum class Instruction: uint8_t;
 
     void NewExceptionTableEntry(Label, Label, Label);
 
-    gc::Handle<Code> ToCode();
+    void RecordPositions() {
+        recordPositions = true;
+    }
+    // Attribute the instructions emitted from now on to the source offset
+    void EmitPosition(uint32_t position) {
+        if (!recordPositions) {
+            return;
+        }
+        if (!positions.empty()) {
+            PositionEntry& last = positions.back();
+            if (last.position == position) {
+                return;
+            }
+            if (last.pc == bytecode.size()) {
+                last.position = position;
+                return;
+            }
+        }
+        positions.push_back({ static_cast<uint32_t>(bytecode.size()), position });
+    }
+
+    // The label will be attached to the next target entered
+    void AddLabel(const grammar::Constant*);
+    void EnterTarget(TargetKind, uint32_t iterator = 0);
+    // Enter the protected block of a try statement. finalizer emits its finally block, or is empty if there is none
+    void EnterTry(std::function<void()> finalizer = nullptr);
+    // Protect [start, end) of the current target with handler, leaving out the exit code of abrupt completions
+    void ProtectTarget(Label start, Label end, Label handler);
+    void LeaveTarget(Label breakTarget, Label continueTarget);
+    void LeaveTarget(Label breakTarget) {
+        LeaveTarget(breakTarget, breakTarget);
+    }
+    // A null label means unlabelled break or continue
+    void EmitBreak(const grammar::Constant* label) {
+        EmitJumpToTarget(label, false);
+    }
+    void EmitContinue(const grammar::Constant* label) {
+        EmitJumpToTarget(label, true);
+    }
+    // Return the value on the stack top, closing iterators and running finally blocks on the way
+    void EmitReturn();
+
+    // Run the optimizer over this code and the code of nested functions. Done by ToCode if not before
+    void Optimize();
+    // Create the code on the heap, interning its constants and compiling its regexp literals.
+    // Pre-parsed functions are compiled from source. Only on the thread running the engine
+    gc::Handle<Code> ToCode(const gc::Handle<JSString>& source);
 };
 
 }
@@ -0,0 +1,176 @@
+#include "Instruction.h"
+
+using namespace norlit::js::bytecode;
+
+const char* norlit::js::bytecode::InstructionName(Instruction ins) {
+    switch (ins) {
+        case Instruction::kWide:
+            return "kWide";
+        case Instruction::kDefVar:
+            return "kDefVar";
+        case Instruction::kDefLet:
+            return "kDefLet";
+        case Instruction::kDefConst:
+            return "kDefConst";
+        case Instruction::kInitDef:
+            return "kInitDef";
+        case Instruction::kLoad:
+            return "kLoad";
+        case Instruction::kGetName:
+            return "kGetName";
+        case Instruction::kGetNameOrUndef:
+            return "kGetNameOrUndef";
+        case Instruction::kPutName:
+            return "kPutName";
+        case Instruction::kDeleteName:
+            return "kDeleteName";
+        case Instruction::kImplicitThis:
+            return "kImplicitThis";
+        case Instruction::kJump:
+            return "kJump";
+        case Instruction::kJumpIfTrue:
+            return "kJumpIfTrue";
+        case Instruction::kTableSwitch:
+            return "kTableSwitch";
+        case Instruction::kLookupSwitch:
+            return "kLookupSwitch";
+        case Instruction::kUnwindScope:
+            return "kUnwindScope";
+        case Instruction::kFunction:
+            return "kFunction";
+        case Instruction::kGenerator:
+            return "kGenerator";
+        case Instruction::kUndef:
+            return "kUndef";
+        case Instruction::kTrue:
+            return "kTrue";
+        case Instruction::kOne:
+            return "kOne";
+        case Instruction::kXchg:
+            return "kXchg";
+        case Instruction::kPrim:
+            return "kPrim";
+        case Instruction::kNum:
+            return "kNum";
+        case Instruction::kStr:
+            return "kStr";
+        case Instruction::kBool:
+            return "kBool";
+        case Instruction::kTypeOf:
+            return "kTypeOf";
+        case Instruction::kGetProperty:
+            return "kGetProperty";
+        case Instruction::kGetPropertyNoPop:
+            return "kGetPropertyNoPop";
+        case Instruction::kSetProperty:
+            return "kSetProperty";
+        case Instruction::kDeleteProperty:
+            return "kDeleteProperty";
+        case Instruction::kCreateDataProperty:
+            return "kCreateDataProperty";
+        case Instruction::kCreateObject:
+            return "kCreateObject";
+        case Instruction::kRegExp:
+            return "kRegExp";
+        case Instruction::kArrayStart:
+            return "kArrayStart";
+        case Instruction::kArrayElision:
+            return "kArrayElision";
+        case Instruction::kArray:
+            return "kArray";
+        case Instruction::kSpread:
+            return "kSpread";
+        case Instruction::kGetIterator:
+            return "kGetIterator";
+        case Instruction::kEnumerate:
+            return "kEnumerate";
+        case Instruction::kIteratorNext:
+            return "kIteratorNext";
+        case Instruction::kIteratorClose:
+            return "kIteratorClose";
+        case Instruction::kIteratorCloseThrow:
+            return "kIteratorCloseThrow";
+        case Instruction::kCall:
+            return "kCall";
+        case Instruction::kNew:
+            return "kNew";
+        case Instruction::kPushScope:
+            return "kPushScope";
+        case Instruction::kPopScope:
+            return "kPopScope";
+        case Instruction::kThrow:
+            return "kThrow";
+        case Instruction::kInstanceOf:
+            return "kInstanceOf";
+        case Instruction::kThis:
+            return "kThis";
+        case Instruction::kNeg:
+            return "kNeg";
+        case Instruction::kBitwiseNot:
+            return "kBitwiseNot";
+        case Instruction::kNot:
+            return "kNot";
+        case Instruction::kMul:
+            return "kMul";
+        case Instruction::kDiv:
+            return "kDiv";
+        case Instruction::kMod:
+            return "kMod";
+        case Instruction::kAddGeneric:
+            return "kAddGeneric";
+        case Instruction::kSub:
+            return "kSub";
+        case Instruction::kShl:
+            return "kShl";
+        case Instruction::kShr:
+            return "kShr";
+        case Instruction::kUshr:
+            return "kUshr";
+        case Instruction::kLt:
+            return "kLt";
+        case Instruction::kLteq:
+            return "kLteq";
+        case Instruction::kEq:
+            return "kEq";
+        case Instruction::kSeq:
+            return "kSeq";
+        case Instruction::kAnd:
+            return "kAnd";
+        case Instruction::kXor:
+            return "kXor";
+        case Instruction::kOr:
+            return "kOr";
+        case Instruction::kAdd:
+            return "kAdd";
+        case Instruction::kConcat:
+            return "kConcat";
+        case Instruction::kDup:
+            return "kDup";
+        case Instruction::kPop:
+            return "kPop";
+        case Instruction::kRotate3:
+            return "kRotate3";
+        case Instruction::kRotate4:
+            return "kRotate4";
+        case Instruction::kReturn:
+            return "kReturn";
+        case Instruction::kYield:
+            return "kYield";
+        case Instruction::kDebugger:
+            return "kDebugger";
+        case Instruction::kGetNamedProperty:
+            return "kGetNamedProperty";
+        case Instruction::kGetNamedPropertyNoPop:
+            return "kGetNamedPropertyNoPop";
+        case Instruction::kGetNameNum:
+            return "kGetNameNum";
+        case Instruction::kInitDefNoPop:
+            return "kInitDefNoPop";
+        case Instruction::kIncName:
+            return "kIncName";
+        case Instruction::kDecName:
+            return "kDecName";
+        default:
+            return "unknown";
+    }
+}
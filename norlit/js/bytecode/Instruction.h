@@ -8,6 +8,11 @@ namespace js {
 namespace bytecode {
 
 enum class Instruction: uint8_t {
+    // Prefix
+    // Immediates of the next instruction are uint32_t instead of uint16_t. Only emitted when an immediate
+    // does not fit in 16 bits
+    kWide,
+
     // Immediates            uint16_t name
     // Create a mutable binding in lexical environment with given name and initialize to undefined
     kDefVar,
@@ -74,6 +79,25 @@ enum class Instruction: uint8_t {
     // Pop a boolean, jump to instruction at target position if operand is true
     kJumpIfTrue,
 
+    // Precondition     ... [Operand1: Any]
+    // Postcondition    ...
+    // Immediates            uint16_t low, uint16_t count, uint16_t default, uint16_t target[count]
+    // Pop the operand. If it is an integer i with low <= i < low + count, where low is treated as signed,
+    // jump to target[i - low], otherwise jump to default
+    kTableSwitch,
+
+    // Precondition     ... [Operand1: Any]
+    // Postcondition    ...
+    // Immediates            uint16_t count, uint16_t default, { uint16_t key, uint16_t target }[count]
+    // Pop the operand and jump to the target whose key constant is strictly equal to it, or default if none.
+    // Keys are tagged values sorted by their bits, so they are searched by identity
+    kLookupSwitch,
+
+    // Immediates            uint16_t count
+    // Exit count lexical scopes. Unlike kPopScope this is used on abrupt paths (break and continue) only,
+    // so it is not accounted for when searching for scope difference of exception handlers
+    kUnwindScope,
+
     kFunction,
     kGenerator,
 
@@ -123,10 +147,42 @@ enum class Instruction: uint8_t {
     // Push new Object()
     kCreateObject,
 
+    // Precondition     ... [Operand1: String] [Operand2: String]
+    // Postcondition    ... [Result: Object]
+    // Pop the pattern and flags of a regular expression literal and push a new RegExp created from them
+    kRegExp,
+
     kArrayStart,
     kArrayElision,
     kArray,
     kSpread,
+
+    // Precondition     ... [Operand1: Any]
+    // Postcondition    ... [Result: Object]
+    // Pop the operand and push GetIterator(Operand1)
+    kGetIterator,
+
+    // Precondition     ... [Operand1: Any]
+    // Postcondition    ... [Result: Object]
+    // Pop the operand and push an iterator over the keys to be visited by for-in
+    kEnumerate,
+
+    // Precondition     ... [Operand1: Object]
+    // Postcondition    ... [Result: Any] or ...
+    // Immediates            uint16_t target
+    // Pop the iterator and step it. Push the value if there is one, otherwise jump to target
+    kIteratorNext,
+
+    // Precondition     ... [Operand1: Object]
+    // Postcondition    ...
+    // Pop the iterator and perform IteratorClose on it
+    kIteratorClose,
+
+    // Precondition     ... [Exception: Any] [Operand1: Object]
+    // Postcondition    Does not complete normally
+    // Pop the iterator and close it, ignoring anything its return method returns or throws, then rethrow the exception
+    kIteratorCloseThrow,
+
     kCall,
     kNew,
 
@@ -190,9 +246,51 @@ enum class Instruction: uint8_t {
     kYield,
 
     // Trigger debugger
-    kDebugger
+    kDebugger,
+
+    // Superinstructions. Formed by the optimizer from common sequences, each one replaces the
+    // sequence in the comment with a single dispatch
+
+    // Precondition     ... [Operand1: Any]
+    // Postcondtion     ... [Result: Any]
+    // Immediates            uint16_t key
+    // kLoad key; kGetProperty
+    kGetNamedProperty,
+
+    // Precondition     ... [Operand1: Any]
+    // Postcondtion     ... [Operand1: String, Number, Boolean, Symbol or Object] [Key: String or Symbol] [Result: Any]
+    // Immediates            uint16_t key
+    // kLoad key; kGetPropertyNoPop
+    kGetNamedPropertyNoPop,
+
+    // Precondition     ...
+    // Postcondition    ... [Result: Number]
+    // Immediates            uint16_t name
+    // kGetName name; kNum
+    kGetNameNum,
+
+    // Precondition     ... [Operand: Any]
+    // Postcondition    ... [Operand: Any]
+    // Immediates            uint16_t name
+    // kDup; kInitDef name
+    kInitDefNoPop,
+
+    // Precondition     ...
+    // Postcondition    ... [Result: Number]
+    // Immediates            uint16_t name
+    // Evaluate name++, that is kGetName name; kNum; kDup; kOne; kAdd; kPutName name; kPop
+    kIncName,
+
+    // Precondition     ...
+    // Postcondition    ... [Result: Number]
+    // Immediates            uint16_t name
+    // Evaluate name--, with kSub in place of kAdd above
+    kDecName
 };
 
+// Name of the enumerator, for reports and traces
+const char* InstructionName(Instruction);
+
 }
 }
 }
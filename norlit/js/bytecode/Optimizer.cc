@@ -0,0 +1,632 @@
+#include "Optimizer.h"
+#include "Instruction.h"
+#include "Emitter.h"
+#include "Code.h"
+
+#include "../Conversion.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace norlit::js;
+using namespace norlit::js::bytecode;
+using namespace norlit::js::grammar;
+
+namespace {
+
+bool IsConversion(Instruction ins) {
+    switch (ins) {
+        case Instruction::kPrim:
+        case Instruction::kNum:
+        case Instruction::kStr:
+        case Instruction::kBool:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Whether control never falls through to the next instruction
+bool IsTerminator(Instruction ins) {
+    switch (ins) {
+        case Instruction::kJump:
+        case Instruction::kTableSwitch:
+        case Instruction::kLookupSwitch:
+        case Instruction::kReturn:
+        case Instruction::kThrow:
+        case Instruction::kIteratorCloseThrow:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+template<typename F>
+void Optimizer::ForEachTarget(Op& op, F func) {
+    switch (op.ins) {
+        case Instruction::kJump:
+        case Instruction::kJumpIfTrue:
+        case Instruction::kIteratorNext:
+            func(op.imm[0]);
+            break;
+        case Instruction::kTableSwitch:
+            for (size_t i = 2; i < op.imm.size(); i++) {
+                func(op.imm[i]);
+            }
+            break;
+        case Instruction::kLookupSwitch:
+            func(op.imm[1]);
+            for (size_t i = 3; i < op.imm.size(); i += 2) {
+                func(op.imm[i]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Optimizer::Decode() {
+    const uint8_t* bc = emitter.bytecode.data();
+    size_t length = emitter.bytecode.size();
+    std::vector<size_t> indexOf(length + 1, 0);
+
+    // Immediates emitted are all 32 bits wide
+    for (size_t pc = 0; pc < length;) {
+        size_t insLength = Code::InstructionLength(bc, pc, 4);
+        indexOf[pc] = ops.size();
+        Op op { static_cast<Instruction>(bc[pc]), true, false, {} };
+        for (size_t i = 1; i < insLength; i += 4) {
+            op.imm.push_back(Code::ReadImmediate(bc, pc + i, 4));
+        }
+        ops.push_back(std::move(op));
+        pc += insLength;
+    }
+    indexOf[length] = ops.size();
+
+    for (Op& op : ops) {
+        ForEachTarget(op, [&](size_t& target) {
+            target = indexOf[target];
+        });
+    }
+    for (const Code::ExceptionTableEntry& entry : emitter.exceptionTable) {
+        ranges.push_back({ indexOf[entry.startPc], indexOf[entry.endPc], indexOf[entry.handlerPc] });
+    }
+    for (const Emitter::PositionEntry& entry : emitter.positions) {
+        positions.push_back(indexOf[entry.pc]);
+    }
+}
+
+bool Optimizer::NeedsWide(const Op& op, const std::vector<size_t>& pcOf) {
+    Op encoded = op;
+    ForEachTarget(encoded, [&](size_t& target) {
+        target = pcOf[target];
+    });
+    for (size_t i = 0; i < encoded.imm.size(); i++) {
+        if (encoded.ins == Instruction::kTableSwitch && i == 0) {
+            // The lower bound of kTableSwitch is signed
+            int32_t low = static_cast<int32_t>(encoded.imm[0]);
+            if (low < INT16_MIN || low > INT16_MAX) {
+                return true;
+            }
+        } else if (encoded.imm[i] > 0xFFFF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Optimizer::Encode() {
+    size_t count = ops.size();
+    std::vector<size_t> pcOf(count + 1);
+    size_t pc;
+
+    // Widening an instruction moves the ones after it, which may in turn require other jumps to be widened.
+    // Instructions are only ever widened, so this terminates
+    bool changed;
+    do {
+        pc = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (ops[i].live) {
+                pcOf[i] = pc;
+                pc += ops[i].wide ? 2 + ops[i].imm.size() * 4 : 1 + ops[i].imm.size() * 2;
+            }
+        }
+        pcOf[count] = pc;
+        // Removed instructions take the position of the next live one
+        for (size_t i = count; i-- > 0;) {
+            if (!ops[i].live) {
+                pcOf[i] = pcOf[i + 1];
+            }
+        }
+
+        changed = false;
+        for (Op& op : ops) {
+            if (op.live && !op.wide && NeedsWide(op, pcOf)) {
+                op.wide = true;
+                changed = true;
+            }
+        }
+    } while (changed);
+
+    std::vector<uint8_t> bc(pc);
+    size_t ptr = 0;
+    for (Op& op : ops) {
+        if (!op.live) {
+            continue;
+        }
+        ForEachTarget(op, [&](size_t& target) {
+            target = pcOf[target];
+        });
+        if (op.wide) {
+            bc[ptr++] = static_cast<uint8_t>(Instruction::kWide);
+        }
+        bc[ptr++] = static_cast<uint8_t>(op.ins);
+        for (size_t imm : op.imm) {
+            if (op.wide) {
+                bc[ptr++] = (imm >> 24) & 0xFF;
+                bc[ptr++] = (imm >> 16) & 0xFF;
+            }
+            bc[ptr++] = (imm >> 8) & 0xFF;
+            bc[ptr++] = imm & 0xFF;
+        }
+    }
+    emitter.bytecode = std::move(bc);
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        emitter.exceptionTable[i] = {
+            static_cast<uint32_t>(pcOf[ranges[i].start]),
+            static_cast<uint32_t>(pcOf[ranges[i].end]),
+            static_cast<uint32_t>(pcOf[ranges[i].handler])
+        };
+    }
+    for (size_t i = 0; i < positions.size(); i++) {
+        emitter.positions[i].pc = static_cast<uint32_t>(pcOf[positions[i]]);
+    }
+}
+
+size_t Optimizer::Resolve(size_t index) {
+    while (index < ops.size() && !ops[index].live) {
+        index++;
+    }
+    return index;
+}
+
+bool Optimizer::IsConstant(const Op& op) {
+    switch (op.ins) {
+        case Instruction::kLoad:
+        case Instruction::kUndef:
+        case Instruction::kTrue:
+        case Instruction::kOne:
+            return true;
+        default:
+            return false;
+    }
+}
+
+Constant Optimizer::GetConstant(const Op& op) {
+    switch (op.ins) {
+        case Instruction::kLoad:
+            return emitter.constantPool[op.imm[0]];
+        case Instruction::kTrue:
+            return Constant::Boolean(true);
+        case Instruction::kOne:
+            return Constant::Number(1);
+        default:
+            return Constant();
+    }
+}
+
+void Optimizer::SetConstant(Op& op, const Constant& value) {
+    op.imm.clear();
+    if (value.type() == Constant::Type::kUndefined) {
+        op.ins = Instruction::kUndef;
+    } else if (value.type() == Constant::Type::kBoolean && value.boolean()) {
+        op.ins = Instruction::kTrue;
+    } else if (value.Equals(Constant::Number(1))) {
+        op.ins = Instruction::kOne;
+    } else {
+        op.ins = Instruction::kLoad;
+        op.imm.push_back(emitter.EmitConstant(value));
+    }
+}
+
+Optimizer::Kind Optimizer::KindOf(const Op& op) {
+    if (IsConstant(op)) {
+        switch (GetConstant(op).type()) {
+            case Constant::Type::kNumber:
+                return Kind::kNumber;
+            case Constant::Type::kString:
+                return Kind::kString;
+            case Constant::Type::kBoolean:
+                return Kind::kBoolean;
+            default:
+                return Kind::kPrimitive;
+        }
+    }
+    switch (op.ins) {
+        case Instruction::kNum:
+        case Instruction::kNeg:
+        case Instruction::kBitwiseNot:
+        case Instruction::kMul:
+        case Instruction::kDiv:
+        case Instruction::kMod:
+        case Instruction::kAdd:
+        case Instruction::kSub:
+        case Instruction::kShl:
+        case Instruction::kShr:
+        case Instruction::kUshr:
+        case Instruction::kAnd:
+        case Instruction::kXor:
+        case Instruction::kOr:
+            return Kind::kNumber;
+        case Instruction::kStr:
+        case Instruction::kConcat:
+        case Instruction::kTypeOf:
+            return Kind::kString;
+        case Instruction::kBool:
+        case Instruction::kNot:
+        case Instruction::kLt:
+        case Instruction::kLteq:
+        case Instruction::kEq:
+        case Instruction::kSeq:
+        case Instruction::kInstanceOf:
+        case Instruction::kDeleteName:
+        case Instruction::kDeleteProperty:
+            return Kind::kBoolean;
+        case Instruction::kPrim:
+        case Instruction::kAddGeneric:
+            return Kind::kPrimitive;
+        default:
+            return Kind::kUnknown;
+    }
+}
+
+bool Optimizer::FoldUnary(const Constant& value, Instruction ins, Constant& result) {
+    Constant::Type type = value.type();
+    switch (ins) {
+        case Instruction::kNeg:
+            if (type != Constant::Type::kNumber) return false;
+            result = Constant::Number(-value.number());
+            return true;
+        case Instruction::kBitwiseNot:
+            if (type != Constant::Type::kNumber) return false;
+            result = Constant::Number(~Conversion::ToInt32(value.number()));
+            return true;
+        case Instruction::kNot:
+            if (type != Constant::Type::kBoolean) return false;
+            result = Constant::Boolean(!value.boolean());
+            return true;
+        case Instruction::kBool:
+            switch (type) {
+                case Constant::Type::kBoolean:
+                    result = value;
+                    return true;
+                case Constant::Type::kNumber:
+                    result = Constant::Boolean(value.number() != 0 && !std::isnan(value.number()));
+                    return true;
+                case Constant::Type::kString:
+                    result = Constant::Boolean(value.string()[0] != 0);
+                    return true;
+                default:
+                    result = Constant::Boolean(false);
+                    return true;
+            }
+        case Instruction::kNum:
+            // Strings are left to be converted at run time
+            switch (type) {
+                case Constant::Type::kNumber:
+                    result = value;
+                    return true;
+                case Constant::Type::kBoolean:
+                    result = Constant::Number(value.boolean() ? 1 : 0);
+                    return true;
+                case Constant::Type::kNull:
+                    result = Constant::Number(0);
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+bool Optimizer::FoldBinary(const Constant& left, const Constant& right, Instruction ins, Constant& result) {
+    if (left.type() != Constant::Type::kNumber || right.type() != Constant::Type::kNumber) {
+        return false;
+    }
+    double lval = left.number();
+    double rval = right.number();
+    switch (ins) {
+        case Instruction::kAdd:
+        case Instruction::kAddGeneric:
+            result = Constant::Number(lval + rval);
+            return true;
+        case Instruction::kSub:
+            result = Constant::Number(lval - rval);
+            return true;
+        case Instruction::kMul:
+            result = Constant::Number(lval * rval);
+            return true;
+        case Instruction::kDiv:
+            result = Constant::Number(lval / rval);
+            return true;
+        case Instruction::kMod:
+            result = Constant::Number(fmod(lval, rval));
+            return true;
+        case Instruction::kShl:
+            result = Constant::Number(static_cast<int32_t>(Conversion::ToUInt32(lval) << (Conversion::ToUInt32(rval) & 0x1F)));
+            return true;
+        case Instruction::kShr:
+            result = Constant::Number(Conversion::ToInt32(lval) >> (Conversion::ToUInt32(rval) & 0x1F));
+            return true;
+        case Instruction::kUshr:
+            result = Constant::Number(Conversion::ToUInt32(lval) >> (Conversion::ToUInt32(rval) & 0x1F));
+            return true;
+        case Instruction::kAnd:
+            result = Constant::Number(Conversion::ToInt32(lval) & Conversion::ToInt32(rval));
+            return true;
+        case Instruction::kXor:
+            result = Constant::Number(Conversion::ToInt32(lval) ^ Conversion::ToInt32(rval));
+            return true;
+        case Instruction::kOr:
+            result = Constant::Number(Conversion::ToInt32(lval) | Conversion::ToInt32(rval));
+            return true;
+        case Instruction::kLt:
+            result = Constant::Boolean(lval < rval);
+            return true;
+        case Instruction::kLteq:
+            result = Constant::Boolean(lval <= rval);
+            return true;
+        case Instruction::kEq:
+        case Instruction::kSeq:
+            result = Constant::Boolean(lval == rval);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Optimizer::ComputeLeaders() {
+    leader.assign(ops.size() + 1, false);
+    leader[Resolve(0)] = true;
+    for (Op& op : ops) {
+        if (!op.live) {
+            continue;
+        }
+        ForEachTarget(op, [&](size_t& target) {
+            leader[Resolve(target)] = true;
+        });
+    }
+    // Keep instructions on both sides of a protected range boundary apart
+    for (Range& range : ranges) {
+        leader[Resolve(range.start)] = true;
+        leader[Resolve(range.end)] = true;
+        leader[Resolve(range.handler)] = true;
+    }
+}
+
+bool Optimizer::ThreadJumps() {
+    bool changed = false;
+    size_t count = ops.size();
+    for (Op& op : ops) {
+        if (!op.live) {
+            continue;
+        }
+        ForEachTarget(op, [&](size_t& target) {
+            size_t final = Resolve(target);
+            size_t hops = 0;
+            while (final < count && ops[final].ins == Instruction::kJump) {
+                // Jump cycle, e.g. an empty infinite loop
+                if (++hops > count) {
+                    return;
+                }
+                final = Resolve(ops[final].imm[0]);
+            }
+            if (final != target) {
+                target = final;
+                changed = true;
+            }
+        });
+    }
+    return changed;
+}
+
+bool Optimizer::Peephole() {
+    bool changed = false;
+    size_t count = ops.size();
+    for (size_t i = Resolve(0); i < count; i = Next(i)) {
+        Op& a = ops[i];
+        size_t j = Next(i);
+
+        // Jump to the next instruction
+        if (a.ins == Instruction::kJump && Resolve(a.imm[0]) == j) {
+            Kill(i);
+            changed = true;
+            continue;
+        }
+        if (a.ins == Instruction::kJumpIfTrue && Resolve(a.imm[0]) == j) {
+            a.ins = Instruction::kPop;
+            a.imm.clear();
+            changed = true;
+            continue;
+        }
+
+        if (j == count || leader[j]) {
+            continue;
+        }
+        Op& b = ops[j];
+
+        // Value pushed only to be popped
+        if ((IsConstant(a) || a.ins == Instruction::kDup) && b.ins == Instruction::kPop) {
+            Kill(i);
+            Kill(j);
+            changed = true;
+            continue;
+        }
+
+        // Conversion of a value already of the target type
+        if (IsConversion(b.ins)) {
+            Kind kind = KindOf(a);
+            if ((b.ins == Instruction::kPrim && kind != Kind::kUnknown) ||
+                    (b.ins == Instruction::kNum && kind == Kind::kNumber) ||
+                    (b.ins == Instruction::kStr && kind == Kind::kString) ||
+                    (b.ins == Instruction::kBool && kind == Kind::kBoolean)) {
+                Kill(j);
+                changed = true;
+                continue;
+            }
+        }
+
+        if (!IsConstant(a)) {
+            continue;
+        }
+        Constant left = GetConstant(a);
+        Constant result;
+        bool defined = left.type() != Constant::Type::kUndefined;
+
+        // Branch on a constant
+        if (b.ins == Instruction::kJumpIfTrue && left.type() == Constant::Type::kBoolean) {
+            Kill(i);
+            if (left.boolean()) {
+                b.ins = Instruction::kJump;
+            } else {
+                Kill(j);
+            }
+            changed = true;
+            continue;
+        }
+
+        if (defined && FoldUnary(left, b.ins, result)) {
+            Kill(i);
+            SetConstant(b, result);
+            changed = true;
+            continue;
+        }
+
+        size_t k = Next(j);
+        if (k == count || leader[k] || !IsConstant(b)) {
+            continue;
+        }
+        Op& c = ops[k];
+
+        // Operands are usually swapped around by ConvertTop2ToNum, swap the constants instead
+        if (c.ins == Instruction::kXchg) {
+            std::swap(a, b);
+            Kill(k);
+            changed = true;
+            continue;
+        }
+
+        Constant right = GetConstant(b);
+        if (FoldBinary(left, right, c.ins, result)) {
+            Kill(i);
+            Kill(j);
+            SetConstant(c, result);
+            changed = true;
+            continue;
+        }
+    }
+    return changed;
+}
+
+bool Optimizer::EliminateDeadCode() {
+    size_t count = ops.size();
+    std::vector<bool> reachable(count + 1, false);
+    std::vector<size_t> worklist;
+    worklist.push_back(Resolve(0));
+    for (Range& range : ranges) {
+        worklist.push_back(Resolve(range.handler));
+    }
+    while (!worklist.empty()) {
+        size_t index = worklist.back();
+        worklist.pop_back();
+        if (reachable[index]) {
+            continue;
+        }
+        reachable[index] = true;
+        if (index == count) {
+            continue;
+        }
+        Op& op = ops[index];
+        if (!IsTerminator(op.ins)) {
+            worklist.push_back(Next(index));
+        }
+        ForEachTarget(op, [&](size_t& target) {
+            worklist.push_back(Resolve(target));
+        });
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        // Scope instructions are kept even if unreachable, as handlers recover the scope depth by
+        // scanning the bytecode linearly
+        if (ops[i].live && !reachable[i] &&
+                ops[i].ins != Instruction::kPushScope && ops[i].ins != Instruction::kPopScope) {
+            ops[i].live = false;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void Optimizer::FuseSequence(const size_t* seq, size_t length, Instruction ins) {
+    ops[seq[0]].ins = ins;
+    for (size_t i = 1; i < length; i++) {
+        Kill(seq[i]);
+    }
+    // Source positions within the sequence now belong to the superinstruction
+    for (size_t& position : positions) {
+        if (position > seq[0] && position <= seq[length - 1]) {
+            position = seq[0];
+        }
+    }
+}
+
+// Superinstructions are formed last, as the other passes only know about the plain instructions
+void Optimizer::Fuse() {
+    const size_t kMaxLength = 7;
+    ComputeLeaders();
+    size_t count = ops.size();
+    for (size_t i = Resolve(0); i < count; i = Next(i)) {
+        // The longest sequence starting at i that control can only enter at i
+        size_t seq[kMaxLength];
+        size_t length = 0;
+        for (size_t k = i; k < count && length < kMaxLength && (k == i || !leader[k]); k = Next(k)) {
+            seq[length++] = k;
+        }
+        auto is = [&](size_t n, Instruction ins) {
+            return n < length && ops[seq[n]].ins == ins;
+        };
+
+        if (is(0, Instruction::kGetName) && is(1, Instruction::kNum) && is(2, Instruction::kDup) &&
+                is(3, Instruction::kOne) && (is(4, Instruction::kAdd) || is(4, Instruction::kSub)) &&
+                is(5, Instruction::kPutName) && ops[seq[5]].imm[0] == ops[i].imm[0] && is(6, Instruction::kPop)) {
+            FuseSequence(seq, 7, is(4, Instruction::kAdd) ? Instruction::kIncName : Instruction::kDecName);
+        } else if (is(0, Instruction::kGetName) && is(1, Instruction::kNum)) {
+            FuseSequence(seq, 2, Instruction::kGetNameNum);
+        } else if (is(0, Instruction::kLoad) && is(1, Instruction::kGetProperty)) {
+            FuseSequence(seq, 2, Instruction::kGetNamedProperty);
+        } else if (is(0, Instruction::kLoad) && is(1, Instruction::kGetPropertyNoPop)) {
+            FuseSequence(seq, 2, Instruction::kGetNamedPropertyNoPop);
+        } else if (is(0, Instruction::kDup) && is(1, Instruction::kInitDef)) {
+            ops[i].imm = ops[seq[1]].imm;
+            FuseSequence(seq, 2, Instruction::kInitDefNoPop);
+        }
+    }
+}
+
+void Optimizer::Run() {
+    Decode();
+    bool changed;
+    do {
+        ComputeLeaders();
+        changed = ThreadJumps();
+        changed |= Peephole();
+        changed |= EliminateDeadCode();
+    } while (changed);
+    Fuse();
+    Encode();
+}
@@ -0,0 +1,96 @@
+#ifndef NORLIT_JS_BYTECODE_OPTIMIZER_H
+#define NORLIT_JS_BYTECODE_OPTIMIZER_H
+
+#include "../grammar/Constant.h"
+
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace bytecode {
+
+class Emitter;
+enum class Instruction: uint8_t;
+
+// Peephole optimizer run over the emitted bytecode before it is turned into Code.
+// Instructions are decoded into a list where branch targets and exception table
+// ranges refer to instruction indices, so instructions can be removed or rewritten
+// freely before everything is encoded again with the new offsets.
+class Optimizer {
+    struct Op {
+        Instruction ins;
+        bool live;
+        // Whether the immediates are encoded in 32 bits with a kWide prefix
+        bool wide;
+        // Immediates. Branch targets are stored as instruction indices
+        std::vector<size_t> imm;
+    };
+
+    struct Range {
+        size_t start;
+        size_t end;
+        size_t handler;
+    };
+
+    enum class Kind {
+        kUnknown,
+        kPrimitive,
+        kNumber,
+        kString,
+        kBoolean
+    };
+
+    Emitter& emitter;
+    std::vector<Op> ops;
+    std::vector<Range> ranges;
+    // Instruction index of each recorded source position
+    std::vector<size_t> positions;
+    // Whether control may enter the instruction other than falling through from the previous one
+    std::vector<bool> leader;
+
+    void Decode();
+    bool NeedsWide(const Op&, const std::vector<size_t>& pcOf);
+    void Encode();
+
+    // Index of the first live instruction at or after index
+    size_t Resolve(size_t index);
+    size_t Next(size_t index) {
+        return Resolve(index + 1);
+    }
+    void Kill(size_t index) {
+        ops[index].live = false;
+        // Control entering the removed instruction now enters the next one
+        if (leader[index]) {
+            leader[Next(index)] = true;
+        }
+    }
+
+    template<typename F>
+    void ForEachTarget(Op& op, F func);
+
+    bool IsConstant(const Op&);
+    grammar::Constant GetConstant(const Op&);
+    void SetConstant(Op&, const grammar::Constant&);
+    Kind KindOf(const Op&);
+
+    bool FoldUnary(const grammar::Constant&, Instruction, grammar::Constant&);
+    bool FoldBinary(const grammar::Constant&, const grammar::Constant&, Instruction, grammar::Constant&);
+
+    void ComputeLeaders();
+    bool ThreadJumps();
+    bool Peephole();
+    bool EliminateDeadCode();
+    // Turn the instructions seq[0, length) into the superinstruction ins, keeping the immediates of seq[0]
+    void FuseSequence(const size_t* seq, size_t length, Instruction ins);
+    void Fuse();
+
+  public:
+    Optimizer(Emitter& emitter): emitter(emitter) {}
+    void Run();
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,49 @@
+#include "Arena.h"
+
+#include <cstring>
+
+using namespace norlit::js::grammar;
+
+Arena::~Arena() {
+    for (char* chunk : chunks_) {
+        delete[] chunk;
+    }
+    for (char* block : large_) {
+        delete[] block;
+    }
+}
+
+void* Arena::AllocateSlow(size_t size) {
+    // Large requests get a block of their own, so the rest of the current chunk is not wasted
+    if (size > kChunkSize / 4) {
+        char* block = new char[size];
+        large_.push_back(block);
+        return block;
+    }
+    // Chunks left behind by Release are reused
+    if (ptr_) {
+        chunk_++;
+    }
+    if (chunk_ == chunks_.size()) {
+        chunks_.push_back(new char[kChunkSize]);
+    }
+    ptr_ = chunks_[chunk_] + size;
+    limit_ = chunks_[chunk_] + kChunkSize;
+    return chunks_[chunk_];
+}
+
+void Arena::Release(const Mark& mark) {
+    chunk_ = mark.chunk;
+    ptr_ = mark.ptr;
+    limit_ = ptr_ ? chunks_[chunk_] + kChunkSize : nullptr;
+    while (large_.size() > mark.large) {
+        delete[] large_.back();
+        large_.pop_back();
+    }
+}
+
+Constant* Arena::NewString(const std::wstring& value) {
+    wchar_t* chars = static_cast<wchar_t*>(Allocate(sizeof(wchar_t) * (value.size() + 1)));
+    std::memcpy(chars, value.c_str(), sizeof(wchar_t) * (value.size() + 1));
+    return NewConstant(Constant::String(chars));
+}
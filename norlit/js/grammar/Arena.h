@@ -0,0 +1,133 @@
+#ifndef NORLIT_JS_GRAMMAR_ARENA_H
+#define NORLIT_JS_GRAMMAR_ARENA_H
+
+#include "Constant.h"
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace grammar {
+
+// Fixed-size list of nodes allocated in the arena, with the same interface as gc::Array
+template<typename T>
+class NodeList {
+    size_t length_;
+    T** items_;
+  public:
+    struct Iterable {
+        T** begin_;
+        T** end_;
+        T** begin() const {
+            return begin_;
+        }
+        T** end() const {
+            return end_;
+        }
+    };
+
+    NodeList(size_t length, T** items): length_(length), items_(items) {}
+
+    size_t Length() const {
+        return length_;
+    }
+    T* Get(size_t index) const {
+        return items_[index];
+    }
+    void Put(size_t index, T* value) {
+        items_[index] = value;
+    }
+    Iterable GetIterable() const {
+        return{ items_, items_ + length_ };
+    }
+};
+
+// Bump-pointer allocator for AST nodes and the constants they refer to. Nothing in the arena is on
+// the heap, so parsing may run on any thread. Nodes are neither traced nor finalized, and all memory
+// is released at once when the arena is destroyed, which is after the code is created
+class Arena {
+  public:
+    // Allocation state that can be restored to drop everything allocated since
+    struct Mark {
+        size_t chunk;
+        char* ptr;
+        size_t large;
+    };
+
+  private:
+    static const size_t kChunkSize = 32 * 1024;
+
+    std::vector<char*> chunks_;
+    // Blocks of large allocations, in the order they are allocated
+    std::vector<char*> large_;
+    // Index of the chunk being allocated from
+    size_t chunk_ = 0;
+    char* ptr_ = nullptr;
+    char* limit_ = nullptr;
+
+    void* AllocateSlow(size_t size);
+
+  public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void* Allocate(size_t size) {
+        size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+        if (static_cast<size_t>(limit_ - ptr_) < size) {
+            return AllocateSlow(size);
+        }
+        void* result = ptr_;
+        ptr_ += size;
+        return result;
+    }
+
+    template<typename T, typename... Args>
+    T* New(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "Destructors of nodes are never run");
+        return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copy of the constant. Its string, if any, must outlive the arena
+    Constant* NewConstant(const Constant& value) {
+        return New<Constant>(value);
+    }
+    // String constant with the characters copied into the arena
+    Constant* NewString(const std::wstring&);
+
+    template<typename T>
+    NodeList<T>* NewList(size_t length) {
+        T** items = static_cast<T**>(Allocate(sizeof(T*) * length));
+        for (size_t i = 0; i < length; i++) {
+            items[i] = nullptr;
+        }
+        return New<NodeList<T>>(length, items);
+    }
+
+    template<typename T>
+    NodeList<T>* NewList(const std::vector<T*>& list) {
+        NodeList<T>* result = NewList<T>(list.size());
+        for (size_t i = 0; i < list.size(); i++) {
+            result->Put(i, list[i]);
+        }
+        return result;
+    }
+
+    Mark GetMark() const {
+        return{ chunk_, ptr_, large_.size() };
+    }
+    // Drop all nodes and constants allocated after the mark was taken
+    void Release(const Mark&);
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "Constant.h"
+
+#include "../JSBoolean.h"
+#include "../JSNumber.h"
+#include "../JSString.h"
+
+#include <cmath>
+#include <cstring>
+#include <cwchar>
+#include <limits>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::grammar;
+
+namespace {
+uint64_t NumberBits(double value) {
+    // All NaNs are the same value
+    if (std::isnan(value)) {
+        value = std::numeric_limits<double>::quiet_NaN();
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+}
+
+Constant Constant::Null() {
+    Constant result;
+    result.type_ = Type::kNull;
+    return result;
+}
+
+Constant Constant::Boolean(bool value) {
+    Constant result;
+    result.type_ = Type::kBoolean;
+    result.boolean_ = value;
+    return result;
+}
+
+Constant Constant::Number(double value) {
+    Constant result;
+    result.type_ = Type::kNumber;
+    result.number_ = value;
+    return result;
+}
+
+Constant Constant::String(const wchar_t* value) {
+    Constant result;
+    result.type_ = Type::kString;
+    result.string_ = value;
+    return result;
+}
+
+bool Constant::Equals(const Constant& other) const {
+    if (type_ != other.type_) {
+        return false;
+    }
+    switch (type_) {
+        case Type::kBoolean:
+            return boolean_ == other.boolean_;
+        case Type::kNumber:
+            return NumberBits(number_) == NumberBits(other.number_);
+        case Type::kString:
+            return std::wcscmp(string_, other.string_) == 0;
+        default:
+            return true;
+    }
+}
+
+size_t Constant::Hash() const {
+    switch (type_) {
+        case Type::kBoolean:
+            return boolean_;
+        case Type::kNumber:
+            return static_cast<size_t>(NumberBits(number_) ^ (NumberBits(number_) >> 32));
+        case Type::kString: {
+            size_t hash = 2166136261u;
+            for (const wchar_t* ch = string_; *ch; ch++) {
+                hash = (hash ^ static_cast<size_t>(*ch)) * 16777619u;
+            }
+            return hash;
+        }
+        default:
+            return static_cast<size_t>(type_);
+    }
+}
+
+bool Constant::ToTagged(JSValue*& value) const {
+    switch (type_) {
+        case Type::kUndefined:
+            value = JSUndefined::New();
+            return true;
+        case Type::kNull:
+            value = JSNull::New();
+            return true;
+        case Type::kBoolean:
+            value = JSBoolean::New(boolean_);
+            return true;
+        case Type::kNumber:
+            value = JSNumber::NewSmallInteger(number_);
+            return value != nullptr;
+        case Type::kString:
+            value = JSString::NewShortString(string_);
+            return value != nullptr;
+    }
+    return false;
+}
+
+Handle<JSValue> Constant::ToValue() const {
+    switch (type_) {
+        case Type::kNull:
+            return JSNull::New();
+        case Type::kBoolean:
+            return JSBoolean::New(boolean_);
+        case Type::kNumber:
+            return JSNumber::New(number_);
+        case Type::kString:
+            return JSString::New(string_);
+        default:
+            return nullptr;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef NORLIT_JS_GRAMMAR_CONSTANT_H
+#define NORLIT_JS_GRAMMAR_CONSTANT_H
+
+#include "../JSValue.h"
+#include "../../gc/Handle.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace norlit {
+namespace js {
+namespace grammar {
+
+// Value of a name or a literal, in the AST and in the constant pool of the code being generated.
+// Constants are kept off the heap so that parsing and code generation may run on any thread, and
+// only become heap values when the code is created, see Emitter::ToCode
+class Constant {
+  public:
+    enum class Type : uint8_t {
+        kUndefined,
+        kNull,
+        kBoolean,
+        kNumber,
+        kString
+    };
+
+  private:
+    Type type_ = Type::kUndefined;
+    bool boolean_ = false;
+    double number_ = 0;
+    // Null-terminated. Owned by the arena of the parser, or static
+    const wchar_t* string_ = nullptr;
+
+  public:
+    Constant() = default;
+
+    static Constant Null();
+    static Constant Boolean(bool);
+    static Constant Number(double);
+    static Constant String(const wchar_t*);
+
+    Type type() const {
+        return type_;
+    }
+    bool boolean() const {
+        return boolean_;
+    }
+    double number() const {
+        return number_;
+    }
+    const wchar_t* string() const {
+        return string_;
+    }
+
+    // SameValue, except that strings compare by their characters
+    bool Equals(const Constant&) const;
+    size_t Hash() const;
+
+    // Store into value the tagged value the constant becomes, without touching the heap. Returns false
+    // if the constant becomes a heap value
+    bool ToTagged(JSValue*& value) const;
+    // Strings are interned. Only on the thread running the engine
+    gc::Handle<JSValue> ToValue() const;
+
+    struct Hasher {
+        size_t operator()(const Constant& constant) const {
+            return constant.Hash();
+        }
+    };
+    struct Comparer {
+        bool operator()(const Constant& a, const Constant& b) const {
+            return a.Equals(b);
+        }
+    };
+};
+
+}
+}
+}
+
+#endif
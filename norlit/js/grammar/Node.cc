@@ -1,14 +1,10 @@
 #include "Node.h"
 
-#include "../JSString.h"
-#include "../JSNumber.h"
-#include "../JSBoolean.h"
 #include <cstdio>
 
 #include "../../pp/Tuple/ForEach.h"
 #include "Token.h"
 
-using namespace norlit::gc;
 using namespace norlit::js::grammar;
 
 static const char* typeToString(uint16_t type) {
@@ -42,91 +38,36 @@ static const char* typeToString(uint16_t type) {
 
 #define IDENT(x) printf("\n%*s", static_cast<int>(ident + x), "")
 
-#define CREATE_ITERATOR_ITEM(x,discard) \
-	iter(&NORLIT_PP_CONCAT_2(x,_));
-
-#define CREATE_ITERATOR(clazz, ...) \
-	void clazz::IterateField(const FieldIterator& iter) {\
-		NORLIT_PP_FOREACH(CREATE_ITERATOR_ITEM, (__VA_ARGS__),)\
-	}
-
 #define CREATE_DUMP_ITEM(x,discard) \
-	if(thisPtr->NORLIT_PP_CONCAT_2(x,_)) {\
+	if(NORLIT_PP_CONCAT_2(x,_)) {\
 		IDENT(2);\
-		thisPtr->NORLIT_PP_CONCAT_2(x,_)->Dump(ident + 2);\
+		NORLIT_PP_CONCAT_2(x,_)->Dump(ident + 2);\
 	}
 
 #define CREATE_DUMP(clazz, ...) \
 	void clazz::Dump(size_t ident) {\
-		Handle<clazz> thisPtr = this;\
 		printf(#clazz);\
 		NORLIT_PP_FOREACH(CREATE_DUMP_ITEM, (__VA_ARGS__),)\
 	}
 
-CREATE_ITERATOR(Identifier, name);
-CREATE_ITERATOR(CoveredFormals, items);
-CREATE_ITERATOR(ArrayLiteral, items);
-CREATE_ITERATOR(ObjectLiteral, items);
-CREATE_ITERATOR(Property, key, value);
-CREATE_ITERATOR(Literal, literal);
-CREATE_ITERATOR(RegexpLiteral, regexp, flags);
-CREATE_ITERATOR(TemplateLiteral, cooked, raw, subst);
-CREATE_ITERATOR(PropertyExpression, base, member);
-CREATE_ITERATOR(SuperPropertyExpression, member);
-CREATE_ITERATOR(PostfixExpression, expr);
-CREATE_ITERATOR(UnaryExpression, expr);
-CREATE_ITERATOR(BinaryExpression, left, right);
-CREATE_ITERATOR(ConditionalExpression, cond, then, otherwise);
-CREATE_ITERATOR(SpreadExpression, expr);
-CREATE_ITERATOR(CallExpression, callee, args);
-CREATE_ITERATOR(SuperCallExpression, args);
-CREATE_ITERATOR(NewExpression, ctor, args);
-CREATE_ITERATOR(TaggedTemplateExpression, callee, arg);
-CREATE_ITERATOR(YieldExpression, expr);
-CREATE_ITERATOR(YieldAllExpression, expr);
-
-CREATE_ITERATOR(BlockStatement, items);
-CREATE_ITERATOR(VariableDeclaration, decl);
-CREATE_ITERATOR(ExpressionStatement, expr);
-CREATE_ITERATOR(IfStatement, cond, then, otherwise);
-CREATE_ITERATOR(DoStatement, body, cond);
-CREATE_ITERATOR(WhileStatement, cond, body);
-CREATE_ITERATOR(ContinueStatement, label);
-CREATE_ITERATOR(BreakStatement, label);
-CREATE_ITERATOR(ReturnStatement, expr);
-CREATE_ITERATOR(WithStatement, base, body);
-CREATE_ITERATOR(SwitchClause, cond, body);
-CREATE_ITERATOR(SwitchStatement, expr, clauses);
-CREATE_ITERATOR(LabelledStatement, label, body);
-CREATE_ITERATOR(ThrowStatement, expr);
-CREATE_ITERATOR(TryStatement, body, param, error, finally);
-
-CREATE_ITERATOR(DirectiveStatement, value);
-CREATE_ITERATOR(FunctionExpression, name, param, body);
-CREATE_ITERATOR(FunctionStatement, func);
-
-CREATE_ITERATOR(Script, body);
-
 void Identifier::Dump(size_t ident) {
-    printf("Identifier %s", &name_->ToCString()->At(0));
+    printf("Identifier %ls", name_->string());
 }
 
 void CoveredFormals::Dump(size_t ident) {
-    Handle<CoveredFormals> thisPtr = this;
     printf("CoveredFormals");
-    for (size_t i = 0, len = thisPtr->items_->Length(); i < len; i++) {
+    for (size_t i = 0, len = items_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->items_->Get(i)->Dump(ident+2);
+        items_->Get(i)->Dump(ident+2);
     }
 }
 
 void ArrayLiteral::Dump(size_t ident) {
-    Handle<ArrayLiteral> thisPtr = this;
-    Handle<Expression> item;
+    Expression* item;
     printf("ArrayLiteral");
-    for (size_t i = 0, len = thisPtr->items_->Length(); i < len; i++) {
+    for (size_t i = 0, len = items_->Length(); i < len; i++) {
         IDENT(2);
-        item = thisPtr->items_->Get(i);
+        item = items_->Get(i);
         if (item)
             item->Dump(ident + 2);
         else {
@@ -136,18 +77,16 @@ void ArrayLiteral::Dump(size_t ident) {
 }
 
 void ObjectLiteral::Dump(size_t ident) {
-    Handle<ObjectLiteral> thisPtr = this;
-    Handle<Property> item;
+    Property* item;
     printf("ObjectLiteral");
-    for (size_t i = 0, len = thisPtr->items_->Length(); i < len; i++) {
+    for (size_t i = 0, len = items_->Length(); i < len; i++) {
         IDENT(2);
-        item = thisPtr->items_->Get(i);
+        item = items_->Get(i);
         item->Dump(ident + 2);
     }
 }
 
 void Property::Dump(size_t ident) {
-    Handle<Property> thisPtr = this;
     switch (type_) {
         case Type::kMethod:
             printf("Method");
@@ -162,27 +101,21 @@ void Property::Dump(size_t ident) {
     IDENT(2);
     key_->Dump(ident+2);
     IDENT(2);
-    thisPtr->value_->Dump(ident+2);
+    value_->Dump(ident+2);
 }
 
 void Literal::Dump(size_t ident) {
-    switch (literal_->GetType()) {
-        case JSValue::Type::kString: {
-            Handle<JSString> str = (JSString*)literal_;
-            printf("StringLiteral %s", &str->ToCString()->At(0));
+    switch (literal_->type()) {
+        case Constant::Type::kString:
+            printf("StringLiteral %ls", literal_->string());
             break;
-        }
-        case JSValue::Type::kNumber: {
-            Handle<JSNumber> val = (JSNumber*)literal_;
-            printf("NumberLiteral %lf", val->Value());
+        case Constant::Type::kNumber:
+            printf("NumberLiteral %lf", literal_->number());
             break;
-        }
-        case JSValue::Type::kBoolean: {
-            Handle<JSBoolean> val = (JSBoolean*)literal_;
-            printf("BooleanLiteral %s", val->Value()?"true":"false");
+        case Constant::Type::kBoolean:
+            printf("BooleanLiteral %s", literal_->boolean()?"true":"false");
             break;
-        }
-        case JSValue::Type::kNull: {
+        case Constant::Type::kNull: {
             printf("NullLiteral");
             break;
         }
@@ -192,27 +125,22 @@ void Literal::Dump(size_t ident) {
 }
 
 void RegexpLiteral::Dump(size_t ident) {
-    Handle<RegexpLiteral> thisPtr = this;
-    Handle<ValueArray<char>> rstr = this->regexp_->ToCString();
-    Handle<ValueArray<char>> fstr = thisPtr->flags_->ToCString();
-
-    printf("RegexpLiteral /%s/%s", &rstr->At(0), &fstr->At(0));
+    printf("RegexpLiteral /%ls/%ls", regexp_->string(), flags_->string());
 
 }
 
 void TemplateLiteral::Dump(size_t ident) {
-    Handle<TemplateLiteral> thisPtr = this;
     printf("TemplateLiteral");
     IDENT(2);
-    printf("Cooked %s, ", &thisPtr->cooked_->Get(0)->ToCString()->At(0));
-    printf("Raw %s", &thisPtr->raw_->Get(0)->ToCString()->At(0));
-    if (thisPtr->subst_) {
-        for (size_t i = 0, len = thisPtr->subst_->Length(); i < len; i++) {
+    printf("Cooked %ls, ", cooked_->Get(0)->string());
+    printf("Raw %ls", raw_->Get(0)->string());
+    if (subst_) {
+        for (size_t i = 0, len = subst_->Length(); i < len; i++) {
             IDENT(2);
-            thisPtr->subst_->Get(i)->Dump(ident + 2);
+            subst_->Get(i)->Dump(ident + 2);
             IDENT(2);
-            printf("Cooked %s, ", &thisPtr->cooked_->Get(i+1)->ToCString()->At(0));
-            printf("Raw %s", &thisPtr->raw_->Get(i+1)->ToCString()->At(0));
+            printf("Cooked %ls, ", cooked_->Get(i+1)->string());
+            printf("Raw %ls", raw_->Get(i+1)->string());
         }
     }
 }
@@ -304,46 +232,41 @@ void BinaryExpression::Dump(size_t ident) {
             }
             break;
     }
-    // left_->Dump() may trigger GC
-    Handle<Expression> right = right_;
     IDENT(2);
     left_->Dump(ident + 2);
     IDENT(2);
-    right->Dump(ident + 2);
+    right_->Dump(ident + 2);
 }
 
 CREATE_DUMP(ConditionalExpression, cond, then, otherwise);
 CREATE_DUMP(SpreadExpression, expr);
 
 void CallExpression::Dump(size_t ident) {
-    Handle<CallExpression> thisPtr = this;
     printf("CallExpression");
     IDENT(2);
     callee_->Dump(ident + 2);
-    for (size_t i = 0, len=thisPtr->args_->Length(); i < len; i++) {
+    for (size_t i = 0, len=args_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->args_->Get(i)->Dump(ident + 2);
+        args_->Get(i)->Dump(ident + 2);
     }
 }
 
 void SuperCallExpression::Dump(size_t ident) {
-    Handle<SuperCallExpression> thisPtr = this;
     printf("SuperCallExpression");
-    for (size_t i = 0, len = thisPtr->args_->Length(); i < len; i++) {
+    for (size_t i = 0, len = args_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->args_->Get(i)->Dump(ident + 2);
+        args_->Get(i)->Dump(ident + 2);
     }
 }
 
 void NewExpression::Dump(size_t ident) {
-    Handle<NewExpression> thisPtr = this;
     printf("NewExpression");
     IDENT(2);
     ctor_->Dump(ident + 2);
-    if (thisPtr->args_) {
-        for (size_t i = 0, len = thisPtr->args_->Length(); i < len; i++) {
+    if (args_) {
+        for (size_t i = 0, len = args_->Length(); i < len; i++) {
             IDENT(2);
-            thisPtr->args_->Get(i)->Dump(ident + 2);
+            args_->Get(i)->Dump(ident + 2);
         }
     }
 }
@@ -354,20 +277,18 @@ CREATE_DUMP(YieldAllExpression, expr);
 
 
 void BlockStatement::Dump(size_t ident) {
-    Handle<BlockStatement> thisPtr = this;
     printf("BlockStatement");
-    for (size_t i = 0, len = thisPtr->items_->Length(); i < len; i++) {
+    for (size_t i = 0, len = items_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->items_->Get(i)->Dump(ident + 2);
+        items_->Get(i)->Dump(ident + 2);
     }
 }
 
 void VariableDeclaration::Dump(size_t ident) {
-    Handle<VariableDeclaration> thisPtr = this;
     printf("VariableDeclaration %s", type_==Type::kConst?"const":(type_==Type::kLet?"let":"var"));
-    for (size_t i = 0, len = thisPtr->decl_->Length(); i < len; i++) {
+    for (size_t i = 0, len = decl_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->decl_->Get(i)->Dump(ident + 2);
+        decl_->Get(i)->Dump(ident + 2);
     }
 }
 
@@ -377,22 +298,24 @@ CREATE_DUMP(ExpressionStatement, expr);
 CREATE_DUMP(IfStatement, cond, then, otherwise);
 CREATE_DUMP(DoStatement, body, cond);
 CREATE_DUMP(WhileStatement, cond, body);
+CREATE_DUMP(ForStatement, decl, init, cond, update, body);
+CREATE_DUMP(ForInStatement, decl, target, expr, body);
+CREATE_DUMP(ForOfStatement, decl, target, expr, body);
 
 void ContinueStatement::Dump(size_t ident) {
     printf("ContinueStatement");
-    if(label_)printf(" %s", &label_->ToCString()->At(0));
+    if(label_)printf(" %ls", label_->string());
 }
 
 void BreakStatement::Dump(size_t ident) {
     printf("BreakStatement");
-    if (label_)printf(" %s", &label_->ToCString()->At(0));
+    if (label_)printf(" %ls", label_->string());
 }
 
 CREATE_DUMP(ReturnStatement, expr);
 CREATE_DUMP(WithStatement, base, body);
 
 void SwitchClause::Dump(size_t ident) {
-    Handle<SwitchClause> thisPtr = this;
     printf("SwitchClause");
     IDENT(2);
     if (cond_) {
@@ -400,28 +323,26 @@ void SwitchClause::Dump(size_t ident) {
     } else {
         printf("default");
     }
-    for (size_t i = 0, len = thisPtr->body_->Length(); i < len; i++) {
+    for (size_t i = 0, len = body_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->body_->Get(i)->Dump(ident + 2);
+        body_->Get(i)->Dump(ident + 2);
     }
 }
 
 void SwitchStatement::Dump(size_t ident) {
-    Handle<SwitchStatement> thisPtr = this;
     printf("SwitchStatement");
     IDENT(2);
     expr_->Dump(ident + 2);
-    for (size_t i = 0, len = thisPtr->clauses_->Length(); i < len; i++) {
+    for (size_t i = 0, len = clauses_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->clauses_->Get(i)->Dump(ident + 2);
+        clauses_->Get(i)->Dump(ident + 2);
     }
 }
 
 void LabelledStatement::Dump(size_t ident) {
-    Handle<LabelledStatement> thisPtr = this;
-    printf("LabelledStatement %s", &label_->ToCString()->At(0));
+    printf("LabelledStatement %ls", label_->string());
     IDENT(2);
-    thisPtr->body_->Dump(ident + 2);
+    body_->Dump(ident + 2);
 }
 
 CREATE_DUMP(ThrowStatement, expr);
@@ -429,36 +350,39 @@ CREATE_DUMP(TryStatement, body, param, error, finally);
 CREATE_DUMP(DebuggerStatement);
 
 void DirectiveStatement::Dump(size_t ident) {
-    printf("DirectiveStatement '%s'", &value_->ToCString()->At(0));
+    printf("DirectiveStatement '%ls'", value_->string());
 }
 
 void FunctionExpression::Dump(size_t ident) {
-    Handle<FunctionExpression> thisPtr = this;
     printf("FunctionExpression%s", generator?"*":"");
     if (name_) {
-        printf(" %s", &this->name_->ToCString()->At(0));
+        printf(" %ls", this->name_->string());
+    }
+    if (isLazy()) {
+        IDENT(2);
+        printf("Lazy [%u, %u)", start, end);
+        return;
     }
     IDENT(2);
     printf("Parameters");
-    for (size_t i = 0, len = thisPtr->param_->Length(); i < len; i++) {
+    for (size_t i = 0, len = param_->Length(); i < len; i++) {
         IDENT(4);
-        thisPtr->param_->Get(i)->Dump(ident + 4);
+        param_->Get(i)->Dump(ident + 4);
     }
     IDENT(2);
     printf("Body");
-    for (size_t i = 0, len = thisPtr->body_->Length(); i < len; i++) {
+    for (size_t i = 0, len = body_->Length(); i < len; i++) {
         IDENT(4);
-        thisPtr->body_->Get(i)->Dump(ident + 4);
+        body_->Get(i)->Dump(ident + 4);
     }
 }
 
 CREATE_DUMP(FunctionStatement, func);
 
 void Script::Dump(size_t ident) {
-    Handle<Script> thisPtr = this;
     printf("Script");
-    for (size_t i = 0, len = thisPtr->body_->Length(); i < len; i++) {
+    for (size_t i = 0, len = body_->Length(); i < len; i++) {
         IDENT(2);
-        thisPtr->body_->Get(i)->Dump(ident + 2);
+        body_->Get(i)->Dump(ident + 2);
     }
 }
\ No newline at end of file
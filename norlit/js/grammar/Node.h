@@ -1,17 +1,19 @@
 #ifndef NORLIT_JS_GRAMMAR_NODE_H
 #define NORLIT_JS_GRAMMAR_NODE_H
 
-#include "../JSString.h"
-#include "../../gc/Handle.h"
-#include "../../gc/Array.h"
+#include "Arena.h"
+#include "Constant.h"
 
 #include "../../pp/Tuple/ForEach.h"
 #include "../../pp/Tuple/Map.h"
 
+#include <typeinfo>
+
 namespace norlit {
 namespace js {
 namespace bytecode {
 class Emitter;
+class Code;
 }
 
 namespace grammar {
@@ -21,10 +23,11 @@ namespace grammar {
 #define NORLIT_PP_FOREACH_TUPLE(callback, tuple) NORLIT_PP_FOREACH(NORLIT_PP_TUPLE_CALLLER, tuple, callback)
 #define NORLIT_PP_MAP_TUPLE(callback, tuple) NORLIT_PP_MAP(NORLIT_PP_TUPLE_CALLLER, tuple, callback)
 
+// Nodes refer to other nodes and to constants by pointer, all of them in the arena
 #define DECLARE_NODE_FIELD(type, name) type* name##_ = nullptr;
-#define DECLARE_NODE_ACCESSOR(type, name) gc::Handle<type> name(){return name##_;}
-#define DECLARE_NODE_CTOR_ARG(type,name) const gc::Handle<type>& name
-#define DECLARE_NODE_WRITE_BARRIER(type,name) WriteBarrier(&this->name##_, name);
+#define DECLARE_NODE_ACCESSOR(type, name) type* name(){return name##_;}
+#define DECLARE_NODE_CTOR_ARG(type,name) type* name
+#define DECLARE_NODE_INIT(type,name) this->name##_ = name;
 #define CODEGEN virtual void Codegen(bytecode::Emitter&);
 #define DECLGEN virtual void VarDeclGen(bytecode::Emitter&);
 
@@ -37,9 +40,8 @@ namespace grammar {
 public:\
 	NORLIT_PP_IF(NORLIT_PP_TUPLE_ISEMPTY(fields),,\
 		name(NORLIT_PP_MAP_TUPLE(DECLARE_NODE_CTOR_ARG, fields)) {\
-			NORLIT_PP_FOREACH_TUPLE(DECLARE_NODE_WRITE_BARRIER, fields)\
+			NORLIT_PP_FOREACH_TUPLE(DECLARE_NODE_INIT, fields)\
 		}\
-		virtual void IterateField(const gc::FieldIterator& iter) override final;\
 	)\
 	virtual void Dump(size_t ident) override final;\
 	extra\
@@ -50,8 +52,18 @@ public:\
 #define NORLIT_AST_CLASS_C(name, base, ...) NORLIT_AST_CLASS(name, base, (__VA_ARGS__), CODEGEN)
 #define NORLIT_AST_CLASS_D(name, base, ...) NORLIT_AST_CLASS(name, base, (__VA_ARGS__), CODEGEN DECLGEN)
 
-class Node : public gc::Object {
+// Cast the node to T if it is exactly of type T, or return nullptr otherwise
+template<typename T, typename U>
+T* ExactCheckedCast(U* node) {
+    return node && typeid(*node) == typeid(T) ? static_cast<T*>(node) : nullptr;
+}
+
+// Nodes are allocated in the Arena of the parser and live until it is destroyed
+class Node {
   public:
+    // Offset in the source, set by the parser for nodes that appear in the position table
+    uint32_t position = 0;
+
     virtual void Dump(size_t ident) = 0;
 };
 
@@ -62,35 +74,35 @@ class Expression: public Node {
 
 NORLIT_AST_CLASS_C(
     Identifier, Expression,
-    (JSString, name)
+    (Constant, name)
 );
 
 NORLIT_AST_CLASS_C(
     Literal, Expression,
-    (JSValue, literal)
+    (Constant, literal)
 );
 
 NORLIT_AST_CLASS_C(
     RegexpLiteral, Expression,
-    (JSString, regexp),
-    (JSString, flags)
+    (Constant, regexp),
+    (Constant, flags)
 );
 
 NORLIT_AST_CLASS_C(
     TemplateLiteral, Expression,
-    (gc::Array<JSString>, cooked),
-    (gc::Array<JSString>, raw),
-    (gc::Array<Expression>, subst)
+    (NodeList<Constant>, cooked),
+    (NodeList<Constant>, raw),
+    (NodeList<Expression>, subst)
 );
 
 NORLIT_AST_CLASS_C(
     CoveredFormals, Expression,
-    (gc::Array<Expression>, items)
+    (NodeList<Expression>, items)
 );
 
 NORLIT_AST_CLASS_C(
     ArrayLiteral, Expression,
-    (gc::Array<Expression>, items)
+    (NodeList<Expression>, items)
 );
 
 class Property final : public Node {
@@ -111,18 +123,17 @@ class Property final : public Node {
     Type type() const {
         return type_;
     }
-    Property(const gc::Handle<Expression>& key, const gc::Handle<Expression>& value, Type type) :type_(type) {
-        DECLARE_NODE_WRITE_BARRIER(, key);
-        DECLARE_NODE_WRITE_BARRIER(, value);
+    Property(Expression* key, Expression* value, Type type) :type_(type) {
+        DECLARE_NODE_INIT(, key);
+        DECLARE_NODE_INIT(, value);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
 };
 
 NORLIT_AST_CLASS_C(
     ObjectLiteral, Expression,
-    (gc::Array<Property>, items)
+    (NodeList<Property>, items)
 );
 
 NORLIT_AST_CLASS_C(ThisExpression, Expression);
@@ -151,10 +162,9 @@ class PostfixExpression: public Expression {
     bool decrement() const {
         return !inc;
     }
-    PostfixExpression(const gc::Handle<Expression>& expr, bool inc):inc(inc) {
-        DECLARE_NODE_WRITE_BARRIER(, expr);
+    PostfixExpression(Expression* expr, bool inc):inc(inc) {
+        DECLARE_NODE_INIT(, expr);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
 };
@@ -167,10 +177,9 @@ class UnaryExpression : public Expression {
     uint16_t op() const {
         return op_;
     }
-    UnaryExpression(const gc::Handle<Expression>& expr, uint16_t op) :op_(op) {
-        DECLARE_NODE_WRITE_BARRIER(,expr);
+    UnaryExpression(Expression* expr, uint16_t op) :op_(op) {
+        DECLARE_NODE_INIT(,expr);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
 };
@@ -186,11 +195,10 @@ class BinaryExpression : public Expression {
     uint16_t op() const {
         return op_;
     }
-    BinaryExpression(const gc::Handle<Expression>& left, const gc::Handle<Expression>& right, uint16_t op) :op_(op) {
-        DECLARE_NODE_WRITE_BARRIER(, left);
-        DECLARE_NODE_WRITE_BARRIER(, right);
+    BinaryExpression(Expression* left, Expression* right, uint16_t op) :op_(op) {
+        DECLARE_NODE_INIT(, left);
+        DECLARE_NODE_INIT(, right);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
 };
@@ -210,18 +218,18 @@ NORLIT_AST_CLASS_C(
 NORLIT_AST_CLASS_C(
     CallExpression, Expression,
     (Expression, callee),
-    (gc::Array<Expression>, args)
+    (NodeList<Expression>, args)
 );
 
 NORLIT_AST_CLASS_C(
     SuperCallExpression, Expression,
-    (gc::Array<Expression>, args)
+    (NodeList<Expression>, args)
 );
 
 NORLIT_AST_CLASS_C(
     NewExpression, Expression,
     (Expression, ctor),
-    (gc::Array<Expression>, args)
+    (NodeList<Expression>, args)
 );
 
 NORLIT_AST_CLASS_C(
@@ -241,8 +249,11 @@ NORLIT_AST_CLASS_C(
 );
 
 /* Statements and Declarations */
-class Statement : public gc::Object {
+class Statement {
   public:
+    // Offset in the source of the start of the statement
+    uint32_t position = 0;
+
     virtual void Dump(size_t ident) = 0;
     virtual void Codegen(bytecode::Emitter&);
     virtual void VarDeclGen(bytecode::Emitter&);
@@ -251,12 +262,12 @@ class Statement : public gc::Object {
 
 NORLIT_AST_CLASS_D (
     BlockStatement, Statement,
-    (gc::Array<Statement>, items)
+    (NodeList<Statement>, items)
 );
 
 class VariableDeclaration : public Statement {
     DECLARE_FIELDS(
-        (gc::Array<Expression>, decl)
+        (NodeList<Expression>, decl)
     )
   public:
     enum class Type {
@@ -270,10 +281,9 @@ class VariableDeclaration : public Statement {
     Type type() const {
         return type_;
     }
-    VariableDeclaration(const gc::Handle<gc::Array<Expression>>& decl, Type type) :type_(type) {
-        DECLARE_NODE_WRITE_BARRIER(, decl);
+    VariableDeclaration(NodeList<Expression>* decl, Type type) :type_(type) {
+        DECLARE_NODE_INIT(, decl);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
     DECLGEN
@@ -308,14 +318,65 @@ NORLIT_AST_CLASS_D(
     (Statement, body)
 );
 
-DECLARE_NODE(
+class ForStatement : public Statement {
+    DECLARE_FIELDS(
+        (VariableDeclaration, decl),
+        (Expression, init),
+        (Expression, cond),
+        (Expression, update),
+        (Statement, body)
+    )
+  private:
+    bool perIterationScope_;
+  public:
+    // Whether closures may capture the lexical declarations, so each iteration needs a fresh copy of them
+    bool perIterationScope() const {
+        return perIterationScope_;
+    }
+    ForStatement(
+        VariableDeclaration* decl,
+        Expression* init,
+        Expression* cond,
+        Expression* update,
+        Statement* body,
+        bool perIterationScope
+    ) :perIterationScope_(perIterationScope) {
+        DECLARE_NODE_INIT(, decl);
+        DECLARE_NODE_INIT(, init);
+        DECLARE_NODE_INIT(, cond);
+        DECLARE_NODE_INIT(, update);
+        DECLARE_NODE_INIT(, body);
+    }
+    virtual void Dump(size_t ident) override final;
+    CODEGEN
+    DECLGEN
+};
+
+// Exactly one of decl and target is present
+NORLIT_AST_CLASS_D(
+    ForInStatement, Statement,
+    (VariableDeclaration, decl),
+    (Expression, target),
+    (Expression, expr),
+    (Statement, body)
+);
+
+NORLIT_AST_CLASS_D(
+    ForOfStatement, Statement,
+    (VariableDeclaration, decl),
+    (Expression, target),
+    (Expression, expr),
+    (Statement, body)
+);
+
+NORLIT_AST_CLASS_D(
     ContinueStatement, Statement,
-    (JSString, label)
+    (Constant, label)
 );
 
-DECLARE_NODE(
+NORLIT_AST_CLASS_D(
     BreakStatement, Statement,
-    (JSString, label)
+    (Constant, label)
 );
 
 NORLIT_AST_CLASS_D (
@@ -332,20 +393,18 @@ DECLARE_NODE(
 DECLARE_NODE(
     SwitchClause, Node,
     (Expression, cond),
-    (gc::Array<Statement>, body)
+    (NodeList<Statement>, body)
 );
 
-DECLARE_NODE(
+NORLIT_AST_CLASS_D(
     SwitchStatement, Statement,
     (Expression, expr),
-    (gc::Array<SwitchClause>, clauses)
+    (NodeList<SwitchClause>, clauses)
 );
 
-// Switch
-
-DECLARE_NODE(
+NORLIT_AST_CLASS_D(
     LabelledStatement, Statement,
-    (JSString, label),
+    (Constant, label),
     (Statement, body)
 );
 
@@ -367,36 +426,54 @@ NORLIT_AST_CLASS_D(DebuggerStatement, Statement);
 // Not in ECMAScript specification. This is a special type of ExpressionStatement
 NORLIT_AST_CLASS_D(
     DirectiveStatement, Statement,
-    (JSString, value)
+    (Constant, value)
 );
 
 
 class FunctionExpression : public Expression {
     DECLARE_FIELDS(
-        (JSString, name),
-        (gc::Array<Expression>, param),
-        (gc::Array<Statement>, body)
+        (Constant, name),
+        (NodeList<Expression>, param),
+        (NodeList<Statement>, body)
     )
   private:
     bool generator;
+    // Source range of pre-parsed functions
+    uint32_t start = 0;
+    uint32_t end = 0;
   public:
     uint16_t isGenerator() const {
         return generator;
     }
+    // Whether only the syntax of the function is checked. Its parameters and body are not kept
+    // and are parsed again from the source when the function is first called
+    bool isLazy() const {
+        return !body_;
+    }
     FunctionExpression(
         bool generator,
-        const gc::Handle<JSString>& name,
-        const gc::Handle<gc::Array<Expression>>& param,
-        const gc::Handle<gc::Array<Statement>>& body
+        Constant* name,
+        NodeList<Expression>* param,
+        NodeList<Statement>* body
     ) :generator(generator) {
-        DECLARE_NODE_WRITE_BARRIER(, name);
-        DECLARE_NODE_WRITE_BARRIER(, param);
-        DECLARE_NODE_WRITE_BARRIER(, body);
+        DECLARE_NODE_INIT(, name);
+        DECLARE_NODE_INIT(, param);
+        DECLARE_NODE_INIT(, body);
+    }
+    FunctionExpression(
+        bool generator,
+        Constant* name,
+        uint32_t start,
+        uint32_t end
+    ) :generator(generator), start(start), end(end) {
+        DECLARE_NODE_INIT(, name);
     }
-    virtual void IterateField(const gc::FieldIterator& iter) override final;
     virtual void Dump(size_t ident) override final;
     CODEGEN
 
+    // Generate the code of the function body into its own emitter
+    void Compile(bytecode::Emitter&);
+
     friend class FunctionStatement;
 };
 
@@ -408,7 +485,7 @@ NORLIT_AST_CLASS_D (
 NORLIT_AST_CLASS(
     Script, Node,
     (
-        (gc::Array<Statement>, body)
+        (NodeList<Statement>, body)
     ),
     CODEGEN
 );
@@ -420,7 +497,7 @@ NORLIT_AST_CLASS(
 #undef DECLARE_NODE_FIELD
 #undef DECLARE_NODE_ACCESSOR
 #undef DECLARE_NODE_CTOR_ARG
-#undef DECLARE_NODE_WRITE_BARRIER
+#undef DECLARE_NODE_INIT
 #undef DECLARE_FIELDS
 #undef DECLARE_NODE
 
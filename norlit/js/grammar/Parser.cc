@@ -6,36 +6,33 @@
 #include "Node.h"
 
 #include <typeinfo>
+#include <vector>
 
-#include "../JSBoolean.h"
-#include "../../util/ArrayList.h"
-
-using namespace norlit::gc;
 using namespace norlit::js::grammar;
-using namespace norlit::util;
 
-Parser::Parser(Scanner& s):scanner(s) {
+Parser::Parser(Scanner& s, size_t lazyDepth):scanner(s), lazyDepth_(lazyDepth) {
     Fetch_();
 }
 
 void Parser::Fetch_() {
-    if (t1_) {
+    if (lookahead_) {
         t0_ = t1_;
-        t1_ = nullptr;
+        lookahead_ = false;
     } else {
         t0_ = scanner.NextToken();
-        if (t0_->type == Token::kIdentifier) {
+        if (t0_.type == Token::kIdentifier) {
             scanner.TranslateIdentifierName(t0_);
         }
     }
 }
 
 void Parser::FetchLookahead_() {
-    if (t1_) {
+    if (lookahead_) {
         return;
     }
+    lookahead_ = true;
     t1_ = scanner.NextToken();
-    if (t1_->type == Token::kIdentifier) {
+    if (t1_.type == Token::kIdentifier) {
         scanner.TranslateIdentifierName(t1_);
     }
 }
@@ -45,12 +42,12 @@ void Parser::Advance_() {
 }
 
 void Parser::AdvanceAndFetchIdentifierName_() {
-    assert(!t1_);
+    assert(!lookahead_);
     t0_ = scanner.NextToken();
 }
 
 bool Parser::ConsumeIf_(uint16_t type) {
-    if (t0_->type == type) {
+    if (t0_.type == type) {
         Advance_();
         return true;
     }
@@ -58,23 +55,42 @@ bool Parser::ConsumeIf_(uint16_t type) {
 }
 
 void Parser::ConsumeSemicolon_() {
-    if (t0_->type == ';') {
+    if (t0_.type == ';') {
         Advance_();
         return;
     }
-    if (t0_->type=='}' || (t0_->flags&Token::kLineBefore)) {
+    if (t0_.type=='}' || (t0_.flags&Token::kLineBefore)) {
         return;
     } else {
         Exceptions::ThrowSyntaxError("Expected semicolon after statement");
     }
 }
 
-Handle<Expression> Parser::ParsePrimaryExpr() {
-    Handle<Expression> returnVal;
-    switch (t0_->type) {
+uint32_t Parser::Position_() {
+    return static_cast<uint32_t>(scanner.offset() + t0_.start);
+}
+
+Constant* Parser::Value_(const Token& tok) {
+    if (tok.type == Token::kNumber) {
+        return arena_.NewConstant(Constant::Number(tok.number));
+    }
+    return StringValue_(tok);
+}
+
+Constant* Parser::StringValue_(const Token& tok) {
+    return arena_.NewString(scanner.StringValue(tok));
+}
+
+Constant* Parser::RawValue_(const Token& tok) {
+    return arena_.NewString(scanner.RawValue(tok));
+}
+
+Expression* Parser::ParsePrimaryExpr() {
+    Expression* returnVal = nullptr;
+    switch (t0_.type) {
         /* 12.2.1 The this Keyword */
         case Token::kThis:
-            returnVal = new ThisExpression();
+            returnVal = arena_.New<ThisExpression>();
             Advance_();
             break;
         /* Inline: 12.1 Identifier */
@@ -82,25 +98,25 @@ Handle<Expression> Parser::ParsePrimaryExpr() {
             //return this._yieldAsIdentifier();
             throw "TODO: yield";
         case Token::kIdentifier:
-            returnVal = new Identifier((JSString*)t0_->value);
+            returnVal = arena_.New<Identifier>(StringValue_(t0_));
             Advance_();
             break;
         /* 12.2.3 Literal */
         case Token::kNull:
-            returnVal = new Literal(JSNull::New());
+            returnVal = arena_.New<Literal>(arena_.NewConstant(Constant::Null()));
             Advance_();
             break;
         case Token::kTrue:
-            returnVal = new Literal(JSBoolean::New(true));
+            returnVal = arena_.New<Literal>(arena_.NewConstant(Constant::Boolean(true)));
             Advance_();
             break;
         case Token::kFalse:
-            returnVal = new Literal(JSBoolean::New(false));
+            returnVal = arena_.New<Literal>(arena_.NewConstant(Constant::Boolean(false)));
             Advance_();
             break;
         case Token::kNumber:
         case Token::kString:
-            returnVal =new Literal(t0_->value);
+            returnVal =arena_.New<Literal>(Value_(t0_));
             Advance_();
             break;
         case '[':
@@ -115,7 +131,7 @@ Handle<Expression> Parser::ParsePrimaryExpr() {
         case '/':
         case Token::kDivAssign:
             t0_ = scanner.NextRegexp(t0_);
-            returnVal = new RegexpLiteral((JSString*)t0_->value, (JSString*)t0_->additional);
+            returnVal = arena_.New<RegexpLiteral>(StringValue_(t0_), RawValue_(t0_));
             Advance_();
             break;
         /* 12.2.8 Template Literals */
@@ -124,8 +140,8 @@ Handle<Expression> Parser::ParsePrimaryExpr() {
             return ParseTemplate();
         /* 12.2.9 The Grouping Operator */
         case '(': {
-            Handle<Array<Expression>> items = ParseCoveredFormals();
-            return new CoveredFormals(items);
+            NodeList<Expression>* items = ParseCoveredFormals();
+            return arena_.New<CoveredFormals>(items);
         }
         default:
             Exceptions::ThrowSyntaxError("Unexpected token when parsing expression");
@@ -133,124 +149,120 @@ Handle<Expression> Parser::ParsePrimaryExpr() {
     return returnVal;
 }
 
-Handle<TemplateLiteral> Parser::ParseTemplate() {
-    Handle<Array<JSString>> cooked;
-    Handle<Array<JSString>> raw;
-    Handle<Array<Expression>> subst;
-    if (t0_->type == Token::kNoSubTemplate) {
-        cooked = Array<JSString>::New(1);
-        raw = Array<JSString>::New(1);
-        cooked->Put(0, (JSString*)t0_->value);
-        raw->Put(0, (JSString*)t0_->additional);
+TemplateLiteral* Parser::ParseTemplate() {
+    std::vector<Constant*> cookedList;
+    std::vector<Constant*> rawList;
+    NodeList<Expression>* subst = nullptr;
+    if (t0_.type == Token::kNoSubTemplate) {
+        cookedList.push_back(StringValue_(t0_));
+        rawList.push_back(RawValue_(t0_));
     } else {
-        assert(t0_->type = Token::kTemplateHead);
-        ArrayList<JSString> cookedList;
-        ArrayList<JSString> rawList;
-        ArrayList<Expression> substList;
+        assert(t0_.type = Token::kTemplateHead);
+        std::vector<Expression*> substList;
 
-        cookedList.Add((JSString*)t0_->value);
-        rawList.Add((JSString*)t0_->additional);
+        cookedList.push_back(StringValue_(t0_));
+        rawList.push_back(RawValue_(t0_));
 
         do {
             Advance_();
-            substList.Add(ParseExpression());
-            if (t0_->type != '}') {
+            substList.push_back(ParseExpression());
+            if (t0_.type != '}') {
                 Exceptions::ThrowSyntaxError("Expected } in template literal");
             }
-            assert(!t1_);
+            assert(!lookahead_);
             t0_ = scanner.NextTemplatePart();
-            cookedList.Add((JSString*)t0_->value);
-            rawList.Add((JSString*)t0_->additional);
-            if (t0_->type == Token::kTemplateTail) {
+            cookedList.push_back(StringValue_(t0_));
+            rawList.push_back(RawValue_(t0_));
+            if (t0_.type == Token::kTemplateTail) {
                 break;
             }
         } while (true);
-        cooked = cookedList.ToArray();
-        raw = rawList.ToArray();
-        subst = substList.ToArray();
+        subst = arena_.NewList(substList);
     }
+    NodeList<Constant>* cooked = arena_.NewList(cookedList);
+    NodeList<Constant>* raw = arena_.NewList(rawList);
     Advance_();
-    return new TemplateLiteral(cooked, raw, subst);
+    return arena_.New<TemplateLiteral>(cooked, raw, subst);
 }
 
-Handle<Array<Expression>> Parser::ParseCoveredFormals() {
+NodeList<Expression>* Parser::ParseCoveredFormals() {
     if (!ConsumeIf_('(')) {
         // This only occur in function parsing.
         Exceptions::ThrowSyntaxError("Expected ( to start a parameter list");
     }
-    if (t0_->type == ')') {
+    if (t0_.type == ')') {
         Advance_();
-        return Array<Expression>::New(0);
+        return arena_.NewList<Expression>(0);
     } else {
-        ArrayList<Expression> args;
-        Handle<Expression> expr;
+        std::vector<Expression*> args;
+        Expression* expr = nullptr;
         while (true) {
-            if (t0_->type == Token::kEllipse) {
+            if (t0_.type == Token::kEllipse) {
                 Advance_();
                 // TODO YIELD!!
-                if (t0_->type != Token::kIdentifier) {
+                if (t0_.type != Token::kIdentifier) {
                     Exceptions::ThrowSyntaxError("Illegal rest binding pattern");
                 }
                 // TODO Directly use identifier
                 expr = ParsePrimaryExpr();
-                args.Add(new SpreadExpression(expr));
-                if (t0_->type != ')') {
+                args.push_back(arena_.New<SpreadExpression>(expr));
+                if (t0_.type != ')') {
                     Exceptions::ThrowSyntaxError("Rest binding pattern should be the last in the list");
                 }
                 break;
             } else {
                 expr = ParseAssignmentExpr();
-                args.Add(expr);
+                args.push_back(expr);
             }
-            if (t0_->type == ')') {
+            if (t0_.type == ')') {
                 break;
-            } else if (t0_->type != ',') {
+            } else if (t0_.type != ',') {
                 Exceptions::ThrowSyntaxError("Parenthesis is not enclosed");
             }
             Advance_();
         }
         Advance_();
-        return args.ToArray();
+        return arena_.NewList(args);
     }
 }
 
-Handle<Expression> Parser::ParseArrayLiteral() {
+Expression* Parser::ParseArrayLiteral() {
     // Consume [
     Advance_();
-    ArrayList<Expression> elements;
-    Handle<Expression> expr;
+    std::vector<Expression*> elements;
+    Expression* expr = nullptr;
     do {
-        switch (t0_->type) {
+        switch (t0_.type) {
             case Token::kEllipse:
                 Advance_();
                 expr = ParseAssignmentExpr();
-                elements.Add(new SpreadExpression(expr));
+                elements.push_back(arena_.New<SpreadExpression>(expr));
                 break;
             case ',':
-                elements.Add(nullptr);
+                elements.push_back(nullptr);
                 break;
             case ']':
                 goto finished;
             default:
-                elements.Add(ParseAssignmentExpr());
+                elements.push_back(ParseAssignmentExpr());
                 break;
         }
     } while (ConsumeIf_(','));
 finished:
     // Consume ]
     Advance_();
-    Handle<Array<Expression>> arr = elements.ToArray();
-    return new ArrayLiteral(arr);
+    NodeList<Expression>* arr = arena_.NewList(elements);
+    return arena_.New<ArrayLiteral>(arr);
 }
 
-Handle<Expression> Parser::RefineArrayAssignmentPattern(const Handle<ArrayLiteral>& pattern) {
-    Handle<Array<Expression>> items = pattern->items();
+Expression* Parser::RefineArrayAssignmentPattern(ArrayLiteral* pattern) {
+    NodeList<Expression>* items = pattern->items();
     size_t size = items->Length();
     // Zero-sized array literal is a valid pattern
     if (size == 0) {
         return pattern;
     }
-    Handle<Expression> expr;
+    Expression* expr = nullptr;
 
     // Check the last element. Spread expression is fine
     expr = items->Get(size - 1);
@@ -265,7 +277,7 @@ Handle<Expression> Parser::RefineArrayAssignmentPattern(const Handle<ArrayLitera
         if (!expr)
             continue;
         if (typeid(*expr) == typeid(BinaryExpression)) {
-            Handle<BinaryExpression> binExpr = expr.CastTo<BinaryExpression>();
+            BinaryExpression* binExpr = static_cast<BinaryExpression*>(expr);
             if (binExpr->op() == '=') {
 //TODO
             }
@@ -274,15 +286,16 @@ Handle<Expression> Parser::RefineArrayAssignmentPattern(const Handle<ArrayLitera
     return pattern;
 }
 
-Handle<Expression> Parser::ParseObjectLiteral() {
+Expression* Parser::ParseObjectLiteral() {
     // Consume {
-    ArrayList<Property> elements;
-    Handle<Expression> key, value;
+    std::vector<Property*> elements;
+    Expression* key = nullptr;
+    Expression* value = nullptr;
     Property::Type type;
     do {
         AdvanceAndFetchIdentifierName_();
 
-        switch (t0_->type) {
+        switch (t0_.type) {
             case '}':
                 goto finish;
             case '*':
@@ -292,11 +305,11 @@ Handle<Expression> Parser::ParseObjectLiteral() {
             case '[': {
                 Advance_();
                 key = ParseAssignmentExpr();
-                if (t0_->type != ']') {
+                if (t0_.type != ']') {
                     Exceptions::ThrowSyntaxError("Bracket mismatch when processing computed property");
                 }
                 Advance_();
-                if (t0_->type == '(') {
+                if (t0_.type == '(') {
                     throw "MethodDefinition : PropertyName ( FormalParameters ) { FunctionBody }";
                 }
                 Advance_();
@@ -306,11 +319,11 @@ Handle<Expression> Parser::ParseObjectLiteral() {
             }
             case Token::kString:
             case Token::kNumber: {
-                key = new Literal(t0_->value);
+                key = arena_.New<Literal>(Value_(t0_));
                 Advance_();
-                if (t0_->type == '(') {
+                if (t0_.type == '(') {
                     throw "MethodDefinition : PropertyName ( FormalParameters ) { FunctionBody }";
-                } else if (t0_->type == ':') {
+                } else if (t0_.type == ':') {
                     Advance_();
                     value = ParseAssignmentExpr();
                     type = Property::Type::kNormal;
@@ -320,15 +333,15 @@ Handle<Expression> Parser::ParseObjectLiteral() {
                 }
             }
             case Token::kIdentifier: {
-                Handle<Token> name = t0_;
+                Token name = t0_;
                 AdvanceAndFetchIdentifierName_();
-                switch (t0_->type) {
+                switch (t0_.type) {
                     case '=': {
                         throw "PropertyDefinition : Identifier = AssignmentExpression";
                     }
                     case ':': {
                         Advance_();
-                        key = new Literal(name->value);
+                        key = arena_.New<Literal>(Value_(name));
                         value = ParseAssignmentExpr();
                         type = Property::Type::kNormal;
                         break;
@@ -346,8 +359,8 @@ Handle<Expression> Parser::ParseObjectLiteral() {
                         "Else\n"
                         "    ERROR";
                     default:
-                        key = new Literal(name->value);
-                        value = new Identifier((JSString*)name->value);
+                        key = arena_.New<Literal>(Value_(name));
+                        value = arena_.New<Identifier>(StringValue_(name));
                         type = Property::Type::kNormal;
                         break;
                 }
@@ -356,65 +369,68 @@ Handle<Expression> Parser::ParseObjectLiteral() {
             default:
                 Exceptions::ThrowSyntaxError("Expected property definition in object literal");
         }
-        elements.Add(new Property(key, value, type));
+        elements.push_back(arena_.New<Property>(key, value, type));
         // Do not use ConsumeIf so it is consumed by AdvanceAndFetchIdentifierName_
-    } while (t0_->type == ',');
+    } while (t0_.type == ',');
 finish:
     Advance_();
-    Handle<Array<Property>> arr = elements.ToArray();
-    return new ObjectLiteral(arr);
+    NodeList<Property>* arr = arena_.NewList(elements);
+    return arena_.New<ObjectLiteral>(arr);
 }
 
-Handle<Expression> Parser::ParseLeftHandSideExpr(bool noCall) {
-    Handle<Expression> returnVal;
-    switch (t0_->type) {
+Expression* Parser::ParseLeftHandSideExpr(bool noCall) {
+    Expression* returnVal = nullptr;
+    switch (t0_.type) {
         case Token::kNew: {
+            uint32_t position = Position_();
             Advance_();
             if (ConsumeIf_('.')) {
-                static Handle<JSString> target = JSString::New("target");
-                if (t0_->type != Token::kIdentifier || t0_->value != target) {
+                if (t0_.type != Token::kIdentifier || !scanner.Matches(t0_, "target")) {
                     Exceptions::ThrowSyntaxError("Expected new.target");
                 }
                 Advance_();
-                returnVal = new NewTargetExpression();
+                returnVal = arena_.New<NewTargetExpression>();
                 break;
             }
-            Handle<Expression> ctor = ParseLeftHandSideExpr(true);
-            if (t0_->type != '(') {
-                return new NewExpression(ctor, nullptr);
+            Expression* ctor = ParseLeftHandSideExpr(true);
+            if (t0_.type != '(') {
+                returnVal = arena_.New<NewExpression>(ctor, nullptr);
+                returnVal->position = position;
+                return returnVal;
             }
             Advance_();
-            Handle<Array<Expression>> args = ParseArguments();
-            returnVal = new NewExpression(ctor, args);
+            NodeList<Expression>* args = ParseArguments();
+            returnVal = arena_.New<NewExpression>(ctor, args);
+            returnVal->position = position;
             break;
         }
         case Token::kSuper:
             Advance_();
-            switch (t0_->type) {
+            switch (t0_.type) {
                 case '.': {
                     AdvanceAndFetchIdentifierName_();
-                    if (t0_->type != Token::kIdentifier) {
+                    if (t0_.type != Token::kIdentifier) {
                         Exceptions::ThrowSyntaxError("Expected identifier after in member expression");
                     }
-                    Handle<Expression> convertedLiteral = new Literal(t0_->value);
+                    Expression* convertedLiteral = arena_.New<Literal>(Value_(t0_));
                     Advance_();
-                    returnVal = new SuperPropertyExpression(convertedLiteral);
+                    returnVal = arena_.New<SuperPropertyExpression>(convertedLiteral);
                     break;
                 }
                 case '[': {
                     Advance_();
-                    Handle<Expression> member = ParseExpression();
-                    if (t0_->type != ']') {
+                    Expression* member = ParseExpression();
+                    if (t0_.type != ']') {
                         Exceptions::ThrowSyntaxError("Bracket mismatch in member expression");
                     }
                     Advance_();
-                    returnVal = new SuperPropertyExpression(member);
+                    returnVal = arena_.New<SuperPropertyExpression>(member);
                     break;
                 }
                 case '(': {
                     Advance_();
-                    Handle<Array<Expression>> args = ParseArguments();
-                    returnVal = new SuperCallExpression(args);
+                    NodeList<Expression>* args = ParseArguments();
+                    returnVal = arena_.New<SuperCallExpression>(args);
                     break;
                 }
                 default:
@@ -426,25 +442,28 @@ Handle<Expression> Parser::ParseLeftHandSideExpr(bool noCall) {
             break;
     }
     while (true) {
-        switch (t0_->type) {
+        uint32_t position = Position_();
+        switch (t0_.type) {
             case '.': {
                 AdvanceAndFetchIdentifierName_();
-                if (t0_->type != Token::kIdentifier) {
+                if (t0_.type != Token::kIdentifier) {
                     Exceptions::ThrowSyntaxError("Expected identifier after in member expression");
                 }
-                Handle<Expression> convertedLiteral = new Literal(t0_->value);
+                Expression* convertedLiteral = arena_.New<Literal>(Value_(t0_));
                 Advance_();
-                returnVal = new PropertyExpression(returnVal, convertedLiteral);
+                returnVal = arena_.New<PropertyExpression>(returnVal, convertedLiteral);
+                returnVal->position = position;
                 break;
             }
             case '[': {
                 Advance_();
-                Handle<Expression> member = ParseExpression();
-                if (t0_->type != ']') {
+                Expression* member = ParseExpression();
+                if (t0_.type != ']') {
                     Exceptions::ThrowSyntaxError("Bracket mismatch in member expression");
                 }
                 Advance_();
-                returnVal = new PropertyExpression(returnVal, member);
+                returnVal = arena_.New<PropertyExpression>(returnVal, member);
+                returnVal->position = position;
                 break;
             }
             case '(': {
@@ -452,14 +471,15 @@ Handle<Expression> Parser::ParseLeftHandSideExpr(bool noCall) {
                     return returnVal;
                 }
                 Advance_();
-                Handle<Array<Expression>> args = ParseArguments();
-                returnVal = new CallExpression(returnVal, args);
+                NodeList<Expression>* args = ParseArguments();
+                returnVal = arena_.New<CallExpression>(returnVal, args);
+                returnVal->position = position;
                 break;
             }
             case Token::kNoSubTemplate:
             case Token::kTemplateHead: {
-                Handle<TemplateLiteral> arg = ParseTemplate();
-                returnVal = new TaggedTemplateExpression(returnVal, arg);
+                TemplateLiteral* arg = ParseTemplate();
+                returnVal = arena_.New<TaggedTemplateExpression>(returnVal, arg);
                 break;
             }
             default:
@@ -468,44 +488,44 @@ Handle<Expression> Parser::ParseLeftHandSideExpr(bool noCall) {
     }
 }
 
-Handle<Array<Expression>> Parser::ParseArguments() {
-    if (t0_->type == ')') {
+NodeList<Expression>* Parser::ParseArguments() {
+    if (t0_.type == ')') {
         Advance_();
-        return Array<Expression>::New(0);
+        return arena_.NewList<Expression>(0);
     }
-    ArrayList<Expression> args;
-    Handle<Expression> expr;
+    std::vector<Expression*> args;
+    Expression* expr = nullptr;
     while (true) {
-        if (t0_->type==Token::kEllipse) {
+        if (t0_.type==Token::kEllipse) {
             Advance_();
             expr = ParseAssignmentExpr();
-            args.Add(new SpreadExpression(expr));
+            args.push_back(arena_.New<SpreadExpression>(expr));
         } else {
             expr = ParseAssignmentExpr();
-            args.Add(expr);
+            args.push_back(expr);
         }
-        if (t0_->type == ')') {
+        if (t0_.type == ')') {
             Advance_();
-            return args.ToArray();
-        } else if (t0_->type != ',') {
+            return arena_.NewList(args);
+        } else if (t0_.type != ',') {
             Exceptions::ThrowSyntaxError("Expected expression in argument list");
         }
         Advance_();
     }
 }
 
-Handle<Expression> Parser::ParsePostfixExpr() {
-    Handle<Expression> expr = ParseLeftHandSideExpr();
-    if (!(t0_->flags&Token::kLineBefore) && (t0_->type == Token::kInc || t0_->type == Token::kDec)) {
-        uint16_t type = t0_->type;
+Expression* Parser::ParsePostfixExpr() {
+    Expression* expr = ParseLeftHandSideExpr();
+    if (!(t0_.flags&Token::kLineBefore) && (t0_.type == Token::kInc || t0_.type == Token::kDec)) {
+        uint16_t type = t0_.type;
         Advance_();
-        return new PostfixExpression(expr, type == Token::kInc);
+        return arena_.New<PostfixExpression>(expr, type == Token::kInc);
     }
     return expr;
 }
 
-Handle<Expression> Parser::ParseUnaryExpr() {
-    switch (t0_->type) {
+Expression* Parser::ParseUnaryExpr() {
+    switch (t0_.type) {
         case Token::kDelete:
         case Token::kVoid:
         case Token::kTypeof:
@@ -515,10 +535,10 @@ Handle<Expression> Parser::ParseUnaryExpr() {
         case '-':
         case '~':
         case '!': {
-            uint16_t op = t0_->type;
+            uint16_t op = t0_.type;
             Advance_();
-            Handle<Expression> expr = ParseUnaryExpr();
-            return new UnaryExpression(expr, op);
+            Expression* expr = ParseUnaryExpr();
+            return arena_.New<UnaryExpression>(expr, op);
         }
         default:
             return ParsePostfixExpr();
@@ -527,16 +547,16 @@ Handle<Expression> Parser::ParseUnaryExpr() {
 
 #define GENERATE_BINARY_EXPR_PARSER_ITEM(type,_) case type:
 #define GENERATE_BINARY_EXPR_PARSER(name, prev, ...)\
-	Handle<Expression> Parser::name() {\
-		Handle<Expression> returnVal = prev();\
-		Handle<Expression> right;\
+	Expression* Parser::name() {\
+		Expression* returnVal = prev();\
+		Expression* right = nullptr;\
 		while (true) {\
-			switch (t0_->type) {\
+			switch (t0_.type) {\
 				NORLIT_PP_FOREACH(GENERATE_BINARY_EXPR_PARSER_ITEM, (__VA_ARGS__),) {\
-					uint16_t type = t0_->type;\
+					uint16_t type = t0_.type;\
 					Advance_();\
 					right = prev();\
-					returnVal = new BinaryExpression(returnVal, right, type);\
+					returnVal = arena_.New<BinaryExpression>(returnVal, right, type);\
 					break;\
 				}\
 			default:\
@@ -549,11 +569,11 @@ GENERATE_BINARY_EXPR_PARSER(ParseMulExpr, ParseUnaryExpr, '*', '/', '%');
 GENERATE_BINARY_EXPR_PARSER(ParseAddExpr, ParseMulExpr, '+', '-');
 GENERATE_BINARY_EXPR_PARSER(ParseShiftExpr, ParseAddExpr, Token::kLShift, Token::kRShift, Token::kURShift);
 
-Handle<Expression> Parser::ParseRelationalExpr(bool noIn) {
-    Handle<Expression> returnVal = ParseShiftExpr();
-    Handle<Expression> right;
+Expression* Parser::ParseRelationalExpr(bool noIn) {
+    Expression* returnVal = ParseShiftExpr();
+    Expression* right = nullptr;
     while (true) {
-        switch (t0_->type) {
+        switch (t0_.type) {
             case Token::kIn:
                 if (noIn) {
                     return returnVal;
@@ -563,10 +583,10 @@ Handle<Expression> Parser::ParseRelationalExpr(bool noIn) {
             case Token::kLteq:
             case Token::kGteq:
             case Token::kInstanceof: {
-                uint16_t type = t0_->type;
+                uint16_t type = t0_.type;
                 Advance_();
                 right = ParseShiftExpr();
-                returnVal = new BinaryExpression(returnVal, right, type);
+                returnVal = arena_.New<BinaryExpression>(returnVal, right, type);
                 break;
             }
             default:
@@ -576,16 +596,16 @@ Handle<Expression> Parser::ParseRelationalExpr(bool noIn) {
 }
 
 #define GENERATE_BINARY_EXPR_PARSER_NO_IN(name, prev, ...)\
-	Handle<Expression> Parser::name(bool noIn) {\
-		Handle<Expression> returnVal = prev(noIn);\
-		Handle<Expression> right;\
+	Expression* Parser::name(bool noIn) {\
+		Expression* returnVal = prev(noIn);\
+		Expression* right = nullptr;\
 		while (true) {\
-			switch (t0_->type) {\
+			switch (t0_.type) {\
 				NORLIT_PP_FOREACH(GENERATE_BINARY_EXPR_PARSER_ITEM, (__VA_ARGS__),) {\
-					uint16_t type = t0_->type;\
+					uint16_t type = t0_.type;\
 					Advance_();\
 					right = prev(noIn);\
-					returnVal = new BinaryExpression(returnVal, right, type);\
+					returnVal = arena_.New<BinaryExpression>(returnVal, right, type);\
 					break;\
 				}\
 			default:\
@@ -601,38 +621,38 @@ GENERATE_BINARY_EXPR_PARSER_NO_IN(ParseOrExpr, ParseXorExpr, '|');
 GENERATE_BINARY_EXPR_PARSER_NO_IN(ParseLAndExpr, ParseOrExpr, Token::kLAnd);
 GENERATE_BINARY_EXPR_PARSER_NO_IN(ParseLOrExpr, ParseLAndExpr, Token::kLOr);
 
-Handle<Expression> Parser::ParseConditionalExpr(bool noIn) {
-    Handle<Expression> cond = ParseLOrExpr(noIn);
-    if (t0_->type!='?') {
+Expression* Parser::ParseConditionalExpr(bool noIn) {
+    Expression* cond = ParseLOrExpr(noIn);
+    if (t0_.type!='?') {
         return cond;
     }
     Advance_();
-    Handle<Expression> trueExpr = ParseAssignmentExpr(noIn);
-    if (t0_->type != ':') {
+    Expression* trueExpr = ParseAssignmentExpr(noIn);
+    if (t0_.type != ':') {
         Exceptions::ThrowSyntaxError("Expected : in conditional expression");
     }
     Advance_();
-    Handle<Expression> falseExpr = ParseAssignmentExpr(noIn);
-    cond = new ConditionalExpression(cond, trueExpr, falseExpr);
+    Expression* falseExpr = ParseAssignmentExpr(noIn);
+    cond = arena_.New<ConditionalExpression>(cond, trueExpr, falseExpr);
     return cond;
 }
 
-Handle<Expression> Parser::ParseAssignmentExpr(bool noIn) {
-    if (t0_->type == Token::kYield) {
+Expression* Parser::ParseAssignmentExpr(bool noIn) {
+    if (t0_.type == Token::kYield) {
         Advance_();
-        if (t0_->flags&Token::kLineBefore) {
-            return new YieldExpression(nullptr);
+        if (t0_.flags&Token::kLineBefore) {
+            return arena_.New<YieldExpression>(nullptr);
         }
-        if (t0_->type == '*') {
+        if (t0_.type == '*') {
             throw "yield*";
         } else {
-            Handle<Expression> expr = ParseAssignmentExpr();
-            return new YieldExpression(expr);
+            Expression* expr = ParseAssignmentExpr();
+            return arena_.New<YieldExpression>(expr);
         }
     }
     // TODO SeekForYield
-    Handle<Expression> returnVal = ParseConditionalExpr(noIn);
-    switch (t0_->type) {
+    Expression* returnVal = ParseConditionalExpr(noIn);
+    switch (t0_.type) {
         case Token::kLambda:
             if (typeid(*returnVal) == typeid(CoveredFormals) || typeid(*returnVal) == typeid(Identifier)) {
                 throw "TODO: Lambda Expression";
@@ -642,8 +662,8 @@ Handle<Expression> Parser::ParseAssignmentExpr(bool noIn) {
         case '=': {
             // Need refine
             Advance_();
-            Handle<Expression> right = ParseAssignmentExpr(noIn);
-            return new BinaryExpression(returnVal, right, '=');
+            Expression* right = ParseAssignmentExpr(noIn);
+            return arena_.New<BinaryExpression>(returnVal, right, '=');
         }
         case Token::kMulAssign:
         case Token::kDivAssign:
@@ -656,10 +676,10 @@ Handle<Expression> Parser::ParseAssignmentExpr(bool noIn) {
         case Token::kAndAssign:
         case Token::kXorAssign:
         case Token::kOrAssign: {
-            uint16_t op = t0_->type;
+            uint16_t op = t0_.type;
             Advance_();
-            Handle<Expression> right = ParseAssignmentExpr(noIn);
-            return new BinaryExpression(returnVal, right, op);
+            Expression* right = ParseAssignmentExpr(noIn);
+            return arena_.New<BinaryExpression>(returnVal, right, op);
         }
         default:
             return returnVal;
@@ -668,8 +688,15 @@ Handle<Expression> Parser::ParseAssignmentExpr(bool noIn) {
 
 GENERATE_BINARY_EXPR_PARSER_NO_IN(ParseExpression, ParseAssignmentExpr, ',');
 
-Handle<Statement> Parser::ParseStatement() {
-    switch (t0_->type) {
+Statement* Parser::ParseStatement() {
+    uint32_t position = Position_();
+    Statement* stmt = ParseStatement_();
+    stmt->position = position;
+    return stmt;
+}
+
+Statement* Parser::ParseStatement_() {
+    switch (t0_.type) {
         case '{':
             return ParseBlock();
         case Token::kVar:
@@ -677,7 +704,7 @@ Handle<Statement> Parser::ParseStatement() {
         case ';':
             /* 13.4 Empty Statement */
             Advance_();
-            return new EmptyStatement();
+            return arena_.New<EmptyStatement>();
         case Token::kIf:
             return ParseIf();
         /* 13.7 Iteration Statements */
@@ -705,11 +732,11 @@ Handle<Statement> Parser::ParseStatement() {
             /* Inline: 13.16 Debugger Statement */
             Advance_();
             ConsumeSemicolon_();
-            return new DebuggerStatement();
+            return arena_.New<DebuggerStatement>();
         case Token::kIdentifier:
         case Token::kYield:
             FetchLookahead_();
-            if (t1_->type == ':') {
+            if (t1_.type == ':') {
                 return ParseLabelled();
             }
         default:
@@ -717,8 +744,8 @@ Handle<Statement> Parser::ParseStatement() {
     }
 }
 
-Handle<Statement> Parser::ParseDeclaration() {
-    switch (t0_->type) {
+Statement* Parser::ParseDeclaration() {
+    switch (t0_.type) {
         case Token::kFunction:
             return ParseFunctionOrGeneratorStatement();
         case Token::kClass:
@@ -732,40 +759,42 @@ Handle<Statement> Parser::ParseDeclaration() {
 }
 
 /* 13.2 Block */
-Handle<BlockStatement> Parser::ParseBlock() {
+BlockStatement* Parser::ParseBlock() {
     // Called by ParseTry()
-    if (t0_->type != '{') {
+    if (t0_.type != '{') {
         Exceptions::ThrowSyntaxError("Expected { to start a block");
     }
     Advance_();
-    Handle<Array<Statement>> stmts = ParseStatementList();
-    if (t0_->type != '}') {
+    NodeList<Statement>* stmts = ParseStatementList();
+    if (t0_.type != '}') {
         Exceptions::ThrowSyntaxError("Expected } to close up a block");
     }
     Advance_();
-    return new BlockStatement(stmts);
+    return arena_.New<BlockStatement>(stmts);
 }
 
-Handle<Array<Statement>> Parser::ParseStatementList(bool useDirective) {
-    ArrayList<Statement> list;
-    Handle<Statement> stmt;
+NodeList<Statement>* Parser::ParseStatementList(bool useDirective) {
+    std::vector<Statement*> list;
+    Statement* stmt = nullptr;
     while (true) {
-        switch (t0_->type) {
+        switch (t0_.type) {
             case '}':
             case Token::kEOF:
             /* Those two are for statement list within switch statement */
             case Token::kCase:
             case Token::kDefault:
-                return list.ToArray();
+                return arena_.NewList(list);
         }
+        uint32_t position = Position_();
         stmt = ParseStatementListItem();
+        stmt->position = position;
         if (useDirective) {
             if (typeid(*stmt) == typeid(ExpressionStatement)) {
-                Handle<Expression> expr = stmt.CastTo<ExpressionStatement>()->expr();
+                Expression* expr = static_cast<ExpressionStatement*>(stmt)->expr();
                 if (typeid(*expr) == typeid(Literal)) {
-                    Handle<JSValue> lit = expr.CastTo<Literal>()->literal();
-                    if (lit->GetType() == JSValue::Type::kString) {
-                        stmt = new DirectiveStatement(lit.CastTo<JSString>());
+                    Constant* lit = static_cast<Literal*>(expr)->literal();
+                    if (lit->type() == Constant::Type::kString) {
+                        stmt = arena_.New<DirectiveStatement>(lit);
                         goto add;
                     }
                 }
@@ -773,12 +802,12 @@ Handle<Array<Statement>> Parser::ParseStatementList(bool useDirective) {
             useDirective = false;
         }
 add:
-        list.Add(stmt);
+        list.push_back(stmt);
     }
 }
 
-Handle<Statement> Parser::ParseStatementListItem() {
-    switch (t0_->type) {
+Statement* Parser::ParseStatementListItem() {
+    switch (t0_.type) {
         case Token::kImport:
             throw "TODO: import";
         case Token::kExport:
@@ -788,10 +817,9 @@ Handle<Statement> Parser::ParseStatementListItem() {
         case Token::kClass:
             return ParseDeclaration();
         case Token::kIdentifier: {
-            static Handle<JSString> let = JSString::New("let");
-            if (t0_->value == let) {
+            if (scanner.Matches(t0_, "let")) {
                 FetchLookahead_();
-                switch(t1_->type) {
+                switch(t1_.type) {
                     case '{':
                     case '[':
                     case Token::kIdentifier:
@@ -806,10 +834,16 @@ Handle<Statement> Parser::ParseStatementListItem() {
 }
 
 
-Handle<Statement> Parser::ParseVariable() {
+Statement* Parser::ParseVariable() {
+    Statement* ret = ParseVariableDeclarationList();
+    ConsumeSemicolon_();
+    return ret;
+}
+
+VariableDeclaration* Parser::ParseVariableDeclarationList(bool noIn) {
     VariableDeclaration::Type type;
-    ArrayList<Expression> decl;
-    switch (t0_->type) {
+    std::vector<Expression*> decl;
+    switch (t0_.type) {
         case Token::kConst:
             type = VariableDeclaration::Type::kConst;
             break;
@@ -824,160 +858,231 @@ Handle<Statement> Parser::ParseVariable() {
     }
     Advance_();
     do {
-        decl.Add(ParseAssignmentExpr());
+        decl.push_back(ParseAssignmentExpr(noIn));
     } while (ConsumeIf_(','));
-    ConsumeSemicolon_();
-    Handle<Array<Expression>> exprs = decl.ToArray();
-    return new VariableDeclaration(exprs, type);
+    NodeList<Expression>* exprs = arena_.NewList(decl);
+    return arena_.New<VariableDeclaration>(exprs, type);
 }
 
 /* 13.5 Expression Statement */
-Handle<Statement> Parser::ParseExpressionStmt() {
-    Handle<Expression> expr = ParseExpression();
+Statement* Parser::ParseExpressionStmt() {
+    Expression* expr = ParseExpression();
     ConsumeSemicolon_();
-    return new ExpressionStatement(expr);
+    return arena_.New<ExpressionStatement>(expr);
 }
 
-Handle<Statement> Parser::ParseIf() {
+Statement* Parser::ParseIf() {
     // Consume If
     Advance_();
-    if (t0_->type != '(') {
+    if (t0_.type != '(') {
         Exceptions::ThrowSyntaxError("Expected ( after if");
     }
     Advance_();
-    Handle<Expression> cond = ParseExpression();
-    if (t0_->type != ')') {
+    Expression* cond = ParseExpression();
+    if (t0_.type != ')') {
         Exceptions::ThrowSyntaxError("Parenthesis is not enclosed");
     }
     Advance_();
-    Handle<Statement> then = ParseStatement();
-    Handle<Statement> otherwise;
-    if (t0_->type == Token::kElse) {
+    Statement* then = ParseStatement();
+    Statement* otherwise = nullptr;
+    if (t0_.type == Token::kElse) {
         Advance_();
         otherwise = ParseStatement();
     }
-    return new IfStatement(cond, then, otherwise);
+    return arena_.New<IfStatement>(cond, then, otherwise);
 }
 
-Handle<Statement> Parser::ParseDo() {
+Statement* Parser::ParseDo() {
     // Consume do
     Advance_();
-    Handle<Statement> body = ParseStatement();
-    if (t0_->type != Token::kWhile) {
+    Statement* body = ParseStatement();
+    if (t0_.type != Token::kWhile) {
         Exceptions::ThrowSyntaxError("Expected while in do while loop");
     }
     Advance_();
-    if (t0_->type != '(') {
+    if (t0_.type != '(') {
         Exceptions::ThrowSyntaxError("Expected ( after while");
     }
     Advance_();
-    Handle<Expression> cond = ParseExpression();
-    if (t0_->type != ')') {
+    Expression* cond = ParseExpression();
+    if (t0_.type != ')') {
         Exceptions::ThrowSyntaxError("Parenthesis is not enclosed");
     }
     Advance_();
     // See Automatic Semicolon Insertion. Do-while loop can end without semicolon
     ConsumeIf_(';');
-    return new DoStatement(body, cond);
+    return arena_.New<DoStatement>(body, cond);
 }
 
-Handle<Statement> Parser::ParseWhile() {
+Statement* Parser::ParseWhile() {
     // Consume while
     Advance_();
-    if (t0_->type != '(') {
+    if (t0_.type != '(') {
         Exceptions::ThrowSyntaxError("Expected ( after while");
     }
     Advance_();
-    Handle<Expression> cond = ParseExpression();
-    if (t0_->type != ')') {
+    Expression* cond = ParseExpression();
+    if (t0_.type != ')') {
         Exceptions::ThrowSyntaxError("Parenthesis is not enclosed");
     }
     Advance_();
-    Handle<Statement> body = ParseStatement();
+    Statement* body = ParseStatement();
     ConsumeSemicolon_();
-    return new WhileStatement(cond, body);
+    return arena_.New<WhileStatement>(cond, body);
 }
 
-Handle<Statement> Parser::ParseFor() {
+Statement* Parser::ParseFor() {
     // Consume for
     Advance_();
-    throw "TODO: For not supported";
+    if (!ConsumeIf_('(')) {
+        Exceptions::ThrowSyntaxError("Expected ( after for");
+    }
+    size_t functionCount = functionCount_;
+    VariableDeclaration* decl = nullptr;
+    Expression* init = nullptr;
+    switch (t0_.type) {
+        case ';':
+            break;
+        case Token::kVar:
+        case Token::kConst:
+            decl = ParseVariableDeclarationList(true);
+            break;
+        case Token::kIdentifier:
+            if (scanner.Matches(t0_, "let")) {
+                FetchLookahead_();
+                switch (t1_.type) {
+                    case '{':
+                    case '[':
+                    case Token::kIdentifier:
+                    case Token::kYield:
+                        decl = ParseVariableDeclarationList(true);
+                        goto parsed;
+                }
+            }
+        default:
+            init = ParseExpression(true);
+            break;
+    }
+parsed:
+    bool isOf = t0_.type == Token::kIdentifier && scanner.Matches(t0_, "of");
+    if (t0_.type == Token::kIn || isOf) {
+        if (decl) {
+            NodeList<Expression>* items = decl->decl();
+            if (items->Length() != 1 || typeid(*items->Get(0)) == typeid(BinaryExpression)) {
+                Exceptions::ThrowSyntaxError(isOf ?
+                                             "Invalid left-hand side in for-of loop" :
+                                             "Invalid left-hand side in for-in loop");
+            }
+        }
+        Advance_();
+        Expression* expr = isOf ? ParseAssignmentExpr() : ParseExpression();
+        if (!ConsumeIf_(')')) {
+            Exceptions::ThrowSyntaxError("Parenthesis mismatch");
+        }
+        Statement* body = ParseStatement();
+        if (isOf) {
+            return arena_.New<ForOfStatement>(decl, init, expr, body);
+        } else {
+            return arena_.New<ForInStatement>(decl, init, expr, body);
+        }
+    }
+    if (!ConsumeIf_(';')) {
+        Exceptions::ThrowSyntaxError("Expected ; in for statement");
+    }
+    Expression* cond = nullptr;
+    if (t0_.type != ';') {
+        cond = ParseExpression();
+    }
+    if (!ConsumeIf_(';')) {
+        Exceptions::ThrowSyntaxError("Expected ; in for statement");
+    }
+    Expression* update = nullptr;
+    if (t0_.type != ')') {
+        update = ParseExpression();
+    }
+    if (!ConsumeIf_(')')) {
+        Exceptions::ThrowSyntaxError("Parenthesis mismatch");
+    }
+    Statement* body = ParseStatement();
+    // If no function is created within the loop, the bindings can never be captured
+    bool perIterationScope = functionCount_ != functionCount;
+    return arena_.New<ForStatement>(decl, init, cond, update, body, perIterationScope);
 }
 
-Handle<Statement> Parser::ParseContinue() {
+Statement* Parser::ParseContinue() {
     // Consume continue
     Advance_();
-    if (t0_->type != Token::kIdentifier || (t0_->flags&Token::kLineBefore)) {
+    if (t0_.type != Token::kIdentifier || (t0_.flags&Token::kLineBefore)) {
         ConsumeSemicolon_();
-        return new ContinueStatement(nullptr);
+        return arena_.New<ContinueStatement>(nullptr);
     }
-    Handle<JSString> name = (JSString*)t0_->value;
+    Constant* name = StringValue_(t0_);
     Advance_();
     ConsumeSemicolon_();
-    return new ContinueStatement(name);
+    return arena_.New<ContinueStatement>(name);
 }
 
-Handle<Statement> Parser::ParseBreak() {
+Statement* Parser::ParseBreak() {
     // Consume break
     Advance_();
-    if (t0_->type != Token::kIdentifier || (t0_->flags&Token::kLineBefore)) {
+    if (t0_.type != Token::kIdentifier || (t0_.flags&Token::kLineBefore)) {
         ConsumeSemicolon_();
-        return new BreakStatement(nullptr);
+        return arena_.New<BreakStatement>(nullptr);
     }
-    Handle<JSString> name = (JSString*)t0_->value;
+    Constant* name = StringValue_(t0_);
     Advance_();
     ConsumeSemicolon_();
-    return new BreakStatement(name);
+    return arena_.New<BreakStatement>(name);
 }
 
-Handle<Statement> Parser::ParseReturn() {
+Statement* Parser::ParseReturn() {
     // Consume return
     Advance_();
-    Handle<Expression> expr;
-    if (t0_->type == ';') {
+    Expression* expr = nullptr;
+    if (t0_.type == ';') {
         Advance_();
-    } else if(t0_->type != '}' && !(t0_->flags&Token::kLineBefore)) {
+    } else if(t0_.type != '}' && !(t0_.flags&Token::kLineBefore)) {
         expr = ParseExpression();
         ConsumeSemicolon_();
     }
-    return new ReturnStatement(expr);
+    return arena_.New<ReturnStatement>(expr);
 }
 
-Handle<Statement> Parser::ParseWith() {
+Statement* Parser::ParseWith() {
     // Consume with
     Advance_();
-    if (t0_->type != '(') {
+    if (t0_.type != '(') {
         Exceptions::ThrowSyntaxError("Expected ( after with");
     }
     Advance_();
-    Handle<Expression> cond = ParseExpression();
-    if (t0_->type != ')') {
+    Expression* cond = ParseExpression();
+    if (t0_.type != ')') {
         Exceptions::ThrowSyntaxError("Parenthesis is not enclosed");
     }
     Advance_();
-    Handle<Statement> body = ParseStatement();
+    Statement* body = ParseStatement();
     ConsumeSemicolon_();
-    return new WithStatement(cond, body);
+    return arena_.New<WithStatement>(cond, body);
 }
 
-Handle<Statement> Parser::ParseSwitch() {
+Statement* Parser::ParseSwitch() {
     Advance_();
     if (!ConsumeIf_('(')) {
         Exceptions::ThrowSyntaxError("Expected ( after switch");
     }
-    Handle<Expression> expr = ParseExpression();
+    Expression* expr = ParseExpression();
     if (!ConsumeIf_(')')) {
         Exceptions::ThrowSyntaxError("Parenthesis mismatch");
     }
     if (!ConsumeIf_('{')) {
         Exceptions::ThrowSyntaxError("Expected { after switch");
     }
-    ArrayList<SwitchClause> clauses;
-    Handle<Expression> cond;
-    Handle<Array<Statement>> stmt;
+    std::vector<SwitchClause*> clauses;
+    Expression* cond = nullptr;
+    NodeList<Statement>* stmt = nullptr;
     bool defDefined = false;
     while (true) {
-        switch (t0_->type) {
+        switch (t0_.type) {
             case Token::kCase:
                 Advance_();
                 cond = ParseExpression();
@@ -987,6 +1092,7 @@ Handle<Statement> Parser::ParseSwitch() {
                     Exceptions::ThrowSyntaxError("Duplicate default clause");
                 }
                 defDefined = true;
+                cond = nullptr;
                 Advance_();
                 break;
             default:
@@ -996,48 +1102,48 @@ Handle<Statement> Parser::ParseSwitch() {
             Exceptions::ThrowSyntaxError("Expected : after case clause");
         }
         stmt = ParseStatementList();
-        clauses.Add(new SwitchClause(cond, stmt));
+        clauses.push_back(arena_.New<SwitchClause>(cond, stmt));
     }
 finish:
     if (!ConsumeIf_('}')) {
         Exceptions::ThrowSyntaxError("Expected } in switch statement");
     }
-    Handle<Array<SwitchClause>> clauseArray = clauses.ToArray();
-    return new SwitchStatement(expr, clauseArray);
+    NodeList<SwitchClause>* clauseArray = arena_.NewList(clauses);
+    return arena_.New<SwitchStatement>(expr, clauseArray);
 }
 
-Handle<Statement> Parser::ParseLabelled() {
-    Handle<JSString> name = (JSString*)t0_->value;
+Statement* Parser::ParseLabelled() {
+    Constant* name = StringValue_(t0_);
     // Consume Identifier
     Advance_();
     // Consume :
     Advance_();
-    Handle<Statement> stmt;
-    if (t0_->type == Token::kFunction) {
+    Statement* stmt = nullptr;
+    if (t0_.type == Token::kFunction) {
         stmt = ParseFunctionOrGeneratorStatement();
     } else {
         stmt = ParseStatement();
     }
-    return new LabelledStatement(name, stmt);
+    return arena_.New<LabelledStatement>(name, stmt);
 }
 
-Handle<Statement> Parser::ParseThrow() {
+Statement* Parser::ParseThrow() {
     // Consume throw
     Advance_();
-    if (t0_->flags&Token::kLineBefore) {
+    if (t0_.flags&Token::kLineBefore) {
         Exceptions::ThrowSyntaxError("No line terminator allowed after throw");
     }
-    Handle<Expression> expr = ParseExpression();
+    Expression* expr = ParseExpression();
     ConsumeSemicolon_();
-    return new ThrowStatement(expr);
+    return arena_.New<ThrowStatement>(expr);
 }
 
-Handle<Statement> Parser::ParseTry() {
+Statement* Parser::ParseTry() {
     // Consume try
     Advance_();
-    Handle<BlockStatement> body = ParseBlock();
-    Handle<Expression> param;
-    Handle<BlockStatement> error;
+    BlockStatement* body = ParseBlock();
+    Expression* param = nullptr;
+    BlockStatement* error = nullptr;
     if (ConsumeIf_(Token::kCatch)) {
         if (!ConsumeIf_('(')) {
             Exceptions::ThrowSyntaxError("Expected ( after catch");
@@ -1048,7 +1154,7 @@ Handle<Statement> Parser::ParseTry() {
         }
         error = ParseBlock();
     }
-    Handle<BlockStatement> finally;
+    BlockStatement* finally = nullptr;
     if (ConsumeIf_(Token::kFinally)) {
         finally = ParseBlock();
     }
@@ -1057,44 +1163,58 @@ Handle<Statement> Parser::ParseTry() {
         Exceptions::ThrowSyntaxError("catch and finally cannot both be missing");
     }
 
-    return new TryStatement(body, param, error, finally);
+    return arena_.New<TryStatement>(body, param, error, finally);
 }
 
-Handle<FunctionExpression> Parser::ParseFunctionOrGeneratorExpression() {
+FunctionExpression* Parser::ParseFunctionOrGeneratorExpression() {
+    uint32_t start = Position_();
     // Consume function
     Advance_();
     bool generator = ConsumeIf_('*');
-    Handle<JSString> name;
-    if (t0_->type == Token::kIdentifier/*yield*/) {
-        name = (JSString*)t0_->value;
+    Constant* name = nullptr;
+    if (t0_.type == Token::kIdentifier/*yield*/) {
+        name = StringValue_(t0_);
         Advance_();
     }
 
-    Handle<Array<Expression>> param = ParseCoveredFormals();
+    // Nodes of pre-parsed functions are dropped once the syntax is checked
+    Arena::Mark mark = arena_.GetMark();
+
+    NodeList<Expression>* param = ParseCoveredFormals();
 
     if (!ConsumeIf_('{')) {
         Exceptions::ThrowSyntaxError("Expected { in function definition");
     }
 
     // TODO generator and yield
-    Handle<Array<Statement>> body = ParseStatementList(true);
+    functionDepth_++;
+    NodeList<Statement>* body = ParseStatementList(true);
+    functionDepth_--;
 
-    if (!ConsumeIf_('}')) {
+    if (t0_.type != '}') {
         Exceptions::ThrowSyntaxError("Brace mismatch in function definition");
     }
+    uint32_t end = scanner.offset() + t0_.end;
+    Advance_();
 
-    return new FunctionExpression(generator, name, param, body);
+    functionCount_++;
+    if (functionDepth_ >= lazyDepth_) {
+        // The AST is dropped once syntax is checked. Code is generated on the first call
+        arena_.Release(mark);
+        return arena_.New<FunctionExpression>(generator, name, start, end);
+    }
+    return arena_.New<FunctionExpression>(generator, name, param, body);
 }
 
-Handle<Statement> Parser::ParseFunctionOrGeneratorStatement() {
-    Handle<FunctionExpression> func = ParseFunctionOrGeneratorExpression();
-    return new FunctionStatement(func);
+Statement* Parser::ParseFunctionOrGeneratorStatement() {
+    FunctionExpression* func = ParseFunctionOrGeneratorExpression();
+    return arena_.New<FunctionStatement>(func);
 }
 
-Handle<Script> Parser::ParseScript() {
-    Handle<Array<Statement>> stmts = ParseStatementList(true);
-    if (t0_->type != Token::kEOF) {
+Script* Parser::ParseScript() {
+    NodeList<Statement>* stmts = ParseStatementList(true);
+    if (t0_.type != Token::kEOF) {
         Exceptions::ThrowSyntaxError("Excessive token");
     }
-    return new Script(stmts);
+    return arena_.New<Script>(stmts);
 }
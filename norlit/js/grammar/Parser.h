@@ -1,21 +1,20 @@
 #ifndef NORLIT_JS_GRAMMAR_PARSER_H
 #define NORLIT_JS_GRAMMAR_PARSER_H
 
-#include "../JSString.h"
-#include "../../gc/Handle.h"
-#include "../../gc/Array.h"
+#include "Token.h"
+#include "Arena.h"
 
 namespace norlit {
 namespace js {
 namespace grammar {
 
 class Scanner;
-class Token;
 class Expression;
 class TemplateLiteral;
 class CoveredFormals;
 class ArrayLiteral;
 class Statement;
+class VariableDeclaration;
 class BlockStatement;
 class Script;
 class FunctionExpression;
@@ -23,8 +22,19 @@ class FunctionExpression;
 class Parser {
   private:
     Scanner& scanner;
-    gc::Handle<Token> t0_;
-    gc::Handle<Token> t1_;
+    // Owns the AST, so the parser must outlive code generation
+    Arena arena_;
+    Token t0_;
+    Token t1_;
+    // Whether t1_ holds a lookahead token
+    bool lookahead_ = false;
+
+    // Number of functions parsed so far, used to detect closures within a region of source
+    size_t functionCount_ = 0;
+    // Number of functions enclosing the current position
+    size_t functionDepth_ = 0;
+    // Functions enclosed by at least this many functions are only pre-parsed
+    size_t lazyDepth_;
 
   private:
     void Fetch_();
@@ -34,62 +44,73 @@ class Parser {
 
     bool ConsumeIf_(uint16_t type);
     void ConsumeSemicolon_();
+    // Offset of the current token in the source
+    uint32_t Position_();
+    // Constants of the token allocated in the arena, see Scanner::StringValue and Scanner::RawValue.
+    // Value_ is the number of numeric literals, or the string value otherwise
+    Constant* Value_(const Token&);
+    Constant* StringValue_(const Token&);
+    Constant* RawValue_(const Token&);
+    Statement* ParseStatement_();
 
   public:
-    gc::Handle<Expression> ParsePrimaryExpr();
-    gc::Handle<gc::Array<Expression>> ParseCoveredFormals();
-    gc::Handle<Expression> ParseArrayLiteral();
-    gc::Handle<Expression> RefineArrayAssignmentPattern(const gc::Handle<ArrayLiteral>&);
-    gc::Handle<Expression> ParseObjectLiteral();
-
-    gc::Handle<Expression> ParseLeftHandSideExpr(bool = false);
-
-    gc::Handle<gc::Array<Expression>> ParseArguments();
-    gc::Handle<TemplateLiteral> ParseTemplate();
-
-    gc::Handle<Expression> ParsePostfixExpr();
-    gc::Handle<Expression> ParseUnaryExpr();
-    gc::Handle<Expression> ParseMulExpr();
-    gc::Handle<Expression> ParseAddExpr();
-    gc::Handle<Expression> ParseShiftExpr();
-    gc::Handle<Expression> ParseRelationalExpr(bool);
-    gc::Handle<Expression> ParseEqualityExpr(bool);
-    gc::Handle<Expression> ParseAndExpr(bool);
-    gc::Handle<Expression> ParseXorExpr(bool);
-    gc::Handle<Expression> ParseOrExpr(bool);
-    gc::Handle<Expression> ParseLAndExpr(bool);
-    gc::Handle<Expression> ParseLOrExpr(bool);
-    gc::Handle<Expression> ParseConditionalExpr(bool);
-    gc::Handle<Expression> ParseAssignmentExpr(bool = false);
-    gc::Handle<Expression> ParseExpression(bool = false);
-
-    gc::Handle<Statement> ParseStatement();
-    gc::Handle<Statement> ParseDeclaration();
-    gc::Handle<BlockStatement> ParseBlock();
-    gc::Handle<gc::Array<Statement>> ParseStatementList(bool = false);
-    gc::Handle<Statement> ParseStatementListItem();
-
-    gc::Handle<Statement> ParseVariable();
-    gc::Handle<Statement> ParseExpressionStmt();
-    gc::Handle<Statement> ParseIf();
-    gc::Handle<Statement> ParseDo();
-    gc::Handle<Statement> ParseWhile();
-    gc::Handle<Statement> ParseFor();
-    gc::Handle<Statement> ParseContinue();
-    gc::Handle<Statement> ParseBreak();
-    gc::Handle<Statement> ParseReturn();
-    gc::Handle<Statement> ParseWith();
-    gc::Handle<Statement> ParseSwitch();
-    gc::Handle<Statement> ParseLabelled();
-    gc::Handle<Statement> ParseThrow();
-    gc::Handle<Statement> ParseTry();
-
-    gc::Handle<FunctionExpression> ParseFunctionOrGeneratorExpression();
-    gc::Handle<Statement> ParseFunctionOrGeneratorStatement();
-
-    gc::Handle<Script> ParseScript();
-
-    Parser(Scanner& s);
+    Expression* ParsePrimaryExpr();
+    NodeList<Expression>* ParseCoveredFormals();
+    Expression* ParseArrayLiteral();
+    Expression* RefineArrayAssignmentPattern(ArrayLiteral*);
+    Expression* ParseObjectLiteral();
+
+    Expression* ParseLeftHandSideExpr(bool = false);
+
+    NodeList<Expression>* ParseArguments();
+    TemplateLiteral* ParseTemplate();
+
+    Expression* ParsePostfixExpr();
+    Expression* ParseUnaryExpr();
+    Expression* ParseMulExpr();
+    Expression* ParseAddExpr();
+    Expression* ParseShiftExpr();
+    Expression* ParseRelationalExpr(bool);
+    Expression* ParseEqualityExpr(bool);
+    Expression* ParseAndExpr(bool);
+    Expression* ParseXorExpr(bool);
+    Expression* ParseOrExpr(bool);
+    Expression* ParseLAndExpr(bool);
+    Expression* ParseLOrExpr(bool);
+    Expression* ParseConditionalExpr(bool);
+    Expression* ParseAssignmentExpr(bool = false);
+    Expression* ParseExpression(bool = false);
+
+    Statement* ParseStatement();
+    Statement* ParseDeclaration();
+    BlockStatement* ParseBlock();
+    NodeList<Statement>* ParseStatementList(bool = false);
+    Statement* ParseStatementListItem();
+
+    Statement* ParseVariable();
+    VariableDeclaration* ParseVariableDeclarationList(bool = false);
+    Statement* ParseExpressionStmt();
+    Statement* ParseIf();
+    Statement* ParseDo();
+    Statement* ParseWhile();
+    Statement* ParseFor();
+    Statement* ParseContinue();
+    Statement* ParseBreak();
+    Statement* ParseReturn();
+    Statement* ParseWith();
+    Statement* ParseSwitch();
+    Statement* ParseLabelled();
+    Statement* ParseThrow();
+    Statement* ParseTry();
+
+    FunctionExpression* ParseFunctionOrGeneratorExpression();
+    Statement* ParseFunctionOrGeneratorStatement();
+
+    Script* ParseScript();
+
+    // Functions at lazyDepth or deeper are pre-parsed. Scripts use 0, while a lazily compiled
+    // function uses 1 so that only the function itself is fully parsed
+    Parser(Scanner& s, size_t lazyDepth = 0);
 };
 
 }
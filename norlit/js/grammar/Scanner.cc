@@ -12,13 +12,15 @@
 
 #include <string>
 #include <cstdio>
+#include <cstring>
 
 using namespace norlit::gc;
 using namespace norlit::js;
 using namespace norlit::js::grammar;
 using namespace norlit::util;
 
-void Scanner::Dump(const Handle<Token>& t) {
+void Scanner::Dump(const Token& tok) {
+    const Token* t = &tok;
     if (t->type < 0x80) {
         printf("[Punctuator %c]\n", t->type);
         return;
@@ -59,39 +61,25 @@ void Scanner::Dump(const Handle<Token>& t) {
         case Token::kEOF:
             printf("[EOF]\n");
             break;
-        case Token::kString: {
-            Handle<JSString> str = (JSString*)t->value;
-            printf("[StringLiteral %s]\n", &str->ToCString()->At(0));
+        case Token::kString:
+            printf("[StringLiteral %ls]\n", StringValue(tok).c_str());
             break;
-        }
-        case Token::kIdentifier: {
-            Handle<JSString> str = (JSString*)t->value;
-            printf("[Identifier %s]\n", &str->ToCString()->At(0));
+        case Token::kIdentifier:
+            printf("[Identifier %ls]\n", StringValue(tok).c_str());
             break;
-        }
-        case Token::kTemplateHead: {
-            Handle<ValueArray<char>> cstr = ((JSString*)t->value)->ToCString();
-            Handle<ValueArray<char>> rstr = ((JSString*)t->additional)->ToCString();
-            printf("[TemplateHead %s; Raw: %s]\n", &cstr->At(0), &rstr->At(0));
+        case Token::kTemplateHead:
+            printf("[TemplateHead %ls; Raw: %ls]\n", StringValue(tok).c_str(), RawValue(tok).c_str());
             break;
-        }
-        case Token::kNoSubTemplate: {
-            Handle<ValueArray<char>> cstr = ((JSString*)t->value)->ToCString();
-            Handle<ValueArray<char>> rstr = ((JSString*)t->additional)->ToCString();
-            printf("[NoSubstitutionTemplate %s; Raw: %s]\n", &cstr->At(0), &rstr->At(0));
+        case Token::kNoSubTemplate:
+            printf("[NoSubstitutionTemplate %ls; Raw: %ls]\n", StringValue(tok).c_str(), RawValue(tok).c_str());
             break;
-        }
         case Token::kNumber: {
-            Handle<JSNumber> val = (JSNumber*)t->value;
-            printf("[NumberLiteral %lf]\n", val->Value());
+            printf("[NumberLiteral %lf]\n", t->number);
             break;
         }
-        case Token::kRegexp: {
-            Handle<ValueArray<char>> rstr = ((JSString*)t->value)->ToCString();
-            Handle<ValueArray<char>> fstr = ((JSString*)t->additional)->ToCString();
-            printf("[Regexp /%s/%s]\n", &rstr->At(0), &fstr->At(0));
+        case Token::kRegexp:
+            printf("[Regexp /%ls/%ls]\n", StringValue(tok).c_str(), RawValue(tok).c_str());
             break;
-        }
         case Token::kBreak:
         case Token::kCase:
         case Token::kCatch:
@@ -127,21 +115,19 @@ void Scanner::Dump(const Handle<Token>& t) {
         case Token::kYield:
         case Token::kNull:
         case Token::kTrue:
-        case Token::kFalse: {
-            Handle<JSString> str = (JSString*)t->value;
-            printf("[%s]\n", &str->ToCString()->At(0));
+        case Token::kFalse:
+            printf("[%ls]\n", StringValue(tok).c_str());
             break;
-        }
         default:
             Exceptions::ThrowSyntaxError("UNK");
     }
 }
 
 void Scanner::Fetch_() {
-    if ((unsigned)ptr >= content->Length()) {
+    if ((unsigned)ptr >= content.size()) {
         c0_ = -1;
     } else {
-        c0_ = content->At(ptr);
+        c0_ = content[ptr];
     }
 }
 
@@ -151,10 +137,10 @@ void Scanner::Advance_(int number) {
 }
 
 int Scanner::Lookahead_(int distance) {
-    if ((unsigned)ptr + distance >= content->Length()) {
+    if ((unsigned)ptr + distance >= content.size()) {
         return -1;
     } else {
-        return content->At(ptr + distance);
+        return content[ptr + distance];
     }
 }
 
@@ -181,11 +167,13 @@ void Scanner::Expect_(const char* str) {
     }
 }
 
-Handle<Token> Scanner::Wrap(Handle<Token>&& tok) {
+Token Scanner::Wrap(Token tok) {
     if (lineBefore_) {
-        tok->flags |= Token::kLineBefore;
+        tok.flags |= Token::kLineBefore;
         lineBefore_ = false;
     }
+    tok.start = tokenStart_;
+    tok.end = ptr;
     return tok;
 }
 
@@ -277,8 +265,7 @@ void Scanner::SkipWhitespace() {
 }
 
 /* ES6 11.6 */
-Handle<Token> Scanner::NextIdentifierName() {
-    std::wstring buf;
+Token Scanner::NextIdentifierName(std::wstring* value) {
     int id = c0_;
     bool escaped = false;
     Advance_();
@@ -291,7 +278,7 @@ Handle<Token> Scanner::NextIdentifierName() {
     } else if (!IsIdentifierStart(id)) {
         Exceptions::ThrowSyntaxError("Expected identifier start");
     }
-    buf += id;
+    if (value) *value += id;
     while (true) {
         int nxt = c0_;
         Advance_();
@@ -301,76 +288,95 @@ Handle<Token> Scanner::NextIdentifierName() {
                 Exceptions::ThrowSyntaxError("Unicode escape sequence should be proper identifier part");
             }
             escaped = true;
-            buf += esc;
+            if (value) *value += esc;
         } else if (IsIdentifierPart(nxt)) {
-            buf += nxt;
+            if (value) *value += nxt;
         } else {
             Pushback_();
             break;
         }
     }
-    Handle<JSString> str = JSString::New(buf.c_str());
-    return Wrap(new Token(Token::kIdentifier, escaped ? Token::kEscaped:0, str));
+    return Wrap(Token(Token::kIdentifier, escaped ? Token::kEscaped:0));
 }
 
-void Scanner::TranslateIdentifierName(const Handle<Token>& tok) {
-    static HashMap<JSString, TaggedInteger> map;
-    NORLIT_STATIC_BLOCK {
-        map.Put(JSString::New("break"), TaggedInteger::New(Token::kBreak));
-        map.Put(JSString::New("case" ), TaggedInteger::New(Token::kCase));
-        map.Put(JSString::New("catch"), TaggedInteger::New(Token::kCatch));
-        map.Put(JSString::New("class"), TaggedInteger::New(Token::kClass));
-        map.Put(JSString::New("const"), TaggedInteger::New(Token::kConst));
-        map.Put(JSString::New("continue"), TaggedInteger::New(Token::kContinue));
-        map.Put(JSString::New("debugger"), TaggedInteger::New(Token::kDebugger));
-        map.Put(JSString::New("default"), TaggedInteger::New(Token::kDefault));
-        map.Put(JSString::New("delete"), TaggedInteger::New(Token::kDelete));
-        map.Put(JSString::New("do"), TaggedInteger::New(Token::kDo));
-        map.Put(JSString::New("else"), TaggedInteger::New(Token::kElse));
-        map.Put(JSString::New("export"), TaggedInteger::New(Token::kExport));
-        map.Put(JSString::New("extends"), TaggedInteger::New(Token::kExtends));
-        map.Put(JSString::New("finally"), TaggedInteger::New(Token::kFinally));
-        map.Put(JSString::New("for"), TaggedInteger::New(Token::kFor));
-        map.Put(JSString::New("function"), TaggedInteger::New(Token::kFunction));
-        map.Put(JSString::New("if"), TaggedInteger::New(Token::kIf));
-        map.Put(JSString::New("import"), TaggedInteger::New(Token::kImport));
-        map.Put(JSString::New("in"), TaggedInteger::New(Token::kIn));
-        map.Put(JSString::New("instanceof"), TaggedInteger::New(Token::kInstanceof));
-        map.Put(JSString::New("new"), TaggedInteger::New(Token::kNew));
-        map.Put(JSString::New("return"), TaggedInteger::New(Token::kReturn));
-        map.Put(JSString::New("super"), TaggedInteger::New(Token::kSuper));
-        map.Put(JSString::New("switch"), TaggedInteger::New(Token::kSwitch));
-        map.Put(JSString::New("this"), TaggedInteger::New(Token::kThis));
-        map.Put(JSString::New("throw"), TaggedInteger::New(Token::kThrow));
-        map.Put(JSString::New("try"), TaggedInteger::New(Token::kTry));
-        map.Put(JSString::New("typeof"), TaggedInteger::New(Token::kTypeof));
-        map.Put(JSString::New("var"), TaggedInteger::New(Token::kVar));
-        map.Put(JSString::New("void"), TaggedInteger::New(Token::kVoid));
-        map.Put(JSString::New("while"), TaggedInteger::New(Token::kWhile));
-        map.Put(JSString::New("with"), TaggedInteger::New(Token::kWith));
-        map.Put(JSString::New("yield"), TaggedInteger::New(Token::kYield));
-        map.Put(JSString::New("null"), TaggedInteger::New(Token::kNull));
-        map.Put(JSString::New("true"), TaggedInteger::New(Token::kTrue));
-        map.Put(JSString::New("false"), TaggedInteger::New(Token::kFalse));
-
-        map.Put(JSString::New("enum"), TaggedInteger::New(Token::kReserved));
-        map.Put(JSString::New("await"), TaggedInteger::New(Token::kReserved));
-    };
+namespace {
+
+struct Keyword {
+    const char* name;
+    uint16_t type;
+};
+
+// Sorted by length so lookup only compares candidates of the same length
+const Keyword keywords[] = {
+    {"do", Token::kDo},
+    {"if", Token::kIf},
+    {"in", Token::kIn},
+    {"for", Token::kFor},
+    {"new", Token::kNew},
+    {"try", Token::kTry},
+    {"var", Token::kVar},
+    {"case", Token::kCase},
+    {"else", Token::kElse},
+    {"this", Token::kThis},
+    {"void", Token::kVoid},
+    {"with", Token::kWith},
+    {"null", Token::kNull},
+    {"true", Token::kTrue},
+    {"enum", Token::kReserved},
+    {"break", Token::kBreak},
+    {"catch", Token::kCatch},
+    {"class", Token::kClass},
+    {"const", Token::kConst},
+    {"super", Token::kSuper},
+    {"throw", Token::kThrow},
+    {"while", Token::kWhile},
+    {"yield", Token::kYield},
+    {"false", Token::kFalse},
+    {"await", Token::kReserved},
+    {"delete", Token::kDelete},
+    {"export", Token::kExport},
+    {"import", Token::kImport},
+    {"return", Token::kReturn},
+    {"switch", Token::kSwitch},
+    {"typeof", Token::kTypeof},
+    {"default", Token::kDefault},
+    {"extends", Token::kExtends},
+    {"finally", Token::kFinally},
+    {"continue", Token::kContinue},
+    {"debugger", Token::kDebugger},
+    {"function", Token::kFunction},
+    {"instanceof", Token::kInstanceof},
+};
 
+}
+
+void Scanner::TranslateIdentifierName(Token& tok) {
     // Escaped identifiers are not keywords
-    if (tok->flags&Token::kEscaped) {
+    if (tok.flags&Token::kEscaped) {
         return;
     }
 
-    Handle<TaggedInteger> value = map.Get((JSString*)tok->value);
-    if (!value)
+    size_t length = tok.end - tok.start;
+    if (length < 2 || length > 10) {
         return;
-    uint16_t type = value->Value();
-    if (type == Token::kReserved) {
-        Exceptions::ThrowSyntaxError("Future reserved keywords cannot be used as identifiers");
     }
-    tok->type = type;
 
+    for (const Keyword& keyword : keywords) {
+        size_t keywordLength = strlen(keyword.name);
+        if (keywordLength < length) {
+            continue;
+        } else if (keywordLength > length) {
+            return;
+        }
+        if (!Matches(tok, keyword.name)) {
+            continue;
+        }
+        if (keyword.type == Token::kReserved) {
+            Exceptions::ThrowSyntaxError("Future reserved keywords cannot be used as identifiers");
+        }
+        tok.type = keyword.type;
+        return;
+    }
 }
 
 int Scanner::NextUnicodeEscapeSequence() {
@@ -478,9 +484,7 @@ int16_t Scanner::ScanExp_() {
 }
 
 /* Numeric Literals 11.8.3 */
-Handle<Token> Scanner::NextDecimal() {
-    Start_();
-
+Token Scanner::NextDecimal() {
     uint64_t s = 0;
     int16_t n = 0;
     int16_t k = 0;
@@ -510,11 +514,12 @@ Handle<Token> Scanner::NextDecimal() {
         Exceptions::ThrowSyntaxError("Unexpected character after number literal");
     }
 
-    Handle<JSNumber> obj = JSNumber::New(value);
-    return Wrap(new Token(Token::kNumber, 0, std::move(obj)));
+    Token tok = Wrap(Token(Token::kNumber));
+    tok.number = value;
+    return tok;
 }
 
-Handle<Token> Scanner::NextNumber() {
+Token Scanner::NextNumber() {
     if (c0_ != '0') {
         return NextDecimal();
     }
@@ -543,8 +548,8 @@ Handle<Token> Scanner::NextNumber() {
         legacy = true;
         ScanDecimal_<8>(result, length, &overflow);
     } else if (c0_ == '8' || c0_ == '9') {
-        Handle<Token> tk = NextDecimal();
-        tk->flags |= Token::kLegacy;
+        Token tk = NextDecimal();
+        tk.flags |= Token::kLegacy;
         return tk;
     } else {
         Pushback_();
@@ -555,25 +560,21 @@ Handle<Token> Scanner::NextNumber() {
         Exceptions::ThrowSyntaxError("Unexpected character after number literal");
     }
 
-    Handle<JSNumber> val;
+    double value = static_cast<double>(result);
     if (overflow) {
-        double value = static_cast<double>(result);
-        if (overflow)
-            value *= pow(static_cast<double>(base), static_cast<double>(overflow));
-        val = JSNumber::New(value);
-    } else {
-        val = JSNumber::New(static_cast<int64_t>(result));
+        value *= pow(static_cast<double>(base), static_cast<double>(overflow));
     }
 
-    return Wrap(new Token(Token::kNumber, legacy ? Token::kLegacy : 0, std::move(val)));
+    Token tok = Wrap(Token(Token::kNumber, legacy ? Token::kLegacy : 0));
+    tok.number = value;
+    return tok;
 }
 
-Handle<Token> Scanner::NextString() {
+Token Scanner::NextString(std::wstring* value) {
     int quote = c0_;
     assert(quote == '\'' || quote == '"');
     Advance_();
 
-    std::wstring value;
     uint8_t flags = 0;
 
     while (true) {
@@ -581,7 +582,7 @@ Handle<Token> Scanner::NextString() {
             case '"':
             case '\'': {
                 if (quote != c0_) {
-                    value += c0_;
+                    if (value) *value += c0_;
                     break;
                 }
                 goto finish;
@@ -602,36 +603,36 @@ Handle<Token> Scanner::NextString() {
                     case 0x2029:
                         break;
                     case '\'':
-                        value += '\'';
+                        if (value) *value += '\'';
                         break;
                     case '"':
-                        value += '"';
+                        if (value) *value += '"';
                         break;
                     case '\\':
-                        value += '\\';
+                        if (value) *value += '\\';
                         break;
                     case 'b':
-                        value += '\b';
+                        if (value) *value += '\b';
                         break;
                     case 'f':
-                        value += '\f';
+                        if (value) *value += '\f';
                         break;
                     case 'n':
-                        value += '\n';
+                        if (value) *value += '\n';
                         break;
                     case 'r':
-                        value += '\r';
+                        if (value) *value += '\r';
                         break;
                     case 't':
-                        value += '\t';
+                        if (value) *value += '\t';
                         break;
                     case 'v':
-                        value += '\v';
+                        if (value) *value += '\v';
                         break;
                     case '0': {
                         Advance_();
                         if (c0_ < '0' || c0_ > '7') {
-                            value += (wchar_t)0;
+                            if (value) *value += (wchar_t)0;
                             continue;
                         }
                         Pushback_();
@@ -648,18 +649,18 @@ Handle<Token> Scanner::NextString() {
                         Advance_();
 
                         if (c0_ < '0' || c0_ > '7') {
-                            value += val;
+                            if (value) *value += val;
                             break;
                         }
                         val = val * 8 + (c0_ - '0');
                         Advance_();
 
                         if (c0_ < '0' || c0_ > '7' || val > 040) {
-                            value += val;
+                            if (value) *value += val;
                         } else {
                             val = val * 8 + (c0_ - '0');
                             Advance_();
-                            value += val;
+                            if (value) *value += val;
                         }
                         continue;
                     }
@@ -678,14 +679,16 @@ Handle<Token> Scanner::NextString() {
                         } else {
                             Exceptions::ThrowSyntaxError("Expected hex digits in hexical escape sequence");
                         }
-                        value += val;
+                        if (value) *value += val;
                         continue;
                     }
-                    case 'u':
-                        value += NextUnicodeEscapeSequence();
+                    case 'u': {
+                        int ch = NextUnicodeEscapeSequence();
+                        if (value) *value += ch;
                         continue;
+                    }
                     default:
-                        value += c0_;
+                        if (value) *value += c0_;
                         break;
                 }
                 break;
@@ -697,45 +700,44 @@ Handle<Token> Scanner::NextString() {
             case 0x2029:
                 Exceptions::ThrowSyntaxError("String literal is not enclosed");
             default:
-                value += c0_;
+                if (value) *value += c0_;
                 break;
         }
         Advance_();
     }
 finish:
     Advance_();
-    Handle<JSString> str = JSString::New(value.c_str());
-    return Wrap(new Token(Token::kString, flags, str));
+    return Wrap(Token(Token::kString, flags));
 }
 
 /* Template Literal Lexical Components 11.8.6 */
-Handle<Token> Scanner::NextTemplate() {
+Token Scanner::NextTemplate() {
     Expect_("`");
-    Handle<Token> tok = ScanTemplateCharacters_();
+    Start_();
+    Token tok = ScanTemplateCharacters_();
     if (c0_ == '`') {
         Advance_();
     } else {
         Expect_("${");
-        tok->type = Token::kTemplateHead;
+        tok.type = Token::kTemplateHead;
     }
     return tok;
 }
 
-Handle<Token> Scanner::NextTemplatePart() {
-    Handle<Token> tok = ScanTemplateCharacters_();
+Token Scanner::NextTemplatePart() {
+    Start_();
+    Token tok = ScanTemplateCharacters_();
     if (c0_ == '`') {
         Advance_();
-        tok->type = Token::kTemplateTail;
+        tok.type = Token::kTemplateTail;
     } else {
         Expect_("${");
-        tok->type = Token::kTemplateMiddle;
+        tok.type = Token::kTemplateMiddle;
     }
     return tok;
 }
 
-Handle<Token> Scanner::ScanTemplateCharacters_() {
-    std::wstring cooked;
-    std::wstring raw;
+Token Scanner::ScanTemplateCharacters_(std::wstring* cooked, std::wstring* raw) {
     while (true) {
         switch (c0_) {
             case -1:
@@ -749,8 +751,8 @@ Handle<Token> Scanner::ScanTemplateCharacters_() {
                     Pushback_();
                     goto finish;
                 } else {
-                    cooked += '$';
-                    raw += '$';
+                    if (cooked) *cooked += '$';
+                    if (raw) *raw += '$';
                     continue;
                 }
             case '\\': {
@@ -758,7 +760,7 @@ Handle<Token> Scanner::ScanTemplateCharacters_() {
                 switch (c0_) {
                     case '\r':
                         Advance_();
-                        raw += L"\\\n";
+                        if (raw) *raw += L"\\\n";
                         if (c0_ != '\n') {
                             continue;
                         }
@@ -766,47 +768,47 @@ Handle<Token> Scanner::ScanTemplateCharacters_() {
                     case '\n':
                     case 0x2028:
                     case 0x2029:
-                        raw += '\\';
-                        raw += c0_;
+                        if (raw) *raw += '\\';
+                        if (raw) *raw += c0_;
                         break;
                     case '\'':
                     case '"':
                     case '\\':
-                        cooked += c0_;
-                        raw += '\\';
-                        raw += c0_;
+                        if (cooked) *cooked += c0_;
+                        if (raw) *raw += '\\';
+                        if (raw) *raw += c0_;
                         break;
                     case 'b':
-                        cooked += '\b';
-                        raw += L"\\b";
+                        if (cooked) *cooked += '\b';
+                        if (raw) *raw += L"\\b";
                         break;
                     case 'f':
-                        cooked += '\f';
-                        raw += L"\\f";
+                        if (cooked) *cooked += '\f';
+                        if (raw) *raw += L"\\f";
                         break;
                     case 'n':
-                        cooked += '\n';
-                        raw +=L"\\n";
+                        if (cooked) *cooked += '\n';
+                        if (raw) *raw += L"\\n";
                         break;
                     case 'r':
-                        cooked += '\r';
-                        raw +=L"\\r";
+                        if (cooked) *cooked += '\r';
+                        if (raw) *raw += L"\\r";
                         break;
                     case 't':
-                        cooked += '\t';
-                        raw +=L"\\t";
+                        if (cooked) *cooked += '\t';
+                        if (raw) *raw += L"\\t";
                         break;
                     case 'v':
-                        cooked += '\v';
-                        raw +=L"\\v";
+                        if (cooked) *cooked += '\v';
+                        if (raw) *raw += L"\\v";
                         break;
                     case '0': {
                         Advance_();
                         if (c0_ >= '0' && c0_ <= '7') {
                             Exceptions::ThrowSyntaxError("Octal escape sequences are not allowed in template literal");
                         }
-                        cooked += (wchar_t)0;
-                        raw +=L"\\0";
+                        if (cooked) *cooked += (wchar_t)0;
+                        if (raw) *raw += L"\\0";
                         continue;
                     }
                     case '1':
@@ -821,65 +823,64 @@ Handle<Token> Scanner::ScanTemplateCharacters_() {
                         char16_t val = 0;
                         Advance_();
 
-                        raw += L"\\x";
+                        if (raw) *raw += L"\\x";
                         if (IsHexDigit(c0_)) {
-                            raw += c0_;
+                            if (raw) *raw += c0_;
                             val = GetDigit(c0_);
                             Advance_();
                         } else {
                             Exceptions::ThrowSyntaxError("Expected hex digits in hexical escape sequence");
                         }
                         if (IsHexDigit(c0_)) {
-                            raw += c0_;
+                            if (raw) *raw += c0_;
                             val = val * 16 + GetDigit(c0_);
                             Advance_();
                         } else {
                             Exceptions::ThrowSyntaxError("Expected hex digits in hexical escape sequence");
                         }
-                        cooked += val;
+                        if (cooked) *cooked += val;
                         continue;
                     }
                     case 'u': {
                         int start = ptr;
-                        cooked += NextUnicodeEscapeSequence();
-                        raw += '\\';
-                        for (int i = start; i < ptr; i++) {
-                            raw += content->At(i);
+                        int ch = NextUnicodeEscapeSequence();
+                        if (cooked) *cooked += ch;
+                        if (raw) {
+                            *raw += '\\';
+                            raw->append(content.begin() + start, content.begin() + ptr);
                         }
                         continue;
                     }
                     default:
-                        cooked += c0_;
-                        raw += '\\';
-                        raw += c0_;
+                        if (cooked) *cooked += c0_;
+                        if (raw) *raw += '\\';
+                        if (raw) *raw += c0_;
                         break;
                 }
                 break;
             }
             case '\r':
                 Advance_();
-                cooked += '\n';
-                raw += '\n';
+                if (cooked) *cooked += '\n';
+                if (raw) *raw += '\n';
                 if (c0_ != '\n') {
                     continue;
                 }
                 break;
             default:
-                cooked += c0_;
-                raw += c0_;
+                if (cooked) *cooked += c0_;
+                if (raw) *raw += c0_;
                 break;
         }
         Advance_();
     }
 finish:
-    Handle<JSString> cstr = JSString::New(cooked.c_str());
-    Handle<JSString> rstr = JSString::New(raw.c_str());
-    return Wrap(new Token(Token::kNoSubTemplate, 0, cstr, rstr));
+    return Wrap(Token(Token::kNoSubTemplate));
 }
 
-Handle<Token> Scanner::NextRegexp(const Handle<Token>& div) {
+Token Scanner::NextRegexp(const Token& div) {
     size_t startPos = ptr;
-    if (div->type == Token::kDivAssign) {
+    if (div.type == Token::kDivAssign) {
         ptr--;
     }
     bool inClass = false;
@@ -941,16 +942,21 @@ scanFlags:
             break;
         }
     }
-    Handle<JSString> rstr = content->Substring(startPos, flagStart - 1);
-    Handle<JSString> fstr = content->Substring(flagStart, ptr);
-    return new Token(Token::kRegexp, 0, rstr, fstr);
+    Token tok(Token::kRegexp);
+    tok.start = startPos;
+    tok.split = flagStart;
+    tok.end = ptr;
+    return tok;
 }
 
-Handle<Token> Scanner::NextToken() {
+Token Scanner::NextToken() {
     SkipWhitespace();
+    Start_();
     switch (c0_) {
         case -1: {
-            return new Token(Token::kEOF, Token::kLineBefore);
+            Token tok(Token::kEOF, Token::kLineBefore);
+            tok.start = tok.end = ptr;
+            return tok;
         }
         case '}': // Dealing with right brace as template tail is in parser
         case '{':
@@ -965,7 +971,7 @@ Handle<Token> Scanner::NextToken() {
         case ':': {
             uint8_t ch = c0_;
             Advance_();
-            return Wrap(new Token(ch));
+            return Wrap(Token(ch));
         }
         case '.': {
             Advance_();
@@ -975,9 +981,9 @@ Handle<Token> Scanner::NextToken() {
             }
             if (LookaheadMatches_("..")) {
                 Advance_(2);
-                return Wrap(new Token(Token::kEllipse));
+                return Wrap(Token(Token::kEllipse));
             }
-            return Wrap(new Token('.'));
+            return Wrap(Token('.'));
         }
         case '<': {
             Advance_();
@@ -985,15 +991,15 @@ Handle<Token> Scanner::NextToken() {
                 Advance_();
                 if (c0_ == '=') {
                     Advance_();
-                    return Wrap(new Token(Token::kLShiftAssign));
+                    return Wrap(Token(Token::kLShiftAssign));
                 } else {
-                    return Wrap(new Token(Token::kLShift));
+                    return Wrap(Token(Token::kLShift));
                 }
             } else if (c0_ == '=') {
                 Advance_();
-                return Wrap(new Token(Token::kLteq));
+                return Wrap(Token(Token::kLteq));
             } else {
-                return Wrap(new Token('<'));
+                return Wrap(Token('<'));
             }
         }
         case '>': {
@@ -1004,28 +1010,28 @@ Handle<Token> Scanner::NextToken() {
                     Advance_();
                     if (c0_ == '=') {
                         Advance_();
-                        return Wrap(new Token(Token::kURShiftAssign));
+                        return Wrap(Token(Token::kURShiftAssign));
                     } else {
-                        return Wrap(new Token(Token::kURShift));
+                        return Wrap(Token(Token::kURShift));
                     }
                 } else if (c0_ == '=') {
                     Advance_();
-                    return Wrap(new Token(Token::kRShiftAssign));
+                    return Wrap(Token(Token::kRShiftAssign));
                 } else {
-                    return Wrap(new Token(Token::kRShift));
+                    return Wrap(Token(Token::kRShift));
                 }
             } else if (c0_ == '=') {
                 Advance_();
-                return Wrap(new Token(Token::kGteq));
+                return Wrap(Token(Token::kGteq));
             } else {
-                return Wrap(new Token('>'));
+                return Wrap(Token('>'));
             }
         }
         case '=':
             Advance_();
             if (c0_ == '>') {
                 Advance_();
-                return Wrap(new Token(Token::kLambda));
+                return Wrap(Token(Token::kLambda));
             }
             Pushback_();
         case '!': {
@@ -1035,12 +1041,12 @@ Handle<Token> Scanner::NextToken() {
                 Advance_();
                 if (c0_ == '=') {
                     Advance_();
-                    return Wrap(new Token(firstChar == '=' ? Token::kStrictEq : Token::kStrictIneq));
+                    return Wrap(Token(firstChar == '=' ? Token::kStrictEq : Token::kStrictIneq));
                 } else {
-                    return Wrap(new Token(firstChar + 0x80));
+                    return Wrap(Token(firstChar + 0x80));
                 }
             } else {
-                return Wrap(new Token(firstChar));
+                return Wrap(Token(firstChar));
             }
         }
         case '+':
@@ -1051,12 +1057,12 @@ Handle<Token> Scanner::NextToken() {
             Advance_();
             if (c0_ == firstChar) {
                 Advance_();
-                return Wrap(new Token(firstChar + 0x100));
+                return Wrap(Token(firstChar + 0x100));
             } else if (c0_ == '=') {
                 Advance_();
-                return Wrap(new Token(firstChar + 0x80));
+                return Wrap(Token(firstChar + 0x80));
             } else {
-                return Wrap(new Token(firstChar));
+                return Wrap(Token(firstChar));
             }
         }
         case '*':
@@ -1067,9 +1073,9 @@ Handle<Token> Scanner::NextToken() {
             Advance_();
             if (c0_ == '=') {
                 Advance_();
-                return Wrap(new Token(firstChar + 0x80));
+                return Wrap(Token(firstChar + 0x80));
             } else {
-                return Wrap(new Token(firstChar));
+                return Wrap(Token(firstChar));
             }
         }
         case '0':
@@ -1099,6 +1105,87 @@ Handle<Token> Scanner::NextToken() {
     }
 }
 
+template<typename F>
+void Scanner::Rescan_(const Token& tok, F func) {
+    int savedPtr = ptr;
+    int savedStart = tokenStart_;
+    bool savedLineBefore = lineBefore_;
+    ptr = tok.start;
+    Fetch_();
+    Start_();
+    func();
+    ptr = savedPtr;
+    tokenStart_ = savedStart;
+    lineBefore_ = savedLineBefore;
+    Fetch_();
+}
+
+std::wstring Scanner::Substring_(size_t start, size_t end) {
+    return std::wstring(content.begin() + start, content.begin() + end);
+}
+
+std::wstring Scanner::StringValue(const Token& tok) {
+    switch (tok.type) {
+        case Token::kString: {
+            if (!(tok.flags & Token::kEscaped)) {
+                return Substring_(tok.start + 1, tok.end - 1);
+            }
+            std::wstring value;
+            Rescan_(tok, [&]() {
+                NextString(&value);
+            });
+            return value;
+        }
+        case Token::kNoSubTemplate:
+        case Token::kTemplateHead:
+        case Token::kTemplateMiddle:
+        case Token::kTemplateTail: {
+            std::wstring cooked;
+            Rescan_(tok, [&]() {
+                ScanTemplateCharacters_(&cooked, nullptr);
+            });
+            return cooked;
+        }
+        case Token::kRegexp:
+            return Substring_(tok.start, tok.split - 1);
+        default: {
+            // Identifiers and keywords
+            if (!(tok.flags & Token::kEscaped)) {
+                return Substring_(tok.start, tok.end);
+            }
+            std::wstring value;
+            Rescan_(tok, [&]() {
+                NextIdentifierName(&value);
+            });
+            return value;
+        }
+    }
+}
+
+std::wstring Scanner::RawValue(const Token& tok) {
+    if (tok.type == Token::kRegexp) {
+        return Substring_(tok.split, tok.end);
+    }
+    std::wstring raw;
+    Rescan_(tok, [&]() {
+        ScanTemplateCharacters_(nullptr, &raw);
+    });
+    return raw;
+}
+
+bool Scanner::Matches(const Token& tok, const char* str) {
+    if (tok.flags & Token::kEscaped) {
+        return StringValue(tok) == std::wstring(str, str + strlen(str));
+    }
+    size_t length = tok.end - tok.start;
+    for (size_t i = 0; i < length; i++) {
+        if (!str[i] || content[tok.start + i] != (unsigned char)str[i]) {
+            return false;
+        }
+    }
+    return !str[length];
+}
+
 bool Scanner::IsWhitespace(int ch) {
     switch (ch) {
         case -1:
@@ -1170,6 +1257,22 @@ int Scanner::GetDigit(int ch) {
     }
 }
 
-Scanner::Scanner(const Handle<JSString>& cnt) :content(cnt) {
+Scanner::Scanner(const char16_t* text, size_t length) :content(text, length) {
+    Fetch_();
+}
+
+Scanner::Scanner(const char* text, size_t length) {
+    content.resize(length);
+    for (size_t i = 0; i < length; i++) {
+        content[i] = static_cast<unsigned char>(text[i]);
+    }
+    Fetch_();
+}
+
+Scanner::Scanner(const Handle<JSString>& cnt, size_t start, size_t end) :offset_(start) {
+    content.resize(end - start);
+    for (size_t i = start; i < end; i++) {
+        content[i - start] = cnt->At(i);
+    }
     Fetch_();
-}
\ No newline at end of file
+}
@@ -1,18 +1,24 @@
 #ifndef NORLIT_JS_GRAMMAR_LEXER_H
 #define NORLIT_JS_GRAMMAR_LEXER_H
 
+#include "Token.h"
+
 #include "../JSString.h"
 #include "../../gc/Handle.h"
 
+#include <string>
+
 namespace norlit {
 namespace js {
 namespace grammar {
 
-class Token;
-
 class Scanner {
   private:
-    gc::Handle<JSString> content;
+    // Source text copied once, so scanning neither touches the heap nor decodes short strings per
+    // character. Scanning may therefore run on any thread
+    std::u16string content;
+    // Position of content within the source
+    size_t offset_ = 0;
     int ptr = 0;
     int tokenStart_;
     bool lineBefore_ = false;
@@ -45,21 +51,33 @@ class Scanner {
     void NextHTMLOpenComment();
     void NextHTMLCloseComment();
     void SkipWhitespace();
-    gc::Handle<Token> Wrap(gc::Handle<Token>&& tok);
-    gc::Handle<Token> ScanTemplateCharacters_();
-    gc::Handle<Token> NextIdentifierName();
-    gc::Handle<Token> NextDecimal();
-    gc::Handle<Token> NextNumber();
-    gc::Handle<Token> NextString();
-    gc::Handle<Token> NextTemplate();
+    Token Wrap(Token tok);
+    Token ScanTemplateCharacters_(std::wstring* cooked = nullptr, std::wstring* raw = nullptr);
+    Token NextIdentifierName(std::wstring* value = nullptr);
+    Token NextDecimal();
+    Token NextNumber();
+    Token NextString(std::wstring* value = nullptr);
+    Token NextTemplate();
+
+    // Scan the token again from its start with the given scanning function, restoring the state afterwards
+    template<typename F>
+    void Rescan_(const Token&, F);
+    std::wstring Substring_(size_t start, size_t end);
 
   public:
-    void Dump(const gc::Handle<Token>&);
-
-    void TranslateIdentifierName(const gc::Handle<Token>&);
-    gc::Handle<Token> NextToken();
-    gc::Handle<Token> NextRegexp(const gc::Handle<Token>&);
-    gc::Handle<Token> NextTemplatePart();
+    void Dump(const Token&);
+
+    void TranslateIdentifierName(Token&);
+    Token NextToken();
+    Token NextRegexp(const Token&);
+    Token NextTemplatePart();
+
+    // Name of identifiers and keywords, cooked value of strings and templates, or body of regexps
+    std::wstring StringValue(const Token&);
+    // Raw value of templates, or flags of regexps
+    std::wstring RawValue(const Token&);
+    // Whether the identifier token has the given name, without allocating
+    bool Matches(const Token&, const char*);
   public:
     static bool IsWhitespace(int ch);
     static bool IsLineTerminator(int ch);
@@ -68,7 +86,16 @@ class Scanner {
     static bool IsHexDigit(int ch);
     static int GetDigit(int ch);
 
-    Scanner(const gc::Handle<JSString>&);
+    size_t offset() const {
+        return offset_;
+    }
+
+    // Scan the source text, which may be on any thread
+    Scanner(const char16_t*, size_t length);
+    // Same as above for one-byte text
+    Scanner(const char*, size_t length);
+    // Scan only the source range [start, end). Only on the thread running the engine
+    Scanner(const gc::Handle<JSString>&, size_t start, size_t end);
 };
 
 }
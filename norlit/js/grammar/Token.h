@@ -1,14 +1,15 @@
 #ifndef NORLIT_JS_GRAMMAR_TOKEN_H
 #define NORLIT_JS_GRAMMAR_TOKEN_H
 
-#include "../JSValue.h"
-#include "../../gc/Handle.h"
+#include <cstdint>
 
 namespace norlit {
 namespace js {
 namespace grammar {
 
-class Token: public gc::Object {
+// Tokens are plain values referring to a span of the source text. Values of identifiers and literals
+// are only copied out when the parser asks the scanner for them, see Scanner::StringValue
+class Token {
   public:
     enum {
         kEllipse = 0x200,
@@ -94,21 +95,20 @@ class Token: public gc::Object {
     };
 
   public:
-    JSValue* value = nullptr;
-    JSValue* additional = nullptr;
-    uint16_t type;
-    uint8_t flags;
+    uint16_t type = kEOF;
+    uint8_t flags = 0;
+    // Source span [start, end). For strings the quotes are included, while for templates and regexps
+    // only the characters between delimiters are
+    uint32_t start = 0;
+    uint32_t end = 0;
+    // Start of the flags of regexp literal
+    uint32_t split = 0;
+    // Value of numeric literal
+    double number = 0;
 
   public:
-    Token(uint16_t type, uint8_t flags = 0, const gc::Handle<JSValue>& value = nullptr, const gc::Handle<JSValue>& additional = nullptr) :type(type), flags(flags) {
-        WriteBarrier(&this->value, value);
-        WriteBarrier(&this->additional, additional);
-    }
-
-    virtual void IterateField(const gc::FieldIterator& iter) override final {
-        iter(&value);
-        iter(&additional);
-    }
+    Token() = default;
+    Token(uint16_t type, uint8_t flags = 0) :type(type), flags(flags) {}
 };
 
 }
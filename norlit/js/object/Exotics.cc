@@ -1,6 +1,7 @@
 #include "../all.h"
 
 #include "Exotics.h"
+#include "../../gc/Heap.h"
 
 using namespace norlit::gc;
 using namespace norlit::util;
@@ -12,6 +13,18 @@ void SymbolObject::IterateField(const FieldIterator& iter) {
     iter(&this->symbolData_);
 }
 
+void ErrorFrame::IterateField(const FieldIterator& iter) {
+    iter(&this->function_);
+    iter(&this->thisValue_);
+    iter(&this->code_);
+}
+
+void ErrorObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->stackFrames_);
+    iter(&this->stack_);
+}
+
 Optional<PropertyDescriptor> StringObject::GetOwnProperty(const Handle<JSPropertyKey>& key) {
     Handle<StringObject> self = this;
     Optional<PropertyDescriptor> desc = OrdinaryGetOwnProperty(self, key);
@@ -101,25 +114,190 @@ void StringObject::IterateField(const FieldIterator& iter) {
     iter(&this->stringData_);
 }
 
+void RegExpObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->originalSource_);
+    iter(&this->originalFlags_);
+    iter(&this->regExpMatcher_);
+}
+
+namespace {
+
+// Index of the key if it is an array index in canonical form, or -1
+int64_t ToArrayIndex(const Handle<JSPropertyKey>& P) {
+    Handle<JSString> str = Testing::CastIf<JSString>(P);
+    if (!str) {
+        return -1;
+    }
+    size_t length = str->Length();
+    if (length == 0 || length > 10 || (length > 1 && str->At(0) == '0')) {
+        return -1;
+    }
+    int64_t index = 0;
+    for (size_t i = 0; i < length; i++) {
+        char16_t ch = str->At(i);
+        if (ch < '0' || ch > '9') {
+            return -1;
+        }
+        index = index * 10 + (ch - '0');
+    }
+    return index < 0xFFFFFFFF ? index : -1;
+}
+
+// Whether defining a property with the descriptor leaves an existing element writable,
+// enumerable and configurable
+bool IsPlainElement(const PropertyDescriptor& Desc) {
+    return !Desc.IsAccessorDescriptor() &&
+           (!Desc.writable || *Desc.writable) &&
+           (!Desc.enumerable || *Desc.enumerable) &&
+           (!Desc.configurable || *Desc.configurable);
+}
+
+}
+
+ArrayObject::ArrayObject(const Handle<JSObject>& proto) : JSOrdinaryObject(proto) {
+    NoGC _;
+    this->WriteBarrier(&this->elements_, new ArrayList<JSValue>());
+}
+
+void ArrayObject::InitializeLength(uint32_t length) {
+    Handle<ArrayObject> self = this;
+    Handle<JSString> key = JSString::New("length");
+    OrdinaryDefineOwnProperty(self, key, {
+        { JSNumber::New(static_cast<int64_t>(length)) },
+        nullopt,
+        nullopt,
+        true,
+        false,
+        false
+    });
+    self->WriteBarrier(&self->lengthProperty_, self->LookupProperty(key).CastTo<DataProperty>());
+    self->length_ = length;
+}
+
+void ArrayObject::MakeSparse() {
+    Handle<ArrayObject> self = this;
+    Handle<ArrayList<JSValue>> elements = self->elements_;
+    if (!elements) {
+        return;
+    }
+    self->elements_ = nullptr;
+    for (size_t i = 0, size = elements->Size(); i < size; i++) {
+        Handle<DataProperty> prop = new DataProperty();
+        prop->value = elements->Get(i);
+        prop->writable = true;
+        prop->enumerable = true;
+        prop->configurable = true;
+        Handle<JSString> key = Conversion::ToString(JSNumber::New(static_cast<int64_t>(i)));
+        self->propKey->Add(key);
+        self->propVal->Add(prop);
+    }
+    self->InvalidateWatch();
+}
+
+bool ArrayObject::DefineLength(const PropertyDescriptor& Desc) {
+    Handle<ArrayObject> self = this;
+    if (!OrdinaryDefineOwnProperty(self, JSString::New("length"), Desc)) {
+        return false;
+    }
+    if (Desc.value) {
+        self->length_ = static_cast<uint32_t>(Conversion::ToNumberValue(*Desc.value));
+    }
+    return true;
+}
+
+void ArrayObject::SetLength(uint32_t length) {
+    length_ = length;
+    lengthProperty_->value = JSNumber::New(static_cast<int64_t>(length));
+    InvalidateWatch();
+}
+
+bool ArrayObject::AddElement(uint32_t index, const Handle<JSValue>& value) {
+    if (!elements_ || index != elements_->Size() || index == 0xFFFFFFFF || !extensible) {
+        return false;
+    }
+    if (index >= length_ && !IsLengthWritable()) {
+        return false;
+    }
+    Handle<ArrayObject> self = this;
+    self->elements_->Add(value);
+    if (index >= self->length_) {
+        self->SetLength(index + 1);
+    } else {
+        self->InvalidateWatch();
+    }
+    return true;
+}
+
+void ArrayObject::SpliceElements(uint32_t start, uint32_t deleteCount, const Handle<Array<JSValue>>& items) {
+    Handle<ArrayObject> self = this;
+    Handle<ArrayList<JSValue>> elements = self->elements_;
+    uint32_t size = static_cast<uint32_t>(elements->Size());
+    uint32_t itemCount = static_cast<uint32_t>(items->Length());
+    if (itemCount > deleteCount) {
+        uint32_t grow = itemCount - deleteCount;
+        for (uint32_t i = 0; i < grow; i++) {
+            elements->Add(nullptr);
+        }
+        for (uint32_t k = size; k > start + deleteCount; k--) {
+            elements->Set(k - 1 + grow, elements->Get(k - 1));
+        }
+    } else if (itemCount < deleteCount) {
+        uint32_t shrink = deleteCount - itemCount;
+        for (uint32_t k = start + deleteCount; k < size; k++) {
+            elements->Set(k - shrink, elements->Get(k));
+        }
+        for (uint32_t i = 0; i < shrink; i++) {
+            elements->RemoveLast();
+        }
+    }
+    for (uint32_t i = 0; i < itemCount; i++) {
+        elements->Set(start + i, items->Get(i));
+    }
+    self->SetLength(static_cast<uint32_t>(elements->Size()));
+}
+
+Optional<PropertyDescriptor> ArrayObject::GetOwnProperty(const Handle<JSPropertyKey>& P) {
+    Handle<ArrayObject> self = this;
+    if (self->elements_) {
+        int64_t index = ToArrayIndex(P);
+        if (index != -1) {
+            if (index >= self->DenseSize()) {
+                return nullopt;
+            }
+            return PropertyDescriptor{
+                { self->GetElement(static_cast<uint32_t>(index)) },
+                nullopt,
+                nullopt,
+                true,
+                true,
+                true
+            };
+        }
+    }
+    return OrdinaryGetOwnProperty(self, P);
+}
+
+// 9.4.2.1 [[DefineOwnProperty]]
 bool ArrayObject::DefineOwnProperty(const Handle<JSPropertyKey>& P, const PropertyDescriptor& Desc) {
     Handle<ArrayObject> self = this;
     if (P == JSString::New("length")) {
+        // 9.4.2.4 ArraySetLength
         if (!Desc.value) {
-            return OrdinaryDefineOwnProperty(self, P, Desc);
+            return self->DefineLength(Desc);
         }
         PropertyDescriptor newLenDesc = Desc;
-        int64_t newLen = Conversion::ToUInt32(Conversion::ToNumber(*Desc.value));
+        uint32_t newLen = Conversion::ToUInt32(Conversion::ToNumber(*Desc.value));
         double numberLen = Conversion::ToNumberValue(*Desc.value);
         if (newLen != numberLen) {
-            throw "Throw range error";
+            Exceptions::ThrowRangeError("Invalid array length");
         }
-        newLenDesc.value = JSNumber::New(newLen);
-        Optional<PropertyDescriptor> oldLenDesc = OrdinaryGetOwnProperty(self, P);
-        int64_t oldLen = Conversion::ToUInt32(Conversion::ToNumber(*Desc.value));
+        newLenDesc.value = JSNumber::New(static_cast<int64_t>(newLen));
+        uint32_t oldLen = self->length_;
         if (newLen >= oldLen) {
-            return OrdinaryDefineOwnProperty(self, P, newLenDesc);
+            return self->DefineLength(newLenDesc);
         }
-        if (!*oldLenDesc->writable) {
+        if (!self->IsLengthWritable()) {
             return false;
         }
         bool newWritable;
@@ -130,23 +308,30 @@ bool ArrayObject::DefineOwnProperty(const Handle<JSPropertyKey>& P, const Proper
             newLenDesc.writable = true;
         }
 
-        bool succeeded = OrdinaryDefineOwnProperty(self, P, newLenDesc);
+        bool succeeded = self->DefineLength(newLenDesc);
         if (!succeeded) return false;
+        if (self->elements_) {
+            // Elements in the backing store are all configurable, and there are no others
+            while (self->elements_->Size() > newLen) {
+                self->elements_->RemoveLast();
+            }
+            oldLen = newLen;
+        }
         while (newLen < oldLen) {
             oldLen--;
-            Handle<JSString> key = Conversion::ToString(JSNumber::New(oldLen));
+            Handle<JSString> key = Conversion::ToString(JSNumber::New(static_cast<int64_t>(oldLen)));
             bool deleteSucceeded = self->Delete(key);
             if (deleteSucceeded == false) {
-                newLenDesc.value = JSNumber::New(oldLen + 1);
+                newLenDesc.value = JSNumber::New(static_cast<int64_t>(oldLen) + 1);
                 if (!newWritable) {
                     newLenDesc.writable = false;
                 }
-                OrdinaryDefineOwnProperty(self, P, newLenDesc);
+                self->DefineLength(newLenDesc);
                 return false;
             }
         }
         if (newWritable == false) {
-            OrdinaryDefineOwnProperty(self, P, {
+            self->DefineLength({
                 nullopt,
                 nullopt,
                 nullopt,
@@ -156,25 +341,115 @@ bool ArrayObject::DefineOwnProperty(const Handle<JSPropertyKey>& P, const Proper
             });
         }
         return true;
-    } else {
-        int64_t PAsIndex = Conversion::ToIntegerIndex(P);
-        if (PAsIndex != -1 && PAsIndex < 0xFFFFFFFF) {
-            Optional<PropertyDescriptor> oldLenDesc = OrdinaryGetOwnProperty(self, JSString::New("length"));
-            uint32_t oldLen = Conversion::ToUInt32(Conversion::ToNumber(*oldLenDesc->value));
-            if (PAsIndex >= oldLen && *oldLenDesc->writable == false) {
-                return false;
+    }
+
+    int64_t index = ToArrayIndex(P);
+    if (index == -1) {
+        return OrdinaryDefineOwnProperty(self, P, Desc);
+    }
+    if (self->elements_) {
+        uint32_t size = self->DenseSize();
+        if (IsPlainElement(Desc)) {
+            if (index < size) {
+                if (Desc.value) {
+                    self->SetElement(static_cast<uint32_t>(index), *Desc.value);
+                }
+                return true;
             }
-            bool succeeded = OrdinaryDefineOwnProperty(self, P, Desc);
-            if (!succeeded)return succeeded;
-            if (PAsIndex >= oldLen) {
-                oldLenDesc->value = JSNumber::New(PAsIndex + 1);
-                OrdinaryDefineOwnProperty(self, JSString::New("length"), *oldLenDesc);
+            // Attributes absent from the descriptor of a new property default to false
+            if (index == size && Desc.writable && Desc.enumerable && Desc.configurable) {
+                // Fails only where an ordinary definition would fail as well
+                return self->AddElement(static_cast<uint32_t>(index), Desc.value ? *Desc.value : nullptr);
+            }
+        }
+        self->MakeSparse();
+    }
+    if (index >= self->length_ && !self->IsLengthWritable()) {
+        return false;
+    }
+    bool succeeded = OrdinaryDefineOwnProperty(self, P, Desc);
+    if (!succeeded) return succeeded;
+    if (index >= self->length_) {
+        self->SetLength(static_cast<uint32_t>(index + 1));
+    }
+    return true;
+}
+
+bool ArrayObject::HasProperty(const Handle<JSPropertyKey>& P) {
+    Handle<ArrayObject> self = this;
+    if (self->elements_) {
+        int64_t index = ToArrayIndex(P);
+        if (index != -1 && index < self->DenseSize()) {
+            return true;
+        }
+    }
+    return OrdinaryHasProperty(self, P);
+}
+
+Handle<JSValue> ArrayObject::Get(const Handle<JSPropertyKey>& P, const Handle<JSValue>& Receiver) {
+    if (elements_) {
+        int64_t index = ToArrayIndex(P);
+        if (index != -1 && index < DenseSize()) {
+            return GetElement(static_cast<uint32_t>(index));
+        }
+    }
+    return JSOrdinaryObject::Get(P, Receiver);
+}
+
+bool ArrayObject::Set(const Handle<JSPropertyKey>& P, const Handle<JSValue>& V, const Handle<JSValue>& Receiver) {
+    // An existing element is a writable data property, so setting it on the array itself only
+    // replaces its value
+    if (elements_ && Receiver == this) {
+        int64_t index = ToArrayIndex(P);
+        if (index != -1 && index < DenseSize()) {
+            SetElement(static_cast<uint32_t>(index), V);
+            return true;
+        }
+    }
+    return JSOrdinaryObject::Set(P, V, Receiver);
+}
+
+bool ArrayObject::Delete(const Handle<JSPropertyKey>& P) {
+    Handle<ArrayObject> self = this;
+    if (self->elements_) {
+        int64_t index = ToArrayIndex(P);
+        if (index != -1) {
+            uint32_t size = self->DenseSize();
+            if (index >= size) {
                 return true;
             }
+            if (index == size - 1) {
+                self->elements_->RemoveLast();
+                self->InvalidateWatch();
+                return true;
+            }
+            self->MakeSparse();
         }
     }
-    return OrdinaryDefineOwnProperty(self, P, Desc);
+    return JSOrdinaryObject::Delete(P);
+}
 
+Handle<Array<JSPropertyKey>> ArrayObject::OwnPropertyKeys() {
+    Handle<ArrayObject> self = this;
+    Handle<Array<JSPropertyKey>> keys = JSOrdinaryObject::OwnPropertyKeys();
+    if (!self->elements_) {
+        return keys;
+    }
+    // Elements in the backing store are the only integer indexes, so they come first
+    ArrayList<JSPropertyKey> list;
+    for (size_t i = 0, size = self->DenseSize(); i < size; i++) {
+        list.Add(Conversion::ToString(JSNumber::New(static_cast<int64_t>(i))));
+    }
+    for (size_t i = 0, size = keys->Length(); i < size; i++) {
+        list.Add(keys->Get(i));
+    }
+    return list.ToArray();
+}
+
+void ArrayObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->elements_);
+    iter(&this->lengthProperty_);
 }
 
 void ArrayIteratorObject::IterateField(const FieldIterator& iter) {
@@ -182,6 +457,37 @@ void ArrayIteratorObject::IterateField(const FieldIterator& iter) {
     iter(&this->iteratedObject_);
 }
 
+void MapObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->mapData_);
+}
+
+void MapIteratorObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->iteratedTable_);
+}
+
+void SetObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->setData_);
+}
+
+void SetIteratorObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->iteratedTable_);
+}
+
+void ForInIteratorObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->enumeratedObject_);
+    iter(&this->enumeratedKeys_);
+}
+
+void WeakSetObject::IterateField(const FieldIterator& iter) {
+    JSOrdinaryObject::IterateField(iter);
+    iter(&this->weakSetData_);
+}
+
 void GeneratorObject::IterateField(const FieldIterator& iter) {
     JSOrdinaryObject::IterateField(iter);
     iter(&this->generatorContext_);
@@ -3,9 +3,17 @@
 
 #include "../common.h"
 #include "JSOrdinaryObject.h"
+#include "../OrderedHashTable.h"
+#include "../regexp/Program.h"
+#include "../../util/HashMap.h"
 
 namespace norlit {
 namespace js {
+
+namespace bytecode {
+class Code;
+}
+
 namespace object {
 
 class BooleanObject final : public JSOrdinaryObject {
@@ -38,9 +46,27 @@ class SymbolObject final : public JSOrdinaryObject {
     virtual void IterateField(const gc::FieldIterator& iter);
 };
 
+// Frame of the context stack captured when an error is created
+class ErrorFrame final : public gc::Object {
+    NORLIT_DEFINE_FIELD(ESFunctionBase, function);
+    NORLIT_DEFINE_FIELD(JSValue, thisValue);
+    // Code and offset being executed, or null if the frame does not run bytecode
+    NORLIT_DEFINE_FIELD(bytecode::Code, code);
+    NORLIT_DEFINE_FIELD_POD(size_t, pc);
+  public:
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
 class ErrorObject final : public JSOrdinaryObject {
+    // Only the frames are captured on creation. They are formatted into the stack trace when it is first
+    // read, after which they are dropped
+    NORLIT_DEFINE_FIELD(gc::Array<ErrorFrame>, stackFrames);
+    // First line of the stack trace until it is formatted, then the whole trace
+    NORLIT_DEFINE_FIELD(JSString, stack);
   public:
     ErrorObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
 };
 
 class NumberObject final : public JSOrdinaryObject {
@@ -91,17 +117,118 @@ class StringObject final : public JSOrdinaryObject {
 };
 
 class RegExpObject final : public JSOrdinaryObject {
+    JSString* originalSource_ = nullptr;
+    JSString* originalFlags_ = nullptr;
+    regexp::Program* regExpMatcher_ = nullptr;
   public:
     RegExpObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
 
-    // TODO
+    gc::Handle<JSString> originalSource() const {
+        return originalSource_;
+    }
+
+    void originalSource(const gc::Handle<JSString>& data) {
+        this->WriteBarrier(&this->originalSource_, data);
+    }
+
+    gc::Handle<JSString> originalFlags() const {
+        return originalFlags_;
+    }
+
+    void originalFlags(const gc::Handle<JSString>& data) {
+        this->WriteBarrier(&this->originalFlags_, data);
+    }
+
+    gc::Handle<regexp::Program> regExpMatcher() const {
+        return regExpMatcher_;
+    }
+
+    void regExpMatcher(const gc::Handle<regexp::Program>& data) {
+        this->WriteBarrier(&this->regExpMatcher_, data);
+    }
+
+    // Whether lastIndex is the only own property, so every other property lookup reaches the prototype
+    bool HasOnlyLastIndex() {
+        return propKey->Size() == 1;
+    }
+
+    virtual void IterateField(const gc::FieldIterator&) override;
 };
 
+// Elements of an array are kept in a backing store while the array is dense: every index below
+// the size of the store is present, no index at or above it is, and all elements are writable,
+// enumerable and configurable data properties. Any change that breaks this moves the elements into
+// ordinary properties for good.
 class ArrayObject final : public JSOrdinaryObject {
+    // Null once the array is sparse
+    util::ArrayList<JSValue>* elements_ = nullptr;
+    // The "length" property, which is never removed or replaced, and its value
+    DataProperty* lengthProperty_ = nullptr;
+    uint32_t length_ = 0;
+
+    void MakeSparse();
+    bool DefineLength(const PropertyDescriptor&);
+    void SetLength(uint32_t length);
   public:
-    ArrayObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+    ArrayObject(const gc::Handle<JSObject>& proto);
+
+    // Define the "length" property of a newly created array
+    void InitializeLength(uint32_t length);
+
+    uint32_t length() const {
+        return length_;
+    }
+
+    bool IsLengthWritable() const {
+        return lengthProperty_->writable;
+    }
+
+    bool IsDense() const {
+        return elements_ != nullptr;
+    }
+
+    // Whether every element below length is in the backing store, so elements can be read from and
+    // written to the store directly
+    bool IsPacked() const {
+        return elements_ && elements_->Size() == length_;
+    }
+
+    // Number of elements in the backing store. Only valid while dense
+    uint32_t DenseSize() const {
+        return static_cast<uint32_t>(elements_->Size());
+    }
+
+    gc::Handle<JSValue> GetElement(uint32_t index) const {
+        return elements_->Get(index);
+    }
+
+    void SetElement(uint32_t index, const gc::Handle<JSValue>& value) {
+        elements_->Set(index, value);
+        InvalidateWatch();
+    }
+
+    // Whether elements can be appended to the backing store
+    bool CanAppend() const {
+        return IsPacked() && extensible && IsLengthWritable() && length_ != 0xFFFFFFFF;
+    }
+
+    // Add an element at index DenseSize() as CreateDataProperty would, updating length if needed.
+    // Returns false without doing anything if the array is sparse, index is not DenseSize(), or the
+    // element cannot be added to the backing store
+    bool AddElement(uint32_t index, const gc::Handle<JSValue>& value);
+    // Replace the elements of a packed array in [start, start + deleteCount) with items, updating
+    // length. Requires the array to be packed and have a writable length, and to be extensible if it
+    // grows
+    void SpliceElements(uint32_t start, uint32_t deleteCount, const gc::Handle<gc::Array<JSValue>>& items);
 
+    virtual util::Optional<PropertyDescriptor> GetOwnProperty(const gc::Handle<JSPropertyKey>&) override;
     virtual bool DefineOwnProperty(const gc::Handle<JSPropertyKey>&, const PropertyDescriptor&) override;
+    virtual bool HasProperty(const gc::Handle<JSPropertyKey>&) override;
+    virtual gc::Handle<JSValue> Get(const gc::Handle<JSPropertyKey>&, const gc::Handle<JSValue>&) override;
+    virtual bool Set(const gc::Handle<JSPropertyKey>&, const gc::Handle<JSValue>&, const gc::Handle<JSValue>&) override;
+    virtual bool Delete(const gc::Handle<JSPropertyKey>&) override;
+    virtual gc::Handle<gc::Array<JSPropertyKey>> OwnPropertyKeys() override;
+    virtual void IterateField(const gc::FieldIterator&) override;
 };
 
 class ArrayIteratorObject final : public JSOrdinaryObject {
@@ -145,6 +272,81 @@ class ArrayIteratorObject final : public JSOrdinaryObject {
     virtual void IterateField(const gc::FieldIterator&) override;
 };
 
+class MapObject final : public JSOrdinaryObject {
+    NORLIT_DEFINE_FIELD(OrderedHashTable, mapData);
+  public:
+    MapObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+// Iterators refer to the table rather than the map, as the table forwards to its replacement
+class MapIteratorObject final : public JSOrdinaryObject {
+  public:
+    using IterationKind = ArrayIteratorObject::IterationKind;
+
+    NORLIT_DEFINE_FIELD(OrderedHashTable, iteratedTable);
+    NORLIT_DEFINE_FIELD_POD(uint32_t, mapNextIndex);
+    NORLIT_DEFINE_FIELD_POD(IterationKind, mapIterationKind);
+  public:
+    MapIteratorObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+class SetObject final : public JSOrdinaryObject {
+    NORLIT_DEFINE_FIELD(OrderedHashTable, setData);
+  public:
+    SetObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+class SetIteratorObject final : public JSOrdinaryObject {
+  public:
+    using IterationKind = ArrayIteratorObject::IterationKind;
+
+    NORLIT_DEFINE_FIELD(OrderedHashTable, iteratedTable);
+    NORLIT_DEFINE_FIELD_POD(uint32_t, setNextIndex);
+    NORLIT_DEFINE_FIELD_POD(IterationKind, setIterationKind);
+  public:
+    SetIteratorObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+// Enumerator of a for-in statement. It is created without a prototype and only stepped by
+// Iterators::IteratorStepValue, so script can neither observe nor replace its next method
+class ForInIteratorObject final : public JSOrdinaryObject {
+    NORLIT_DEFINE_FIELD(JSObject, enumeratedObject);
+    NORLIT_DEFINE_FIELD(gc::Array<JSPropertyKey>, enumeratedKeys);
+    NORLIT_DEFINE_FIELD_POD(uint32_t, enumerateNextIndex);
+  public:
+    ForInIteratorObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+// Keys are held weakly and values strongly. Only suits WeakSet, whose values never refer to anything
+using WeakTable = util::HashMap<JSObject, JSValue, true>;
+
+// A WeakMap has no storage of its own. Each value is stored in its key, in a table keyed weakly by the map,
+// so the value is only reachable through the key. An entry whose value refers to its own key is therefore
+// collected with the key, as ephemeron semantics require. An entry of a collected map keeps its value
+// alive until the table of the key is next accessed
+class WeakMapObject final : public JSOrdinaryObject {
+  public:
+    WeakMapObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+};
+
+class WeakSetObject final : public JSOrdinaryObject {
+    NORLIT_DEFINE_FIELD(WeakTable, weakSetData);
+  public:
+    WeakSetObject(const gc::Handle<JSObject>& proto) :JSOrdinaryObject(proto) {}
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
 class GeneratorObject final: public JSOrdinaryObject {
   public:
     enum class GeneratorState {
@@ -5,6 +5,7 @@
 
 #include "../vm/Realm.h"
 #include "../vm/Context.h"
+#include "../bytecode/Code.h"
 
 #include "../../gc/Heap.h"
 
@@ -42,12 +43,20 @@ void ESFunction::IterateField(const FieldIterator& iter) {
 }
 
 
+void ESFunction::EnsureCompiled() {
+    Handle<bytecode::Code> code = this->code_;
+    if (!code->IsCompiled()) {
+        code->Compile();
+    }
+}
+
 Handle<JSValue> ESFunction::Call(const Handle<JSValue>& that, const Handle<Array<JSValue>>& args) {
     Handle<ESFunction> self = this;
     if (self->functionKind_ == FunctionKind::kClassConstructor) {
         Exceptions::ThrowTypeError("Class constructors cannot be invoked without 'new'");
     }
 
+    self->EnsureCompiled();
     Handle<FunctionEnvironment> funcEnv = new FunctionEnvironment(self, nullptr);
     Handle<BytecodeContext> ctx = new BytecodeContext(funcEnv, funcEnv, self->realm_, self, self->code_);
     if (self->thisMode() != ThisMode::kLexical) {
@@ -89,6 +98,7 @@ Handle<JSObject> ESFunction::Construct(const Handle<Array<JSValue>>& args, const
         thisArgument = Objects::OrdinaryCreateFromConstructor(target, &Realm::ObjectPrototype);
     }
 
+    self->EnsureCompiled();
     Handle<FunctionEnvironment> funcEnv = new FunctionEnvironment(self, nullptr);
     Handle<BytecodeContext> ctx = new BytecodeContext(funcEnv, funcEnv, self->realm_, self, self->code_);
 
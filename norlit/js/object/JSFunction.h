@@ -62,6 +62,9 @@ class ESFunction : public ESFunctionBase {
   public:
     ESFunction(const gc::Handle<JSObject>& proto, const gc::Handle<vm::Realm>& realm) :ESFunctionBase(proto, realm) {}
 
+    // Compile the code of a pre-parsed function before its first run
+    void EnsureCompiled();
+
     virtual gc::Handle<JSValue> Call(const gc::Handle<JSValue>&, const gc::Handle<gc::Array<JSValue>>&) override;
     virtual gc::Handle<JSObject> Construct(const gc::Handle<gc::Array<JSValue>>&, const gc::Handle<JSObject>&) override;
     virtual void IterateField(const gc::FieldIterator&) override;
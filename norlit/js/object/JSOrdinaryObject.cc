@@ -70,6 +70,7 @@ bool JSOrdinaryObject::SetPrototypeOf(const Handle<JSObject>& V) {
         p = ordinaryP->prototype_;
     }
     self->prototype_ = V;
+    self->InvalidateWatch();
     return true;
 }
 
@@ -146,6 +147,7 @@ bool JSOrdinaryObject::ValidateAndApplyPropertyDescriptor(
             property->configurable = Desc.configurable ? *Desc.configurable : false;
             O->propKey->Add(P);
             O->propVal->Add(property);
+            O->InvalidateWatch();
         }
         return true;
     }
@@ -208,6 +210,7 @@ bool JSOrdinaryObject::ValidateAndApplyPropertyDescriptor(
         }
         if (Desc.configurable)prop->configurable = *Desc.configurable;
         if (Desc.enumerable)prop->enumerable = *Desc.enumerable;
+        O->InvalidateWatch();
     }
     return true;
 }
@@ -306,6 +309,7 @@ bool JSOrdinaryObject::Delete(const Handle<JSPropertyKey>& P) {
         int index = self->LookupPropertyId(P);
         self->propKey->Remove(index);
         self->propVal->Remove(index);
+        self->InvalidateWatch();
         return true;
     } else {
         return false;
@@ -352,8 +356,19 @@ Handle<Array<JSPropertyKey>> JSOrdinaryObject::OwnPropertyKeys() {
     return list.ToArray();
 }
 
+Handle<HashMap<JSObject, JSValue, true>> JSOrdinaryObject::WeakMapValues(bool create) {
+    if (!weakMapValues && create) {
+        Handle<JSOrdinaryObject> self = this;
+        Handle<HashMap<JSObject, JSValue, true>> values = new HashMap<JSObject, JSValue, true>();
+        self->WriteBarrier(&self->weakMapValues, values);
+        return values;
+    }
+    return weakMapValues;
+}
+
 void JSOrdinaryObject::IterateField(const FieldIterator& callback) {
     callback(&propKey);
     callback(&propVal);
     callback(&prototype_);
+    callback(&weakMapValues);
 }
\ No newline at end of file
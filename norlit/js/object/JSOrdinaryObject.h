@@ -3,6 +3,7 @@
 
 #include "JSObject.h"
 #include "../../util/ArrayList.h"
+#include "../../util/HashMap.h"
 
 namespace norlit {
 namespace js {
@@ -17,12 +18,49 @@ class JSOrdinaryObject : public JSObject {
     JSObject* prototype_ = nullptr;
     bool extensible = true;
 
+    // Values this object is mapped to by WeakMaps, keyed weakly by the map. See WeakMapObject
+    util::HashMap<JSObject, JSValue, true>* weakMapValues = nullptr;
+
+    // Watchpoint used by the VM to guard fast paths that assume an intrinsic is unmodified
+    enum class WatchState : uint8_t {
+        kUnwatched,
+        kIntact,
+        kInvalidated
+    };
+    WatchState watchState = WatchState::kUnwatched;
+
+    void InvalidateWatch() {
+        if (watchState == WatchState::kIntact) {
+            watchState = WatchState::kInvalidated;
+        }
+    }
+
     int LookupPropertyId(const gc::Handle<JSPropertyKey>&);
     gc::Handle<Property> LookupProperty(const gc::Handle<JSPropertyKey>&);
 
   public:
     JSOrdinaryObject(const gc::Handle<JSObject>&);
 
+    // Start watching this object. Any later change to its properties or prototype invalidates the watchpoint.
+    void Watch() {
+        if (watchState == WatchState::kUnwatched) {
+            watchState = WatchState::kIntact;
+        }
+    }
+
+    bool IsWatchIntact() const {
+        return watchState == WatchState::kIntact;
+    }
+
+    // Values this object is mapped to by WeakMaps. Null until the object is first used as a key, unless create
+    gc::Handle<util::HashMap<JSObject, JSValue, true>> WeakMapValues(bool create);
+
+    // Whether the property table holds key, without going through any overridden internal method.
+    // Exotic objects keep indexed properties elsewhere, so this is only meaningful for other keys
+    bool HasStoredProperty(const gc::Handle<JSPropertyKey>& key) {
+        return LookupPropertyId(key) != -1;
+    }
+
   public:
     /* 7.3.4 CreateDataProperty */
     static bool CreateDataProperty(const gc::Handle<JSObject>&, const gc::Handle<JSPropertyKey>&, const gc::Handle<JSValue>&);
@@ -0,0 +1,1039 @@
+#include "Compiler.h"
+#include "Opcode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::regexp;
+
+namespace {
+
+enum NodeType {
+    kEmpty,
+    kChar,
+    kClass,
+    kAny,
+    kAlternation,
+    kSequence,
+    kGroup,
+    kRepeat,
+    kAssertion,
+    kBackref,
+    kLookahead,
+};
+
+const uint32_t kInfinity = static_cast<uint32_t>(-1);
+const uint32_t kNoRegister = static_cast<uint32_t>(-1);
+// Repetitions are expanded into copies of their body, which must not get out of hand
+const size_t kMaxCodeSize = 1 << 22;
+
+bool IsDigit(uint32_t ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+bool IsOctalDigit(uint32_t ch) {
+    return ch >= '0' && ch <= '7';
+}
+
+int HexValue(uint32_t ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+bool IsSyntaxCharacter(uint32_t ch) {
+    return ch && ch < 0x80 && strchr("^$\\.*+?()[]{}|/", static_cast<int>(ch));
+}
+
+bool IsLeadSurrogate(uint32_t ch) {
+    return ch >= 0xD800 && ch <= 0xDBFF;
+}
+
+bool IsTrailSurrogate(uint32_t ch) {
+    return ch >= 0xDC00 && ch <= 0xDFFF;
+}
+
+// Simple uppercase mapping of the scripts with case that are common in practice
+uint32_t ToUpper(uint32_t ch) {
+    if (ch < 0x80) {
+        return ch >= 'a' && ch <= 'z' ? ch - 32 : ch;
+    }
+    if (ch < 0x100) {
+        if (ch == 0xB5) return 0x39C;
+        if (ch == 0xFF) return 0x178;
+        return ch >= 0xE0 && ch != 0xF7 && ch != 0xFF ? ch - 32 : ch;
+    }
+    if (ch < 0x180) {
+        if (ch == 0x131) return 'I';
+        if (ch == 0x17F) return 'S';
+        // Pairs of upper and lower case letters, aligned differently in each part of the block
+        if ((ch >= 0x100 && ch <= 0x12F) || (ch >= 0x132 && ch <= 0x137) || (ch >= 0x14A && ch <= 0x177)) {
+            return ch & ~1u;
+        }
+        if ((ch >= 0x139 && ch <= 0x148) || (ch >= 0x179 && ch <= 0x17E)) {
+            return ch & 1 ? ch : ch - 1;
+        }
+        return ch;
+    }
+    if (ch >= 0x3AC && ch <= 0x3CE) {
+        if (ch == 0x3AC) return 0x386;
+        if (ch <= 0x3AF) return ch - 37;
+        if (ch == 0x3C2) return 0x3A3;
+        if (ch >= 0x3B1 && ch <= 0x3CB) return ch - 32;
+        if (ch == 0x3CC) return 0x38C;
+        if (ch >= 0x3CD) return ch - 63;
+        return ch;
+    }
+    if (ch >= 0x430 && ch <= 0x44F) return ch - 32;
+    if (ch >= 0x450 && ch <= 0x45F) return ch - 80;
+    if ((ch >= 0x460 && ch <= 0x481) || (ch >= 0x48A && ch <= 0x4BF) || (ch >= 0x4D0 && ch <= 0x52F)) {
+        return ch & ~1u;
+    }
+    if (ch >= 0x561 && ch <= 0x586) return ch - 48;
+    if ((ch >= 0x1E00 && ch <= 0x1E95) || (ch >= 0x1EA0 && ch <= 0x1EFF)) {
+        return ch & ~1u;
+    }
+    if (ch >= 0x2170 && ch <= 0x217F) return ch - 16;
+    if (ch >= 0x24D0 && ch <= 0x24E9) return ch - 26;
+    if (ch >= 0xFF41 && ch <= 0xFF5A) return ch - 32;
+    return ch;
+}
+
+// Pairs of canonical value and another character canonicalized to it, sorted
+const std::vector<std::pair<uint32_t, uint32_t>>& CaseVariants() {
+    static std::vector<std::pair<uint32_t, uint32_t>> variants = [] {
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        for (uint32_t ch = 0; ch <= 0xFFFF; ch++) {
+            uint32_t canon = Compiler::Canonicalize(ch);
+            if (canon != ch) {
+                result.emplace_back(canon, ch);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }();
+    return variants;
+}
+
+bool HasCaseVariants(uint32_t ch) {
+    if (Compiler::Canonicalize(ch) != ch) {
+        return true;
+    }
+    const auto& variants = CaseVariants();
+    auto it = std::lower_bound(variants.begin(), variants.end(), std::make_pair(ch, 0u));
+    return it != variants.end() && it->first == ch;
+}
+
+void Normalize(std::vector<std::pair<uint32_t, uint32_t>>& ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    size_t size = 0;
+    for (const auto& range : ranges) {
+        if (size && range.first <= ranges[size - 1].second + 1) {
+            ranges[size - 1].second = std::max(ranges[size - 1].second, range.second);
+        } else {
+            ranges[size++] = range;
+        }
+    }
+    ranges.resize(size);
+}
+
+bool Contains(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint32_t ch) {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), std::make_pair(ch, kInfinity));
+    return it != ranges.begin() && (--it)->second >= ch;
+}
+
+}
+
+struct Compiler::Node {
+    int type;
+    // Character, class offset, group, opcode of an assertion or register of a repetition
+    uint32_t value = 0;
+    uint32_t min = 0;
+    uint32_t max = 0;
+    // Greedy for repetitions, negative for lookaheads
+    bool flag = false;
+    // Groups [firstGroup, lastGroup) are inside a repetition
+    uint32_t firstGroup = 0;
+    uint32_t lastGroup = 0;
+    std::vector<size_t> children;
+};
+
+uint32_t Compiler::Canonicalize(uint32_t ch) {
+    uint32_t upper = ToUpper(ch);
+    // Characters outside ASCII are never mapped into it
+    if (ch >= 0x80 && upper < 0x80) {
+        return ch;
+    }
+    return upper;
+}
+
+Compiler::Compiler(const std::u16string& source, uint8_t flags) :
+    source_(source), flags_(flags), unicode_(flags & Program::kUnicode), ignoreCase_(flags & Program::kIgnoreCase) {
+}
+
+void Compiler::Error(const char* message) {
+    std::string text = "Invalid regular expression: ";
+    text += message;
+    Exceptions::ThrowSyntaxError(text.c_str());
+}
+
+size_t Compiler::NewNode(int type) {
+    nodes_.emplace_back();
+    nodes_.back().type = type;
+    return nodes_.size() - 1;
+}
+
+/* Parsing */
+
+bool Compiler::AtEnd() const {
+    return pos_ >= source_.size();
+}
+
+uint32_t Compiler::Peek() const {
+    return AtEnd() ? 0 : source_[pos_];
+}
+
+// With the unicode flag a surrogate pair is read as one code point
+uint32_t Compiler::Next() {
+    if (AtEnd()) {
+        Error("Unexpected end of pattern");
+    }
+    uint32_t ch = source_[pos_++];
+    if (unicode_ && IsLeadSurrogate(ch) && !AtEnd() && IsTrailSurrogate(source_[pos_])) {
+        ch = 0x10000 + ((ch - 0xD800) << 10) + (source_[pos_++] - 0xDC00);
+    }
+    return ch;
+}
+
+bool Compiler::Consume(uint32_t ch) {
+    if (!AtEnd() && source_[pos_] == ch) {
+        pos_++;
+        return true;
+    }
+    return false;
+}
+
+// Backreferences may refer to groups opened later, so groups are counted before parsing
+void Compiler::CountGroups() {
+    bool inClass = false;
+    for (size_t i = 0; i < source_.size(); i++) {
+        switch (source_[i]) {
+            case '\\':
+                i++;
+                break;
+            case '[':
+                inClass = true;
+                break;
+            case ']':
+                inClass = false;
+                break;
+            case '(':
+                if (!inClass && (i + 1 >= source_.size() || source_[i + 1] != '?')) {
+                    groupCount_++;
+                }
+                break;
+        }
+    }
+}
+
+size_t Compiler::ParseDisjunction() {
+    size_t first = ParseAlternative();
+    if (Peek() != '|' || AtEnd()) {
+        return first;
+    }
+    size_t alternation = NewNode(kAlternation);
+    nodes_[alternation].children.push_back(first);
+    while (Consume('|')) {
+        size_t alternative = ParseAlternative();
+        nodes_[alternation].children.push_back(alternative);
+    }
+    return alternation;
+}
+
+size_t Compiler::ParseAlternative() {
+    size_t sequence = NewNode(kSequence);
+    while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+        ParseTerm(sequence);
+    }
+    if (nodes_[sequence].children.size() == 1) {
+        return nodes_[sequence].children[0];
+    }
+    return sequence;
+}
+
+void Compiler::ParseTerm(size_t sequence) {
+    uint32_t firstGroup = static_cast<uint32_t>(parsedGroups_ + 1);
+    size_t atom;
+    bool quantifiable = true;
+    switch (Peek()) {
+        case '^':
+        case '$': {
+            bool start = Next() == '^';
+            atom = NewNode(kAssertion);
+            bool multiline = flags_ & Program::kMultiline;
+            Opcode op = start ? (multiline ? Opcode::kLineStart : Opcode::kInputStart) : (multiline ? Opcode::kLineEnd : Opcode::kInputEnd);
+            nodes_[atom].value = static_cast<uint32_t>(op);
+            quantifiable = false;
+            break;
+        }
+        case '\\': {
+            Next();
+            if (Peek() == 'b' || Peek() == 'B') {
+                atom = NewNode(kAssertion);
+                nodes_[atom].value = static_cast<uint32_t>(Next() == 'b' ? Opcode::kWordBoundary : Opcode::kNotWordBoundary);
+                quantifiable = false;
+            } else {
+                atom = ParseAtomEscape();
+            }
+            break;
+        }
+        case '(': {
+            Next();
+            if (Consume('?')) {
+                if (Peek() == '=' || Peek() == '!') {
+                    bool negative = Next() == '!';
+                    atom = NewNode(kLookahead);
+                    size_t body = ParseDisjunction();
+                    nodes_[atom].flag = negative;
+                    nodes_[atom].children.push_back(body);
+                    hasLookaheads_ = true;
+                    // Annex B allows quantified lookaheads without the unicode flag
+                    quantifiable = !unicode_;
+                } else if (Consume(':')) {
+                    atom = ParseDisjunction();
+                } else {
+                    Error("Invalid group");
+                }
+            } else {
+                atom = NewNode(kGroup);
+                nodes_[atom].value = static_cast<uint32_t>(++parsedGroups_);
+                size_t body = ParseDisjunction();
+                nodes_[atom].children.push_back(body);
+            }
+            if (!Consume(')')) {
+                Error("Unterminated group");
+            }
+            break;
+        }
+        case '[':
+            Next();
+            atom = ParseClass();
+            break;
+        case '.':
+            Next();
+            atom = NewNode(kAny);
+            break;
+        case '*':
+        case '+':
+        case '?':
+            Error("Nothing to repeat");
+        case '{': {
+            uint32_t min, max;
+            if (unicode_ || ParseQuantifier(min, max)) {
+                Error("Nothing to repeat");
+            }
+            atom = CharNode(Next());
+            break;
+        }
+        case '}':
+        case ']':
+            if (unicode_) {
+                Error("Lone quantifier brackets");
+            }
+            atom = CharNode(Next());
+            break;
+        default:
+            atom = CharNode(Next());
+            break;
+    }
+
+    uint32_t min, max;
+    if (!ParseQuantifier(min, max)) {
+        if (unicode_ && Peek() == '{') {
+            Error("Incomplete quantifier");
+        }
+        nodes_[sequence].children.push_back(atom);
+        return;
+    }
+    if (!quantifiable) {
+        Error("Nothing to repeat");
+    }
+    bool greedy = !Consume('?');
+    if (max == 0) {
+        nodes_[sequence].children.push_back(NewNode(kEmpty));
+        return;
+    }
+    size_t repeat = NewNode(kRepeat);
+    Node& node = nodes_[repeat];
+    node.min = min;
+    node.max = max;
+    node.flag = greedy;
+    node.firstGroup = firstGroup;
+    node.lastGroup = static_cast<uint32_t>(parsedGroups_ + 1);
+    node.value = max > min && CanBeEmpty(atom) ? static_cast<uint32_t>(registerCount_++) : kNoRegister;
+    node.children.push_back(atom);
+    nodes_[sequence].children.push_back(repeat);
+}
+
+bool Compiler::ParseQuantifier(uint32_t& min, uint32_t& max) {
+    switch (Peek()) {
+        case '*':
+            Next();
+            min = 0;
+            max = kInfinity;
+            return true;
+        case '+':
+            Next();
+            min = 1;
+            max = kInfinity;
+            return true;
+        case '?':
+            Next();
+            min = 0;
+            max = 1;
+            return true;
+        case '{': {
+            size_t start = pos_++;
+            if (!ParseDecimal(min)) {
+                pos_ = start;
+                return false;
+            }
+            max = min;
+            if (Consume(',')) {
+                if (!ParseDecimal(max)) {
+                    max = kInfinity;
+                }
+            }
+            if (!Consume('}')) {
+                pos_ = start;
+                return false;
+            }
+            if (min > max) {
+                Error("Numbers out of order in {} quantifier");
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Values too large to be used are clamped
+bool Compiler::ParseDecimal(uint32_t& value) {
+    if (!IsDigit(Peek())) {
+        return false;
+    }
+    uint64_t result = 0;
+    while (IsDigit(Peek())) {
+        result = std::min<uint64_t>(result * 10 + (source_[pos_++] - '0'), kInfinity - 1);
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+size_t Compiler::ParseAtomEscape() {
+    if (AtEnd()) {
+        Error("\\ at end of pattern");
+    }
+    uint32_t ch = Peek();
+    Ranges ranges;
+    if (ParseCharacterClassEscape(ch, ranges)) {
+        return ClassNode(std::move(ranges), false);
+    }
+    if (ch >= '1' && ch <= '9') {
+        size_t start = pos_;
+        uint32_t group;
+        ParseDecimal(group);
+        if (group <= groupCount_) {
+            size_t backref = NewNode(kBackref);
+            nodes_[backref].value = group;
+            hasBackrefs_ = true;
+            return backref;
+        }
+        if (unicode_) {
+            Error("Invalid escape");
+        }
+        // Annex B reads escapes that are not backreferences as octal, or as 8 and 9 themselves
+        pos_ = start;
+        if (ch >= '8') {
+            return CharNode(Next());
+        }
+    }
+    if (IsOctalDigit(ch) && !unicode_) {
+        uint32_t value = Next() - '0';
+        if (IsOctalDigit(Peek())) {
+            value = value * 8 + (Next() - '0');
+            if (ch <= '3' && IsOctalDigit(Peek())) {
+                value = value * 8 + (Next() - '0');
+            }
+        }
+        return CharNode(value);
+    }
+    return CharNode(ParseCharacterEscape(false));
+}
+
+// Character class escapes, appended to ranges. Returns false if ch does not start one
+bool Compiler::ParseCharacterClassEscape(uint32_t ch, Ranges& ranges) {
+    Ranges members;
+    switch (ch) {
+        case 'd':
+        case 'D':
+            members = { { '0', '9' } };
+            break;
+        case 'w':
+        case 'W':
+            members = { { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } };
+            break;
+        case 's':
+        case 'S':
+            members = {
+                { 0x09, 0x0D }, { 0x20, 0x20 }, { 0xA0, 0xA0 }, { 0x1680, 0x1680 }, { 0x2000, 0x200A },
+                { 0x2028, 0x2029 }, { 0x202F, 0x202F }, { 0x205F, 0x205F }, { 0x3000, 0x3000 }, { 0xFEFF, 0xFEFF }
+            };
+            break;
+        default:
+            return false;
+    }
+    Next();
+    if (ch >= 'a') {
+        ranges.insert(ranges.end(), members.begin(), members.end());
+        return true;
+    }
+    uint32_t next = 0;
+    for (const auto& range : members) {
+        if (range.first > next) {
+            ranges.emplace_back(next, range.first - 1);
+        }
+        next = range.second + 1;
+    }
+    ranges.emplace_back(next, unicode_ ? 0x10FFFF : 0xFFFF);
+    return true;
+}
+
+bool Compiler::ParseHex(size_t digits, uint32_t& value) {
+    if (pos_ + digits > source_.size()) {
+        return false;
+    }
+    uint32_t result = 0;
+    for (size_t i = 0; i < digits; i++) {
+        int digit = HexValue(source_[pos_ + i]);
+        if (digit < 0) {
+            return false;
+        }
+        result = result * 16 + digit;
+    }
+    pos_ += digits;
+    value = result;
+    return true;
+}
+
+// Escapes denoting a single character, after the backslash
+uint32_t Compiler::ParseCharacterEscape(bool inClass) {
+    uint32_t ch = Next();
+    switch (ch) {
+        case 't':
+            return '\t';
+        case 'n':
+            return '\n';
+        case 'v':
+            return '\v';
+        case 'f':
+            return '\f';
+        case 'r':
+            return '\r';
+        case '0':
+            if (IsDigit(Peek())) {
+                Error("Invalid decimal escape");
+            }
+            return 0;
+        case 'c': {
+            uint32_t letter = Peek();
+            if ((letter >= 'a' && letter <= 'z') || (letter >= 'A' && letter <= 'Z')) {
+                return Next() % 32;
+            }
+            if (unicode_) {
+                Error("Invalid unicode escape");
+            }
+            if (inClass && (IsDigit(letter) || letter == '_')) {
+                return Next() % 32;
+            }
+            // The backslash stands for itself and c is read again
+            pos_--;
+            return '\\';
+        }
+        case 'x': {
+            uint32_t value;
+            if (ParseHex(2, value)) {
+                return value;
+            }
+            if (unicode_) {
+                Error("Invalid escape");
+            }
+            return 'x';
+        }
+        case 'u': {
+            uint32_t value;
+            if (unicode_ && Consume('{')) {
+                value = 0;
+                size_t digits = 0;
+                for (int digit; (digit = HexValue(Peek())) >= 0; digits++) {
+                    value = value * 16 + digit;
+                    if (value > 0x10FFFF) {
+                        Error("Invalid unicode escape");
+                    }
+                    pos_++;
+                }
+                if (!digits || !Consume('}')) {
+                    Error("Invalid unicode escape");
+                }
+                return value;
+            }
+            if (ParseHex(4, value)) {
+                // With the unicode flag a pair of escaped surrogates is one code point
+                uint32_t trail;
+                size_t start = pos_;
+                if (unicode_ && IsLeadSurrogate(value) && Consume('\\') && Consume('u') && ParseHex(4, trail) && IsTrailSurrogate(trail)) {
+                    return 0x10000 + ((value - 0xD800) << 10) + (trail - 0xDC00);
+                }
+                pos_ = start;
+                return value;
+            }
+            if (unicode_) {
+                Error("Invalid unicode escape");
+            }
+            return 'u';
+        }
+        default:
+            if (unicode_ && !IsSyntaxCharacter(ch) && !(inClass && ch == '-')) {
+                Error("Invalid escape");
+            }
+            return ch;
+    }
+}
+
+size_t Compiler::ParseClass() {
+    bool negated = Consume('^');
+    Ranges ranges;
+    while (true) {
+        if (AtEnd()) {
+            Error("Unterminated character class");
+        }
+        if (Consume(']')) {
+            break;
+        }
+        uint32_t from;
+        bool single = ParseClassAtom(ranges, from);
+        if (Peek() != '-' || pos_ + 1 >= source_.size() || source_[pos_ + 1] == ']') {
+            if (single) {
+                ranges.emplace_back(from, from);
+            }
+            continue;
+        }
+        Next();
+        uint32_t to;
+        bool singleTo = ParseClassAtom(ranges, to);
+        if (!single || !singleTo) {
+            if (unicode_) {
+                Error("Invalid character class");
+            }
+            // Annex B reads the dash literally when either side is a class escape
+            if (single) {
+                ranges.emplace_back(from, from);
+            }
+            if (singleTo) {
+                ranges.emplace_back(to, to);
+            }
+            ranges.emplace_back('-', '-');
+            continue;
+        }
+        if (from > to) {
+            Error("Range out of order in character class");
+        }
+        ranges.emplace_back(from, to);
+    }
+    return ClassNode(std::move(ranges), negated);
+}
+
+// Returns true and the character if the atom is a single character, otherwise the atom is a
+// class escape and its ranges are added
+bool Compiler::ParseClassAtom(Ranges& ranges, uint32_t& ch) {
+    uint32_t first = Next();
+    if (first != '\\') {
+        ch = first;
+        return true;
+    }
+    if (AtEnd()) {
+        Error("\\ at end of pattern");
+    }
+    uint32_t escape = Peek();
+    if (ParseCharacterClassEscape(escape, ranges)) {
+        return false;
+    }
+    if (escape == 'b') {
+        Next();
+        ch = '\b';
+        return true;
+    }
+    if (IsDigit(escape) && !unicode_) {
+        if (escape >= '8') {
+            ch = Next();
+            return true;
+        }
+        uint32_t value = Next() - '0';
+        if (IsOctalDigit(Peek())) {
+            value = value * 8 + (Next() - '0');
+            if (escape <= '3' && IsOctalDigit(Peek())) {
+                value = value * 8 + (Next() - '0');
+            }
+        }
+        ch = value;
+        return true;
+    }
+    ch = ParseCharacterEscape(true);
+    return true;
+}
+
+size_t Compiler::CharNode(uint32_t ch) {
+    size_t node = NewNode(kChar);
+    nodes_[node].value = ch;
+    return node;
+}
+
+size_t Compiler::ClassNode(Ranges ranges, bool negated) {
+    uint32_t offset = AddClass(std::move(ranges), negated);
+    size_t node = NewNode(kClass);
+    nodes_[node].value = offset;
+    return node;
+}
+
+/* Analysis */
+
+bool Compiler::CanBeEmpty(size_t index) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+        case kChar:
+        case kClass:
+        case kAny:
+            return false;
+        case kSequence:
+            for (size_t child : node.children) {
+                if (!CanBeEmpty(child)) {
+                    return false;
+                }
+            }
+            return true;
+        case kAlternation:
+            for (size_t child : node.children) {
+                if (CanBeEmpty(child)) {
+                    return true;
+                }
+            }
+            return false;
+        case kGroup:
+            return CanBeEmpty(node.children[0]);
+        case kRepeat:
+            return node.min == 0 || CanBeEmpty(node.children[0]);
+        default:
+            return true;
+    }
+}
+
+// Append the code units every match of the node starts with. complete is set if the node matches
+// exactly those units, so what follows it may extend the prefix
+void Compiler::CollectPrefix(size_t index, std::u16string& prefix, bool& complete) const {
+    const Node& node = nodes_[index];
+    complete = false;
+    switch (node.type) {
+        case kChar:
+            if (ignoreCase_ && HasCaseVariants(node.value)) {
+                return;
+            }
+            // With the unicode flag a lone surrogate never matches half of a pair, which a scan for
+            // its code unit would find
+            if (unicode_ && node.value >= 0xD800 && node.value <= 0xDFFF) {
+                return;
+            }
+            if (node.value >= 0x10000) {
+                prefix += static_cast<char16_t>(0xD800 + ((node.value - 0x10000) >> 10));
+                prefix += static_cast<char16_t>(0xDC00 + ((node.value - 0x10000) & 0x3FF));
+            } else {
+                prefix += static_cast<char16_t>(node.value);
+            }
+            complete = true;
+            return;
+        case kEmpty:
+        case kAssertion:
+        case kLookahead:
+            complete = true;
+            return;
+        case kSequence:
+            for (size_t child : node.children) {
+                CollectPrefix(child, prefix, complete);
+                if (!complete) {
+                    return;
+                }
+            }
+            return;
+        case kGroup:
+            CollectPrefix(node.children[0], prefix, complete);
+            return;
+        case kRepeat:
+            if (node.min > 0) {
+                CollectPrefix(node.children[0], prefix, complete);
+                complete = false;
+            }
+            return;
+        default:
+            return;
+    }
+}
+
+bool Compiler::IsAnchored(size_t index) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+        case kAssertion:
+            return node.value == static_cast<uint32_t>(Opcode::kInputStart);
+        case kSequence:
+            return !node.children.empty() && IsAnchored(node.children[0]);
+        case kGroup:
+            return IsAnchored(node.children[0]);
+        case kAlternation:
+            for (size_t child : node.children) {
+                if (!IsAnchored(child)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Code generation */
+
+size_t Compiler::Emit(uint32_t word) {
+    if (code_.size() >= kMaxCodeSize) {
+        Error("Regular expression too large");
+    }
+    code_.push_back(word);
+    return code_.size() - 1;
+}
+
+void Compiler::Patch(size_t at, size_t target) {
+    code_[at] = static_cast<uint32_t>(target);
+}
+
+void Compiler::Generate(size_t index) {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+        case kEmpty:
+            break;
+        case kChar:
+            if (ignoreCase_ && HasCaseVariants(node.value)) {
+                Emit(static_cast<uint32_t>(Opcode::kCharIgnoreCase));
+                Emit(Canonicalize(node.value));
+            } else {
+                Emit(static_cast<uint32_t>(Opcode::kChar));
+                Emit(node.value);
+            }
+            break;
+        case kClass:
+            Emit(static_cast<uint32_t>(Opcode::kClass));
+            Emit(node.value);
+            break;
+        case kAny:
+            Emit(static_cast<uint32_t>(Opcode::kAny));
+            break;
+        case kSequence:
+            for (size_t child : node.children) {
+                Generate(child);
+            }
+            break;
+        case kAlternation: {
+            std::vector<size_t> jumps;
+            for (size_t i = 0, size = node.children.size(); i < size; i++) {
+                if (i == size - 1) {
+                    Generate(node.children[i]);
+                    break;
+                }
+                size_t split = Emit(static_cast<uint32_t>(Opcode::kSplit));
+                Emit(static_cast<uint32_t>(split + 3));
+                Emit(0);
+                Generate(node.children[i]);
+                Emit(static_cast<uint32_t>(Opcode::kJump));
+                jumps.push_back(Emit(0));
+                Patch(split + 2, code_.size());
+            }
+            for (size_t jump : jumps) {
+                Patch(jump, code_.size());
+            }
+            break;
+        }
+        case kGroup:
+            Emit(static_cast<uint32_t>(Opcode::kSave));
+            Emit(node.value * 2);
+            Generate(node.children[0]);
+            Emit(static_cast<uint32_t>(Opcode::kSave));
+            Emit(node.value * 2 + 1);
+            break;
+        case kRepeat:
+            GenerateRepeat(node);
+            break;
+        case kAssertion:
+            Emit(node.value);
+            break;
+        case kBackref:
+            Emit(static_cast<uint32_t>(ignoreCase_ ? Opcode::kBackrefIgnoreCase : Opcode::kBackref));
+            Emit(node.value);
+            break;
+        case kLookahead: {
+            size_t look = Emit(static_cast<uint32_t>(node.flag ? Opcode::kNegativeLookahead : Opcode::kLookahead));
+            Emit(0);
+            Generate(node.children[0]);
+            Emit(static_cast<uint32_t>(Opcode::kLookEnd));
+            Patch(look + 1, code_.size());
+            break;
+        }
+    }
+}
+
+// The body is repeated min times, then followed by a loop if there is no maximum, or by max - min
+// optional copies, each of which may be skipped to the end
+void Compiler::GenerateRepeat(const Node& node) {
+    size_t body = node.children[0];
+    bool checked = node.value != kNoRegister;
+    // Registers are stored after the capture slots
+    uint32_t registerSlot = static_cast<uint32_t>((groupCount_ + 1) * 2) + node.value;
+    auto iteration = [&](bool optional) {
+        // Captures inside the body are cleared at the start of each iteration
+        if (node.lastGroup > node.firstGroup) {
+            Emit(static_cast<uint32_t>(Opcode::kResetCaptures));
+            Emit(node.firstGroup * 2);
+            Emit(node.lastGroup * 2);
+        }
+        if (optional && checked) {
+            Emit(static_cast<uint32_t>(Opcode::kSetMark));
+            Emit(registerSlot);
+        }
+        Generate(body);
+        if (optional && checked) {
+            Emit(static_cast<uint32_t>(Opcode::kCheckProgress));
+            Emit(registerSlot);
+        }
+    };
+    for (uint32_t i = 0; i < node.min; i++) {
+        iteration(false);
+    }
+    if (node.max == kInfinity) {
+        size_t loop = Emit(static_cast<uint32_t>(Opcode::kSplit));
+        Emit(0);
+        Emit(0);
+        iteration(true);
+        Emit(static_cast<uint32_t>(Opcode::kJump));
+        Emit(static_cast<uint32_t>(loop));
+        Patch(loop + (node.flag ? 1 : 2), loop + 3);
+        Patch(loop + (node.flag ? 2 : 1), code_.size());
+        return;
+    }
+    std::vector<size_t> splits;
+    for (uint32_t i = node.min; i < node.max; i++) {
+        size_t split = Emit(static_cast<uint32_t>(Opcode::kSplit));
+        Emit(0);
+        Emit(0);
+        Patch(split + (node.flag ? 1 : 2), split + 3);
+        splits.push_back(split);
+        iteration(true);
+    }
+    for (size_t split : splits) {
+        Patch(split + (node.flag ? 2 : 1), code_.size());
+    }
+}
+
+uint32_t Compiler::AddClass(Ranges ranges, bool negated) {
+    uint32_t limit = unicode_ ? 0x10FFFF : 0xFFFF;
+    for (auto& range : ranges) {
+        range.second = std::min(range.second, limit);
+    }
+    Normalize(ranges);
+    // Close the class under case mapping, so a character is a member if any character with the
+    // same canonical value is
+    if (ignoreCase_) {
+        const auto& variants = CaseVariants();
+        Ranges closed = ranges;
+        for (const auto& variant : variants) {
+            if (Contains(ranges, variant.second)) {
+                closed.emplace_back(variant.first, variant.first);
+            }
+        }
+        Normalize(closed);
+        ranges = closed;
+        for (const auto& variant : variants) {
+            if (Contains(closed, variant.first)) {
+                ranges.emplace_back(variant.second, variant.second);
+            }
+        }
+        Normalize(ranges);
+    }
+
+    uint32_t offset = static_cast<uint32_t>(classes_.size());
+    classes_.push_back(negated);
+    classes_.push_back(static_cast<uint32_t>(ranges.size()));
+    uint32_t bitmap[8] = {};
+    for (const auto& range : ranges) {
+        for (uint32_t ch = range.first; ch <= range.second && ch < 256; ch++) {
+            bitmap[ch >> 5] |= 1u << (ch & 31);
+        }
+    }
+    classes_.insert(classes_.end(), bitmap, bitmap + 8);
+    for (const auto& range : ranges) {
+        classes_.push_back(range.first);
+        classes_.push_back(range.second);
+    }
+    return offset;
+}
+
+Handle<Program> Compiler::Compile(const std::u16string& source, uint8_t flags) {
+    Compiler compiler(source, flags);
+    compiler.CountGroups();
+    size_t root = compiler.ParseDisjunction();
+    if (!compiler.AtEnd()) {
+        compiler.Error("Unmatched ')'");
+    }
+
+    compiler.Emit(static_cast<uint32_t>(Opcode::kSave));
+    compiler.Emit(0);
+    compiler.Generate(root);
+    compiler.Emit(static_cast<uint32_t>(Opcode::kSave));
+    compiler.Emit(1);
+    compiler.Emit(static_cast<uint32_t>(Opcode::kMatch));
+
+    std::u16string prefix;
+    bool complete;
+    compiler.CollectPrefix(root, prefix, complete);
+
+    Handle<Program> program = new Program();
+    program->captureCount_ = compiler.groupCount_ + 1;
+    program->registerCount_ = compiler.registerCount_;
+    program->flags_ = flags;
+    program->linear_ = !compiler.hasBackrefs_ && !compiler.hasLookaheads_;
+    program->anchored_ = compiler.IsAnchored(root);
+
+    Handle<ValueArray<uint32_t>> code = ValueArray<uint32_t>::New(compiler.code_.size());
+    std::copy(compiler.code_.begin(), compiler.code_.end(), &code->At(0));
+    program->WriteBarrier(&program->code_, code);
+    if (!compiler.classes_.empty()) {
+        Handle<ValueArray<uint32_t>> classes = ValueArray<uint32_t>::New(compiler.classes_.size());
+        std::copy(compiler.classes_.begin(), compiler.classes_.end(), &classes->At(0));
+        program->WriteBarrier(&program->classes_, classes);
+    }
+    if (!prefix.empty()) {
+        Handle<ValueArray<char16_t>> units = ValueArray<char16_t>::New(prefix.size());
+        std::copy(prefix.begin(), prefix.end(), &units->At(0));
+        program->WriteBarrier(&program->prefix_, units);
+    }
+    return program;
+}
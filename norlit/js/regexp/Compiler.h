@@ -0,0 +1,85 @@
+#ifndef NORLIT_JS_REGEXP_COMPILER_H
+#define NORLIT_JS_REGEXP_COMPILER_H
+
+#include "Program.h"
+
+#include "../Exception.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace regexp {
+
+// Parses a pattern into a tree, then generates the instructions of the program from it
+class Compiler {
+    struct Node;
+    using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    const std::u16string& source_;
+    size_t pos_ = 0;
+    uint8_t flags_;
+    bool unicode_;
+    bool ignoreCase_;
+
+    std::vector<Node> nodes_;
+    size_t groupCount_ = 0;
+    size_t parsedGroups_ = 0;
+    size_t registerCount_ = 0;
+    bool hasBackrefs_ = false;
+    bool hasLookaheads_ = false;
+
+    std::vector<uint32_t> code_;
+    std::vector<uint32_t> classes_;
+
+    Compiler(const std::u16string& source, uint8_t flags);
+
+    NORLIT_NORETURN void Error(const char* message);
+    size_t NewNode(int type);
+
+    // Parsing
+    bool AtEnd() const;
+    uint32_t Peek() const;
+    uint32_t Next();
+    bool Consume(uint32_t ch);
+    void CountGroups();
+    size_t ParseDisjunction();
+    size_t ParseAlternative();
+    void ParseTerm(size_t sequence);
+    bool ParseQuantifier(uint32_t& min, uint32_t& max);
+    bool ParseDecimal(uint32_t& value);
+    size_t ParseAtomEscape();
+    size_t ParseClass();
+    bool ParseClassAtom(Ranges& ranges, uint32_t& ch);
+    bool ParseCharacterClassEscape(uint32_t ch, Ranges& ranges);
+    uint32_t ParseCharacterEscape(bool inClass);
+    bool ParseHex(size_t digits, uint32_t& value);
+    size_t CharNode(uint32_t ch);
+    size_t ClassNode(Ranges ranges, bool negated);
+
+    // Analysis
+    bool CanBeEmpty(size_t node) const;
+    void CollectPrefix(size_t node, std::u16string& prefix, bool& complete) const;
+    bool IsAnchored(size_t node) const;
+
+    // Code generation
+    size_t Emit(uint32_t word);
+    void Patch(size_t at, size_t target);
+    void Generate(size_t node);
+    void GenerateRepeat(const Node& node);
+    uint32_t AddClass(Ranges ranges, bool negated);
+
+  public:
+    static gc::Handle<Program> Compile(const std::u16string& source, uint8_t flags);
+
+    // Canonicalize of 21.2.2.8.2 with the unicode flag cleared
+    static uint32_t Canonicalize(uint32_t ch);
+};
+
+}
+}
+}
+
+#endif
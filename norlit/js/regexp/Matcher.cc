@@ -0,0 +1,543 @@
+#include "Program.h"
+#include "Compiler.h"
+#include "Opcode.h"
+
+#include "../../util/StringSearch.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::regexp;
+using namespace norlit::util;
+
+namespace {
+
+// Backtracks a linear program may take before the search moves on to the Pike VM, in addition to
+// kBacktrackBudgetPerUnit for every code unit of input searched
+const size_t kBacktrackBudget = 100000;
+const size_t kBacktrackBudgetPerUnit = 16;
+
+const uint32_t kNoChar = static_cast<uint32_t>(-1);
+
+inline bool IsLineTerminator(uint32_t ch) {
+    return ch == '\n' || ch == '\r' || ch == 0x2028 || ch == 0x2029;
+}
+
+inline bool IsWordChar(uint32_t ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+inline uint32_t Canonicalize(uint32_t ch) {
+    if (ch < 0x80) {
+        return ch >= 'a' && ch <= 'z' ? ch - 32 : ch;
+    }
+    return Compiler::Canonicalize(ch);
+}
+
+inline bool InClass(const uint32_t* cls, uint32_t ch) {
+    bool member;
+    if (ch < 256) {
+        member = (cls[2 + (ch >> 5)] >> (ch & 31)) & 1;
+    } else {
+        const uint32_t* ranges = cls + 10;
+        size_t low = 0, high = cls[1];
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (ranges[mid * 2 + 1] < ch) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        member = low < cls[1] && ranges[low * 2] <= ch;
+    }
+    return member != (cls[0] != 0);
+}
+
+// Input characters and the state shared by both matchers
+template<typename T>
+struct Subject {
+    const uint32_t* code;
+    const uint32_t* classes;
+    const T* input;
+    size_t length;
+    bool unicode;
+
+    // Character at pos, a code point with the unicode flag. next is set to the position after it
+    uint32_t Read(size_t pos, size_t& next) const {
+        uint32_t ch = input[pos];
+        next = pos + 1;
+        if (unicode && ch >= 0xD800 && ch <= 0xDBFF && next < length) {
+            uint32_t trail = input[next];
+            if (trail >= 0xDC00 && trail <= 0xDFFF) {
+                ch = 0x10000 + ((ch - 0xD800) << 10) + (trail - 0xDC00);
+                next++;
+            }
+        }
+        return ch;
+    }
+
+    // Whether the consuming instruction at pc matches ch
+    bool Matches(const uint32_t* ins, uint32_t ch) const {
+        switch (static_cast<Opcode>(ins[0])) {
+            case Opcode::kChar:
+                return ch == ins[1];
+            case Opcode::kCharIgnoreCase:
+                return Canonicalize(ch) == ins[1];
+            case Opcode::kAny:
+                return !IsLineTerminator(ch);
+            case Opcode::kClass:
+                return InClass(classes + ins[1], ch);
+            default:
+                return false;
+        }
+    }
+
+    bool IsWordAt(size_t pos) const {
+        return pos < length && IsWordChar(input[pos]);
+    }
+
+    // Whether the zero-width assertion holds at pos
+    bool Asserts(Opcode op, size_t pos) const {
+        switch (op) {
+            case Opcode::kInputStart:
+                return pos == 0;
+            case Opcode::kInputEnd:
+                return pos == length;
+            case Opcode::kLineStart:
+                return pos == 0 || IsLineTerminator(input[pos - 1]);
+            case Opcode::kLineEnd:
+                return pos == length || IsLineTerminator(input[pos]);
+            case Opcode::kWordBoundary:
+                return (pos > 0 && IsWordAt(pos - 1)) != IsWordAt(pos);
+            case Opcode::kNotWordBoundary:
+                return (pos > 0 && IsWordAt(pos - 1)) == IsWordAt(pos);
+            default:
+                return false;
+        }
+    }
+
+    size_t Advance(size_t pos) const {
+        size_t next;
+        Read(pos, next);
+        return next;
+    }
+};
+
+// Depth-first matcher. Choice points and the previous values of changed slots share one stack, so
+// failing restores the slots on its way back to the last choice
+template<typename T>
+class Backtracker {
+    struct Entry {
+        bool choice;
+        // Instruction of a choice, slot of a restore
+        uint32_t index;
+        // Position of a choice, old value of a restore
+        int64_t value;
+    };
+
+    const Subject<T>& subject_;
+    int64_t* slots_;
+    std::vector<Entry> stack_;
+    // Backtracks left, or unlimited if null
+    size_t* budget_;
+
+    void SetSlot(uint32_t slot, int64_t value) {
+        stack_.push_back({ false, slot, slots_[slot] });
+        slots_[slot] = value;
+    }
+
+    // Pop everything above base, restoring slots
+    void Unwind(size_t base) {
+        while (stack_.size() > base) {
+            const Entry& entry = stack_.back();
+            if (!entry.choice) {
+                slots_[entry.index] = entry.value;
+            }
+            stack_.pop_back();
+        }
+    }
+
+    // Drop the choices above base but keep the restores, so the slots set there are still undone
+    // when backtracking past base
+    void Commit(size_t base) {
+        size_t size = base;
+        for (size_t i = base; i < stack_.size(); i++) {
+            if (!stack_[i].choice) {
+                stack_[size++] = stack_[i];
+            }
+        }
+        stack_.resize(size);
+    }
+
+  public:
+    enum class Result {
+        kMatch,
+        kFail,
+        kOutOfBudget
+    };
+
+    Backtracker(const Subject<T>& subject, int64_t* slots, size_t* budget) : subject_(subject), slots_(slots), budget_(budget) {}
+
+    void Reset() {
+        stack_.clear();
+    }
+
+    // Run from pc at pos until kMatch or kLookEnd
+    Result Run(size_t pc, size_t pos) {
+        const uint32_t* code = subject_.code;
+        size_t length = subject_.length;
+        size_t base = stack_.size();
+        while (true) {
+            const uint32_t* ins = code + pc;
+            Opcode op = static_cast<Opcode>(ins[0]);
+            switch (op) {
+                case Opcode::kChar:
+                case Opcode::kCharIgnoreCase:
+                case Opcode::kAny:
+                case Opcode::kClass: {
+                    size_t next;
+                    if (pos < length && subject_.Matches(ins, subject_.Read(pos, next))) {
+                        pos = next;
+                        pc += op == Opcode::kAny ? 1 : 2;
+                        continue;
+                    }
+                    break;
+                }
+                case Opcode::kSplit:
+                    stack_.push_back({ true, ins[2], static_cast<int64_t>(pos) });
+                    pc = ins[1];
+                    continue;
+                case Opcode::kJump:
+                    pc = ins[1];
+                    continue;
+                case Opcode::kSave:
+                case Opcode::kSetMark:
+                    SetSlot(ins[1], static_cast<int64_t>(pos));
+                    pc += 2;
+                    continue;
+                case Opcode::kResetCaptures:
+                    for (uint32_t slot = ins[1]; slot < ins[2]; slot++) {
+                        if (slots_[slot] != -1) {
+                            SetSlot(slot, -1);
+                        }
+                    }
+                    pc += 3;
+                    continue;
+                case Opcode::kCheckProgress:
+                    if (slots_[ins[1]] != static_cast<int64_t>(pos)) {
+                        pc += 2;
+                        continue;
+                    }
+                    break;
+                case Opcode::kInputStart:
+                case Opcode::kInputEnd:
+                case Opcode::kLineStart:
+                case Opcode::kLineEnd:
+                case Opcode::kWordBoundary:
+                case Opcode::kNotWordBoundary:
+                    if (subject_.Asserts(op, pos)) {
+                        pc++;
+                        continue;
+                    }
+                    break;
+                case Opcode::kBackref:
+                case Opcode::kBackrefIgnoreCase: {
+                    int64_t start = slots_[ins[1] * 2], end = slots_[ins[1] * 2 + 1];
+                    // Groups that did not participate match the empty string
+                    if (start == -1 || end == -1) {
+                        pc += 2;
+                        continue;
+                    }
+                    size_t count = static_cast<size_t>(end - start);
+                    if (length - pos < count) {
+                        break;
+                    }
+                    const T* captured = subject_.input + start;
+                    const T* here = subject_.input + pos;
+                    bool same = true;
+                    for (size_t i = 0; i < count && same; i++) {
+                        same = op == Opcode::kBackref ? captured[i] == here[i] : Canonicalize(captured[i]) == Canonicalize(here[i]);
+                    }
+                    if (same) {
+                        pos += count;
+                        pc += 2;
+                        continue;
+                    }
+                    break;
+                }
+                case Opcode::kLookahead:
+                case Opcode::kNegativeLookahead: {
+                    size_t lookBase = stack_.size();
+                    Result result = Run(pc + 2, pos);
+                    if (result == Result::kOutOfBudget) {
+                        return result;
+                    }
+                    bool negative = op == Opcode::kNegativeLookahead;
+                    if (result == Result::kMatch) {
+                        if (negative) {
+                            Unwind(lookBase);
+                            break;
+                        }
+                        Commit(lookBase);
+                    } else if (!negative) {
+                        break;
+                    }
+                    pc = ins[1];
+                    continue;
+                }
+                case Opcode::kLookEnd:
+                case Opcode::kMatch:
+                    return Result::kMatch;
+            }
+
+            // Failed, resume at the last choice
+            while (true) {
+                if (stack_.size() == base) {
+                    return Result::kFail;
+                }
+                Entry entry = stack_.back();
+                stack_.pop_back();
+                if (!entry.choice) {
+                    slots_[entry.index] = entry.value;
+                    continue;
+                }
+                if (budget_ && (*budget_)-- == 0) {
+                    return Result::kOutOfBudget;
+                }
+                pc = entry.index;
+                pos = static_cast<size_t>(entry.value);
+                break;
+            }
+        }
+    }
+};
+
+// Breadth-first matcher for programs without backreferences and lookaheads. Threads are kept in
+// order of priority and at most one thread is kept per instruction, so the time taken is linear in
+// the length of the input, and the match found is the one backtracking would find
+template<typename T>
+class PikeVM {
+    struct Job {
+        uint32_t pc;
+        // Slot to restore, or -1 to add a thread at pc
+        int32_t slot;
+        int64_t value;
+    };
+
+    // Threads waiting at consuming instructions or kMatch, with the instructions visited while
+    // adding them as a sparse set
+    struct ThreadList {
+        std::vector<uint32_t> sparse;
+        std::vector<uint32_t> dense;
+        std::vector<uint32_t> threads;
+        std::vector<int64_t> slots;
+
+        explicit ThreadList(size_t codeLength) : sparse(codeLength) {}
+
+        bool Visit(uint32_t pc) {
+            uint32_t index = sparse[pc];
+            if (index < dense.size() && dense[index] == pc) {
+                return false;
+            }
+            sparse[pc] = static_cast<uint32_t>(dense.size());
+            dense.push_back(pc);
+            return true;
+        }
+
+        void Clear() {
+            dense.clear();
+            threads.clear();
+            slots.clear();
+        }
+    };
+
+    const Subject<T>& subject_;
+    size_t codeLength_;
+    size_t slotCount_;
+    std::vector<Job> jobs_;
+
+    // Follow the instructions from pc that do not consume input, adding a thread at every
+    // consuming instruction reached. work holds the slots and is restored before returning
+    void AddThread(ThreadList& list, uint32_t pc, size_t pos, int64_t* work) {
+        const uint32_t* code = subject_.code;
+        jobs_.push_back({ pc, -1, 0 });
+        while (!jobs_.empty()) {
+            Job job = jobs_.back();
+            jobs_.pop_back();
+            if (job.slot >= 0) {
+                work[job.slot] = job.value;
+                continue;
+            }
+            pc = job.pc;
+            while (list.Visit(pc)) {
+                const uint32_t* ins = code + pc;
+                Opcode op = static_cast<Opcode>(ins[0]);
+                bool follow = true;
+                switch (op) {
+                    case Opcode::kSplit:
+                        jobs_.push_back({ ins[2], -1, 0 });
+                        pc = ins[1];
+                        break;
+                    case Opcode::kJump:
+                        pc = ins[1];
+                        break;
+                    case Opcode::kSave:
+                    case Opcode::kSetMark:
+                        jobs_.push_back({ 0, static_cast<int32_t>(ins[1]), work[ins[1]] });
+                        work[ins[1]] = static_cast<int64_t>(pos);
+                        pc += 2;
+                        break;
+                    case Opcode::kResetCaptures:
+                        for (uint32_t slot = ins[1]; slot < ins[2]; slot++) {
+                            jobs_.push_back({ 0, static_cast<int32_t>(slot), work[slot] });
+                            work[slot] = -1;
+                        }
+                        pc += 3;
+                        break;
+                    case Opcode::kCheckProgress:
+                        follow = work[ins[1]] != static_cast<int64_t>(pos);
+                        pc += 2;
+                        break;
+                    case Opcode::kInputStart:
+                    case Opcode::kInputEnd:
+                    case Opcode::kLineStart:
+                    case Opcode::kLineEnd:
+                    case Opcode::kWordBoundary:
+                    case Opcode::kNotWordBoundary:
+                        follow = subject_.Asserts(op, pos);
+                        pc++;
+                        break;
+                    default:
+                        list.threads.push_back(pc);
+                        list.slots.insert(list.slots.end(), work, work + slotCount_);
+                        follow = false;
+                        break;
+                }
+                if (!follow) {
+                    break;
+                }
+            }
+        }
+    }
+
+  public:
+    PikeVM(const Subject<T>& subject, size_t codeLength, size_t slotCount) :
+        subject_(subject), codeLength_(codeLength), slotCount_(slotCount) {}
+
+    // Search from start, only matching at start if anchored. captures receives the slots of the
+    // match
+    bool Search(size_t start, bool anchored, const char16_t* prefix, size_t prefixLength, std::vector<int64_t>& captures) {
+        ThreadList current(codeLength_), next(codeLength_);
+        std::vector<int64_t> work(slotCount_, -1);
+        size_t length = subject_.length;
+        bool matched = false;
+
+        for (size_t pos = start;;) {
+            if (!matched && (pos == start || !anchored)) {
+                // Skip to where the prefix occurs when no thread is alive
+                if (current.threads.empty() && prefix && !anchored) {
+                    pos = StringSearch::Find(subject_.input, length, prefix, prefixLength, pos);
+                    if (pos == StringSearch::kNotFound) {
+                        break;
+                    }
+                }
+                std::fill(work.begin(), work.end(), -1);
+                AddThread(current, 0, pos, work.data());
+            }
+            if (current.threads.empty()) {
+                break;
+            }
+
+            size_t after = pos;
+            uint32_t ch = pos < length ? subject_.Read(pos, after) : kNoChar;
+            next.Clear();
+            for (size_t i = 0; i < current.threads.size(); i++) {
+                uint32_t pc = current.threads[i];
+                const uint32_t* ins = subject_.code + pc;
+                int64_t* slots = &current.slots[i * slotCount_];
+                if (static_cast<Opcode>(ins[0]) == Opcode::kMatch) {
+                    // Threads after this one have lower priority and are dropped
+                    matched = true;
+                    std::copy(slots, slots + slotCount_, captures.begin());
+                    break;
+                }
+                if (ch != kNoChar && subject_.Matches(ins, ch)) {
+                    std::copy(slots, slots + slotCount_, work.begin());
+                    AddThread(next, pc + (static_cast<Opcode>(ins[0]) == Opcode::kAny ? 1 : 2), after, work.data());
+                }
+            }
+            std::swap(current, next);
+            if (pos >= length) {
+                break;
+            }
+            pos = after;
+        }
+        return matched;
+    }
+};
+
+}
+
+template<typename T>
+bool Program::Match(const T* input, size_t length, size_t start, std::vector<int64_t>& captures) {
+    size_t slotCount = captureCount_ * 2 + registerCount_;
+    captures.assign(slotCount, -1);
+    if (start > length) {
+        return false;
+    }
+    bool sticky = flags_ & kSticky;
+    if (anchored_ && !sticky && start > 0) {
+        return false;
+    }
+    bool onlyAtStart = sticky || anchored_;
+    const char16_t* prefix = prefix_ ? &prefix_->At(0) : nullptr;
+    size_t prefixLength = prefix_ ? prefix_->Length() : 0;
+
+    Subject<T> subject { &code_->At(0), classes_ ? &classes_->At(0) : nullptr, input, length, (flags_ & kUnicode) != 0 };
+    size_t budget = kBacktrackBudget + kBacktrackBudgetPerUnit * (length - start);
+    Backtracker<T> backtracker(subject, captures.data(), linear_ ? &budget : nullptr);
+
+    for (size_t pos = start; pos <= length;) {
+        if (prefix && !onlyAtStart) {
+            pos = StringSearch::Find(input, length, prefix, prefixLength, pos);
+            if (pos == StringSearch::kNotFound) {
+                return false;
+            }
+        }
+        backtracker.Reset();
+        typename Backtracker<T>::Result result = backtracker.Run(0, pos);
+        if (result == Backtracker<T>::Result::kMatch) {
+            captures.resize(captureCount_ * 2);
+            return true;
+        }
+        if (result == Backtracker<T>::Result::kOutOfBudget) {
+            captures.assign(slotCount, -1);
+            PikeVM<T> vm(subject, code_->Length(), slotCount);
+            if (vm.Search(pos, onlyAtStart, prefix, prefixLength, captures)) {
+                captures.resize(captureCount_ * 2);
+                return true;
+            }
+            return false;
+        }
+        if (onlyAtStart || pos == length) {
+            return false;
+        }
+        pos = subject.Advance(pos);
+    }
+    return false;
+}
+
+bool Program::Exec(const Handle<JSString>& input, size_t start, std::vector<int64_t>& captures) {
+    Handle<Program> self = this;
+    // Characters are read in place, so nothing may move them until the match is over
+    NoGC _;
+    char16_t buffer[JSString::MAX_ASCII_SHORT_STRING_LENGTH];
+    JSString::Characters chars = input->GetCharacters(buffer);
+    if (chars.oneByte) {
+        return self->Match(static_cast<const uint8_t*>(chars.data), chars.length, start, captures);
+    }
+    return self->Match(static_cast<const char16_t*>(chars.data), chars.length, start, captures);
+}
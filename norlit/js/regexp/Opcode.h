@@ -0,0 +1,102 @@
+#ifndef NORLIT_JS_REGEXP_OPCODE_H
+#define NORLIT_JS_REGEXP_OPCODE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace norlit {
+namespace js {
+namespace regexp {
+
+// Instructions of compiled regular expressions. Each is a word holding the opcode followed by its
+// operands, one word each. Positions are indices into the input in code units, and characters are
+// code units, or code points with the unicode flag
+enum class Opcode : uint32_t {
+    // Operands             char
+    // Match ch
+    kChar,
+
+    // Operands             char
+    // Match a character whose canonicalized value is ch
+    kCharIgnoreCase,
+
+    // Match any character but line terminators
+    kAny,
+
+    // Operands             class
+    // Match a character in the character class at the given offset of the class table
+    kClass,
+
+    // Operands             first, second
+    // Continue at first, and at second if that fails
+    kSplit,
+
+    // Operands             target
+    kJump,
+
+    // Operands             slot
+    // Record the current position in the capture slot
+    kSave,
+
+    // Operands             from, to
+    // Set capture slots [from, to) to unmatched
+    kResetCaptures,
+
+    // Operands             slot
+    // Record the current position in the register at the slot
+    kSetMark,
+
+    // Operands             slot
+    // Fail if the position has not moved since the register at the slot was recorded. Ends iterations of loops
+    // whose body matched the empty string
+    kCheckProgress,
+
+    kInputStart,
+    kInputEnd,
+    kLineStart,
+    kLineEnd,
+    kWordBoundary,
+    kNotWordBoundary,
+
+    // Operands             group
+    // Match the text captured by the group
+    kBackref,
+    kBackrefIgnoreCase,
+
+    // Operands             end
+    // Match the instructions that follow up to kLookEnd at the current position without moving it,
+    // then continue at end. Once the lookahead succeeds it is never backtracked into
+    kLookahead,
+    kNegativeLookahead,
+    kLookEnd,
+
+    kMatch
+};
+
+inline size_t OperandCount(Opcode op) {
+    switch (op) {
+        case Opcode::kChar:
+        case Opcode::kCharIgnoreCase:
+        case Opcode::kClass:
+        case Opcode::kJump:
+        case Opcode::kSave:
+        case Opcode::kSetMark:
+        case Opcode::kCheckProgress:
+        case Opcode::kBackref:
+        case Opcode::kBackrefIgnoreCase:
+        case Opcode::kLookahead:
+        case Opcode::kNegativeLookahead:
+            return 1;
+        case Opcode::kSplit:
+        case Opcode::kResetCaptures:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+}
+}
+}
+
+#endif
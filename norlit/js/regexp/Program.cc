@@ -0,0 +1,68 @@
+#include "Program.h"
+#include "Compiler.h"
+
+#include "../../util/HashMap.h"
+
+#include <string>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::regexp;
+using namespace norlit::util;
+
+bool Program::ParseFlags(const Handle<JSString>& flags, uint8_t& result) {
+    result = 0;
+    for (size_t i = 0, length = flags->Length(); i < length; i++) {
+        uint8_t flag;
+        switch (flags->At(i)) {
+            case 'g':
+                flag = kGlobal;
+                break;
+            case 'i':
+                flag = kIgnoreCase;
+                break;
+            case 'm':
+                flag = kMultiline;
+                break;
+            case 'y':
+                flag = kSticky;
+                break;
+            case 'u':
+                flag = kUnicode;
+                break;
+            default:
+                return false;
+        }
+        if (result & flag) {
+            return false;
+        }
+        result |= flag;
+    }
+    return true;
+}
+
+Handle<Program> Program::Compile(const Handle<JSString>& source, uint8_t flags) {
+    // Keyed by the flags followed by the source. Programs no longer used by any RegExp are dropped
+    static HashMap<JSString, Program, false, true> cache;
+
+    wchar_t tag[] = { static_cast<wchar_t>('a' + flags), '/', 0 };
+    Handle<JSString> key = JSString::Concat(JSString::New(tag), source);
+    Handle<Program> program = cache.Get(key);
+    if (program) {
+        return program;
+    }
+
+    std::u16string text;
+    for (size_t i = 0, length = source->Length(); i < length; i++) {
+        text += source->At(i);
+    }
+    program = Compiler::Compile(text, flags);
+    cache.Put(key, program);
+    return program;
+}
+
+void Program::IterateField(const FieldIterator& iter) {
+    iter(&this->code_);
+    iter(&this->classes_);
+    iter(&this->prefix_);
+}
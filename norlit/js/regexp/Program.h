@@ -0,0 +1,83 @@
+#ifndef NORLIT_JS_REGEXP_PROGRAM_H
+#define NORLIT_JS_REGEXP_PROGRAM_H
+
+#include "../JSString.h"
+#include "../../gc/Array.h"
+
+#include <vector>
+
+namespace norlit {
+namespace js {
+namespace regexp {
+
+class Compiler;
+
+// A compiled regular expression. Programs are immutable and shared by every RegExp object with the
+// same source and flags.
+//
+// Matching runs a backtracking interpreter over the instructions, starting only where the literal
+// prefix of the pattern occurs, if it has one. Patterns without backreferences and lookaheads
+// cannot need more than linear time, so once backtracking has taken too many steps on one of them
+// the search goes on with a Pike VM, which steps all alternatives through the input in lockstep.
+class Program final : public gc::Object {
+    friend class Compiler;
+  public:
+    enum Flag : uint8_t {
+        kGlobal = 1,
+        kIgnoreCase = 2,
+        kMultiline = 4,
+        kSticky = 8,
+        kUnicode = 16,
+    };
+
+  private:
+    gc::ValueArray<uint32_t>* code_ = nullptr;
+    // Character classes. Each is a negation flag, the number of ranges, a bitmap of the members
+    // below 256, then the ranges as inclusive pairs sorted and disjoint
+    gc::ValueArray<uint32_t>* classes_ = nullptr;
+    // Code units every match starts with. Null if there are none
+    gc::ValueArray<char16_t>* prefix_ = nullptr;
+    // Capture groups, including the whole match as group 0
+    size_t captureCount_ = 0;
+    // Registers used to detect empty iterations of loops, stored after the capture slots
+    size_t registerCount_ = 0;
+    uint8_t flags_ = 0;
+    // Whether the Pike VM can run the program
+    bool linear_ = false;
+    // Whether a match can only start at the beginning of the input
+    bool anchored_ = false;
+
+    Program() {}
+
+    template<typename T>
+    bool Match(const T* input, size_t length, size_t start, std::vector<int64_t>& captures);
+
+  public:
+    // Parse flags of a RegExp. Returns false if a flag is unknown or repeated
+    static bool ParseFlags(const gc::Handle<JSString>& flags, uint8_t& result);
+
+    // Compile the pattern, or return the program compiled before for the same source and flags.
+    // Throws a SyntaxError if the pattern is invalid
+    static gc::Handle<Program> Compile(const gc::Handle<JSString>& source, uint8_t flags);
+
+    size_t CaptureCount() const {
+        return captureCount_;
+    }
+
+    uint8_t Flags() const {
+        return flags_;
+    }
+
+    // Find the first match in input at or after start, or only at start if the program is sticky.
+    // On success captures holds the start and end of each group, or -1 for groups that did not
+    // participate in the match
+    bool Exec(const gc::Handle<JSString>& input, size_t start, std::vector<int64_t>& captures);
+
+    virtual void IterateField(const gc::FieldIterator&) override;
+};
+
+}
+}
+}
+
+#endif
@@ -13,6 +13,8 @@
 
 #include "Environment.h"
 #include "Realm.h"
+#include "Profiler.h"
+#include "OpcodeStats.h"
 
 using namespace norlit::gc;
 using namespace norlit::js;
@@ -115,12 +117,23 @@ Handle<T> BytecodeContext::PopAs() {
 
 
 template<typename T>
-Handle<T> BytecodeContext::GetConstantAs(uint16_t index) {
+Handle<T> BytecodeContext::GetConstantAs(uint32_t index) {
     Handle<JSValue> val = this->code->GetConstant(index);
     assert(Testing::Is<T>(val));
     return val.CastTo<T>();
 }
 
+Handle<Environment> BytecodeContext::ResolveBinding(const Handle<JSString>& name) {
+    Handle<Environment> lex = this->lexEnv;
+    while (lex) {
+        if (lex->HasBinding(name)) {
+            break;
+        }
+        lex = lex->outer();
+    }
+    return lex;
+}
+
 Handle<Environment> BytecodeContext::GetThisEnvironment() {
     Handle<Environment> lex = this->lexEnv;
     while (true) {
@@ -143,15 +156,23 @@ void BytecodeContext::IterateField(const FieldIterator& iter) {
     iter(&this->code);
 }
 
-uint16_t BytecodeContext::Fetch16() {
-    uint8_t hi = this->code->At(this->ip++);
-    uint8_t lo = this->code->At(this->ip++);
-    return (hi << 8) | lo;
+Handle<Code> BytecodeContext::GetCode() {
+    return code;
+}
+
+uint32_t BytecodeContext::FetchImmediate() {
+    uint32_t ret = this->code->ReadImmediate(this->ip, this->wide);
+    this->ip += this->wide ? 4 : 2;
+    return ret;
 }
 
 BytecodeContext::ReturnStatus BytecodeContext::Step() {
     Handle<BytecodeContext> self = this;
     Instruction ins = static_cast<Instruction>(self->code->At(self->ip++));
+    self->wide = ins == Instruction::kWide;
+    if (self->wide) {
+        ins = static_cast<Instruction>(self->code->At(self->ip++));
+    }
     Handle<JSValue> result;
 
     switch (ins) {
@@ -165,26 +186,74 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
             self->Push(JSBoolean::New(true));
             break;
         case Instruction::kLoad: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             self->Push(tmp);
             break;
         }
 
         case Instruction::kJump: {
-            ip = self->Fetch16();
+            ip = self->FetchImmediate();
             break;
         }
         case Instruction::kJumpIfTrue: {
-            uint16_t target = self->Fetch16();
+            uint32_t target = self->FetchImmediate();
             if (self->PopAs<JSBoolean>()->Value()) {
                 ip = target;
             }
             break;
         }
 
+        case Instruction::kTableSwitch: {
+            uint32_t lowBits = self->FetchImmediate();
+            int32_t low = self->wide ? static_cast<int32_t>(lowBits) : static_cast<int16_t>(lowBits);
+            uint32_t count = self->FetchImmediate();
+            uint32_t target = self->FetchImmediate();
+            size_t table = self->ip;
+            size_t width = self->wide ? 4 : 2;
+            Handle<JSValue> value = self->Pop();
+            if (value->GetType() == JSValue::Type::kNumber) {
+                double index = value.CastTo<JSNumber>()->Value() - low;
+                if (index >= 0 && index < count && index == static_cast<uint32_t>(index)) {
+                    target = self->code->ReadImmediate(table + static_cast<size_t>(index) * width, self->wide);
+                }
+            }
+            self->ip = target;
+            break;
+        }
+        case Instruction::kLookupSwitch: {
+            uint32_t count = self->FetchImmediate();
+            uint32_t target = self->FetchImmediate();
+            size_t table = self->ip;
+            size_t width = self->wide ? 4 : 2;
+            Handle<JSValue> value = self->Pop();
+            // -0 === +0, while all other numbers are normalized by JSNumber::New
+            if (value->GetType() == JSValue::Type::kNumber && value.CastTo<JSNumber>()->Value() == 0) {
+                value = JSNumber::Zero();
+            }
+            // Keys are tagged values sorted by their bits, so identity is strict equality
+            uintptr_t key = reinterpret_cast<uintptr_t>(static_cast<JSValue*>(value));
+            size_t lo = 0, hi = count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                size_t entry = table + mid * 2 * width;
+                uint32_t keyIndex = self->code->ReadImmediate(entry, self->wide);
+                uintptr_t candidate = reinterpret_cast<uintptr_t>(static_cast<JSValue*>(self->code->GetConstant(keyIndex)));
+                if (candidate == key) {
+                    target = self->code->ReadImmediate(entry + width, self->wide);
+                    break;
+                } else if (candidate < key) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            self->ip = target;
+            break;
+        }
+
         case Instruction::kFunction: {
-            uint16_t codeIndex = self->Fetch16();
+            uint32_t codeIndex = self->FetchImmediate();
             Handle<Code> code = self->code->GetCode(codeIndex);
             Handle<JSObject> F = Objects::FunctionCreate(FunctionKind::kNormal, code, self->lexEnv, true);
             Objects::MakeConstructor(F);
@@ -193,7 +262,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kGenerator: {
-            uint16_t codeIndex = self->Fetch16();
+            uint32_t codeIndex = self->FetchImmediate();
             Handle<Code> code = self->code->GetCode(codeIndex);
             Handle<JSObject> F = Objects::GeneratorFunctionCreate(FunctionKind::kNormal, code, self->lexEnv, true);
             Handle<JSObject> prototype = Objects::ObjectCreate(CurrentRealm()->GeneratorPrototype());
@@ -244,7 +313,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kDefVar: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -259,7 +328,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kDefLet: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -269,7 +338,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kDefConst: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -279,7 +348,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kInitDef: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -300,9 +369,16 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
             self->lexEnv = self->lexEnv->outer();
             break;
         }
+        case Instruction::kUnwindScope: {
+            uint32_t count = self->FetchImmediate();
+            for (uint32_t i = 0; i < count; i++) {
+                self->lexEnv = self->lexEnv->outer();
+            }
+            break;
+        }
 
         case Instruction::kGetName: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -326,7 +402,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
 
 
         case Instruction::kGetNameOrUndef: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> tmp = self->code->GetConstant(index);
             assert(tmp->GetType() == JSValue::Type::kString);
             Handle<JSString> name = tmp.CastTo<JSString>();
@@ -349,7 +425,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kPutName: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> value = self->Peek();
             Handle<JSString> name = self->GetConstantAs<JSString>(index);
 
@@ -372,7 +448,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kDeleteName: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSValue> value = self->Peek();
             Handle<JSString> name = self->GetConstantAs<JSString>(index);
 
@@ -496,6 +572,13 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
             break;
         }
 
+        case Instruction::kRegExp: {
+            Handle<JSValue> flags = self->Pop();
+            Handle<JSValue> pattern = self->Pop();
+            self->Push(Objects::RegExpCreate(pattern, flags));
+            break;
+        }
+
         case Instruction::kCall: {
             Handle<Array<JSValue>> args;
             {
@@ -592,12 +675,48 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         case Instruction::kSpread: {
             Handle<JSValue> spreadObj = self->Pop();
             Handle<JSObject> iterator = Iterators::GetIterator(spreadObj);
-            while (Handle<JSObject> next = Iterators::IteratorStep(iterator)) {
-                Handle<JSValue> nextValue = Iterators::IteratorValue(next);
+            Handle<JSValue> nextValue;
+            while (Iterators::IteratorStepValue(iterator, nextValue)) {
                 self->Push(nextValue);
             }
             break;
         }
+        case Instruction::kGetIterator: {
+            Handle<JSValue> obj = self->Pop();
+            self->Push(Iterators::GetIterator(obj));
+            break;
+        }
+        case Instruction::kEnumerate: {
+            Handle<JSValue> obj = self->Pop();
+            self->Push(Iterators::EnumerateObjectProperties(obj));
+            break;
+        }
+        case Instruction::kIteratorNext: {
+            uint32_t target = self->FetchImmediate();
+            Handle<JSObject> iterator = self->PopAs<JSObject>();
+            Handle<JSValue> nextValue;
+            if (Iterators::IteratorStepValue(iterator, nextValue)) {
+                self->Push(nextValue);
+            } else {
+                self->ip = target;
+            }
+            break;
+        }
+        case Instruction::kIteratorClose: {
+            Handle<JSObject> iterator = self->PopAs<JSObject>();
+            Iterators::IteratorClose(iterator);
+            break;
+        }
+        case Instruction::kIteratorCloseThrow: {
+            Handle<JSObject> iterator = self->PopAs<JSObject>();
+            Handle<JSValue> exception = self->Pop();
+            // The original exception wins over anything thrown while closing
+            try {
+                Iterators::IteratorClose(iterator);
+            } catch (ESException&) {
+            }
+            throw ESException(exception);
+        }
         case Instruction::kDup:
             result = self->Peek();
             self->Push(result);
@@ -634,7 +753,7 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         }
 
         case Instruction::kImplicitThis: {
-            uint16_t index = self->Fetch16();
+            uint32_t index = self->FetchImmediate();
             Handle<JSString> name = self->GetConstantAs<JSString>(index);
 
             Handle<Environment> lex = self->lexEnv;
@@ -841,6 +960,68 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
         case Instruction::kDebugger: {
             break;
         }
+
+        /* Superinstructions */
+        case Instruction::kGetNamedProperty: {
+            uint32_t index = self->FetchImmediate();
+            Handle<JSValue> base = self->Pop();
+
+            Testing::RequireObjectCoercible(base);
+            Handle<JSPropertyKey> prop = Conversion::ToPropertyKey(self->code->GetConstant(index));
+
+            result = Objects::GetV(base, prop);
+            self->Push(result);
+            break;
+        }
+        case Instruction::kGetNamedPropertyNoPop: {
+            uint32_t index = self->FetchImmediate();
+            Handle<JSValue> base = self->Peek();
+
+            Testing::RequireObjectCoercible(base);
+            Handle<JSPropertyKey> prop = Conversion::ToPropertyKey(self->code->GetConstant(index));
+
+            result = Objects::GetV(base, prop);
+
+            self->Push(prop);
+            self->Push(result);
+            break;
+        }
+        case Instruction::kGetNameNum: {
+            uint32_t index = self->FetchImmediate();
+            Handle<JSString> name = self->GetConstantAs<JSString>(index);
+            Handle<Environment> lex = self->ResolveBinding(name);
+            if (!lex) {
+                Exceptions::ThrowReferenceError(name);
+            }
+            result = Conversion::ToNumber(lex->GetBindingValue(name, false));
+            self->Push(result);
+            break;
+        }
+        case Instruction::kInitDefNoPop: {
+            uint32_t index = self->FetchImmediate();
+            Handle<JSString> name = self->GetConstantAs<JSString>(index);
+            self->lexEnv->InitializeBinding(name, self->Peek());
+            break;
+        }
+        case Instruction::kIncName:
+        case Instruction::kDecName: {
+            uint32_t index = self->FetchImmediate();
+            Handle<JSString> name = self->GetConstantAs<JSString>(index);
+            Handle<Environment> lex = self->ResolveBinding(name);
+            if (!lex) {
+                Exceptions::ThrowReferenceError(name);
+            }
+            Handle<JSNumber> old = Conversion::ToNumber(lex->GetBindingValue(name, false));
+            double delta = ins == Instruction::kIncName ? 1 : -1;
+            // The binding is resolved again, as converting the old value may run arbitrary code
+            lex = self->ResolveBinding(name);
+            if (!lex) {
+                Exceptions::ThrowReferenceError(name);
+            }
+            lex->SetMutableBinding(name, JSNumber::New(old->Value() + delta), true);
+            self->Push(old);
+            break;
+        }
         case Instruction::kReturn: {
             return ReturnStatus::kReturn;
         }
@@ -856,8 +1037,8 @@ BytecodeContext::ReturnStatus BytecodeContext::Step() {
 bool BytecodeContext::HandleException(const Handle<JSValue>& ex) {
     Handle<BytecodeContext> self = this;
     // -1 here because we advanced self->ip already in self->Step();
-    uint16_t handler = self->code->FindExceptionHandler(self->ip - 1);
-    if (handler != 0xFFFF) {
+    size_t handler = self->code->FindExceptionHandler(self->ip - 1);
+    if (handler != Code::kNoHandler) {
         // Clear the stack and push the exception
         self->stack->Clear();
         self->Push(ex);
@@ -880,6 +1061,16 @@ bool BytecodeContext::HandleException(const Handle<JSValue>& ex) {
 BytecodeContext::ReturnStatus BytecodeContext::Run() {
     Handle<BytecodeContext> self = this;
     while (self->ip < self->code->Length()) {
+        if (Profiler::sampleRequested.load(std::memory_order_relaxed)) {
+            Profiler::TakeSample();
+        }
+#ifdef NORLIT_OPCODE_STATS
+        Instruction ins = static_cast<Instruction>(self->code->At(self->ip));
+        if (ins == Instruction::kWide) {
+            ins = static_cast<Instruction>(self->code->At(self->ip + 1));
+        }
+        OpcodeStats::Sample sample(ins, static_cast<uint32_t>(self->ip));
+#endif
         try {
             ReturnStatus status = self->Step();
             if (status != ReturnStatus::kNormal) {
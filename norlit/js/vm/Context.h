@@ -5,6 +5,7 @@
 #include "../../util/ArrayList.h"
 
 #include "../JSValue.h"
+#include "../JSString.h"
 #include "../object/JSFunction.h"
 
 namespace norlit {
@@ -49,17 +50,21 @@ class BytecodeContext : public Context {
 
     bytecode::Code* code = nullptr;
     size_t ip = 0;
+    // Whether the instruction being executed is prefixed by kWide
+    bool wide = false;
 
     template<typename T>
     gc::Handle<T> PopAs();
 
     template<typename T>
-    gc::Handle<T> GetConstantAs(uint16_t);
+    gc::Handle<T> GetConstantAs(uint32_t);
 
     gc::Handle<Environment> GetThisEnvironment();
+    // Innermost environment with a binding of the name, or null if there is none
+    gc::Handle<Environment> ResolveBinding(const gc::Handle<JSString>&);
     gc::Handle<JSValue> ResolveThisBinding();
 
-    uint16_t Fetch16();
+    uint32_t FetchImmediate();
 
     virtual void IterateField(const gc::FieldIterator&) override final;
   public:
@@ -83,6 +88,12 @@ class BytecodeContext : public Context {
 
     bool HandleException(const gc::Handle<JSValue>&);
 
+    gc::Handle<bytecode::Code> GetCode();
+    // Offset of the instruction being executed. For callers, this is the call in progress
+    size_t GetPc() const {
+        return ip ? ip - 1 : 0;
+    }
+
     ReturnStatus Step();
     ReturnStatus Run();
 };
@@ -0,0 +1,186 @@
+#include "OpcodeStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace norlit::js::vm;
+using namespace norlit::js::bytecode;
+
+namespace {
+
+uint64_t counts[OpcodeStats::kOpcodes];
+uint64_t cycles[OpcodeStats::kOpcodes];
+uint64_t pairs[OpcodeStats::kOpcodes][OpcodeStats::kOpcodes];
+// The instruction executed before, in any frame
+size_t previous = OpcodeStats::kOpcodes;
+
+const size_t kRecordSize = 5;
+const size_t kTraceBufferSize = 64 * 1024;
+uint8_t traceBuffer[kTraceBufferSize];
+size_t traceLength = 0;
+FILE* trace = nullptr;
+
+void FlushTrace() {
+    fwrite(traceBuffer, 1, traceLength, trace);
+    traceLength = 0;
+}
+
+}
+
+uint64_t OpcodeStats::ReadCycles() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+void OpcodeStats::Begin(Instruction ins, uint32_t pc) {
+    size_t opcode = static_cast<uint8_t>(ins);
+    counts[opcode]++;
+    if (previous != kOpcodes) {
+        pairs[previous][opcode]++;
+    }
+    previous = opcode;
+
+    if (trace) {
+        if (traceLength + kRecordSize > kTraceBufferSize) {
+            FlushTrace();
+        }
+        uint8_t* record = traceBuffer + traceLength;
+        record[0] = static_cast<uint8_t>(opcode);
+        record[1] = pc & 0xFF;
+        record[2] = (pc >> 8) & 0xFF;
+        record[3] = (pc >> 16) & 0xFF;
+        record[4] = (pc >> 24) & 0xFF;
+        traceLength += kRecordSize;
+    }
+}
+
+void OpcodeStats::End(Instruction ins, uint64_t startCycles) {
+    cycles[static_cast<uint8_t>(ins)] += ReadCycles() - startCycles;
+}
+
+void OpcodeStats::Reset() {
+    memset(counts, 0, sizeof(counts));
+    memset(cycles, 0, sizeof(cycles));
+    memset(pairs, 0, sizeof(pairs));
+    previous = kOpcodes;
+}
+
+uint64_t OpcodeStats::TotalCount() {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kOpcodes; i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+bool OpcodeStats::StartTrace(const std::string& path) {
+    StopTrace();
+    trace = fopen(path.c_str(), "wb");
+    if (!trace) {
+        return false;
+    }
+    fwrite("NJST", 1, 4, trace);
+    return true;
+}
+
+void OpcodeStats::StopTrace() {
+    if (!trace) {
+        return;
+    }
+    FlushTrace();
+    fclose(trace);
+    trace = nullptr;
+}
+
+bool OpcodeStats::WriteReport(const std::string& path, size_t topPairs) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    uint64_t totalCount = 0;
+    uint64_t totalCycles = 0;
+    std::vector<size_t> opcodes;
+    for (size_t i = 0; i < kOpcodes; i++) {
+        if (counts[i]) {
+            opcodes.push_back(i);
+            totalCount += counts[i];
+            totalCycles += cycles[i];
+        }
+    }
+    std::sort(opcodes.begin(), opcodes.end(), [](size_t a, size_t b) {
+        return counts[a] > counts[b];
+    });
+
+    fprintf(file, "%-24s %14s %7s %16s %7s %10s\n", "opcode", "count", "%", "cycles", "%", "cycles/op");
+    for (size_t opcode : opcodes) {
+        fprintf(file, "%-24s %14llu %6.2f%% %16llu %6.2f%% %10.1f\n",
+                InstructionName(static_cast<Instruction>(opcode)),
+                static_cast<unsigned long long>(counts[opcode]),
+                100.0 * counts[opcode] / totalCount,
+                static_cast<unsigned long long>(cycles[opcode]),
+                totalCycles ? 100.0 * cycles[opcode] / totalCycles : 0.0,
+                static_cast<double>(cycles[opcode]) / counts[opcode]);
+    }
+
+    struct Pair {
+        size_t first;
+        size_t second;
+        uint64_t count;
+    };
+    std::vector<Pair> frequent;
+    for (size_t i = 0; i < kOpcodes; i++) {
+        for (size_t j = 0; j < kOpcodes; j++) {
+            if (pairs[i][j]) {
+                frequent.push_back({ i, j, pairs[i][j] });
+            }
+        }
+    }
+    std::sort(frequent.begin(), frequent.end(), [](const Pair& a, const Pair& b) {
+        return a.count > b.count;
+    });
+    if (frequent.size() > topPairs) {
+        frequent.resize(topPairs);
+    }
+
+    fprintf(file, "\n%-24s %-24s %14s %7s\n", "first", "second", "count", "%");
+    for (const Pair& pair : frequent) {
+        fprintf(file, "%-24s %-24s %14llu %6.2f%%\n",
+                InstructionName(static_cast<Instruction>(pair.first)),
+                InstructionName(static_cast<Instruction>(pair.second)),
+                static_cast<unsigned long long>(pair.count),
+                100.0 * pair.count / totalCount);
+    }
+    return fclose(file) == 0;
+}
+
+bool OpcodeStats::PrintTrace(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char magic[4];
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "NJST", 4) != 0) {
+        fclose(file);
+        return false;
+    }
+    uint8_t record[kRecordSize];
+    while (fread(record, 1, kRecordSize, file) == kRecordSize) {
+        uint32_t pc = record[1] | (record[2] << 8) | (record[3] << 16) | (static_cast<uint32_t>(record[4]) << 24);
+        printf("%-6u %s\n", pc, InstructionName(static_cast<Instruction>(record[0])));
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef NORLIT_JS_VM_OPCODESTATS_H
+#define NORLIT_JS_VM_OPCODESTATS_H
+
+#include "../bytecode/Instruction.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace norlit {
+namespace js {
+namespace vm {
+
+// Per-opcode execution counts, cumulative cycles and opcode pair frequencies, and an optional
+// binary trace of every instruction executed. Only collected when the engine is compiled with
+// NORLIT_OPCODE_STATS defined, in which case BytecodeContext::Run wraps each Step in a Sample.
+// Nothing is allocated while instructions execute.
+//
+// Cycles are read with rdtsc where available and are inclusive: kCall and kNew include the time
+// spent in the callee.
+//
+// The trace starts with the magic "NJST", followed by one record per instruction: the opcode as
+// a byte and its bytecode offset as a little endian uint32_t.
+class OpcodeStats {
+  public:
+    static const size_t kOpcodes = 256;
+
+    static uint64_t ReadCycles();
+
+    // Record one instruction. Must be followed by End once the instruction has executed
+    static void Begin(bytecode::Instruction, uint32_t pc);
+    static void End(bytecode::Instruction, uint64_t startCycles);
+
+    class Sample {
+        bytecode::Instruction ins;
+        uint64_t start;
+      public:
+        Sample(bytecode::Instruction ins, uint32_t pc): ins(ins) {
+            Begin(ins, pc);
+            start = ReadCycles();
+        }
+        Sample(const Sample&) = delete;
+        ~Sample() {
+            End(ins, start);
+        }
+    };
+
+    static void Reset();
+    // Number of instructions executed since the last Reset
+    static uint64_t TotalCount();
+    static bool StartTrace(const std::string& path);
+    static void StopTrace();
+
+    // Write a text report: each opcode by execution count with its cycles, followed by the most
+    // frequent opcode pairs. Returns false if the file cannot be written
+    static bool WriteReport(const std::string& path, size_t topPairs = 50);
+    // Print a binary trace with opcode names. Returns false if the trace cannot be read
+    static bool PrintTrace(const std::string& path);
+};
+
+}
+}
+}
+
+#endif
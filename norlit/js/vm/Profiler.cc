@@ -0,0 +1,222 @@
+#include "Profiler.h"
+#include "Context.h"
+
+#include "../bytecode/Code.h"
+#include "../object/JSFunction.h"
+#include "../Objects.h"
+#include "../Conversion.h"
+#include "../Exception.h"
+
+#include "../../util/ArrayList.h"
+#include "../../util/HashMap.h"
+#include "../../util/TaggedInteger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace norlit::gc;
+using namespace norlit::js;
+using namespace norlit::js::vm;
+using namespace norlit::js::object;
+using namespace norlit::js::bytecode;
+using namespace norlit::util;
+
+std::atomic<bool> Profiler::sampleRequested{ false };
+
+namespace {
+
+// Each sample is the number of frames, followed by the function id and bytecode offset of each
+// frame, outermost first
+const size_t kBufferSize = 1 << 16;
+uint32_t buffer[kBufferSize];
+// Total number of words written and read. Their difference is the number of words buffered
+size_t wordsWritten = 0;
+size_t wordsRead = 0;
+
+// Number of samples of each stack drained from the buffer
+std::map<std::vector<uint32_t>, size_t> stacks;
+
+std::thread timer;
+std::mutex timerMutex;
+std::condition_variable timerStopped;
+bool running = false;
+
+// Index into the lists below of each function seen. Keys are the Code of bytecode frames and
+// the function object of native frames
+Handle<HashMap<Object, TaggedInteger>>& FunctionIds() {
+    static Handle<HashMap<Object, TaggedInteger>> ids = new HashMap<Object, TaggedInteger>();
+    return ids;
+}
+
+ArrayList<Object>& FunctionKeys() {
+    static ArrayList<Object> keys;
+    return keys;
+}
+
+// Function object used to name the frame, or null for scripts
+ArrayList<ESFunctionBase>& Functions() {
+    static ArrayList<ESFunctionBase> functions;
+    return functions;
+}
+
+uint32_t FunctionId(const Handle<Object>& key, const Handle<ESFunctionBase>& func) {
+    if (Handle<TaggedInteger> id = FunctionIds()->Get(key)) {
+        return static_cast<uint32_t>(id->Value());
+    }
+    size_t id = FunctionKeys().Size();
+    FunctionKeys().Add(key);
+    Functions().Add(func);
+    FunctionIds()->Put(key, TaggedInteger::New(id));
+    return static_cast<uint32_t>(id);
+}
+
+void Drain() {
+    std::vector<uint32_t> stack;
+    while (wordsRead != wordsWritten) {
+        uint32_t frames = buffer[wordsRead++ % kBufferSize];
+        stack.clear();
+        for (uint32_t i = 0; i < frames * 2; i++) {
+            stack.push_back(buffer[wordsRead++ % kBufferSize]);
+        }
+        stacks[stack]++;
+    }
+}
+
+void Write(uint32_t word) {
+    buffer[wordsWritten++ % kBufferSize] = word;
+}
+
+std::string FunctionName(uint32_t id) {
+    Handle<ESFunctionBase> func = Functions().Get(id);
+    if (!func) {
+        return "script";
+    }
+    try {
+        Handle<JSString> name = Conversion::ToString(Objects::GetV(func, "name"));
+        if (name->Length()) {
+            return &name->ToCString()->At(0);
+        }
+    } catch (ESException&) {
+    }
+    return "anonymous";
+}
+
+}
+
+void Profiler::Start(uint32_t intervalMicroseconds) {
+    std::lock_guard<std::mutex> lock(timerMutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    timer = std::thread([intervalMicroseconds] {
+        std::unique_lock<std::mutex> lock(timerMutex);
+        auto stopped = [] {
+            return !running;
+        };
+        while (!timerStopped.wait_for(lock, std::chrono::microseconds(intervalMicroseconds), stopped)) {
+            sampleRequested.store(true, std::memory_order_relaxed);
+        }
+    });
+}
+
+void Profiler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    timerStopped.notify_all();
+    timer.join();
+    sampleRequested.store(false, std::memory_order_relaxed);
+}
+
+bool Profiler::IsRunning() {
+    std::lock_guard<std::mutex> lock(timerMutex);
+    return running;
+}
+
+void Profiler::Reset() {
+    wordsRead = wordsWritten;
+    stacks.clear();
+    // No sample refers to a function id any more, so the functions need not be kept alive
+    FunctionIds() = new HashMap<Object, TaggedInteger>();
+    FunctionKeys().Clear();
+    Functions().Clear();
+}
+
+void Profiler::TakeSample() {
+    sampleRequested.store(false, std::memory_order_relaxed);
+    ArrayList<Context>& contexts = Context::GetContextStack();
+    size_t depth = contexts.Size();
+    size_t needed = 1 + depth * 2;
+    if (needed > kBufferSize) {
+        return;
+    }
+    if (kBufferSize - (wordsWritten - wordsRead) < needed) {
+        Drain();
+    }
+
+    // The frame count is filled in once frames that are neither code nor functions are skipped
+    size_t countIndex = wordsWritten;
+    Write(0);
+    uint32_t frames = 0;
+    for (size_t i = 0; i < depth; i++) {
+        Handle<Context> context = contexts.Get(i);
+        Handle<ESFunctionBase> func = context->function();
+        uint32_t id;
+        uint32_t pc = 0;
+        if (Handle<BytecodeContext> frame = context.DynamicCastTo<BytecodeContext>()) {
+            id = FunctionId(frame->GetCode(), func);
+            pc = static_cast<uint32_t>(frame->GetPc());
+        } else if (func) {
+            id = FunctionId(func, func);
+        } else {
+            continue;
+        }
+        Write(id);
+        Write(pc);
+        frames++;
+    }
+    buffer[countIndex % kBufferSize] = frames;
+}
+
+bool Profiler::WriteCollapsed(const std::string& path) {
+    Drain();
+
+    // Offsets within the same line are merged
+    std::map<std::string, size_t> lines;
+    for (auto&& pair : stacks) {
+        const std::vector<uint32_t>& stack = pair.first;
+        std::string collapsed;
+        for (size_t i = 0; i < stack.size(); i += 2) {
+            if (i) {
+                collapsed += ';';
+            }
+            collapsed += FunctionName(stack[i]);
+            if (Handle<Code> code = FunctionKeys().Get(stack[i]).DynamicCastTo<Code>()) {
+                size_t line, column;
+                if (code->FindLineAndColumn(stack[i + 1], line, column)) {
+                    collapsed += ':' + std::to_string(line);
+                }
+            }
+        }
+        lines[collapsed] += pair.second;
+    }
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    for (auto&& pair : lines) {
+        fprintf(file, "%s %llu\n", pair.first.c_str(), static_cast<unsigned long long>(pair.second));
+    }
+    return fclose(file) == 0;
+}
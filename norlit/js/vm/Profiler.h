@@ -0,0 +1,44 @@
+#ifndef NORLIT_JS_VM_PROFILER_H
+#define NORLIT_JS_VM_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace norlit {
+namespace js {
+namespace vm {
+
+// Sampling CPU profiler for JS code.
+//
+// A timer thread requests a sample every interval. Only the thread running the engine may touch the
+// heap, and objects may move during collection, so the sample itself is taken by
+// BytecodeContext::Run between two instructions. The context stack is then walked and each frame is
+// recorded as a (function, bytecode offset) pair in a fixed-size ring buffer. Functions are
+// identified by small integers, so the buffer holds no heap pointers. Samples are aggregated when
+// the buffer fills up and when the profile is written.
+class Profiler {
+  public:
+    // Set by the timer thread and polled by the interpreter
+    static std::atomic<bool> sampleRequested;
+
+    static void Start(uint32_t intervalMicroseconds = 1000);
+    static void Stop();
+    static bool IsRunning();
+    // Discard all samples taken so far, and release the functions they refer to
+    static void Reset();
+
+    // Record the current context stack. Called by the interpreter when a sample is requested
+    static void TakeSample();
+
+    // Write the samples in collapsed stack format as read by flamegraph.pl and speedscope: one line
+    // per distinct stack with frames outermost first, separated by ';', followed by the sample count.
+    // Frames of bytecode are named as function:line. Returns false if the file cannot be written
+    static bool WriteCollapsed(const std::string& path);
+};
+
+}
+}
+}
+
+#endif
@@ -369,6 +369,7 @@ Realm::Realm() {
 			DefineProperty(prototype, "message", JSString::New(""));\
 			DefineProperty(prototype, "name", JSString::New(#className));\
 			DefineMethod(this, prototype, className::prototype::toString, "toString", 0);\
+			DefineAccessorProperty(this, prototype, "stack", className::prototype::get_stack, className::prototype::set_stack);\
 		}while(0)
 
         // 19.5.1 - 19.5.4
@@ -555,19 +556,19 @@ Realm::Realm() {
         DefineMethod(this, prototype, TODO(String::prototype::charCodeAt), "charCodeAt", 1);
         DefineMethod(this, prototype, TODO(String::prototype::codePointAt), "codePointAt", 1);
         DefineMethod(this, prototype, TODO(String::prototype::concat), "concat", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::endsWith), "endsWith", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::includes), "includes", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::indexOf), "indexOf", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::lastIndexOf), "lastIndexOf", 1);
+        DefineMethod(this, prototype, String::prototype::endsWith, "endsWith", 1);
+        DefineMethod(this, prototype, String::prototype::includes, "includes", 1);
+        DefineMethod(this, prototype, String::prototype::indexOf, "indexOf", 1);
+        DefineMethod(this, prototype, String::prototype::lastIndexOf, "lastIndexOf", 1);
         DefineMethod(this, prototype, TODO(String::prototype::localCompare), "localCompare", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::match), "match", 1);
+        DefineMethod(this, prototype, String::prototype::match, "match", 1);
         DefineMethod(this, prototype, TODO(String::prototype::normalize), "normalize", 0);
         DefineMethod(this, prototype, TODO(String::prototype::repeat), "repeat", 1);
-        DefineMethod(this, prototype, TODO(String::prototype::replace), "replace", 2);
-        DefineMethod(this, prototype, TODO(String::prototype::search), "search", 1);
+        DefineMethod(this, prototype, String::prototype::replace, "replace", 2);
+        DefineMethod(this, prototype, String::prototype::search, "search", 1);
         DefineMethod(this, prototype, TODO(String::prototype::splice), "splice", 2);
-        DefineMethod(this, prototype, TODO(String::prototype::split), "split", 2);
-        DefineMethod(this, prototype, TODO(String::prototype::startsWith), "startsWith", 1);
+        DefineMethod(this, prototype, String::prototype::split, "split", 2);
+        DefineMethod(this, prototype, String::prototype::startsWith, "startsWith", 1);
         DefineMethod(this, prototype, TODO(String::prototype::substring), "substring", 2);
         DefineMethod(this, prototype, TODO(String::prototype::toLocaleLowerCase), "toLocaleLowerCase", 0);
         DefineMethod(this, prototype, TODO(String::prototype::toLocaleUpperCase), "toLocaleUpperCase", 0);
@@ -595,29 +596,31 @@ Realm::Realm() {
 
     // 21.2 RegExp Objects
     if (true) {
-        Handle<JSObject> object = CreateBuiltinFunction(this, TODO(RegExp::Call), TODO_CTOR(RegExp::Construct), "RegExp", 2);
+        Handle<JSObject> object = CreateBuiltinFunction(this, RegExp::Call, RegExp::Construct, "RegExp", 2);
         this->WriteBarrier(&this->RegExp_, object);
         Handle<JSObject> prototype = new JSOrdinaryObject(objProto);
         this->WriteBarrier(&this->RegExpPrototype_, prototype);
 
         DefineFixedProperty(object, "prototype", prototype);
-        DefineAccessorProperty(this, object, JSSymbol::Species(), TODO(RegExp::get_Symbol_species), nullptr);
+        DefineAccessorProperty(this, object, JSSymbol::Species(), RegExp::get_Symbol_species, nullptr);
 
         DefineProperty(prototype, "constructor", object);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::exec), "exec", 1);
-        DefineAccessorProperty(this, prototype, "flags", TODO(RegExp::prototype::get_flags), nullptr);
-        DefineAccessorProperty(this, prototype, "global", TODO(RegExp::prototype::get_global), nullptr);
-        DefineAccessorProperty(this, prototype, "ignoreCase", TODO(RegExp::prototype::get_ignoreCase), nullptr);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::Symbol_match), JSSymbol::Match(), 1);
-        DefineAccessorProperty(this, prototype, "multiline", TODO(RegExp::prototype::get_multiline), nullptr);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::Symbol_replace), JSSymbol::Replace(), 2);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::Symbol_search), JSSymbol::Search(), 1);
-        DefineAccessorProperty(this, prototype, "source", TODO(RegExp::prototype::get_source), nullptr);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::Symbol_split), JSSymbol::Split(), 2);
-        DefineAccessorProperty(this, prototype, "sticky", TODO(RegExp::prototype::get_sticky), nullptr);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::test), "test", 1);
-        DefineMethod(this, prototype, TODO(RegExp::prototype::toString), "toString", 0);
-        DefineAccessorProperty(this, prototype, "unicode", TODO(RegExp::prototype::get_unicode), nullptr);
+        DefineMethod(this, prototype, RegExp::prototype::exec, "exec", 1);
+        DefineAccessorProperty(this, prototype, "flags", RegExp::prototype::get_flags, nullptr);
+        DefineAccessorProperty(this, prototype, "global", RegExp::prototype::get_global, nullptr);
+        DefineAccessorProperty(this, prototype, "ignoreCase", RegExp::prototype::get_ignoreCase, nullptr);
+        DefineMethod(this, prototype, RegExp::prototype::Symbol_match, JSSymbol::Match(), 1);
+        DefineAccessorProperty(this, prototype, "multiline", RegExp::prototype::get_multiline, nullptr);
+        DefineMethod(this, prototype, RegExp::prototype::Symbol_replace, JSSymbol::Replace(), 2);
+        DefineMethod(this, prototype, RegExp::prototype::Symbol_search, JSSymbol::Search(), 1);
+        DefineAccessorProperty(this, prototype, "source", RegExp::prototype::get_source, nullptr);
+        DefineMethod(this, prototype, RegExp::prototype::Symbol_split, JSSymbol::Split(), 2);
+        DefineAccessorProperty(this, prototype, "sticky", RegExp::prototype::get_sticky, nullptr);
+        DefineMethod(this, prototype, RegExp::prototype::test, "test", 1);
+        DefineMethod(this, prototype, RegExp::prototype::toString, "toString", 0);
+        DefineAccessorProperty(this, prototype, "unicode", RegExp::prototype::get_unicode, nullptr);
+        // Guards the fast paths of the RegExp methods
+        prototype.CastTo<JSOrdinaryObject>()->Watch();
     }
 
     // 22.1 Array Objects
@@ -631,7 +634,7 @@ Realm::Realm() {
         DefineMethod(this, object, TODO(BuiltinArray::from), "from", 1);
         DefineMethod(this, object, TODO(BuiltinArray::isArray), "isArray", 1);
         DefineMethod(this, object, TODO(BuiltinArray::of), "of", 0);
-        DefineAccessorProperty(this, object, JSSymbol::Species(), TODO(BuiltinArray::get_Symbol_species), nullptr);
+        DefineAccessorProperty(this, object, JSSymbol::Species(), BuiltinArray::get_Symbol_species, nullptr);
 
         if(true) {
             Handle<JSObject> blackList = Objects::ObjectCreate(nullptr);
@@ -649,25 +652,25 @@ Realm::Realm() {
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::entries), "entries", 0);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::every), "every", 1);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::fill), "fill", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::filter), "filter", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::filter, "filter", 1);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::find), "find", 1);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::findIndex), "findIndex", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::forEach), "forEach", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::indexOf), "indexOf", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::join), "join", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::forEach, "forEach", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::indexOf, "indexOf", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::join, "join", 1);
         DefineMethod(this, prototype, BuiltinArray::prototype::keys, "keys", 0);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::lastIndexOf), "lastIndexOf", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::map), "map", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::pop), "pop", 0);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::push), "push", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::reduce), "reduce", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::map, "map", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::pop, "pop", 0);
+        DefineMethod(this, prototype, BuiltinArray::prototype::push, "push", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::reduce, "reduce", 1);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::reduceRight), "reduceRight", 1);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::reverse), "reverse", 0);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::shift), "shift", 0);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::slice), "slice", 2);
+        DefineMethod(this, prototype, BuiltinArray::prototype::slice, "slice", 2);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::some), "some", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::sort), "sort", 1);
-        DefineMethod(this, prototype, TODO(BuiltinArray::prototype::splice), "splice", 2);
+        DefineMethod(this, prototype, BuiltinArray::prototype::sort, "sort", 1);
+        DefineMethod(this, prototype, BuiltinArray::prototype::splice, "splice", 2);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::toLocaleString), "toLocaleString", 0);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::toString), "toString", 0);
         DefineMethod(this, prototype, TODO(BuiltinArray::prototype::unshift), "unshift", 1);
@@ -681,6 +684,118 @@ Realm::Realm() {
 
         DefineReadonlyProperty(iteratorPrototype, JSSymbol::ToStringTag(), JSString::New("Array Iterator"));
         DefineMethod(this, iteratorPrototype, BuiltinArray::Iterator_next, "next", 0);
+        // Guards the fast path of Iterators::IteratorStepValue
+        iteratorPrototype.CastTo<JSOrdinaryObject>()->Watch();
+    }
+
+    // 23.1 Map Objects
+    if (true) {
+        Handle<JSObject> object = CreateBuiltinFunction(this, Map::Call, Map::Construct, "Map", 0);
+        this->WriteBarrier(&this->Map_, object);
+        Handle<JSObject> prototype = Objects::ObjectCreate(objProto);
+        this->WriteBarrier(&this->MapPrototype_, prototype);
+
+        DefineFixedProperty(object, "prototype", prototype);
+        DefineAccessorProperty(this, object, JSSymbol::Species(), Map::get_Symbol_species, nullptr);
+
+        DefineProperty(prototype, "constructor", object);
+        DefineMethod(this, prototype, Map::prototype::clear, "clear", 0);
+        DefineMethod(this, prototype, Map::prototype::delete_, "delete", 1);
+        DefineMethod(this, prototype, Map::prototype::forEach, "forEach", 1);
+        DefineMethod(this, prototype, Map::prototype::get, "get", 1);
+        DefineMethod(this, prototype, Map::prototype::has, "has", 1);
+        DefineMethod(this, prototype, Map::prototype::keys, "keys", 0);
+        DefineMethod(this, prototype, Map::prototype::set, "set", 2);
+        DefineAccessorProperty(this, prototype, "size", Map::prototype::get_size, nullptr);
+        DefineMethod(this, prototype, Map::prototype::values, "values", 0);
+        DefineReadonlyProperty(prototype, JSSymbol::ToStringTag(), JSString::New("Map"));
+
+        Handle<JSObject> entries = CreateBuiltinFunction(this, Map::prototype::entries, nullptr, "entries", 0);
+        DefineProperty(prototype, "entries", entries);
+        DefineProperty(prototype, JSSymbol::Iterator(), entries);
+        // Guards the fast path of the Map constructor
+        prototype.CastTo<JSOrdinaryObject>()->Watch();
+
+        Handle<JSObject> iteratorPrototype = Objects::ObjectCreate(this->IteratorPrototype_);
+        this->WriteBarrier(&this->MapIteratorPrototype_, iteratorPrototype);
+
+        DefineReadonlyProperty(iteratorPrototype, JSSymbol::ToStringTag(), JSString::New("Map Iterator"));
+        DefineMethod(this, iteratorPrototype, Map::Iterator_next, "next", 0);
+        // Guards the fast path of Iterators::IteratorStepValue
+        iteratorPrototype.CastTo<JSOrdinaryObject>()->Watch();
+    }
+
+    // 23.2 Set Objects
+    if (true) {
+        Handle<JSObject> object = CreateBuiltinFunction(this, Set::Call, Set::Construct, "Set", 0);
+        this->WriteBarrier(&this->Set_, object);
+        Handle<JSObject> prototype = Objects::ObjectCreate(objProto);
+        this->WriteBarrier(&this->SetPrototype_, prototype);
+
+        DefineFixedProperty(object, "prototype", prototype);
+        DefineAccessorProperty(this, object, JSSymbol::Species(), Set::get_Symbol_species, nullptr);
+
+        DefineProperty(prototype, "constructor", object);
+        DefineMethod(this, prototype, Set::prototype::add, "add", 1);
+        DefineMethod(this, prototype, Set::prototype::clear, "clear", 0);
+        DefineMethod(this, prototype, Set::prototype::delete_, "delete", 1);
+        DefineMethod(this, prototype, Set::prototype::entries, "entries", 0);
+        DefineMethod(this, prototype, Set::prototype::forEach, "forEach", 1);
+        DefineMethod(this, prototype, Set::prototype::has, "has", 1);
+        DefineAccessorProperty(this, prototype, "size", Set::prototype::get_size, nullptr);
+        DefineReadonlyProperty(prototype, JSSymbol::ToStringTag(), JSString::New("Set"));
+
+        Handle<JSObject> values = CreateBuiltinFunction(this, Set::prototype::values, nullptr, "values", 0);
+        DefineProperty(prototype, "keys", values);
+        DefineProperty(prototype, "values", values);
+        DefineProperty(prototype, JSSymbol::Iterator(), values);
+        // Guards the fast path of the Set constructor
+        prototype.CastTo<JSOrdinaryObject>()->Watch();
+
+        Handle<JSObject> iteratorPrototype = Objects::ObjectCreate(this->IteratorPrototype_);
+        this->WriteBarrier(&this->SetIteratorPrototype_, iteratorPrototype);
+
+        DefineReadonlyProperty(iteratorPrototype, JSSymbol::ToStringTag(), JSString::New("Set Iterator"));
+        DefineMethod(this, iteratorPrototype, Set::Iterator_next, "next", 0);
+        // Guards the fast path of Iterators::IteratorStepValue
+        iteratorPrototype.CastTo<JSOrdinaryObject>()->Watch();
+    }
+
+    // 23.3 WeakMap Objects
+    if (true) {
+        Handle<JSObject> object = CreateBuiltinFunction(this, WeakMap::Call, WeakMap::Construct, "WeakMap", 0);
+        this->WriteBarrier(&this->WeakMap_, object);
+        Handle<JSObject> prototype = Objects::ObjectCreate(objProto);
+        this->WriteBarrier(&this->WeakMapPrototype_, prototype);
+
+        DefineFixedProperty(object, "prototype", prototype);
+
+        DefineProperty(prototype, "constructor", object);
+        DefineMethod(this, prototype, WeakMap::prototype::delete_, "delete", 1);
+        DefineMethod(this, prototype, WeakMap::prototype::get, "get", 1);
+        DefineMethod(this, prototype, WeakMap::prototype::has, "has", 1);
+        DefineMethod(this, prototype, WeakMap::prototype::set, "set", 2);
+        DefineReadonlyProperty(prototype, JSSymbol::ToStringTag(), JSString::New("WeakMap"));
+        // Guards the fast path of the WeakMap constructor
+        prototype.CastTo<JSOrdinaryObject>()->Watch();
+    }
+
+    // 23.4 WeakSet Objects
+    if (true) {
+        Handle<JSObject> object = CreateBuiltinFunction(this, WeakSet::Call, WeakSet::Construct, "WeakSet", 0);
+        this->WriteBarrier(&this->WeakSet_, object);
+        Handle<JSObject> prototype = Objects::ObjectCreate(objProto);
+        this->WriteBarrier(&this->WeakSetPrototype_, prototype);
+
+        DefineFixedProperty(object, "prototype", prototype);
+
+        DefineProperty(prototype, "constructor", object);
+        DefineMethod(this, prototype, WeakSet::prototype::add, "add", 1);
+        DefineMethod(this, prototype, WeakSet::prototype::delete_, "delete", 1);
+        DefineMethod(this, prototype, WeakSet::prototype::has, "has", 1);
+        DefineReadonlyProperty(prototype, JSSymbol::ToStringTag(), JSString::New("WeakSet"));
+        // Guards the fast path of the WeakSet constructor
+        prototype.CastTo<JSOrdinaryObject>()->Watch();
     }
 
     // 25.2 GeneratorFunction Objects
@@ -705,6 +820,7 @@ Realm::Realm() {
         DefineMethod(this, genProto, Generator::prototype::next, "next", 1);
         DefineMethod(this, genProto, Generator::prototype::return_, "return", 1);
         DefineMethod(this, genProto, Generator::prototype::throw_, "throw", 1);
+        genProto.CastTo<JSOrdinaryObject>()->Watch();
     }
 
     // B.2 Additional Builtin Properties
@@ -722,6 +838,8 @@ Realm::Realm() {
             false,
             true
         });
+        // Guards fast paths that assume no elements are inherited from Object.prototype
+        objProto.CastTo<JSOrdinaryObject>()->Watch();
     }
 
     // Conforming to SetRealmGlobalObject(this, undefined)
@@ -140,6 +140,16 @@ Handle<Object> HashMapBase<kWeak, vWeak>::Get(const Handle<Object>& key) {
     return entry ? entry->value : nullptr;
 }
 
+template<bool kWeak, bool vWeak>
+bool HashMapBase<kWeak, vWeak>::ContainsKey(const Handle<Object>& key) {
+    if (dirty) Clean();
+
+    // Hash() may cause GC
+    Handle<HashMapBase> thisPtr = this;
+    uintptr_t hash = Hash(key);
+    return static_cast<bool>(thisPtr->GetNode(hash, key));
+}
+
 template<bool kWeak, bool vWeak>
 Handle<Object> HashMapBase<kWeak, vWeak>::Put(const Handle<Object>& key, const Handle<Object>& value) {
     if (dirty) Clean();
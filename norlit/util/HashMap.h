@@ -35,6 +35,8 @@ class HashMapBase : public gc::Object {
     static const float DEFAULT_LOAD_FACTOR;
 
     gc::Handle<gc::Object> Get(const gc::Handle<gc::Object>& key);
+    // Tells a key mapped to null apart from an absent one
+    bool ContainsKey(const gc::Handle<gc::Object>& key);
     gc::Handle<gc::Object> Put(const gc::Handle<gc::Object>& key, const gc::Handle<gc::Object>& value);
     gc::Handle<gc::Object> Remove(const gc::Handle<gc::Object>& key);
 
@@ -49,6 +51,10 @@ class HashMap: public detail::HashMapBase<kWeak, vWeak> {
         return (V*)detail::HashMapBase<kWeak, vWeak>::Get((gc::Object*)key);
     }
 
+    bool ContainsKey(const gc::Handle<K>& key) {
+        return detail::HashMapBase<kWeak, vWeak>::ContainsKey((gc::Object*)key);
+    }
+
     gc::Handle<V> Put(const gc::Handle<K>& key, const gc::Handle<V>& value) {
         return (V*)detail::HashMapBase<kWeak, vWeak>::Put((gc::Object*)key, (gc::Object*)value);
     }
@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace norlit::util;
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const char* path) {
+    Close();
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    // Empty files cannot be mapped
+    void* map = st.st_size ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map != MAP_FAILED) {
+        size_ = st.st_size;
+        // Source files are scanned front to back exactly once
+        madvise(map, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(map);
+        mapped_ = true;
+        return true;
+    }
+#endif
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length < 0) {
+        fclose(file);
+        return false;
+    }
+    char* buffer = new char[length + 1];
+    size_ = fread(buffer, 1, length, file);
+    buffer[size_] = 0;
+    fclose(file);
+    data_ = buffer;
+    return true;
+}
+
+void MappedFile::Close() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    } else
+#endif
+    {
+        delete[] data_;
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
@@ -0,0 +1,36 @@
+#ifndef NORLIT_UTIL_MAPPEDFILE_H
+#define NORLIT_UTIL_MAPPEDFILE_H
+
+#include <cstddef>
+
+namespace norlit {
+namespace util {
+
+// Read-only view of a whole file. The file is memory mapped where supported, and read into
+// memory otherwise
+class MappedFile {
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool Open(const char* path);
+    void Close();
+
+    const char* data() const {
+        return data_;
+    }
+    size_t size() const {
+        return size_;
+    }
+};
+
+}
+}
+
+#endif
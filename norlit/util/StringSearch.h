@@ -0,0 +1,179 @@
+#ifndef NORLIT_UTIL_STRINGSEARCH_H
+#define NORLIT_UTIL_STRINGSEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NORLIT_STRINGSEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace norlit {
+namespace util {
+
+// Substring search over raw characters. Text and pattern are each either Latin-1 (uint8_t) or
+// UTF-16 (char16_t), and are compared by code unit without converting one to the other.
+//
+// A single character is found by scanning 16 bytes at a time, with memchr for Latin-1 and SSE2
+// where available for UTF-16. Short patterns are found by scanning for their first character and
+// comparing the rest, longer ones with Boyer-Moore-Horspool, whose shift table is indexed by the low
+// byte of a character so it stays small for UTF-16.
+class StringSearch {
+    // Patterns shorter than this are matched by scanning for their first character
+    static const size_t kHorspoolMinPattern = 8;
+
+    static unsigned CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return index;
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+
+    template<typename T, typename P>
+    static bool Equals(const T* text, const P* pattern, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] != pattern[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool Equals(const uint8_t* text, const uint8_t* pattern, size_t length) {
+        return memcmp(text, pattern, length) == 0;
+    }
+
+    static bool Equals(const char16_t* text, const char16_t* pattern, size_t length) {
+        return memcmp(text, pattern, length * sizeof(char16_t)) == 0;
+    }
+
+    template<typename T, typename P>
+    static size_t FindByFirstChar(const T* text, size_t textLength, const P* pattern, size_t patternLength, size_t from) {
+        // Positions at which the whole pattern still fits
+        size_t limit = textLength - patternLength + 1;
+        while (from < limit) {
+            size_t pos = FindChar(text, limit, pattern[0], from);
+            if (pos == kNotFound) {
+                return kNotFound;
+            }
+            if (Equals(text + pos + 1, pattern + 1, patternLength - 1)) {
+                return pos;
+            }
+            from = pos + 1;
+        }
+        return kNotFound;
+    }
+
+    template<typename T, typename P>
+    static size_t FindHorspool(const T* text, size_t textLength, const P* pattern, size_t patternLength, size_t from) {
+        size_t last = patternLength - 1;
+        size_t shift[256];
+        for (size_t i = 0; i < 256; i++) {
+            shift[i] = patternLength;
+        }
+        // Characters sharing a low byte get the smallest shift of any of them
+        for (size_t i = 0; i < last; i++) {
+            shift[pattern[i] & 0xFF] = last - i;
+        }
+        P lastChar = pattern[last];
+        for (size_t pos = from; pos + last < textLength;) {
+            T ch = text[pos + last];
+            if (ch == lastChar && Equals(text + pos, pattern, last)) {
+                return pos;
+            }
+            pos += shift[ch & 0xFF];
+        }
+        return kNotFound;
+    }
+
+  public:
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    // Index of the first ch in text[from, length), or kNotFound
+    static size_t FindChar(const uint8_t* text, size_t length, char16_t ch, size_t from) {
+        if (ch > 0xFF || from >= length) {
+            return kNotFound;
+        }
+        const void* found = memchr(text + from, ch, length - from);
+        return found ? static_cast<const uint8_t*>(found) - text : kNotFound;
+    }
+
+    static size_t FindChar(const char16_t* text, size_t length, char16_t ch, size_t from) {
+        size_t i = from;
+#ifdef NORLIT_STRINGSEARCH_SSE2
+        __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+        for (; i + 8 <= length; i += 8) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, needle));
+            if (mask) {
+                return i + CountTrailingZeros(mask) / 2;
+            }
+        }
+#endif
+        for (; i < length; i++) {
+            if (text[i] == ch) {
+                return i;
+            }
+        }
+        return kNotFound;
+    }
+
+    // Index of the first occurrence of pattern in text starting at or after from, or kNotFound
+    template<typename T, typename P>
+    static size_t Find(const T* text, size_t textLength, const P* pattern, size_t patternLength, size_t from) {
+        if (from > textLength || patternLength > textLength - from) {
+            return kNotFound;
+        }
+        if (patternLength == 0) {
+            return from;
+        }
+        if (patternLength == 1) {
+            return FindChar(text, textLength, pattern[0], from);
+        }
+        if (patternLength < kHorspoolMinPattern) {
+            return FindByFirstChar(text, textLength, pattern, patternLength, from);
+        }
+        return FindHorspool(text, textLength, pattern, patternLength, from);
+    }
+
+    // Index of the last occurrence of pattern in text starting at or before from, or kNotFound
+    template<typename T, typename P>
+    static size_t FindLast(const T* text, size_t textLength, const P* pattern, size_t patternLength, size_t from) {
+        if (patternLength > textLength) {
+            return kNotFound;
+        }
+        size_t pos = textLength - patternLength;
+        if (from < pos) {
+            pos = from;
+        }
+        if (patternLength == 0) {
+            return pos;
+        }
+        for (pos++; pos-- > 0;) {
+            if (text[pos] == pattern[0] && Equals(text + pos + 1, pattern + 1, patternLength - 1)) {
+                return pos;
+            }
+        }
+        return kNotFound;
+    }
+
+    // Whether pattern occurs in text at pos
+    template<typename T, typename P>
+    static bool MatchesAt(const T* text, size_t textLength, const P* pattern, size_t patternLength, size_t pos) {
+        return pos <= textLength && patternLength <= textLength - pos && Equals(text + pos, pattern, patternLength);
+    }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,429 @@
+#ifndef NORLIT_UTIL_TIMSORT_H
+#define NORLIT_UTIL_TIMSORT_H
+
+#include <cstddef>
+
+namespace norlit {
+namespace util {
+
+// Stable adaptive merge sort. Runs already in order (or strictly descending, which are reversed)
+// are found and extended to a minimum length with binary insertion sort, then merged while keeping
+// the run lengths balanced. When one run keeps winning during a merge, elements are moved in bulk by
+// galloping: an exponential followed by a binary search.
+//
+// Elements are accessed through Slots, a copyable reference to storage with Get(index) and
+// Put(index, value), whose Allocate(size) returns a new Slots of the same kind. This lets garbage
+// collected arrays be sorted in place while the comparison may allocate or call into script.
+// Less(x, y) tells whether x sorts strictly before y. An inconsistent Less leaves the elements in an
+// unspecified order, but never loses or duplicates any.
+template<typename Slots, typename Less>
+class TimSort {
+    static const size_t kMinMerge = 32;
+    static const size_t kMinGallop = 7;
+    // Enough for 2^64 elements, as run lengths on the stack grow at least as fast as Fibonacci numbers
+    static const size_t kMaxStack = 85;
+
+    Slots a;
+    Less less;
+    Slots tmp;
+    size_t tmpSize = 0;
+    size_t minGallop = kMinGallop;
+
+    size_t stackSize = 0;
+    size_t runBase[kMaxStack];
+    size_t runLen[kMaxStack];
+
+    TimSort(const Slots& a, const Less& less) : a(a), less(less), tmp(a) {}
+
+    static size_t MinRunLength(size_t n) {
+        size_t r = 0;
+        while (n >= kMinMerge) {
+            r |= n & 1;
+            n >>= 1;
+        }
+        return n + r;
+    }
+
+    void EnsureTemp(size_t size) {
+        if (tmpSize < size) {
+            tmpSize = size < 256 ? 256 : size;
+            tmp = a.Allocate(tmpSize);
+        }
+    }
+
+    static void Copy(Slots& from, size_t fromPos, Slots& to, size_t toPos, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            to.Put(toPos + i, from.Get(fromPos + i));
+        }
+    }
+
+    // Copy that is safe when the ranges overlap and the destination is to the right
+    static void CopyBackward(Slots& from, size_t fromPos, Slots& to, size_t toPos, size_t length) {
+        for (size_t i = length; i > 0; i--) {
+            to.Put(toPos + i - 1, from.Get(fromPos + i - 1));
+        }
+    }
+
+    // Length of the run starting at lo, reversing it if it is strictly descending
+    size_t CountRunAndMakeAscending(size_t lo, size_t hi) {
+        size_t runHi = lo + 1;
+        if (runHi == hi) {
+            return 1;
+        }
+        if (less(a.Get(runHi), a.Get(lo))) {
+            runHi++;
+            while (runHi < hi && less(a.Get(runHi), a.Get(runHi - 1))) {
+                runHi++;
+            }
+            for (size_t i = lo, j = runHi - 1; i < j; i++, j--) {
+                auto t = a.Get(i);
+                a.Put(i, a.Get(j));
+                a.Put(j, t);
+            }
+        } else {
+            runHi++;
+            while (runHi < hi && !less(a.Get(runHi), a.Get(runHi - 1))) {
+                runHi++;
+            }
+        }
+        return runHi - lo;
+    }
+
+    // Sort [lo, hi) given that [lo, start) is sorted
+    void BinarySort(size_t lo, size_t hi, size_t start) {
+        for (; start < hi; start++) {
+            auto pivot = a.Get(start);
+            size_t left = lo, right = start;
+            while (left < right) {
+                size_t mid = left + (right - left) / 2;
+                if (less(pivot, a.Get(mid))) {
+                    right = mid;
+                } else {
+                    left = mid + 1;
+                }
+            }
+            CopyBackward(a, left, a, left + 1, start - left);
+            a.Put(left, pivot);
+        }
+    }
+
+    // Index in s[base, base + length) of the leftmost element not less than key, searching
+    // outwards from hint
+    template<typename Value>
+    size_t GallopLeft(const Value& key, Slots& s, size_t base, size_t length, size_t hint) {
+        ptrdiff_t lastOfs = 0, ofs = 1;
+        ptrdiff_t len = static_cast<ptrdiff_t>(length), h = static_cast<ptrdiff_t>(hint);
+        if (less(s.Get(base + h), key)) {
+            ptrdiff_t maxOfs = len - h;
+            while (ofs < maxOfs && less(s.Get(base + h + ofs), key)) {
+                lastOfs = ofs;
+                ofs = ofs * 2 + 1;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            lastOfs += h;
+            ofs += h;
+        } else {
+            ptrdiff_t maxOfs = h + 1;
+            while (ofs < maxOfs && !less(s.Get(base + h - ofs), key)) {
+                lastOfs = ofs;
+                ofs = ofs * 2 + 1;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            ptrdiff_t t = lastOfs;
+            lastOfs = h - ofs;
+            ofs = h - t;
+        }
+        // s[base + lastOfs] < key <= s[base + ofs]
+        lastOfs++;
+        while (lastOfs < ofs) {
+            ptrdiff_t m = lastOfs + (ofs - lastOfs) / 2;
+            if (less(s.Get(base + m), key)) {
+                lastOfs = m + 1;
+            } else {
+                ofs = m;
+            }
+        }
+        return static_cast<size_t>(ofs);
+    }
+
+    // Index in s[base, base + length) of the leftmost element greater than key, searching outwards
+    // from hint
+    template<typename Value>
+    size_t GallopRight(const Value& key, Slots& s, size_t base, size_t length, size_t hint) {
+        ptrdiff_t lastOfs = 0, ofs = 1;
+        ptrdiff_t len = static_cast<ptrdiff_t>(length), h = static_cast<ptrdiff_t>(hint);
+        if (less(key, s.Get(base + h))) {
+            ptrdiff_t maxOfs = h + 1;
+            while (ofs < maxOfs && less(key, s.Get(base + h - ofs))) {
+                lastOfs = ofs;
+                ofs = ofs * 2 + 1;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            ptrdiff_t t = lastOfs;
+            lastOfs = h - ofs;
+            ofs = h - t;
+        } else {
+            ptrdiff_t maxOfs = len - h;
+            while (ofs < maxOfs && !less(key, s.Get(base + h + ofs))) {
+                lastOfs = ofs;
+                ofs = ofs * 2 + 1;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            lastOfs += h;
+            ofs += h;
+        }
+        // s[base + lastOfs] <= key < s[base + ofs]
+        lastOfs++;
+        while (lastOfs < ofs) {
+            ptrdiff_t m = lastOfs + (ofs - lastOfs) / 2;
+            if (less(key, s.Get(base + m))) {
+                ofs = m;
+            } else {
+                lastOfs = m + 1;
+            }
+        }
+        return static_cast<size_t>(ofs);
+    }
+
+    // Merge adjacent runs with len1 <= len2, moving the first run into temporary storage
+    void MergeLo(size_t base1, size_t len1, size_t base2, size_t len2) {
+        EnsureTemp(len1);
+        Copy(a, base1, tmp, 0, len1);
+        size_t cursor1 = 0, cursor2 = base2, dest = base1;
+
+        a.Put(dest++, a.Get(cursor2++));
+        if (--len2 == 0) {
+            Copy(tmp, cursor1, a, dest, len1);
+            return;
+        }
+        if (len1 == 1) {
+            Copy(a, cursor2, a, dest, len2);
+            a.Put(dest + len2, tmp.Get(cursor1));
+            return;
+        }
+
+        size_t gallop = minGallop;
+        while (true) {
+            size_t count1 = 0, count2 = 0;
+            // One element at a time until a run wins consistently
+            do {
+                if (less(a.Get(cursor2), tmp.Get(cursor1))) {
+                    a.Put(dest++, a.Get(cursor2++));
+                    count2++;
+                    count1 = 0;
+                    if (--len2 == 0) goto done;
+                } else {
+                    a.Put(dest++, tmp.Get(cursor1++));
+                    count1++;
+                    count2 = 0;
+                    if (--len1 == 1) goto done;
+                }
+            } while ((count1 | count2) < gallop);
+
+            // Gallop until neither run wins consistently any more
+            do {
+                count1 = GallopRight(a.Get(cursor2), tmp, cursor1, len1, 0);
+                if (count1 != 0) {
+                    Copy(tmp, cursor1, a, dest, count1);
+                    dest += count1;
+                    cursor1 += count1;
+                    len1 -= count1;
+                    if (len1 <= 1) goto done;
+                }
+                a.Put(dest++, a.Get(cursor2++));
+                if (--len2 == 0) goto done;
+
+                count2 = GallopLeft(tmp.Get(cursor1), a, cursor2, len2, 0);
+                if (count2 != 0) {
+                    Copy(a, cursor2, a, dest, count2);
+                    dest += count2;
+                    cursor2 += count2;
+                    len2 -= count2;
+                    if (len2 == 0) goto done;
+                }
+                a.Put(dest++, tmp.Get(cursor1++));
+                if (--len1 == 1) goto done;
+                if (gallop > 0) gallop--;
+            } while (count1 >= kMinGallop || count2 >= kMinGallop);
+            gallop += 2;
+        }
+
+      done:
+        minGallop = gallop < 1 ? 1 : gallop;
+        if (len1 == 1) {
+            Copy(a, cursor2, a, dest, len2);
+            a.Put(dest + len2, tmp.Get(cursor1));
+        } else if (len1 != 0) {
+            // len1 is only 0 if less is inconsistent, in which case the rest is already in place
+            Copy(tmp, cursor1, a, dest, len1);
+        }
+    }
+
+    // Merge adjacent runs with len1 >= len2 from the right, moving the second run into temporary
+    // storage. Cursors point one past the next element to move
+    void MergeHi(size_t base1, size_t len1, size_t base2, size_t len2) {
+        EnsureTemp(len2);
+        Copy(a, base2, tmp, 0, len2);
+        size_t cursor1 = base1 + len1, cursor2 = len2, dest = base2 + len2;
+
+        a.Put(--dest, a.Get(--cursor1));
+        if (--len1 == 0) {
+            Copy(tmp, 0, a, dest - len2, len2);
+            return;
+        }
+        if (len2 == 1) {
+            dest -= len1;
+            cursor1 -= len1;
+            CopyBackward(a, cursor1, a, dest, len1);
+            a.Put(dest - 1, tmp.Get(cursor2 - 1));
+            return;
+        }
+
+        size_t gallop = minGallop;
+        while (true) {
+            size_t count1 = 0, count2 = 0;
+            do {
+                if (less(tmp.Get(cursor2 - 1), a.Get(cursor1 - 1))) {
+                    a.Put(--dest, a.Get(--cursor1));
+                    count1++;
+                    count2 = 0;
+                    if (--len1 == 0) goto done;
+                } else {
+                    a.Put(--dest, tmp.Get(--cursor2));
+                    count2++;
+                    count1 = 0;
+                    if (--len2 == 1) goto done;
+                }
+            } while ((count1 | count2) < gallop);
+
+            do {
+                count1 = len1 - GallopRight(tmp.Get(cursor2 - 1), a, base1, len1, len1 - 1);
+                if (count1 != 0) {
+                    dest -= count1;
+                    cursor1 -= count1;
+                    len1 -= count1;
+                    CopyBackward(a, cursor1, a, dest, count1);
+                    if (len1 == 0) goto done;
+                }
+                a.Put(--dest, tmp.Get(--cursor2));
+                if (--len2 == 1) goto done;
+
+                count2 = len2 - GallopLeft(a.Get(cursor1 - 1), tmp, 0, len2, len2 - 1);
+                if (count2 != 0) {
+                    dest -= count2;
+                    cursor2 -= count2;
+                    len2 -= count2;
+                    Copy(tmp, cursor2, a, dest, count2);
+                    if (len2 <= 1) goto done;
+                }
+                a.Put(--dest, a.Get(--cursor1));
+                if (--len1 == 0) goto done;
+                if (gallop > 0) gallop--;
+            } while (count1 >= kMinGallop || count2 >= kMinGallop);
+            gallop += 2;
+        }
+
+      done:
+        minGallop = gallop < 1 ? 1 : gallop;
+        if (len2 == 1) {
+            dest -= len1;
+            cursor1 -= len1;
+            CopyBackward(a, cursor1, a, dest, len1);
+            a.Put(dest - 1, tmp.Get(cursor2 - 1));
+        } else if (len2 != 0) {
+            // len2 is only 0 if less is inconsistent, in which case the rest is already in place
+            Copy(tmp, 0, a, dest - len2, len2);
+        }
+    }
+
+    void MergeAt(size_t i) {
+        size_t base1 = runBase[i], len1 = runLen[i];
+        size_t base2 = runBase[i + 1], len2 = runLen[i + 1];
+        runLen[i] = len1 + len2;
+        if (i == stackSize - 3) {
+            runBase[i + 1] = runBase[i + 2];
+            runLen[i + 1] = runLen[i + 2];
+        }
+        stackSize--;
+
+        // Elements of the first run before the start of the second are already in place, and so are
+        // elements of the second run after the end of the first
+        size_t k = GallopRight(a.Get(base2), a, base1, len1, 0);
+        base1 += k;
+        len1 -= k;
+        if (len1 == 0) {
+            return;
+        }
+        len2 = GallopLeft(a.Get(base1 + len1 - 1), a, base2, len2, len2 - 1);
+        if (len2 == 0) {
+            return;
+        }
+        if (len1 <= len2) {
+            MergeLo(base1, len1, base2, len2);
+        } else {
+            MergeHi(base1, len1, base2, len2);
+        }
+    }
+
+    // Merge until the run lengths on the stack satisfy the invariants
+    //   runLen[i - 2] > runLen[i - 1] + runLen[i] and runLen[i - 1] > runLen[i]
+    // which are checked for the top four runs
+    void MergeCollapse() {
+        while (stackSize > 1) {
+            size_t n = stackSize - 2;
+            if ((n > 0 && runLen[n - 1] <= runLen[n] + runLen[n + 1]) ||
+                    (n > 1 && runLen[n - 2] <= runLen[n] + runLen[n - 1])) {
+                if (runLen[n - 1] < runLen[n + 1]) {
+                    n--;
+                }
+            } else if (runLen[n] > runLen[n + 1]) {
+                break;
+            }
+            MergeAt(n);
+        }
+    }
+
+    void MergeForceCollapse() {
+        while (stackSize > 1) {
+            size_t n = stackSize - 2;
+            if (n > 0 && runLen[n - 1] < runLen[n + 1]) {
+                n--;
+            }
+            MergeAt(n);
+        }
+    }
+
+  public:
+    static void Sort(const Slots& a, size_t size, const Less& less) {
+        if (size < 2) {
+            return;
+        }
+        TimSort sorter(a, less);
+        if (size < kMinMerge) {
+            sorter.BinarySort(0, size, sorter.CountRunAndMakeAscending(0, size));
+            return;
+        }
+
+        size_t minRun = MinRunLength(size);
+        size_t lo = 0;
+        while (lo < size) {
+            size_t runLength = sorter.CountRunAndMakeAscending(lo, size);
+            if (runLength < minRun) {
+                size_t force = size - lo < minRun ? size - lo : minRun;
+                sorter.BinarySort(lo, lo + force, lo + runLength);
+                runLength = force;
+            }
+            sorter.runBase[sorter.stackSize] = lo;
+            sorter.runLen[sorter.stackSize] = runLength;
+            sorter.stackSize++;
+            sorter.MergeCollapse();
+            lo += runLength;
+        }
+        sorter.MergeForceCollapse();
+    }
+};
+
+}
+}
+
+#endif